@@ -0,0 +1,178 @@
+///@file PixieEmulator.h
+///@brief Emulates a crate of Pixie-16 modules in software, for PixieInterface to use in place of the Pixie-16 API.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+
+#ifndef __PIXIEEMULATOR_H_
+#define __PIXIEEMULATOR_H_
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "XiaListModeDataEncoder.hpp"
+
+///Emulates the list mode runs of a crate, so that poll2 can be tested and benchmarked without the hardware. Each
+/// channel fires at random at its own rate, and its hits are encoded with XiaListModeDataEncoder using the firmware
+/// and frequency of its module. Every module copies its hits into its external FIFO at a fixed number of words per
+/// second, so the FIFO is often caught part way through an event, like the real one. Hits that fire while the module
+/// is still copying the one before, or while the FIFO is full, are lost. The FIFO holds EXTERNAL_FIFO_LENGTH words,
+/// once it's full the copy stops until it has been read. Time is real time since the run started.
+///
+/// The methods take the same arguments as the Pixie-16 API functions of the same name, and return a negative number
+/// on failure like them. Everything that isn't needed for a list mode run, e.g. histograms and traces, fails.
+///
+/// The configuration file is read by PixieInterface when pixie.cfg has an EmulatorFile tag. Each line is a tag
+/// followed by its values, lines starting with a '#' are ignored. A module or channel of '*' applies to all of them,
+/// and later lines win over earlier ones.
+///   Module <mod> <firmware> <frequency in MS/s> <ADC bits> : The default is 30474 250 14
+///   Rate <mod> <chan> <hits per second> : The default is 0, the channel never fires
+///   TraceLength <mod> <chan> <samples> : The default is 0, no trace
+///   TransferRate <words per second> : How fast each module copies its hits into its FIFO, the default is 2.5e7
+///   Seed <seed> : The seed of the random numbers, the default is 1
+class PixieEmulator {
+public:
+    ///Default constructor
+    PixieEmulator();
+
+    ///Default destructor
+    ~PixieEmulator() {}
+
+    ///Reads the emulator configuration file, see the description of the class.
+    ///@param[in] fn : The name of the file
+    ///@return False if the file couldn't be opened or has a line that we don't understand.
+    bool ReadConfigurationFile(const char *fn);
+
+    int InitSystem(unsigned short numModules, unsigned short *slotMap);
+
+    int ExitSystem(unsigned short numModules);
+
+    int ReadModuleInfo(unsigned short mod, unsigned short *rev, unsigned int *serNum, unsigned short *adcBits,
+                       unsigned short *adcMsps);
+
+    int ReadSglModPar(const char *name, unsigned int *val, unsigned short mod);
+
+    int WriteSglModPar(const char *name, unsigned int val, unsigned short mod);
+
+    int ReadSglChanPar(const char *name, double *val, unsigned short mod, unsigned short chan);
+
+    int WriteSglChanPar(const char *name, double val, unsigned short mod, unsigned short chan);
+
+    ///Starts a run in a module, or in all of them if mod is the number of modules.
+    int StartListModeRun(unsigned short mod, unsigned short listMode, unsigned short runMode);
+
+    ///@return 1 while the module is running or still has data that hasn't been read, 0 otherwise.
+    int CheckRunStatus(unsigned short mod);
+
+    int CheckExternalFIFOStatus(unsigned int *nWords, unsigned short mod);
+
+    int ReadDataFromExternalFIFO(unsigned int *buf, unsigned int nWords, unsigned short mod);
+
+    ///Stops the module firing. The event that it was copying into its FIFO is finished straight away.
+    int EndRun(unsigned short mod);
+
+    ///Takes a snapshot of the counts of the module that the Compute methods use, statistics isn't touched.
+    int ReadStatisticsFromModule(unsigned int *statistics, unsigned short mod);
+
+    double ComputeInputCountRate(unsigned int *statistics, unsigned short mod, unsigned short chan);
+
+    double ComputeOutputCountRate(unsigned int *statistics, unsigned short mod, unsigned short chan);
+
+    double ComputeLiveTime(unsigned int *statistics, unsigned short mod, unsigned short chan);
+
+    double ComputeRealTime(unsigned int *statistics, unsigned short mod);
+
+    double ComputeProcessedEvents(unsigned int *statistics, unsigned short mod);
+
+    ///Stands in for the Pixie-16 API functions that aren't emulated.
+    ///@param[in] function : The name of the function, for the warning
+    ///@return Always -1
+    int Unsupported(const char *function);
+
+private:
+    ///Everything that the configuration file says about a channel.
+    struct ChannelSettings {
+        double rate; ///< The number of hits per second
+        unsigned int traceLength; ///< The number of samples in each trace
+    };
+
+    ///Everything that the configuration file says about a module.
+    struct ModuleSettings {
+        std::string firmware; ///< The firmware revision
+        unsigned int frequency; ///< The sampling frequency in MS/s
+        unsigned int adcBits; ///< The resolution of the ADC
+    };
+
+    ///A line of the configuration file, kept until we know how many modules there are.
+    struct ConfigurationLine {
+        std::string tag; ///< The tag of the line
+        int mod; ///< The module, -1 for all of them
+        int chan; ///< The channel, -1 for all of them
+        std::vector<std::string> values; ///< The values after the module and channel
+    };
+
+    ///The state of one of the emulated modules.
+    struct Module {
+        ModuleSettings settings; ///< The firmware, frequency and ADC of the module
+        std::vector<ChannelSettings> channels; ///< The settings of each channel
+        XiaListModeDataEncoder encoder; ///< Encodes the hits with the module's firmware and frequency
+        unsigned short slot; ///< The slot that the module is in
+        double clockPeriod; ///< The period of the time stamp clock in ns
+        double cfdSize; ///< The number of steps of the CFD fractional time
+        std::vector<std::vector<double> > pulses; ///< The shape of the trace of each channel, with a height of one
+        bool running; ///< True while the module is taking data
+        std::vector<double> nextHit; ///< The time of the next hit of each channel, in seconds since the run started
+        std::vector<unsigned long long> hits; ///< The number of hits of each channel this run
+        std::vector<unsigned long long> accepted; ///< The number of hits of each channel that reached the FIFO
+        std::deque<unsigned int> fifo; ///< The words in the external FIFO
+        std::vector<unsigned int> event; ///< The words of the hit being copied into the FIFO
+        size_t transferred; ///< The number of words of event that are in the FIFO
+        double transferStart; ///< The time that the copy of event started
+        double transferEnd; ///< The time that the copy of the previous hit ended, the module is dead until then
+        double realTime; ///< The run time of the last statistics snapshot
+        std::vector<unsigned long long> hitsSnapshot; ///< hits at the last statistics snapshot
+        std::vector<unsigned long long> acceptedSnapshot; ///< accepted at the last statistics snapshot
+        std::map<std::string, unsigned int> moduleParameters; ///< The module parameters that have been written
+        std::map<std::string, std::vector<double> > channelParameters; ///< The channel parameters that have been written
+
+        ///Constructor
+        ///@param[in] settings_ : The firmware, frequency and ADC of the module
+        Module(const ModuleSettings &settings_);
+    };
+
+    std::vector<ConfigurationLine> configuration_; ///< The configuration file
+    std::vector<Module> modules_; ///< The emulated modules, indexed by module number
+    std::chrono::steady_clock::time_point runStart_; ///< The wall clock time that the run started
+    std::mt19937 random_; ///< The source of every random number
+    double transferRate_; ///< The number of words per second that a module copies into its FIFO
+    unsigned int seed_; ///< The seed of random_
+    std::vector<unsigned short> trace_; ///< Holds the trace of a hit while it's encoded
+
+    ///@return The number of seconds since the run started.
+    double GetRunTime();
+
+    ///@return A random number in (0, 1).
+    double Uniform();
+
+    ///@return The time from one hit of a channel to its next one, in seconds.
+    double NextInterval(const double &rate);
+
+    ///Fires every channel of a module that should have fired by now, and copies the hits into the FIFO.
+    ///@param[in] module : The module
+    ///@param[in] now : The time in seconds since the run started
+    void Advance(Module &module, const double &now);
+
+    ///Encodes a hit into the event of the module.
+    ///@param[in] module : The module
+    ///@param[in] chan : The channel that fired
+    ///@param[in] time : The time of the hit in seconds since the run started
+    void EncodeHit(Module &module, const unsigned int &chan, const double &time);
+
+    ///@return True if mod is one of our modules, with a warning if it's not.
+    bool IsValidModule(const unsigned short &mod);
+};
+
+#endif // __PIXIEEMULATOR_H_
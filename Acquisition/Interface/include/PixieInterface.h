@@ -42,6 +42,10 @@
 
 #include "Lock.h"
 
+#ifdef PIF_EMULATOR
+class PixieEmulator;
+#endif
+
 #ifdef PIF_CATCHER
 const int CCSRA_PILEUP  = 15;
 const int CCSRA_CATCHER = 16;
@@ -195,6 +199,13 @@ public:
 
     bool AdjustOffsets(unsigned short mod);
 
+    /// @brief Return true if the modules are emulated in software, see the EmulatorFile tag of the configuration file
+#ifdef PIF_EMULATOR
+    bool IsEmulated() const { return emulator != NULL; }
+#else
+    bool IsEmulated() const { return false; }
+#endif
+
     // accessors
     unsigned short GetNumberCards(void) const { return numberCards; };
 
@@ -242,6 +253,10 @@ private:
 
     bool doneInit;
 
+#ifdef PIF_EMULATOR
+    PixieEmulator *emulator; ///< Stands in for the modules if the EmulatorFile tag was given, NULL otherwise
+#endif
+
     /// @brief Convert a configuration string to be relative to PixieBaseDir unless it begins with a .
     std::string ConfigFileName(const std::string &type, const std::string &str);
 
@@ -0,0 +1,459 @@
+///@file PixieEmulator.cpp
+///@brief Emulates a crate of Pixie-16 modules in software, for PixieInterface to use in place of the Pixie-16 API.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <cmath>
+
+#include "pixie16app_defs.h"
+
+#include "Display.h"
+#include "PixieEmulator.h"
+
+using namespace std;
+
+namespace {
+    const unsigned int MAX_TRACE_LENGTH = 16000; ///< The longest trace that the event length of old firmwares holds
+    const double MAX_ENERGY = 65535.; ///< The largest energy that fits in the energy field
+    const double MEAN_ENERGY = 2000.; ///< The mean of the energy spectrum
+    const double BASELINE = 400.; ///< The baseline of the traces in ADC units
+    const double RISE_TIME = 4.; ///< The rise time constant of the pulses in samples
+    const double DECAY_TIME = 40.; ///< The decay time constant of the pulses in samples
+}
+
+PixieEmulator::Module::Module(const ModuleSettings &settings_) : settings(settings_),
+        encoder(settings_.firmware, settings_.frequency), slot(0), running(false), transferred(0), transferStart(0),
+        transferEnd(0), realTime(0) {
+    cfdSize = XiaListModeDataMask(settings.firmware, settings.frequency).GetCfdSize();
+    clockPeriod = (settings.frequency == 250 ? 8. : 10.);
+}
+
+PixieEmulator::PixieEmulator() : runStart_(chrono::steady_clock::now()), random_(1), transferRate_(2.5e7), seed_(1) {
+}
+
+///Module, Rate and TraceLength lines are only checked for syntax here, since we don't know how many modules there
+/// are until InitSystem.
+bool PixieEmulator::ReadConfigurationFile(const char *fn) {
+    ifstream in(fn);
+    if (!in)
+        return false;
+
+    string line;
+    unsigned int lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        istringstream lineStream(line);
+        if (lineStream.peek() == '#')
+            continue;
+
+        ConfigurationLine entry;
+        if (!(lineStream >> entry.tag))
+            continue;
+
+        bool isGood = true;
+        if (entry.tag == "TransferRate")
+            isGood = (lineStream >> transferRate_) && transferRate_ > 0;
+        else if (entry.tag == "Seed")
+            isGood = (bool) (lineStream >> seed_);
+        else if (entry.tag == "Module" || entry.tag == "Rate" || entry.tag == "TraceLength") {
+            //The module and the channel are either a number or a '*' for all of them.
+            const unsigned int numberOfIndices = (entry.tag == "Module" ? 1 : 2);
+            entry.mod = entry.chan = -1;
+            for (unsigned int i = 0; i < numberOfIndices && isGood; i++) {
+                string index;
+                int &value = (i == 0 ? entry.mod : entry.chan);
+                isGood = (bool) (lineStream >> index);
+                if (isGood && index != "*")
+                    isGood = (istringstream(index) >> value) && value >= 0;
+            }
+
+            string value;
+            while (lineStream >> value)
+                entry.values.push_back(value);
+            isGood = isGood && entry.values.size() == (entry.tag == "Module" ? 3u : 1u);
+            if (isGood)
+                configuration_.push_back(entry);
+        } else
+            isGood = false;
+
+        if (!isGood) {
+            cout << Display::ErrorStr() << " Unable to understand line " << lineNumber << " of the emulator "
+                 << "configuration file " << fn << ": '" << line << "'\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int PixieEmulator::InitSystem(unsigned short numModules, unsigned short *slotMap) {
+    //Work out what each module and channel looks like before building anything, since the lines can come in any order.
+    ModuleSettings defaultModule = {"30474", 250, 14};
+    ChannelSettings defaultChannel = {0., 0};
+    vector<ModuleSettings> moduleSettings(numModules, defaultModule);
+    vector<vector<ChannelSettings> > channelSettings(numModules,
+                                                     vector<ChannelSettings>(NUMBER_OF_CHANNELS, defaultChannel));
+
+    for (vector<ConfigurationLine>::const_iterator it = configuration_.begin(); it != configuration_.end(); it++) {
+        if (it->mod >= (int) numModules || it->chan >= (int) NUMBER_OF_CHANNELS) {
+            cout << Display::WarningStr() << " Ignoring the emulator's " << it->tag << " line for module " << it->mod
+                 << ", channel " << it->chan << ", which isn't in the crate.\n";
+            continue;
+        }
+
+        for (unsigned short mod = 0; mod < numModules; mod++) {
+            if (it->mod >= 0 && it->mod != mod)
+                continue;
+            if (it->tag == "Module") {
+                moduleSettings[mod].firmware = it->values[0];
+                istringstream(it->values[1]) >> moduleSettings[mod].frequency;
+                istringstream(it->values[2]) >> moduleSettings[mod].adcBits;
+                continue;
+            }
+            for (unsigned short chan = 0; chan < NUMBER_OF_CHANNELS; chan++) {
+                if (it->chan >= 0 && it->chan != chan)
+                    continue;
+                if (it->tag == "Rate")
+                    istringstream(it->values[0]) >> channelSettings[mod][chan].rate;
+                else
+                    istringstream(it->values[0]) >> channelSettings[mod][chan].traceLength;
+            }
+        }
+    }
+
+    modules_.clear();
+    random_.seed(seed_);
+    for (unsigned short mod = 0; mod < numModules; mod++) {
+        const ModuleSettings &settings = moduleSettings[mod];
+        if (settings.frequency != 100 && settings.frequency != 250 && settings.frequency != 500) {
+            cout << Display::ErrorStr() << " Emulated module " << mod << " can't run at " << settings.frequency
+                 << " MS/s, only at 100, 250 or 500 MS/s.\n";
+            return -1;
+        }
+        if (settings.adcBits < 8 || settings.adcBits > 16) {
+            cout << Display::ErrorStr() << " Emulated module " << mod << " needs between 8 and 16 ADC bits.\n";
+            return -1;
+        }
+        for (unsigned short chan = 0; chan < NUMBER_OF_CHANNELS; chan++) {
+            const ChannelSettings &channel = channelSettings[mod][chan];
+            if (channel.rate < 0 || channel.traceLength % 2 != 0 || channel.traceLength > MAX_TRACE_LENGTH) {
+                cout << Display::ErrorStr() << " Emulated module " << mod << ", channel " << chan
+                     << " needs a positive rate and an even trace length of at most " << MAX_TRACE_LENGTH
+                     << " samples.\n";
+                return -1;
+            }
+        }
+
+        try {
+            modules_.push_back(Module(settings));
+        } catch (invalid_argument &ex) {
+            cout << Display::ErrorStr() << " Unable to emulate firmware " << settings.firmware << " at "
+                 << settings.frequency << " MS/s for module " << mod << ": " << ex.what() << "\n";
+            return -1;
+        }
+
+        Module &module = modules_.back();
+        module.slot = slotMap[mod];
+        module.channels = channelSettings[mod];
+        module.nextHit.assign(NUMBER_OF_CHANNELS, numeric_limits<double>::infinity());
+        module.hits.assign(NUMBER_OF_CHANNELS, 0);
+        module.accepted.assign(NUMBER_OF_CHANNELS, 0);
+        module.hitsSnapshot.assign(NUMBER_OF_CHANNELS, 0);
+        module.acceptedSnapshot.assign(NUMBER_OF_CHANNELS, 0);
+        module.moduleParameters["SlotID"] = slotMap[mod];
+        module.moduleParameters["ModID"] = mod;
+
+        //The pulse of each channel starts a quarter of the way into its trace and peaks at one.
+        module.pulses.resize(NUMBER_OF_CHANNELS);
+        for (unsigned short chan = 0; chan < NUMBER_OF_CHANNELS; chan++) {
+            vector<double> &pulse = module.pulses[chan];
+            pulse.assign(module.channels[chan].traceLength, 0.);
+            double peak = 0;
+            for (size_t i = pulse.size() / 4; i < pulse.size(); i++) {
+                const double t = i - pulse.size() / 4;
+                pulse[i] = exp(-t / DECAY_TIME) - exp(-t / RISE_TIME);
+                peak = max(peak, pulse[i]);
+            }
+            for (size_t i = 0; i < pulse.size() && peak > 0; i++)
+                pulse[i] /= peak;
+        }
+    }
+
+    return 0;
+}
+
+int PixieEmulator::ExitSystem(unsigned short numModules) {
+    for (vector<Module>::iterator it = modules_.begin(); it != modules_.end(); it++)
+        it->running = false;
+    return 0;
+}
+
+///The modules are all Rev. F, with serial numbers that count up from 1000.
+int PixieEmulator::ReadModuleInfo(unsigned short mod, unsigned short *rev, unsigned int *serNum,
+                                  unsigned short *adcBits, unsigned short *adcMsps) {
+    if (!IsValidModule(mod))
+        return -1;
+    *rev = 15;
+    *serNum = 1000 + mod;
+    *adcBits = (unsigned short) modules_[mod].settings.adcBits;
+    *adcMsps = (unsigned short) modules_[mod].settings.frequency;
+    return 0;
+}
+
+///A parameter that hasn't been written is zero.
+int PixieEmulator::ReadSglModPar(const char *name, unsigned int *val, unsigned short mod) {
+    if (!IsValidModule(mod))
+        return -1;
+    map<string, unsigned int>::const_iterator it = modules_[mod].moduleParameters.find(name);
+    *val = (it == modules_[mod].moduleParameters.end() ? 0 : it->second);
+    return 0;
+}
+
+int PixieEmulator::WriteSglModPar(const char *name, unsigned int val, unsigned short mod) {
+    if (!IsValidModule(mod))
+        return -1;
+    modules_[mod].moduleParameters[name] = val;
+    return 0;
+}
+
+///A parameter that hasn't been written is zero.
+int PixieEmulator::ReadSglChanPar(const char *name, double *val, unsigned short mod, unsigned short chan) {
+    if (!IsValidModule(mod) || chan >= NUMBER_OF_CHANNELS)
+        return -1;
+    map<string, vector<double> >::const_iterator it = modules_[mod].channelParameters.find(name);
+    *val = (it == modules_[mod].channelParameters.end() ? 0. : it->second[chan]);
+    return 0;
+}
+
+int PixieEmulator::WriteSglChanPar(const char *name, double val, unsigned short mod, unsigned short chan) {
+    if (!IsValidModule(mod) || chan >= NUMBER_OF_CHANNELS)
+        return -1;
+    vector<double> &values = modules_[mod].channelParameters[name];
+    values.resize(NUMBER_OF_CHANNELS, 0.);
+    values[chan] = val;
+    return 0;
+}
+
+int PixieEmulator::StartListModeRun(unsigned short mod, unsigned short listMode, unsigned short runMode) {
+    if (mod != modules_.size() && !IsValidModule(mod))
+        return -1;
+
+    //The clock starts over with a new run, unless another module is already running.
+    bool isRunning = false;
+    for (vector<Module>::const_iterator it = modules_.begin(); it != modules_.end(); it++)
+        isRunning = isRunning || it->running;
+    if (runMode == NEW_RUN && !isRunning)
+        runStart_ = chrono::steady_clock::now();
+    const double now = GetRunTime();
+
+    for (unsigned short i = 0; i < modules_.size(); i++) {
+        if (mod != modules_.size() && mod != i)
+            continue;
+
+        Module &module = modules_[i];
+        if (runMode == NEW_RUN) {
+            module.fifo.clear();
+            module.event.clear();
+            module.transferred = 0;
+            module.transferStart = module.transferEnd = now;
+            module.hits.assign(NUMBER_OF_CHANNELS, 0);
+            module.accepted.assign(NUMBER_OF_CHANNELS, 0);
+        }
+        for (unsigned short chan = 0; chan < NUMBER_OF_CHANNELS; chan++)
+            module.nextHit[chan] = now + NextInterval(module.channels[chan].rate);
+        module.running = true;
+    }
+
+    return 0;
+}
+
+int PixieEmulator::CheckRunStatus(unsigned short mod) {
+    if (!IsValidModule(mod))
+        return -1;
+    Module &module = modules_[mod];
+    Advance(module, GetRunTime());
+    return (module.running || module.transferred < module.event.size() || !module.fifo.empty()) ? 1 : 0;
+}
+
+int PixieEmulator::CheckExternalFIFOStatus(unsigned int *nWords, unsigned short mod) {
+    if (!IsValidModule(mod))
+        return -1;
+    Advance(modules_[mod], GetRunTime());
+    *nWords = (unsigned int) modules_[mod].fifo.size();
+    return 0;
+}
+
+int PixieEmulator::ReadDataFromExternalFIFO(unsigned int *buf, unsigned int nWords, unsigned short mod) {
+    if (!IsValidModule(mod) || nWords > modules_[mod].fifo.size())
+        return -1;
+    deque<unsigned int> &fifo = modules_[mod].fifo;
+    copy(fifo.begin(), fifo.begin() + nWords, buf);
+    fifo.erase(fifo.begin(), fifo.begin() + nWords);
+    return 0;
+}
+
+int PixieEmulator::EndRun(unsigned short mod) {
+    if (!IsValidModule(mod))
+        return -1;
+    Module &module = modules_[mod];
+    const double now = GetRunTime();
+    Advance(module, now);
+    module.running = false;
+    Advance(module, now);
+    return 0;
+}
+
+int PixieEmulator::ReadStatisticsFromModule(unsigned int *statistics, unsigned short mod) {
+    if (!IsValidModule(mod))
+        return -1;
+    Module &module = modules_[mod];
+    module.realTime = GetRunTime();
+    Advance(module, module.realTime);
+    module.hitsSnapshot = module.hits;
+    module.acceptedSnapshot = module.accepted;
+    return 0;
+}
+
+double PixieEmulator::ComputeInputCountRate(unsigned int *statistics, unsigned short mod, unsigned short chan) {
+    if (!IsValidModule(mod) || chan >= NUMBER_OF_CHANNELS || modules_[mod].realTime <= 0)
+        return 0;
+    return modules_[mod].hitsSnapshot[chan] / modules_[mod].realTime;
+}
+
+double PixieEmulator::ComputeOutputCountRate(unsigned int *statistics, unsigned short mod, unsigned short chan) {
+    if (!IsValidModule(mod) || chan >= NUMBER_OF_CHANNELS || modules_[mod].realTime <= 0)
+        return 0;
+    return modules_[mod].acceptedSnapshot[chan] / modules_[mod].realTime;
+}
+
+///The emulated channels are never dead.
+double PixieEmulator::ComputeLiveTime(unsigned int *statistics, unsigned short mod, unsigned short chan) {
+    return ComputeRealTime(statistics, mod);
+}
+
+double PixieEmulator::ComputeRealTime(unsigned int *statistics, unsigned short mod) {
+    if (!IsValidModule(mod))
+        return 0;
+    return modules_[mod].realTime;
+}
+
+double PixieEmulator::ComputeProcessedEvents(unsigned int *statistics, unsigned short mod) {
+    if (!IsValidModule(mod))
+        return 0;
+    double total = 0;
+    for (unsigned short chan = 0; chan < NUMBER_OF_CHANNELS; chan++)
+        total += modules_[mod].acceptedSnapshot[chan];
+    return total;
+}
+
+int PixieEmulator::Unsupported(const char *function) {
+    cout << Display::WarningStr() << " " << function << " is not available with an emulated crate.\n";
+    return -1;
+}
+
+double PixieEmulator::GetRunTime() {
+    return chrono::duration<double>(chrono::steady_clock::now() - runStart_).count();
+}
+
+///We don't use the distributions from <random> since their output is up to the standard library.
+double PixieEmulator::Uniform() {
+    return (random_() + 0.5) / 4294967296.;
+}
+
+double PixieEmulator::NextInterval(const double &rate) {
+    if (rate <= 0)
+        return numeric_limits<double>::infinity();
+    return -log(Uniform()) / rate;
+}
+
+///A module copies one hit at a time into its FIFO, hits that fire while it's busy copying or while the FIFO is full
+/// are lost. Once the run has ended the module finishes the hit that it started straight away.
+void PixieEmulator::Advance(Module &module, const double &now) {
+    while (true) {
+        if (module.transferred < module.event.size()) {
+            size_t target = module.event.size();
+            if (module.running)
+                target = (size_t) min((double) target, max(0., (now - module.transferStart) * transferRate_));
+            while (module.transferred < target && module.fifo.size() < EXTERNAL_FIFO_LENGTH)
+                module.fifo.push_back(module.event[module.transferred++]);
+
+            if (module.transferred < module.event.size()) {
+                for (unsigned short chan = 0; chan < NUMBER_OF_CHANNELS && module.running; chan++) {
+                    for (; module.nextHit[chan] <= now; module.nextHit[chan] += NextInterval(module.channels[chan].rate))
+                        module.hits[chan]++;
+                }
+                return;
+            }
+            module.transferEnd = max(module.transferStart + module.event.size() / transferRate_,
+                                     (target < module.event.size() ? now : 0.));
+        }
+
+        if (!module.running)
+            return;
+
+        vector<double>::iterator next = min_element(module.nextHit.begin(), module.nextHit.end());
+        if (*next > now)
+            return;
+
+        const unsigned int chan = (unsigned int) (next - module.nextHit.begin());
+        const double time = *next;
+        *next += NextInterval(module.channels[chan].rate);
+        module.hits[chan]++;
+        if (time < module.transferEnd || module.fifo.size() >= EXTERNAL_FIFO_LENGTH)
+            continue;
+
+        module.accepted[chan]++;
+        EncodeHit(module, chan, time);
+        module.transferStart = time;
+    }
+}
+
+///The energies come from an exponential continuum, and the trace is a single pulse with a little noise.
+void PixieEmulator::EncodeHit(Module &module, const unsigned int &chan, const double &time) {
+    XiaData data;
+    data.SetCrateNumber(0);
+    data.SetSlotNumber(module.slot);
+    data.SetChannelNumber(chan);
+
+    const unsigned long long ticks = (unsigned long long) (time * 1.e9 / module.clockPeriod);
+    data.SetEventTimeLow((unsigned int) (ticks & 0xFFFFFFFF));
+    data.SetEventTimeHigh((unsigned int) (ticks >> 32));
+    data.SetCfdFractionalTime(1 + (unsigned int) (Uniform() * (module.cfdSize - 2)));
+
+    const double energy = min(max(-MEAN_ENERGY * log(Uniform()), 1.), MAX_ENERGY);
+    data.SetEnergy(floor(energy));
+
+    const vector<double> &pulse = module.pulses[chan];
+    if (!pulse.empty()) {
+        const double maximum = (1 << module.settings.adcBits) - 1;
+        const double amplitude = energy * maximum / MAX_ENERGY;
+        bool isSaturated = false;
+        trace_.resize(pulse.size());
+        for (size_t i = 0; i < pulse.size(); i++) {
+            double value = BASELINE + amplitude * pulse[i] + (double) (random_() % 5) - 2.;
+            if (value > maximum) {
+                value = maximum;
+                isSaturated = true;
+            }
+            trace_[i] = (unsigned short) value;
+        }
+        data.SetSaturation(isSaturated);
+        data.SetTrace(&trace_[0], &trace_[0] + trace_.size());
+    }
+
+    module.event = module.encoder.EncodeXiaData(data);
+    module.transferred = 0;
+}
+
+bool PixieEmulator::IsValidModule(const unsigned short &mod) {
+    if (mod < modules_.size())
+        return true;
+    cout << Display::WarningStr() << " Module " << mod << " is not in the emulated crate.\n";
+    return false;
+}
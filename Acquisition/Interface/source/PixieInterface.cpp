@@ -15,6 +15,14 @@
 #include "Display.h"
 #include "PixieInterface.h"
 
+#ifdef PIF_EMULATOR
+#include "PixieEmulator.h"
+///Calls the emulated crate instead of the Pixie-16 API when there is one.
+#define PIXIE16_CALL(api, emulated) (emulator ? emulator->emulated : api)
+#else
+#define PIXIE16_CALL(api, emulated) (api)
+#endif
+
 using namespace std;
 using namespace Display;
 
@@ -95,7 +103,7 @@ bool PixieInterface::Histogram::Write(ofstream &out) {
     return true;
 }
 
-PixieInterface::PixieInterface(const char *fn) : lock("PixieInterface") {
+PixieInterface::PixieInterface(const char *fn) : doneInit(false), lock("PixieInterface") {
     SetColorTerm();
     // Set-up valid configuration keys if they don't exist yet
     if (validConfigKeys.empty()) {
@@ -114,6 +122,7 @@ PixieInterface::PixieInterface(const char *fn) : lock("PixieInterface") {
         validConfigKeys.insert("ListModeFile");
         validConfigKeys.insert("SlotFile");
         validConfigKeys.insert("CrateConfig");
+        validConfigKeys.insert("EmulatorFile");
     }
     if (!ReadConfigurationFile(fn)) {
         std::cout << Display::ErrorStr()
@@ -129,19 +138,42 @@ PixieInterface::PixieInterface(const char *fn) : lock("PixieInterface") {
     //Overwrite the default path 'pxisys.ini' with the one specified in the scan file.
     PCISysIniFile = configStrings["global"]["CrateConfig"].c_str();
 
+#ifdef PIF_EMULATOR
+    emulator = NULL;
+#endif
+    //The EmulatorFile tag swaps the crate for one that is emulated in software.
+    map<string, string>::const_iterator emulatorFile = configStrings["global"].find("EmulatorFile");
+    if (emulatorFile != configStrings["global"].end()) {
+#ifdef PIF_EMULATOR
+        emulator = new PixieEmulator();
+        if (!emulator->ReadConfigurationFile(emulatorFile->second.c_str())) {
+            std::cout << Display::ErrorStr() << " Unable to read emulator configuration file: '"
+                      << emulatorFile->second << "'\n";
+            exit(EXIT_FAILURE);
+        }
+        std::cout << Display::WarningStr() << " Using an emulated crate, no data will be taken from the modules.\n";
+#else
+        std::cout << Display::ErrorStr() << " The EmulatorFile tag needs the crate emulator, which is only built "
+                  << "along with the analysis libraries.\n";
+        exit(EXIT_FAILURE);
+#endif
+    }
 }
 
 PixieInterface::~PixieInterface() {
-    if (!doneInit)
-        return;
+    if (doneInit) {
+        if (CheckRunStatus())
+            EndRun();
 
-    if (CheckRunStatus())
-        EndRun();
+        LeaderPrint("Closing Pixie interface");
 
-    LeaderPrint("Closing Pixie interface");
+        retval = PIXIE16_CALL(Pixie16ExitSystem(numberCards), ExitSystem(numberCards));
+        CheckError();
+    }
 
-    retval = Pixie16ExitSystem(numberCards);
-    CheckError();
+#ifdef PIF_EMULATOR
+    delete emulator;
+#endif
 }
 
 std::string PixieInterface::ParseModuleTypeTag(std::string value) {
@@ -376,7 +408,7 @@ bool PixieInterface::GetSlots(const char *slotF) {
 bool PixieInterface::Init(bool offlineMode) {
     LeaderPrint("Initializing Pixie");
 
-    retval = Pixie16InitSystem(numberCards, slotMap, offlineMode);
+    retval = PIXIE16_CALL(Pixie16InitSystem(numberCards, slotMap, offlineMode), InitSystem(numberCards, slotMap));
     doneInit = !CheckError(true);
 
     return doneInit;
@@ -389,6 +421,12 @@ bool PixieInterface::Boot(int mode, bool useWorkingSetFile) {
 
     LeaderPrint("Boot Configuration");
 
+    //There's nothing to load into the emulated modules.
+    if (IsEmulated()) {
+        cout << OkayStr("[EMULATED]") << endl;
+        return true;
+    }
+
     //Loop through each module and determine its type.
     //We also check if the modules are all the same. If not we set multiConf to true.
     bool multiConf = false;
@@ -512,8 +550,8 @@ bool PixieInterface::WriteSglModPar(const char *name, word_t val, int mod,
                                     word_t &pval) {
     strncpy(tmpName, name, nameSize);
 
-    Pixie16ReadSglModPar(tmpName, &pval, mod);
-    retval = Pixie16WriteSglModPar(tmpName, val, mod);
+    PIXIE16_CALL(Pixie16ReadSglModPar(tmpName, &pval, mod), ReadSglModPar(tmpName, &pval, mod));
+    retval = PIXIE16_CALL(Pixie16WriteSglModPar(tmpName, val, mod), WriteSglModPar(tmpName, val, mod));
     if (retval < 0) {
         cout << "Error writing module parameter " << WarningStr(name)
              << " for module " << mod << endl;
@@ -525,7 +563,7 @@ bool PixieInterface::WriteSglModPar(const char *name, word_t val, int mod,
 bool PixieInterface::ReadSglModPar(const char *name, word_t &val, int mod) {
     strncpy(tmpName, name, nameSize);
 
-    retval = Pixie16ReadSglModPar(tmpName, &val, mod);
+    retval = PIXIE16_CALL(Pixie16ReadSglModPar(tmpName, &val, mod), ReadSglModPar(tmpName, &val, mod));
     if (retval < 0) {
         cout << "Error reading module parameter " << WarningStr(name)
              << " for module " << mod << endl;
@@ -569,8 +607,8 @@ PixieInterface::WriteSglChanPar(const char *name, double val, int mod, int chan,
                                 double &pval) {
     strncpy(tmpName, name, nameSize);
 
-    Pixie16ReadSglChanPar(tmpName, &pval, mod, chan);
-    retval = Pixie16WriteSglChanPar(tmpName, val, mod, chan);
+    PIXIE16_CALL(Pixie16ReadSglChanPar(tmpName, &pval, mod, chan), ReadSglChanPar(tmpName, &pval, mod, chan));
+    retval = PIXIE16_CALL(Pixie16WriteSglChanPar(tmpName, val, mod, chan), WriteSglChanPar(tmpName, val, mod, chan));
     if (retval < 0) {
         cout << "Error writing channel parameter " << WarningStr(name)
              << " for module " << mod << ", channel " << chan << endl;
@@ -583,7 +621,7 @@ bool PixieInterface::ReadSglChanPar(const char *name, double &pval, int mod,
                                     int chan) {
     strncpy(tmpName, name, nameSize);
 
-    retval = Pixie16ReadSglChanPar(tmpName, &pval, mod, chan);
+    retval = PIXIE16_CALL(Pixie16ReadSglChanPar(tmpName, &pval, mod, chan), ReadSglChanPar(tmpName, &pval, mod, chan));
     if (retval < 0) {
         cout << "Error reading channel parameter " << WarningStr(name)
              << " for module " << mod << ", channel " << chan << endl;
@@ -624,12 +662,12 @@ bool PixieInterface::SaveDSPParameters(const char *fn) {
 
     LeaderPrint("Writing DSP parameters");
 
-    retval = Pixie16SaveDSPParametersToFile(tmpName);
+    retval = PIXIE16_CALL(Pixie16SaveDSPParametersToFile(tmpName), Unsupported("Pixie16SaveDSPParametersToFile"));
     return !CheckError();
 }
 
 bool PixieInterface::AcquireTraces(int mod) {
-    retval = Pixie16AcquireADCTrace(mod);
+    retval = PIXIE16_CALL(Pixie16AcquireADCTrace(mod), Unsupported("Pixie16AcquireADCTrace"));
 
     if (retval < 0) {
         cout << ErrorStr("Error acquiring ADC traces from module ") << mod
@@ -647,7 +685,7 @@ bool PixieInterface::ReadSglChanTrace(unsigned short *buf, unsigned long sz,
         return false;
     }
 
-    retval = Pixie16ReadSglChanADCTrace(buf, sz, mod, chan);
+    retval = PIXIE16_CALL(Pixie16ReadSglChanADCTrace(buf, sz, mod, chan), Unsupported("Pixie16ReadSglChanADCTrace"));
 
     if (retval < 0) {
         cout << ErrorStr("Error reading trace in module ") << mod << endl;
@@ -658,7 +696,7 @@ bool PixieInterface::ReadSglChanTrace(unsigned short *buf, unsigned long sz,
 }
 
 bool PixieInterface::GetStatistics(unsigned short mod) {
-    retval = Pixie16ReadStatisticsFromModule(statistics, mod);
+    retval = PIXIE16_CALL(Pixie16ReadStatisticsFromModule(statistics, mod), ReadStatisticsFromModule(statistics, mod));
 
     if (retval < 0) {
         cout << WarningStr("Error reading statistics from module ") << mod
@@ -670,35 +708,37 @@ bool PixieInterface::GetStatistics(unsigned short mod) {
 }
 
 double PixieInterface::GetInputCountRate(int mod, int chan) {
-    return Pixie16ComputeInputCountRate(statistics, mod, chan);
+    return PIXIE16_CALL(Pixie16ComputeInputCountRate(statistics, mod, chan),
+                        ComputeInputCountRate(statistics, mod, chan));
 }
 
 double PixieInterface::GetOutputCountRate(int mod, int chan) {
-    return Pixie16ComputeOutputCountRate(statistics, mod, chan);
+    return PIXIE16_CALL(Pixie16ComputeOutputCountRate(statistics, mod, chan),
+                        ComputeOutputCountRate(statistics, mod, chan));
 }
 
 double PixieInterface::GetLiveTime(int mod, int chan) {
-    return Pixie16ComputeLiveTime(statistics, mod, chan);
+    return PIXIE16_CALL(Pixie16ComputeLiveTime(statistics, mod, chan), ComputeLiveTime(statistics, mod, chan));
 }
 
 double PixieInterface::GetRealTime(int mod) {
-    return Pixie16ComputeRealTime(statistics, mod);
+    return PIXIE16_CALL(Pixie16ComputeRealTime(statistics, mod), ComputeRealTime(statistics, mod));
 }
 
 double PixieInterface::GetProcessedEvents(int mod) {
-    return Pixie16ComputeProcessedEvents(statistics, mod);
+    return PIXIE16_CALL(Pixie16ComputeProcessedEvents(statistics, mod), ComputeProcessedEvents(statistics, mod));
 }
 
 bool PixieInterface::StartHistogramRun(unsigned short mode) {
     LeaderPrint("Starting histogram run");
-    retval = Pixie16StartHistogramRun(numberCards, mode);
+    retval = PIXIE16_CALL(Pixie16StartHistogramRun(numberCards, mode), Unsupported("Pixie16StartHistogramRun"));
 
     return !CheckError();
 }
 
 bool
 PixieInterface::StartHistogramRun(unsigned short mod, unsigned short mode) {
-    retval = Pixie16StartHistogramRun(mod, mode);
+    retval = PIXIE16_CALL(Pixie16StartHistogramRun(mod, mode), Unsupported("Pixie16StartHistogramRun"));
 
     if (retval < 0) {
         cout << ErrorStr("Error starting histogram run in module ") << mod
@@ -711,7 +751,8 @@ PixieInterface::StartHistogramRun(unsigned short mod, unsigned short mode) {
 bool PixieInterface::StartListModeRun(unsigned short listMode,
                                       unsigned short runMode) {
     LeaderPrint("Starting list mode run");
-    retval = Pixie16StartListModeRun(numberCards, listMode, runMode);
+    retval = PIXIE16_CALL(Pixie16StartListModeRun(numberCards, listMode, runMode),
+                          StartListModeRun(numberCards, listMode, runMode));
 
     return !CheckError();
 }
@@ -719,7 +760,7 @@ bool PixieInterface::StartListModeRun(unsigned short listMode,
 bool PixieInterface::StartListModeRun(unsigned short mod,
                                       unsigned short listMode,
                                       unsigned short runMode) {
-    retval = Pixie16StartListModeRun(mod, listMode, runMode);
+    retval = PIXIE16_CALL(Pixie16StartListModeRun(mod, listMode, runMode), StartListModeRun(mod, listMode, runMode));
 
     if (retval < 0) {
         cout << ErrorStr("Error starting list mode run in module ") << mod
@@ -740,7 +781,7 @@ bool PixieInterface::CheckRunStatus() {
 }
 
 bool PixieInterface::CheckRunStatus(int mod) {
-    retval = Pixie16CheckRunStatus(mod);
+    retval = PIXIE16_CALL(Pixie16CheckRunStatus(mod), CheckRunStatus(mod));
 
     if (retval < 0) {
         cout << WarningStr("Error checking run status in module ") << mod
@@ -758,7 +799,7 @@ unsigned long PixieInterface::CheckFIFOWords(unsigned short mod)
   // word_t nWords;
   unsigned int nWords;
 
-  retval = Pixie16CheckExternalFIFOStatus(&nWords, mod);
+  retval = PIXIE16_CALL(Pixie16CheckExternalFIFOStatus(&nWords, mod), CheckExternalFIFOStatus(&nWords, mod));
 
   if (retval < 0) {
     cout << WarningStr("Error checking FIFO status in module ") << mod << endl;
@@ -785,7 +826,8 @@ bool PixieInterface::ReadFIFOWords(word_t *buf, unsigned long nWords,
                 std::cout << Display::ErrorStr() << " Not enough words available in module " << mod << "'s FIFO for read! (" << availWords << "/" << MIN_FIFO_READ << ")\n";
                 return false;
             }
-            retval = Pixie16ReadDataFromExternalFIFO(minibuf, MIN_FIFO_READ, mod);
+            retval = PIXIE16_CALL(Pixie16ReadDataFromExternalFIFO(minibuf, MIN_FIFO_READ, mod),
+                                  ReadDataFromExternalFIFO(minibuf, MIN_FIFO_READ, mod));
 
             if (retval < 0) {
                 cout << WarningStr("Error reading words from FIFO in module ") << mod << " retVal " << retval << endl;
@@ -815,7 +857,7 @@ bool PixieInterface::ReadFIFOWords(word_t *buf, unsigned long nWords,
         std::cout << Display::ErrorStr() << " Not enough words available in module " << mod << "'s FIFO for read! (" << availWords << "/" << nWords << ")\n";
         return false;
     }
-    retval = Pixie16ReadDataFromExternalFIFO(buf, nWords, mod);
+    retval = PIXIE16_CALL(Pixie16ReadDataFromExternalFIFO(buf, nWords, mod), ReadDataFromExternalFIFO(buf, nWords, mod));
 
     if (retval < 0) {
         cout << WarningStr("Error reading words from FIFO in module ") << mod << " retVal " << retval << endl;
@@ -846,7 +888,7 @@ bool PixieInterface::EndRun() {
 }
 
 bool PixieInterface::EndRun(int mod) {
-    retval = Pixie16EndRun(mod);
+    retval = PIXIE16_CALL(Pixie16EndRun(mod), EndRun(mod));
 
     if (retval < 0) {
         cout << WarningStr("Failed to end run in module ") << mod << endl;
@@ -878,7 +920,8 @@ bool PixieInterface::ReadHistogram(word_t *hist, unsigned long sz,
         return false;
     }
 
-    retval = Pixie16ReadHistogramFromModule(hist, sz, mod, ch);
+    retval = PIXIE16_CALL(Pixie16ReadHistogramFromModule(hist, sz, mod, ch),
+                          Unsupported("Pixie16ReadHistogramFromModule"));
 
     if (retval < 0) {
         cout << ErrorStr("Failed to get histogram data from module ") << mod
@@ -890,7 +933,7 @@ bool PixieInterface::ReadHistogram(word_t *hist, unsigned long sz,
 
 bool PixieInterface::AdjustOffsets(unsigned short mod) {
     LeaderPrint("Adjusting Offsets");
-    retval = Pixie16AdjustOffsets(mod);
+    retval = PIXIE16_CALL(Pixie16AdjustOffsets(mod), Unsupported("Pixie16AdjustOffsets"));
 
     return !CheckError();
 }
@@ -1015,5 +1058,6 @@ PixieInterface::GetModuleInfo(const unsigned short &mod, unsigned short *rev,
                               unsigned int *serNum, unsigned short *adcBits,
                               unsigned short *adcMsps) {
     //Return false if error code provided.
-    return (Pixie16ReadModuleInfo(mod, rev, serNum, adcBits, adcMsps) == 0);
+    return (PIXIE16_CALL(Pixie16ReadModuleInfo(mod, rev, serNum, adcBits, adcMsps),
+                         ReadModuleInfo(mod, rev, serNum, adcBits, adcMsps)) == 0);
 }
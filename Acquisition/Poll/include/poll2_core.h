@@ -18,6 +18,7 @@
 #ifndef POLL2_CORE_H
 #define POLL2_CORE_H
 
+#include <mutex>
 #include <vector>
 
 #include "PixieInterface.h"
@@ -97,7 +98,9 @@ struct data_pack{
 // Forward class declarations
 class StatsHandler;
 class Client;
+class PollDiskWriter;
 class Server;
+class SpillRingWriter;
 class Terminal;
 
 class Poll{
@@ -112,6 +115,8 @@ private:
     struct tm *time_info;
 
     Client *client; /// UDP client for network access
+    SpillRingWriter *spill_ring; /// Shared memory ring that the spills are written to in shm mode
+    std::mutex spill_ring_mutex; /// Held while the ring is opened or closed, so that the command thread can look at it
     Server *server; /// UDP server to listen for pacman commands
 
     PixieInterface *pif; /// The main pixie interface pointer
@@ -156,6 +161,9 @@ private:
     // The main output data file and related variables
     int current_file_num;
     PollOutputFile output_file;
+    PollDiskWriter *disk_writer; /// Writes the spills to output_file on a thread of its own
+    unsigned int disk_buffers; /// The number of spill buffers that the disk writer has
+    word_t *fifoData; /// The buffer that the next spill is read into, from the disk writer's pool
 
     size_t n_cards;
     size_t threshWords;
@@ -197,6 +205,12 @@ private:
     /// Display polling threshold.
     void show_thresh();
 
+    /// Display the consumers of the shared memory ring and how many spills each of them has dropped.
+    void show_consumers();
+
+    /// Open or close the shared memory ring to match shm_mode. Only called from the run control thread.
+    void update_spill_ring();
+
     /// Acquire raw traces from a pixie module.
     void get_traces(int mod_, int chan_, int thresh_=0);
 
@@ -224,7 +238,10 @@ private:
     /// Opens a new file if no file is currently open.
     bool OpenOutputFile(bool continueRun = false);
 
-    /// Write a data spill to disk.
+    /// Replace the output file with a continuation file once it is full. Only called from the disk writer thread.
+    bool rollover_output_file();
+
+    /// Queue a data spill to be written to disk.
     int write_data(word_t *data, unsigned int nWords);
 
     /// Broadcast a data spill onto the network.
@@ -271,6 +288,8 @@ public:
 
     void SetThreshWords(const size_t &thresh_){ threshWords = thresh_; }
 
+    void SetDiskBuffers(const unsigned int &buffers_){ disk_buffers = buffers_; }
+
     ///Set the terminal pointer.
     void SetTerminal(Terminal *term){ poll_term_ = term; };
 
@@ -295,6 +314,8 @@ public:
 
     size_t GetThreshWords(){ return threshWords; }
 
+    unsigned int GetDiskBuffers(){ return disk_buffers; }
+
     ///\brief Prints the information about each module.
     void PrintModuleInfo();
 
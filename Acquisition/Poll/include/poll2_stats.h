@@ -35,6 +35,10 @@ public:
     void
     SetXiaRates(int mod, std::vector <std::pair<double, double>> *xiaRates);
 
+    ///Set the depth of the disk writer's queue and its write latency in ms, sent at the end of the next dump.
+    void SetWriterStats(double meanDepth, double maxDepth, double meanLatency,
+                        double maxLatency);
+
     bool CanSend() { return is_able_to_send; }
 
     ///Clear the stats.
@@ -67,6 +71,8 @@ private:
     double **inputCountRate; ///<The XIA Module input count rate.
     double **outputCountRate; ///<The XIA Module output count rate.
 
+    double writerStats[4]; ///<The mean and max disk writer queue depth and write latency.
+
     /** calculated data rate in bytes per second for each module */
     size_t *calcDataRate;
 
@@ -0,0 +1,128 @@
+/** \file poll2_writer.h
+  *
+  * \brief Writes the spills to the poll2 output file on a thread of its own
+  *
+  * The run control thread reads each spill straight into one of a fixed
+  * pool of buffers and queues it here, so that it can go back to reading
+  * the FIFOs while the spill is written. A slow disk only holds up the run
+  * control thread once every buffer in the pool is waiting to be written.
+  * The output file is also replaced by a new one on the writer thread when
+  * it grows too large.
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+*/
+
+#ifndef POLL2_WRITER_H
+#define POLL2_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+class Client;
+class PollOutputFile;
+
+class PollDiskWriter {
+public:
+    /** Allocate depth_ buffers of bufferWords_ words and start the writer thread. rollover_ is called on the writer
+      * thread to replace the output file when the next spill would push it past maxFileSize_ bytes, it returns false
+      * if the new file could not be opened. */
+    PollDiskWriter(PollOutputFile *file_, const size_t &bufferWords_, const unsigned int &depth_,
+                   const std::streampos &maxFileSize_, const std::function<bool()> &rollover_);
+
+    /// Write whatever is still queued and stop the writer thread.
+    ~PollDiskWriter();
+
+    /// Return an empty buffer to read a spill into, waiting for a spill to be written if every buffer is queued.
+    uint32_t *GetBuffer();
+
+    /** Queue the first nWords_ of a buffer from GetBuffer to be written to the output file. The buffer goes back to
+      * the pool once it has been written. If client_ isn't NULL, a spill notification is sent to it once the spill
+      * is in the file. */
+    void Write(uint32_t *buffer_, const unsigned int &nWords_, Client *client_ = NULL);
+
+    /// Wait until everything that has been queued is written.
+    void Flush();
+
+    /// Return the mutex that the writer thread holds while it uses the output file.
+    std::mutex &GetFileMutex() { return fileMutex; }
+
+    /// Return true if the writer thread replaced the output file since the last call.
+    bool HasRolledOver() { return rolledOver.exchange(false); }
+
+    /// Return true if a spill could not be written since the last call.
+    bool HadError() { return writeError.exchange(false); }
+
+    /// Update the size and name that GetFilesize and GetFilename return, after the file was opened or closed.
+    void UpdateFileStatus();
+
+    /// Return the size of the output file after the last spill was written, in bytes.
+    std::streampos GetFilesize();
+
+    /// Return the name of the output file that the last spill was written to.
+    std::string GetFilename();
+
+    /** Get the mean and maximum number of spills that were waiting to be written when a spill was queued, and the
+      * mean and maximum time in ms that it took to write a spill, since the last call. */
+    void GetStats(double &meanDepth_, double &maxDepth_, double &meanLatency_, double &maxLatency_);
+
+private:
+    /// A spill that is waiting to be written.
+    struct Job {
+        uint32_t *buffer; /// One of the buffers of the pool.
+        unsigned int nWords; /// The number of words of the spill.
+        Client *client; /// Sent a spill notification once the spill is written, if not NULL.
+    };
+
+    PollOutputFile *file; /// The output file, only used while fileMutex is held.
+    std::streampos maxFileSize; /// The size in bytes that the output file may not grow past.
+    std::function<bool()> rollover; /// Replaces the output file with a new one.
+    std::vector<std::vector<uint32_t> > buffers; /// The storage of the pool.
+    std::thread thread; /// Writes the queued spills.
+
+    std::mutex fileMutex; /// Held while the output file is used.
+    std::atomic<bool> rolledOver; /// True if the output file was replaced.
+    std::atomic<bool> writeError; /// True if a spill could not be written.
+
+    std::mutex queueMutex; /// Protects everything below.
+    std::condition_variable queued; /// Signaled when a spill is queued or the thread should stop.
+    std::condition_variable written; /// Signaled when a spill has been written.
+    std::deque<Job> queue; /// The spills waiting to be written, oldest first.
+    std::vector<uint32_t *> pool; /// The buffers that aren't queued or being read into.
+    bool writing; /// True while the thread is writing a spill.
+    bool stopping; /// True when the thread should stop once the queue is empty.
+    std::streampos filesize; /// The size of the output file after the last write.
+    std::string filename; /// The name of the output file.
+    uint64_t depthSamples; /// The number of spills queued since the last GetStats.
+    double depthSum; /// The sum of the depth of the queue when each of them was queued.
+    unsigned int depthMax; /// The deepest that the queue was.
+    uint64_t writes; /// The number of spills written since the last GetStats.
+    double latencySum; /// The total time spent writing them, in ms.
+    double latencyMax; /// The longest time that a spill took to write, in ms.
+
+    /// The loop that writes the queued spills until the writer is destroyed.
+    void Run();
+
+    /// Write a spill to the output file, replacing the file first if it would get too large. Return false on failure.
+    bool WriteSpill(const Job &job_);
+
+    /// Update filesize and filename, with fileMutex held.
+    void UpdateFileStatusLocked();
+
+    /// Copying would hand the same buffers out twice.
+    PollDiskWriter(const PollDiskWriter &);
+
+    PollDiskWriter &operator=(const PollDiskWriter &);
+};
+
+#endif
@@ -129,7 +129,7 @@ std::string GetTimeString(double input_) {
 }
 
 int main() {
-    const size_t msg_size = 5844;// 5.8 kB of stats data max
+    const size_t msg_size = 5876;// 5.9 kB of stats data max
     const int modColumnWidth = 25;
     char buffer[msg_size];
     Server poll_server;
@@ -141,6 +141,7 @@ int main() {
     double **inputCountRate = NULL;
     double **outputCountRate = NULL;
     unsigned int **totals = NULL;
+    double writerStats[4];
 
     bool first_packet = true;
     if (poll_server.Init(5556)) {
@@ -149,7 +150,7 @@ int main() {
         while (true) {
             std::cout << std::setprecision(2);
 
-            poll_server.RecvMessage(buffer, msg_size);
+            int recv_bytes = poll_server.RecvMessage(buffer, msg_size);
             char *ptr = buffer;
 
             if (strcmp(buffer, "$KILL_SOCKET") == 0) {
@@ -180,6 +181,10 @@ int main() {
             // ...
             // channel N-1, 15 rate
             // channel N-1, 15 total
+            // 8 byte mean disk writer queue depth (in spills)
+            // 8 byte max disk writer queue depth (in spills)
+            // 8 byte mean disk write latency (in ms)
+            // 8 byte max disk write latency (in ms)
             memcpy(&num_modules, ptr, 4);
             ptr += 4;
 
@@ -214,11 +219,22 @@ int main() {
                 }
             }
 
+            // Older versions of poll2 don't send the disk writer stats.
+            bool hasWriterStats = (ptr - buffer) + (int) sizeof(writerStats) <= recv_bytes;
+            if (hasWriterStats)
+                memcpy(writerStats, ptr, sizeof(writerStats));
+
             // Display the rate information
             std::cout << "Run Time: " << GetTimeString(time_in_sec);
             if (num_modules > 1) std::cout << "\t";
             else std::cout << "\n";
             std::cout << "Data Rate: " << GetRateString(data_rate) << std::endl;
+            if (hasWriterStats) {
+                std::cout << "Disk Queue: " << writerStats[0] << " / "
+                          << writerStats[1] << " spills (mean / max)\t";
+                std::cout << "Write Latency: " << writerStats[2] << " / "
+                          << writerStats[3] << " ms (mean / max)\n";
+            }
             std::cout << "   ";
             for (unsigned int i = 0; i < (unsigned int) num_modules; i++) {
                 std::cout << "|"
@@ -34,6 +34,7 @@ void help(const char *progName_) {
     std::cout << "  --rates               | Display module rates in quiet mode (false by defualt)\n";
     std::cout << "  --thresh (-t) <num>   | Sets FIFO read threshold to num% full (50% by default)\n";
     std::cout << "  --zero                | Zero clocks on each START_ACQ (false by default)\n";
+    std::cout << "  --disk-buffers <num>  | Number of spills that may be waiting to be written to disk (8 by default)\n";
     std::cout << "  --debug (-d)          | Set debug mode to true (false by default)\n";
     std::cout << "  --help (-h)           | Display this help dialogue.\n\n";
 }
@@ -59,6 +60,7 @@ int main(int argc, char *argv[]) {
             {"rates",         no_argument,       NULL, 0},
             {"thresh",        required_argument, NULL, 't'},
             {"zero",          no_argument,       NULL, 0},
+            {"disk-buffers",  required_argument, NULL, 0},
             {"debug",         no_argument,       NULL, 'd'},
             {"help",          no_argument,       NULL, 'h'},
             {"prefix",        no_argument,       NULL, 0},
@@ -115,6 +117,14 @@ int main(int argc, char *argv[]) {
                     poll.SetShowRates();
                 } else if (strcmp("zero", longOpts[idx].name) == 0) { // --zero
                     poll.SetZeroClocks();
+                } else if (strcmp("disk-buffers", longOpts[idx].name) == 0) { // --disk-buffers
+                    int buffers = atoi(optarg);
+                    if (buffers <= 0) {
+                        std::cout << Display::ErrorStr() << " Failed to set the number of disk buffers to ("
+                                  << optarg << ")!\n";
+                        return 1;
+                    }
+                    poll.SetDiskBuffers(buffers);
                 }
                 break;
             case '?' :
@@ -36,6 +36,8 @@
 #include "poll2_core.h"
 #include "poll2_socket.h"
 #include "poll2_stats.h"
+#include "poll2_writer.h"
+#include "SpillRing.h"
 
 #include "CTerminal.h"
 #include "StringManipulationFunctions.hpp"
@@ -51,15 +53,9 @@
 // Adjusted to help alleviate the issue with data corruption
 #define POLL_TRIES 100
 
-// Length of shm packet header (in bytes)
-#define PKT_HEAD_LEN 8
-
 // 2 GB. Maximum allowable .ldf file size in bytes
 #define MAX_FILE_SIZE 2147483648ll
 
-// Maximum shm packet size (in bytes)
-#define MAX_PKT_DATA (MAX_ORPH_DATA - PKT_HEAD_LEN)
-
 std::vector<std::string> chan_params = {"TRIGGER_RISETIME", "TRIGGER_FLATTOP", "TRIGGER_THRESHOLD", "ENERGY_RISETIME",
                                         "ENERGY_FLATTOP", "TAU", "TRACE_LENGTH", "TRACE_DELAY", "VOFFSET", "XDT",
                                         "BASELINE_PERCENT", "EMIN", "BINFACTOR", "CHANNEL_CSRA", "CHANNEL_CSRB", "BLCUT",
@@ -75,14 +71,14 @@ std::vector<std::string> mod_params = {"MODULE_CSRA", "MODULE_CSRB", "MODULE_FOR
 
 const std::vector<std::string> Poll::runControlCommands_ ({"run", "stop",
                                                            "startacq", "startvme", "stopacq", "stopvme", "timedrun", "acq", "shm", "spill",
-                                                           "hup", "prefix", "fdir", "title", "runnum", "oform", "close", "reboot", "stats",
+                                                           "hup", "prefix", "fdir", "title", "runnum", "oform", "tcomp", "close", "reboot", "stats",
                                                            "mca"});
 
 const std::vector<std::string> Poll::paramControlCommands_ ({"dump", "pread",
                                                              "pmread", "pwrite", "pmwrite", "adjust_offsets", "find_tau", "toggle",
                                                              "toggle_bit", "csr_test", "bit_test", "get_traces", "save"});
 
-const std::vector<std::string> Poll::pollStatusCommands_ ({"status", "thresh",
+const std::vector<std::string> Poll::pollStatusCommands_ ({"status", "thresh", "consumers",
                                                            "debug", "quiet", "quit", "help", "version"});
 
 MCA_args::MCA_args(){
@@ -179,7 +175,10 @@ Poll::Poll() :
         output_title("PIXIE data file"), // Set with 'title' command
         next_run_num(1), // Set with 'runnum' command
         output_format(0), // Set with 'oform' command
-        current_file_num(0)
+        current_file_num(0),
+        disk_writer(NULL),
+        disk_buffers(8),
+        fifoData(NULL)
 {
     pif = new PixieInterface("pixie.cfg");
 
@@ -195,7 +194,7 @@ Poll::Poll() :
     else{ std::cout << Display::WarningStr("UNEXPECTED") << std::endl; }
 
     client = new Client();
-
+    spill_ring = new SpillRingWriter();
 }
 
 Poll::~Poll(){
@@ -203,6 +202,7 @@ Poll::~Poll(){
         Close();
     }
 
+    delete spill_ring;
     delete pif;
 }
 
@@ -260,6 +260,10 @@ bool Poll::Initialize(){
     statsHandler = new StatsHandler(n_cards);
     statsHandler->SetDumpInterval(statsInterval_);
 
+    //Start the thread that writes the spills to disk, with room for a full FIFO from every module in each buffer.
+    disk_writer = new PollDiskWriter(&output_file, (EXTERNAL_FIFO_LENGTH + 2) * n_cards, disk_buffers, MAX_FILE_SIZE,
+                                     [this]() { return rollover_output_file(); });
+
     //Build the list of commands
     commands_.insert(commands_.begin(), pollStatusCommands_.begin(), pollStatusCommands_.end());
     commands_.insert(commands_.begin(), paramControlCommands_.begin(), paramControlCommands_.end());
@@ -278,12 +282,21 @@ bool Poll::Close(){
 
     //Send message to Cory's SHM that we are closing.
     client->SendMessage((char *)"$KILL_SOCKET", 13);
-    //Close the UDP data / SHM port.
+    //Close the UDP data port and the SHM ring.
     client->Close();
+    {
+        std::lock_guard<std::mutex> lock(spill_ring_mutex);
+        spill_ring->Close();
+    }
 
     // Close any open files.
     if(output_file.IsOpen()) CloseOutputFile();
 
+    //Stop the disk writer, the buffer that we were reading into belongs to it.
+    delete disk_writer;
+    disk_writer = NULL;
+    fifoData = NULL;
+
     //Delete the array of partial event vectors.
     delete[] partialEvents;
     partialEvents = NULL;
@@ -307,6 +320,9 @@ bool Poll::Close(){
 bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
     Display::LeaderPrint("Closing output file");
 
+    //Let the disk writer finish with the spills that are still queued, it leaves the file alone after that.
+    disk_writer->Flush();
+
     //No file was open.
     if(!output_file.IsOpen()){
         std::cout << Display::WarningStr() << std::endl;
@@ -321,10 +337,15 @@ bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
         statsHandler->Dump();
     }
 
-    output_file.CloseFile();
+    {
+        std::lock_guard<std::mutex> lock(disk_writer->GetFileMutex());
+        output_file.CloseFile();
+    }
+    disk_writer->UpdateFileStatus();
 
     //Broadcast to Cory's SHM that the file is now closed.
     client->SendMessage((char *)"$CLOSE_FILE", 12);
+    spill_ring->Write(SPILL_RING_CLOSE_FILE);
 
     //Set the flag that no file is open.
     file_open = false;
@@ -365,7 +386,13 @@ bool Poll::OpenOutputFile(bool continueRun){
     }
 
     //Try to open a file and check if unsuccessful.
-    if(!output_file.OpenNewFile(output_title, next_run_num, filename_prefix, output_directory, continueRun)){
+    bool opened;
+    {
+        std::lock_guard<std::mutex> lock(disk_writer->GetFileMutex());
+        opened = output_file.OpenNewFile(output_title, next_run_num, filename_prefix, output_directory, continueRun);
+    }
+    disk_writer->UpdateFileStatus();
+    if(!opened){
         std::cout << Display::ErrorStr() << std::endl;
         //Unsuccessful when opening file print a message.
         std::cout << "|- Failed to open output file! Check that the path is correct.\n";
@@ -385,6 +412,7 @@ bool Poll::OpenOutputFile(bool continueRun){
     statsHandler->Dump();
 
     client->SendMessage((char *)"$OPEN_FILE", 12);
+    spill_ring->Write(SPILL_RING_OPEN_FILE);
 
     file_open = true;
 
@@ -415,69 +443,89 @@ bool Poll::synch_mods(){
     return !hadError;
 }
 
+/** The spill is written by the disk writer thread, which also replaces the output
+ * file once it is full. The listeners are told about a new file here, on the
+ * next spill after it was opened.
+ *
+ * \return The number of words queued, or 0 if the spill won't be written.
+ */
 int Poll::write_data(word_t *data, unsigned int nWords){
     // Open an output file if needed
-    if(!output_file.IsOpen()){
+    if(!file_open){
         std::cout << Display::ErrorStr() << " Recording data, but no file is open!\n";
         do_stop_acq = true;
         had_error = true;
         return 0;
     }
 
-    // Handle the writing of buffers to the file
-    //65552 = 8194 * 4 * 2 , 2 EOF buffers are need 8194 words at 4 bytes per word
-    std::streampos current_filesize = output_file.GetFilesize();
-    if(current_filesize + (std::streampos)(4*nWords + 65552) > MAX_FILE_SIZE){
-        // Adding nWords plus 2 EOF buffers to the file will push it over MAX_FILE_SIZE.
-        // Open a new output file instead
-        std::cout << sys_message_head << "Maximum ifile size reached. New output file will be created.\n";
-        std::cout << sys_message_head << "Current filesize is " << current_filesize + (std::streampos)65552 << " bytes.\n";
-        CloseOutputFile(true);
-        OpenOutputFile(true);
+    if(disk_writer->HasRolledOver()){
+        client->SendMessage((char *)"$CLOSE_FILE", 12);
+        spill_ring->Write(SPILL_RING_CLOSE_FILE);
+
+        statsHandler->Clear();
+        statsHandler->Dump();
+
+        client->SendMessage((char *)"$OPEN_FILE", 12);
+        spill_ring->Write(SPILL_RING_OPEN_FILE);
+    }
+
+    if(disk_writer->HadError()){
+        std::cout << Display::ErrorStr() << " Failed to write to '" << disk_writer->GetFilename() << "'!\n";
+        had_error = true;
+        record_data = false;
+        return 0;
     }
 
     if (!is_quiet) std::cout << "Writing " << nWords << " words.\n";
 
-    return output_file.Write((char*)data, nWords);
+    // In shm mode the spill ring tells the scanners about the spill instead of a notification packet.
+    disk_writer->Write(data, nWords, shm_mode ? NULL : client);
+    return nWords;
+}
+
+/** Called by the disk writer thread, with the file mutex held, before a spill
+ * that would push the output file over MAX_FILE_SIZE.
+ *
+ * \return True if the continuation file was opened.
+ */
+bool Poll::rollover_output_file(){
+    std::cout << sys_message_head << "Maximum file size reached. New output file will be created.\n";
+    std::cout << sys_message_head << "Current filesize is " << output_file.GetFilesize() + (std::streampos)65552 << " bytes.\n";
+
+    unsigned int run_num = output_file.GetRunNumber();
+    output_file.CloseFile();
+    if(!output_file.OpenNewFile(output_title, run_num, filename_prefix, output_directory, true)){
+        std::cout << sys_message_head << Display::ErrorStr() << " Failed to open the continuation file '"
+                  << output_file.GetCurrentFilename() << "'!\n";
+        return false;
+    }
+    std::cout << sys_message_head << "Writing to '" << output_file.GetCurrentFilename() << "'.\n";
+
+    return true;
 }
 
 void Poll::broadcast_data(word_t *data, unsigned int nWords) {
-    // Maximum size of the shared memory buffer
-    static const unsigned int maxShmSizeL = 4050; // in pixie words
-    static const unsigned int maxShmSize  = maxShmSizeL * sizeof(word_t); // in bytes
-
-    if(shm_mode){ // Broadcast the spill onto the network using the new shm style
-        int shm_data[maxShmSizeL+2]; // packets of data
-        unsigned int num_net_chunks = nWords / maxShmSizeL;
-        unsigned int num_net_remain = nWords % maxShmSizeL;
-        if(num_net_remain != 0){ num_net_chunks++; }
-
-        unsigned int net_chunk = 1;
-        unsigned int words_bcast = 0;
-        if(debug_mode)
-            std::cout << " debug: Splitting " << nWords << " words into network spill of " << num_net_chunks
-                      << " chunks (fragment = " << num_net_remain << " words)\n";
-
-        while(words_bcast < nWords){
-            if(nWords - words_bcast > maxShmSizeL){ // Broadcast the spill chunks
-                memcpy(&shm_data[0], &net_chunk, 4);
-                memcpy(&shm_data[1], &num_net_chunks, 4);
-                memcpy(&shm_data[2], &data[words_bcast], maxShmSize);
-                client->SendMessage((char *)shm_data, maxShmSize+8);
-                words_bcast += maxShmSizeL;
-            }
-            else{ // Broadcast the spill remainder
-                memcpy(&shm_data[0], &net_chunk, 4);
-                memcpy(&shm_data[1], &num_net_chunks, 4);
-                memcpy(&shm_data[2], &data[words_bcast], (nWords-words_bcast)*4);
-                client->SendMessage((char *)shm_data, (nWords - words_bcast + 2)*4);
-                words_bcast += nWords-words_bcast;
-            }
-            usleep(1);
-            net_chunk++;
+    if(shm_mode && spill_ring->IsOpen()){ // Write the spill into the shared memory ring
+        // The spill goes straight into the ring, with the end of spill flag that the scanners expect after it. If a
+        // lossless consumer is behind, this waits until it has made room.
+        unsigned int *output = spill_ring->Reserve(nWords + 2);
+        if(!output){
+            std::cout << sys_message_head << Display::ErrorStr() << " Spill of " << nWords
+                      << " words is larger than the shared memory ring!\n";
+            return;
         }
+        memcpy(output, data, nWords * sizeof(word_t));
+        output[nWords] = 2;
+        output[nWords + 1] = 9999;
+        spill_ring->Commit(SPILL_RING_SPILL, nWords + 2);
+
+        if(debug_mode)
+            std::cout << " debug: Wrote " << nWords << " words to the shared memory ring (record "
+                      << spill_ring->GetNumberOfRecords() << ")\n";
     }
-    else{ // Broadcast a spill notification to the network
+    else if(!shm_mode && !record_data){ // Broadcast a spill notification to the network
+        // When recording, the disk writer sends it once the spill is in the file.
+        std::lock_guard<std::mutex> lock(disk_writer->GetFileMutex());
         output_file.SendPacket(client);
     }
 }
@@ -497,6 +545,7 @@ void Poll::help(){
     std::cout << "   title [runTitle]    - Set the title of the current run (default='PIXIE Data File)\n";
     std::cout << "   runnum [number]     - Set the number of the current run (default=0)\n";
     std::cout << "   oform [0|1|2]       - Set the format of the output file (default=0)\n";
+    std::cout << "   tcomp [on|off]      - Compress the traces written to .pld files (default=off)\n";
     std::cout << "   reboot              - Reboot PIXIE crate\n";
     std::cout << "   stats [time]        - Set the time delay between statistics dumps (default=-1)\n";
     std::cout << "   mca [root|damm] [time] [filename]     - Use MCA to record data for debugging purposes\n";
@@ -515,6 +564,7 @@ void Poll::help(){
     std::cout << "   get_traces <mod> <chan> [threshold]   - Get traces for all channels in a specified module\n";
     std::cout << "   status              - Display system status information\n";
     std::cout << "   thresh [threshold]  - Modify or display the current polling threshold.\n";
+    std::cout << "   consumers           - Display the scanners reading the shared memory ring and their dropped spills\n";
     std::cout << "   debug               - Toggle debug mode flag (default=false)\n";
     std::cout << "   quiet               - Toggle quiet mode flag (default=false)\n";
     std::cout << "   quit                - Close the program\n";
@@ -609,7 +659,8 @@ void Poll::show_status(){
     std::cout << "   Acq running     - " << StringManipulation::BoolToString(acq_running) << std::endl;
     std::cout << "   Shared memory   - " << StringManipulation::BoolToString(shm_mode) << std::endl;
     std::cout << "   Write to disk   - " << StringManipulation::BoolToString(record_data) << std::endl;
-    std::cout << "   File open       - " << StringManipulation::BoolToString(output_file.IsOpen()) << std::endl;
+    std::cout << "   File open       - " << StringManipulation::BoolToString(file_open) << std::endl;
+    std::cout << "   Disk buffers    - " << disk_buffers << std::endl;
     std::cout << "   Rebooting       - " << StringManipulation::BoolToString(do_reboot) << std::endl;
     std::cout << "   Force Spill     - " << StringManipulation::BoolToString(force_spill) << std::endl;
     std::cout << "   Do MCA run      - " << StringManipulation::BoolToString(do_MCA_run) << std::endl;
@@ -626,6 +677,51 @@ void Poll::show_status(){
     std::cout << "   Initialized - " << StringManipulation::BoolToString(init) << std::endl;
 }
 
+void Poll::show_consumers() {
+    std::vector<SpillRingConsumerInfo> consumers;
+    uint64_t records = 0, waits = 0;
+    {
+        std::lock_guard<std::mutex> lock(spill_ring_mutex);
+        if(!spill_ring->IsOpen()){
+            std::cout << sys_message_head << "The shared memory ring is not open, use \"shm\" to open it.\n";
+            return;
+        }
+        spill_ring->GetConsumers(consumers);
+        records = spill_ring->GetNumberOfRecords();
+        waits = spill_ring->GetNumberOfWaits();
+    }
+
+    const char *policies[] = {"best-effort", "lossless", "spool", "latest", "sample"};
+    std::cout << "  Consumers of " << SPILL_RING_DEFAULT_NAME << " (" << records << " records written, waited "
+              << waits << " times for lossless consumers):\n";
+    if(consumers.empty()){ std::cout << "   None\n"; }
+    else{
+        std::cout << "   " << std::left << std::setw(16) << "Name" << std::right << std::setw(8) << "PID"
+                  << "  " << std::left << std::setw(14) << "Policy" << std::right << std::setw(12) << "Delivered"
+                  << std::setw(10) << "Dropped" << std::setw(10) << "Skipped" << std::setw(13) << "Behind (MB)\n";
+    }
+    for(std::vector<SpillRingConsumerInfo>::iterator it = consumers.begin(); it != consumers.end(); it++){
+        std::string policy = (it->policy <= SPILL_RING_SAMPLED ? policies[it->policy] : "unknown");
+        if(it->policy == SPILL_RING_SAMPLED){ policy += ":" + std::to_string(it->sampling); }
+        std::cout << "   " << std::left << std::setw(16) << it->name << std::right << std::setw(8) << it->pid
+                  << "  " << std::left << std::setw(14) << policy << std::right << std::setw(12) << it->delivered
+                  << std::setw(10) << it->dropped << std::setw(10) << it->skipped << std::setw(12) << std::fixed
+                  << std::setprecision(1) << it->behind / (1024.0 * 1024.0) << std::endl;
+    }
+}
+
+void Poll::update_spill_ring() {
+    if(shm_mode == spill_ring->IsOpen()){ return; }
+
+    std::lock_guard<std::mutex> lock(spill_ring_mutex);
+    if(!shm_mode){ spill_ring->Close(); }
+    else if(!spill_ring->Open()){
+        std::cout << sys_message_head << Display::ErrorStr() << " Unable to create the shared memory ring "
+                  << SPILL_RING_DEFAULT_NAME << "!\n";
+        shm_mode = false;
+    }
+}
+
 void Poll::show_thresh() {
     float threshPercent = (float) threshWords / EXTERNAL_FIFO_LENGTH * 100;
     std::cout << sys_message_head << "Polling Threshold = " << threshPercent << "% (" << threshWords << "/" << EXTERNAL_FIFO_LENGTH << ")\n";
@@ -804,6 +900,9 @@ void Poll::CommandControl(){
         else if(cmd == "status"){
             show_status();
         }
+        else if(cmd == "consumers"){
+            show_consumers();
+        }
         else if(cmd == "thresh"){
             if(p_args==1){
                 if(!StringManipulation::IsNumeric(arguments.at(0))) {
@@ -1301,6 +1400,7 @@ void Poll::CommandControl(){
         } else if(cmd == "stop" || cmd == "stopacq" || cmd == "stopvme"){ // Tell POLL to stop recording data to disk and stop acq.
             stop_run();
         } else if(cmd == "shm"){ // Toggle "shared-memory" mode
+            // The run control thread opens or closes the ring, since it's the one that writes to it.
             if(shm_mode){
                 std::cout << sys_message_head << "Toggling shared-memory mode OFF\n";
                 shm_mode = false;
@@ -1415,6 +1515,19 @@ void Poll::CommandControl(){
             if(output_file.IsOpen()){
                 std::cout << sys_message_head << "New output format used for new files only! Current file is unchanged.\n";
             }
+        } else if(cmd == "tcomp"){ // Toggle the compression of traces in .pld files
+            if(arg == "on" || arg == "off"){
+                output_file.SetCompressTraces(arg == "on");
+                std::cout << sys_message_head << "Set trace compression to '" << arg << "'\n";
+                if(output_format != 1)
+                    std::cout << "  Note! Traces are only compressed in the .pld file format (oform 1)\n";
+            } else if(arg != ""){
+                std::cout << sys_message_head << "Unknown trace compression setting '" << arg << "', use 'on' or 'off'\n";
+            } else{ std::cout << sys_message_head << "Trace compression is '" << (output_file.GetCompressTraces() ? "on" : "off") << "'\n"; }
+
+            if(output_file.IsOpen()){
+                std::cout << sys_message_head << "Trace compression used for new files only! Current file is unchanged.\n";
+            }
         } else{ std::cout << sys_message_head << "Unknown command '" << cmd << "'\n"; }
     }
 }
@@ -1428,6 +1541,8 @@ void Poll::RunControl(){
     time_t acqStartTime;
     time_t currentTime;
     while(true){
+        update_spill_ring();
+
         if(kill_all){ // Supersedes all other commands
             if(acq_running || mca_args.IsRunning()){ do_stop_acq = true; } // Safety catch
             else{ break; }
@@ -1579,8 +1694,8 @@ void Poll::RunControl(){
                 statsHandler->Dump();
                 statsHandler->ClearTotals();
 
-                //Close the output file
-                if(output_file.IsOpen()) CloseOutputFile();
+                //Close the output file, the disk writer may still be writing to it.
+                if(file_open) CloseOutputFile();
 
                 //Reset status flags
                 do_stop_acq = false;
@@ -1625,8 +1740,8 @@ void Poll::UpdateStatus() {
     if (file_open) {
         if (acq_running && !record_data) status << TermColors::DkYellow;
         //Add file size to status
-        status << " " << StringManipulation::FormatHumanReadableSizes(output_file.GetFilesize());
-        status << " " << output_file.GetCurrentFilename();
+        status << " " << StringManipulation::FormatHumanReadableSizes(disk_writer->GetFilesize());
+        status << " " << disk_writer->GetFilename();
         if (acq_running && !record_data) status << TermColors::Reset;
     }
 
@@ -1651,10 +1766,11 @@ void Poll::ReadScalers() {
     }
 }
 bool Poll::ReadFIFO() {
-    static word_t *fifoData = new word_t[(EXTERNAL_FIFO_LENGTH + 2) * n_cards];
-
     if (!acq_running) return false;
 
+    //The spill is read into a buffer from the disk writer, which only has to wait if they're all queued.
+    if (!fifoData) fifoData = disk_writer->GetBuffer();
+
     //Number of words in the FIFO of each module.
     std::vector<word_t> nWords(n_cards);
     //Iterator to determine which card has the most words.
@@ -1865,16 +1981,20 @@ bool Poll::ReadFIFO() {
         //If exceed interval we read the scalers from the modules and dump the stats.
         if (statsHandler->AddTime(durSpill * 1e-6)) {
             ReadScalers();
+            double meanDepth, maxDepth, meanLatency, maxLatency;
+            disk_writer->GetStats(meanDepth, maxDepth, meanLatency, maxLatency);
+            statsHandler->SetWriterStats(meanDepth, maxDepth, meanLatency, maxLatency);
             statsHandler->Dump();
             statsHandler->ClearRates();
         }
 
         if (!is_quiet || debug_mode)
             std::cout << "Writing/Broadcasting " << dataWords << " words.\n";
-        //We have read the FIFO now we write the data
-        if (record_data)
-            write_data(fifoData, dataWords);
+        //We have read the FIFO now we write the data. A buffer that was queued goes back to the disk writer's
+        // pool once it's written, so the next spill is read into another one.
+        bool queued = (record_data && write_data(fifoData, dataWords) > 0);
         broadcast_data(fifoData, dataWords);
+        if (queued) fifoData = NULL;
 
     } //If we had exceeded the threshold or forced a flush
 
@@ -126,12 +126,17 @@ void StatsHandler::Dump(void) {
     // ...
     // channel N-1, 15 rate
     // channel N-1, 15 total
-    //msg_size = 20 fixed bytes + 4 words/card/ch * numCards * 16 ch * 8 bytes/ word
+    // 8 byte mean disk writer queue depth (in spills)
+    // 8 byte max disk writer queue depth (in spills)
+    // 8 byte mean disk write latency (in ms)
+    // 8 byte max disk write latency (in ms)
+    //msg_size = 20 fixed bytes + 4 words/card/ch * numCards * 16 ch * 8 bytes/ word + 32 bytes of writer stats
     size_t msg_size = sizeof(numCards) + sizeof(totalTime) + sizeof(dataRate) +
                       numCards * 16 * (sizeof(inputCountRate[0][0]) +
                                        sizeof(outputCountRate[0][0]) +
                                        sizeof(calcEventRate[0][0]) +
-                                       sizeof(nEventsTotal[0][0]));
+                                       sizeof(nEventsTotal[0][0])) +
+                      sizeof(writerStats);
     char *message = new char[msg_size];
     char *ptr = message;
 
@@ -157,6 +162,7 @@ void StatsHandler::Dump(void) {
             ptr += sizeof(nEventsTotal[i][j]);
         } //Update the status bar
     }
+    memcpy(ptr, writerStats, sizeof(writerStats));
 
     client->SendMessage(message, msg_size);
 
@@ -205,6 +211,14 @@ void StatsHandler::SetXiaRates(int mod,
     }
 }
 
+void StatsHandler::SetWriterStats(double meanDepth, double maxDepth,
+                                  double meanLatency, double maxLatency) {
+    writerStats[0] = meanDepth;
+    writerStats[1] = maxDepth;
+    writerStats[2] = meanLatency;
+    writerStats[3] = maxLatency;
+}
+
 void StatsHandler::ClearTotals() {
     totalTime = 0;
     for (size_t i = 0; i < numCards; i++) {
@@ -217,4 +231,5 @@ void StatsHandler::ClearTotals() {
 void StatsHandler::Clear() {
     ClearRates();
     ClearTotals();
+    SetWriterStats(0, 0, 0, 0);
 }
@@ -0,0 +1,146 @@
+/** \file poll2_writer.cpp
+  *
+  * \brief Writes the spills to the poll2 output file on a thread of its own
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+*/
+
+#include <algorithm>
+#include <chrono>
+
+#include "hribf_buffers.h"
+#include "poll2_writer.h"
+
+PollDiskWriter::PollDiskWriter(PollOutputFile *file_, const size_t &bufferWords_, const unsigned int &depth_,
+                               const std::streampos &maxFileSize_, const std::function<bool()> &rollover_) :
+        file(file_), maxFileSize(maxFileSize_), rollover(rollover_), buffers(std::max(depth_, 1u)),
+        rolledOver(false), writeError(false), writing(false), stopping(false), filesize(0), depthSamples(0),
+        depthSum(0), depthMax(0), writes(0), latencySum(0), latencyMax(0)
+{
+    // The buffers are filled in now so that the pages are already mapped when the first spills are read into them.
+    for(std::vector<std::vector<uint32_t> >::iterator it = buffers.begin(); it != buffers.end(); it++){
+        it->resize(bufferWords_, 0);
+        pool.push_back(&(*it)[0]);
+    }
+
+    thread = std::thread(&PollDiskWriter::Run, this);
+}
+
+PollDiskWriter::~PollDiskWriter(){
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    thread.join();
+}
+
+uint32_t *PollDiskWriter::GetBuffer(){
+    std::unique_lock<std::mutex> lock(queueMutex);
+    written.wait(lock, [this]() { return !pool.empty(); });
+    uint32_t *buffer = pool.back();
+    pool.pop_back();
+    return buffer;
+}
+
+void PollDiskWriter::Write(uint32_t *buffer_, const unsigned int &nWords_, Client *client_/*=NULL*/){
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        Job job = {buffer_, nWords_, client_};
+        queue.push_back(job);
+
+        unsigned int depth = queue.size() + (writing ? 1 : 0);
+        depthSamples++;
+        depthSum += depth;
+        depthMax = std::max(depthMax, depth);
+    }
+    queued.notify_one();
+}
+
+void PollDiskWriter::Flush(){
+    std::unique_lock<std::mutex> lock(queueMutex);
+    written.wait(lock, [this]() { return queue.empty() && !writing; });
+}
+
+void PollDiskWriter::UpdateFileStatus(){
+    std::lock_guard<std::mutex> lock(fileMutex);
+    UpdateFileStatusLocked();
+}
+
+std::streampos PollDiskWriter::GetFilesize(){
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return filesize;
+}
+
+std::string PollDiskWriter::GetFilename(){
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return filename;
+}
+
+void PollDiskWriter::GetStats(double &meanDepth_, double &maxDepth_, double &meanLatency_, double &maxLatency_){
+    std::lock_guard<std::mutex> lock(queueMutex);
+    meanDepth_ = (depthSamples > 0 ? depthSum / depthSamples : 0);
+    maxDepth_ = depthMax;
+    meanLatency_ = (writes > 0 ? latencySum / writes : 0);
+    maxLatency_ = latencyMax;
+
+    depthSamples = writes = 0;
+    depthSum = latencySum = latencyMax = 0;
+    depthMax = 0;
+}
+
+void PollDiskWriter::Run(){
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while(true){
+        queued.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if(queue.empty()){ return; } // Only stop once everything has been written.
+
+        Job job = queue.front();
+        queue.pop_front();
+        writing = true;
+        lock.unlock();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool success = WriteSpill(job);
+        double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if(!success){ writeError = true; }
+
+        lock.lock();
+        writing = false;
+        pool.push_back(job.buffer);
+        writes++;
+        latencySum += latency;
+        latencyMax = std::max(latencyMax, latency);
+        written.notify_all();
+    }
+}
+
+bool PollDiskWriter::WriteSpill(const Job &job_){
+    std::lock_guard<std::mutex> lock(fileMutex);
+
+    //65552 = 8194 * 4 * 2 , 2 EOF buffers are need 8194 words at 4 bytes per word
+    if(file->IsOpen() && file->GetFilesize() + (std::streampos)(4 * job_.nWords + 65552) > maxFileSize){
+        if(!rollover()){
+            UpdateFileStatusLocked();
+            return false;
+        }
+        rolledOver = true;
+    }
+
+    bool success = (file->Write((char *)job_.buffer, job_.nWords) >= 0);
+    if(job_.client){ file->SendPacket(job_.client); }
+
+    UpdateFileStatusLocked();
+    return success;
+}
+
+void PollDiskWriter::UpdateFileStatusLocked(){
+    std::streampos size = (file->IsOpen() ? file->GetFilesize() : std::streampos(0));
+    std::string name = file->GetCurrentFilename();
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    filesize = size;
+    filename = name;
+}
@@ -0,0 +1,147 @@
+///@file SyntheticRunGenerator.hpp
+///@brief Generates spills of Pixie-16 list mode data that look like those from a real run.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_SYNTHETICRUNGENERATOR_HPP
+#define PIXIESUITE_SYNTHETICRUNGENERATOR_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "XiaData.hpp"
+#include "XiaListModeDataEncoder.hpp"
+#include "XiaListModeDataMask.hpp"
+
+///The firmware and frequency of one of the simulated modules.
+struct SyntheticModule {
+    ///Constructor
+    ///@param[in] fw : The firmware revision, e.g. "30474"
+    ///@param[in] freq : The sampling frequency in MS/s
+    SyntheticModule(const std::string &fw = "30474", const unsigned int &freq = 250) : firmware(fw), frequency(freq) {}
+
+    std::string firmware; ///< The firmware revision of the module
+    unsigned int frequency; ///< The sampling frequency of the module in MS/s
+};
+
+///Everything that describes a synthetic run. The defaults give a single 250 MS/s module without traces.
+struct SyntheticRunSettings {
+    ///Default constructor
+    SyntheticRunSettings() : modules(1), channelsPerModule(16), eventRate(1.e4), multiplicity(1.), pileupFraction(0.),
+                             traceLength(0), traceFraction(1.), hasQdc(false), hasEnergySums(false),
+                             hasExternalTimestamp(false), spillDuration(0.1), maxSpillWords(100000), adcBits(14),
+                             baseline(400.), noise(2.), riseTime(4.), decayTime(40.), seed(1) {}
+
+    std::vector<SyntheticModule> modules; ///< The modules in the crate, indexed by module number
+    unsigned int channelsPerModule; ///< The number of channels in each module that fire
+    double eventRate; ///< The number of physics events per second
+    double multiplicity; ///< The mean number of hits in each physics event, at least one
+    double pileupFraction; ///< The fraction of hits that have a second pulse on top of the first
+    unsigned int traceLength; ///< The number of samples in each trace, zero for no traces
+    double traceFraction; ///< The fraction of the channels that record traces
+    bool hasQdc; ///< True if the hits have the QDC words
+    bool hasEnergySums; ///< True if the hits have the energy sums and baseline
+    bool hasExternalTimestamp; ///< True if the hits have the external time stamp
+    double spillDuration; ///< The number of seconds of the run in each spill
+    unsigned int maxSpillWords; ///< A spill is cut short when it gets this long, like poll2's FIFO threshold
+    unsigned int adcBits; ///< The resolution of the ADC, traces above this range are saturated
+    double baseline; ///< The baseline of the traces in ADC units
+    double noise; ///< The standard deviation of the noise on the traces in ADC units
+    double riseTime; ///< The rise time constant of the pulses in samples
+    double decayTime; ///< The decay time constant of the pulses in samples
+    unsigned int seed; ///< The seed of the random numbers, the same seed always gives the same run
+};
+
+///Generates a run one spill at a time. Each physics event fires a few random channels at nearly the same time, and
+/// the hits are encoded with XiaListModeDataEncoder using the firmware and frequency of their module. The energies
+/// come from a continuum with a few peaks on top of it and the traces are two exponentials on a noisy baseline. The
+/// random numbers come from std::mt19937 alone, so a seed gives the same data with any compiler.
+class SyntheticRunGenerator {
+public:
+    ///Constructor that checks the settings.
+    ///@param[in] settings : The description of the run
+    ///@throws invalid_argument if the settings don't make sense or a module's firmware or frequency is unknown
+    SyntheticRunGenerator(const SyntheticRunSettings &settings);
+
+    ///Default destructor
+    ~SyntheticRunGenerator() {}
+
+    ///Generates the next spill in the same layout that poll2 reads out of the modules: one buffer for each module,
+    /// starting with the length of the buffer and the module number, followed by the module's hits.
+    ///@return The words of the spill, which stay valid until the next call.
+    const std::vector<unsigned int> &NextSpill();
+
+    ///@return The settings of the run.
+    const SyntheticRunSettings &GetSettings() const { return settings_; }
+
+    ///@return The number of physics events generated so far.
+    unsigned long long GetNumberOfEvents() const { return numberOfEvents_; }
+
+    ///@return The number of hits generated so far.
+    unsigned long long GetNumberOfHits() const { return numberOfHits_; }
+
+    ///@return The number of hits that were piled up.
+    unsigned long long GetNumberOfPileups() const { return numberOfPileups_; }
+
+    ///@return The number of spills generated so far.
+    unsigned long long GetNumberOfSpills() const { return numberOfSpills_; }
+
+    ///@return The number of seconds of the run that have been generated so far.
+    double GetRunTime() const { return spillStart_; }
+
+private:
+    SyntheticRunSettings settings_; ///< The description of the run
+    std::vector<XiaListModeDataMask> masks_; ///< The masks of each module
+    std::vector<XiaListModeDataEncoder> encoders_; ///< The encoder of each module
+    std::vector<double> cfdSizes_; ///< The range of the CFD fractional time of each module
+    std::vector<double> clockPeriods_; ///< The period of the time stamp clock of each module in ns
+    std::vector<bool> hasTrace_; ///< True for the channels that record traces, indexed by XiaData::GetId
+    std::vector<double> pulse_; ///< The shape of a pulse with unit height, sampled at every sample of a trace
+    std::vector<double> noise_; ///< Normally distributed numbers that the traces pick their noise from
+    std::vector<std::vector<unsigned int> > buffers_; ///< The buffer of each module for the spill being built
+    std::vector<unsigned int> spill_; ///< The last spill that we generated
+    std::vector<unsigned short> trace_; ///< The trace of the hit that we're generating, kept to reuse the storage
+    std::mt19937 random_; ///< The source of every random number
+    unsigned int maxMultiplicity_; ///< The largest number of hits in a physics event
+    unsigned int maxEventWords_; ///< The largest number of words that a physics event can take
+
+    double spillStart_; ///< The time at which the next spill starts, in seconds
+    double nextEventTime_; ///< The time of the next physics event, in seconds
+    unsigned long long numberOfEvents_; ///< The number of physics events generated so far
+    unsigned long long numberOfHits_; ///< The number of hits generated so far
+    unsigned long long numberOfPileups_; ///< The number of piled up hits generated so far
+    unsigned long long numberOfSpills_; ///< The number of spills generated so far
+
+    ///@return A random number in (0, 1).
+    double Uniform();
+
+    ///@return A normally distributed random number with a mean of zero and a standard deviation of one.
+    double Gaussian();
+
+    ///@param[in] mean : The mean of the distribution
+    ///@return A random number drawn from a Poisson distribution.
+    unsigned int Poisson(const double &mean);
+
+    ///@return An energy drawn from the spectrum, in the units of the energy filter.
+    double Energy();
+
+    ///Adds the hits of a physics event to the module buffers.
+    ///@param[in] time : The time of the event in seconds
+    ///@return The number of words added to the buffers.
+    unsigned int AddEvent(const double &time);
+
+    ///Fills a hit with everything that its module records, and encodes it into the module's buffer.
+    ///@param[in] module : The module number of the hit
+    ///@param[in] channel : The channel number of the hit
+    ///@param[in] time : The time of the hit in seconds
+    ///@return The number of words added to the buffer.
+    unsigned int AddHit(const unsigned int &module, const unsigned int &channel, const double &time);
+
+    ///Fills the trace of a hit with one pulse, or two if it piled up.
+    ///@param[in] amplitude : The height of the first pulse in ADC units
+    ///@param[in] pileupAmplitude : The height of the second pulse, zero if there isn't one
+    ///@return True if the trace went outside of the range of the ADC.
+    bool FillTrace(const double &amplitude, const double &pileupAmplitude);
+};
+
+#endif //PIXIESUITE_SYNTHETICRUNGENERATOR_HPP
@@ -0,0 +1,278 @@
+///@file SyntheticRunGenerator.cpp
+///@brief Generates spills of Pixie-16 list mode data that look like those from a real run.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <stdexcept>
+
+#include <cmath>
+
+#include "SyntheticRunGenerator.hpp"
+
+using namespace std;
+
+namespace {
+    const unsigned int MAX_MODULES = 14; ///< poll2 never reads more modules than this from a crate
+    const unsigned int MAX_CHANNELS = 16; ///< The number of channels in a module
+    const unsigned int MAX_MODULE_WORDS = 131072; ///< The largest module buffer that the Unpacker accepts
+    const unsigned int MAX_SPILL_WORDS = 1000000; ///< The largest spill that the scan reads in one go
+    const unsigned int MAX_HEADER_WORDS = 18; ///< The longest header, with the energy sums, QDCs and external time
+    const unsigned int MAX_TRACE_LENGTH = 16000; ///< The longest trace that the 13-bit event length of old firmwares holds
+    const unsigned int NOISE_TABLE_SIZE = 4096; ///< The number of entries in the noise table, a power of two
+    const double MAX_ENERGY = 65535.; ///< The largest energy that fits in the energy field
+    const double EXTERNAL_CLOCK_PERIOD = 10.; ///< The period of the external time stamp clock in ns
+    const double TIME_JITTER = 2.; ///< The spread of the hit times in a physics event, in ns
+}
+
+SyntheticRunGenerator::SyntheticRunGenerator(const SyntheticRunSettings &settings) : settings_(settings),
+        random_(settings.seed), maxMultiplicity_(1), maxEventWords_(0), spillStart_(0), nextEventTime_(0),
+        numberOfEvents_(0), numberOfHits_(0), numberOfPileups_(0), numberOfSpills_(0) {
+    if (settings_.modules.empty() || settings_.modules.size() > MAX_MODULES)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - We need between 1 and "
+                               + to_string(MAX_MODULES) + " modules.");
+    if (settings_.channelsPerModule == 0 || settings_.channelsPerModule > MAX_CHANNELS)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - We need between 1 and "
+                               + to_string(MAX_CHANNELS) + " channels in each module.");
+    if (settings_.eventRate <= 0 || settings_.spillDuration <= 0)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - The event rate and the spill duration "
+                                       "need to be positive.");
+    if (settings_.multiplicity < 1 || settings_.pileupFraction < 0 || settings_.pileupFraction > 1
+        || settings_.traceFraction < 0 || settings_.traceFraction > 1)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - The multiplicity needs to be at least "
+                                       "one, and the pileup and trace fractions between zero and one.");
+    if (settings_.traceLength % 2 != 0 || settings_.traceLength > MAX_TRACE_LENGTH)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - The trace length needs to be even and "
+                               "no more than " + to_string(MAX_TRACE_LENGTH) + " samples.");
+    if (settings_.adcBits < 8 || settings_.adcBits > 16 || settings_.riseTime <= 0
+        || settings_.decayTime <= settings_.riseTime || settings_.noise < 0)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - The ADC needs between 8 and 16 bits, "
+                                       "and the pulses a positive rise time that is shorter than their decay time.");
+
+    // Large multiplicities are capped at four times the mean, so that we know the most words that an event can take.
+    maxMultiplicity_ = min((unsigned int) ceil(settings_.multiplicity * 4),
+                           (unsigned int) settings_.modules.size() * settings_.channelsPerModule);
+    maxEventWords_ = maxMultiplicity_ * (MAX_HEADER_WORDS + settings_.traceLength / 2);
+    if (settings_.maxSpillWords < 2 * settings_.modules.size() + maxEventWords_
+        || settings_.maxSpillWords > MAX_SPILL_WORDS || 2 + maxEventWords_ > MAX_MODULE_WORDS)
+        throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - The spills need room for the largest "
+                               "event (" + to_string(maxEventWords_) + " words), and can't be longer than "
+                               + to_string(MAX_SPILL_WORDS) + " words.");
+
+    // Building the masks here makes sure that every firmware and frequency is one that we know how to encode.
+    for (vector<SyntheticModule>::const_iterator it = settings_.modules.begin(); it != settings_.modules.end(); it++) {
+        if (it->frequency != 100 && it->frequency != 250 && it->frequency != 500)
+            throw invalid_argument("SyntheticRunGenerator::SyntheticRunGenerator - The modules run at 100, 250 or "
+                                           "500 MS/s, not " + to_string(it->frequency) + ".");
+        masks_.push_back(XiaListModeDataMask(it->firmware, it->frequency));
+        encoders_.push_back(XiaListModeDataEncoder(masks_.back()));
+        cfdSizes_.push_back(masks_.back().GetCfdSize());
+        clockPeriods_.push_back(it->frequency == 250 ? 8. : 10.);
+    }
+
+    hasTrace_.resize(settings_.modules.size() * MAX_CHANNELS);
+    for (size_t i = 0; i < hasTrace_.size(); i++)
+        hasTrace_[i] = settings_.traceLength != 0 && Uniform() < settings_.traceFraction;
+
+    // The pulse starts a quarter of the way into the trace, and is scaled so that its peak is one.
+    pulse_.assign(settings_.traceLength, 0.);
+    double peak = 0;
+    for (unsigned int i = 0; i < settings_.traceLength; i++) {
+        pulse_[i] = exp(-(double) i / settings_.decayTime) - exp(-(double) i / settings_.riseTime);
+        if (pulse_[i] > peak)
+            peak = pulse_[i];
+    }
+    for (unsigned int i = 0; i < settings_.traceLength; i++)
+        pulse_[i] /= peak;
+    trace_.resize(settings_.traceLength);
+
+    noise_.resize(NOISE_TABLE_SIZE);
+    for (unsigned int i = 0; i < NOISE_TABLE_SIZE; i++)
+        noise_[i] = settings_.noise * Gaussian();
+
+    buffers_.resize(settings_.modules.size());
+    nextEventTime_ = -log(Uniform()) / settings_.eventRate;
+}
+
+///We don't use the distributions from <random> since their output is up to the standard library.
+double SyntheticRunGenerator::Uniform() {
+    return (random_() + 0.5) / 4294967296.;
+}
+
+///The two uniform numbers are drawn in separate statements, since the order that the arguments of an expression are
+/// evaluated in is up to the compiler.
+double SyntheticRunGenerator::Gaussian() {
+    const double radius = sqrt(-2. * log(Uniform()));
+    return radius * cos(2. * M_PI * Uniform());
+}
+
+///Knuth's method is plenty fast for the small means that we use it for.
+unsigned int SyntheticRunGenerator::Poisson(const double &mean) {
+    const double limit = exp(-mean);
+    unsigned int count = 0;
+    for (double product = Uniform(); product > limit; product *= Uniform())
+        count++;
+    return count;
+}
+
+///The spectrum is an exponential continuum with three narrow peaks on top of it, which are at a fixed fraction of
+/// the range so that every ADC resolution shows them.
+double SyntheticRunGenerator::Energy() {
+    static const double peaks[] = {0.1, 0.25, 0.6};
+    const double choice = Uniform();
+    double energy;
+    if (choice < 0.7)
+        energy = -0.08 * MAX_ENERGY * log(Uniform());
+    else {
+        const double peak = peaks[(unsigned int) ((choice - 0.7) / 0.1) % 3] * MAX_ENERGY;
+        energy = peak * (1 + 0.005 * Gaussian());
+    }
+    return min(max(energy, 1.), MAX_ENERGY);
+}
+
+const vector<unsigned int> &SyntheticRunGenerator::NextSpill() {
+    for (unsigned int module = 0; module < buffers_.size(); module++) {
+        buffers_[module].clear();
+        buffers_[module].push_back(0);
+        buffers_[module].push_back(module);
+    }
+
+    // Like poll2, we end the spill early if the modules have too much data to hold.
+    const double spillEnd = spillStart_ + settings_.spillDuration;
+    unsigned int words = 2 * (unsigned int) buffers_.size();
+    bool isFull = false;
+
+    while (nextEventTime_ < spillEnd && !isFull) {
+        words += AddEvent(nextEventTime_);
+        nextEventTime_ += -log(Uniform()) / settings_.eventRate;
+
+        isFull = words + maxEventWords_ > settings_.maxSpillWords;
+        for (unsigned int module = 0; module < buffers_.size() && !isFull; module++)
+            isFull = buffers_[module].size() + maxEventWords_ > MAX_MODULE_WORDS;
+    }
+    spillStart_ = isFull ? nextEventTime_ : spillEnd;
+
+    spill_.clear();
+    for (unsigned int module = 0; module < buffers_.size(); module++) {
+        buffers_[module][0] = (unsigned int) buffers_[module].size();
+        spill_.insert(spill_.end(), buffers_[module].begin(), buffers_[module].end());
+    }
+    numberOfSpills_++;
+    return spill_;
+}
+
+///The channels that fire are picked at random from every module, without repeats.
+unsigned int SyntheticRunGenerator::AddEvent(const double &time) {
+    const unsigned int numberOfChannels = (unsigned int) settings_.modules.size() * settings_.channelsPerModule;
+    const unsigned int multiplicity = min(1 + Poisson(settings_.multiplicity - 1), maxMultiplicity_);
+
+    vector<unsigned int> fired;
+    unsigned int words = 0;
+    while (fired.size() < multiplicity) {
+        const unsigned int channel = random_() % numberOfChannels;
+        bool isRepeat = false;
+        for (vector<unsigned int>::const_iterator it = fired.begin(); it != fired.end() && !isRepeat; it++)
+            isRepeat = *it == channel;
+        if (isRepeat)
+            continue;
+        fired.push_back(channel);
+        words += AddHit(channel / settings_.channelsPerModule, channel % settings_.channelsPerModule, time);
+    }
+
+    numberOfEvents_++;
+    return words;
+}
+
+unsigned int SyntheticRunGenerator::AddHit(const unsigned int &module, const unsigned int &channel,
+                                           const double &time) {
+    XiaData data;
+    data.SetCrateNumber(0);
+    data.SetSlotNumber(module + 2);
+    data.SetChannelNumber(channel);
+
+    const double hitTime = max(time * 1.e9 + TIME_JITTER * Gaussian(), 0.);
+    const unsigned long long ticks = (unsigned long long) (hitTime / clockPeriods_[module]);
+    data.SetEventTimeLow((unsigned int) (ticks & 0xFFFFFFFF));
+    data.SetEventTimeHigh((unsigned int) (ticks >> 32));
+    data.SetCfdFractionalTime(1 + (unsigned int) (Uniform() * (cfdSizes_[module] - 2)));
+    if (settings_.modules[module].frequency == 250)
+        data.SetCfdTriggerSourceBit(Uniform() < 0.5);
+
+    const double energy = Energy();
+    const bool isPileup = Uniform() < settings_.pileupFraction;
+    data.SetEnergy(floor(energy));
+    data.SetPileup(isPileup);
+    if (isPileup)
+        numberOfPileups_++;
+
+    // The ADC range matches the energy range, so the largest energies and the piled up pulses can saturate.
+    const double amplitude = energy * ((1 << settings_.adcBits) - 1) / MAX_ENERGY;
+    const bool hasTrace = hasTrace_[module * MAX_CHANNELS + channel];
+    if (hasTrace) {
+        data.SetSaturation(FillTrace(amplitude, isPileup ? amplitude * (0.2 + 0.8 * Uniform()) : 0.));
+        data.SetTrace(&trace_[0], &trace_[0] + trace_.size());
+    }
+
+    if (settings_.hasEnergySums) {
+        // The last of the energy sum words is the baseline, which the encoder adds on its own.
+        vector<unsigned int> sums(masks_[module].GetNumberOfEnergySumWords() - 1, 0);
+        sums[0] = (unsigned int) (settings_.baseline * 16);
+        if (sums.size() > 1)
+            sums[1] = (unsigned int) (settings_.baseline * 16 + energy);
+        if (sums.size() > 2)
+            sums[2] = (unsigned int) (energy / 2);
+        data.SetEnergySums(sums);
+        data.SetFilterBaseline(settings_.baseline + 0.1 * settings_.noise * Gaussian());
+    }
+
+    if (settings_.hasQdc) {
+        // With a trace the QDCs are its sums over consecutive windows, without one they follow the same pulse.
+        vector<unsigned int> qdcs(masks_[module].GetNumberOfQdcWords(), 0);
+        for (unsigned int i = 0; i < qdcs.size(); i++) {
+            if (hasTrace) {
+                const size_t width = trace_.size() / qdcs.size();
+                double sum = 0;
+                for (size_t j = i * width; j < (i + 1) * width; j++)
+                    sum += trace_[j];
+                qdcs[i] = (unsigned int) sum;
+            } else
+                qdcs[i] = (unsigned int) (settings_.baseline * 10 + energy * exp(-fabs(i - 2.5)));
+        }
+        data.SetQdc(qdcs);
+    }
+
+    if (settings_.hasExternalTimestamp) {
+        // The encoder only writes the external time stamp when the lower word isn't zero.
+        const unsigned long long external = (unsigned long long) (hitTime / EXTERNAL_CLOCK_PERIOD) + 1;
+        data.SetExternalTimeLow(max((unsigned int) (external & 0xFFFFFFFF), 1u));
+        data.SetExternalTimeHigh((unsigned int) (external >> 32));
+    }
+
+    vector<unsigned int> encoded = encoders_[module].EncodeXiaData(data);
+    buffers_[module].insert(buffers_[module].end(), encoded.begin(), encoded.end());
+    numberOfHits_++;
+    return (unsigned int) encoded.size();
+}
+
+bool SyntheticRunGenerator::FillTrace(const double &amplitude, const double &pileupAmplitude) {
+    const unsigned int length = settings_.traceLength;
+    const unsigned int start = length / 4;
+    const unsigned int pileupStart = start + (unsigned int) ((0.1 + 0.5 * Uniform()) * length);
+    const double maximum = (1 << settings_.adcBits) - 1;
+    unsigned int noise = random_() % NOISE_TABLE_SIZE;
+    bool isSaturated = false;
+
+    for (unsigned int i = 0; i < length; i++) {
+        double value = settings_.baseline + noise_[noise++ % NOISE_TABLE_SIZE];
+        if (i >= start)
+            value += amplitude * pulse_[i - start];
+        if (pileupAmplitude != 0 && i >= pileupStart)
+            value += pileupAmplitude * pulse_[i - pileupStart];
+
+        if (value > maximum) {
+            value = maximum;
+            isSaturated = true;
+        }
+        trace_[i] = (unsigned short) max(value + 0.5, 0.);
+    }
+
+    return isSaturated;
+}
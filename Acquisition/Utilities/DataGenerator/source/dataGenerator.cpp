@@ -4,69 +4,240 @@
 ///@date August 9, 2017
 ///@copyright Copyright (c) 2017 S. V. Paulauskas.
 ///@copyright All rights reserved. Released under the Creative Commons Attribution-ShareAlike 4.0 International License
-#include <array>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
 
-#include "XiaListModeDataEncoder.hpp"
+#include <getopt.h>
+
+#include "StringManipulationFunctions.hpp"
+#include "SyntheticRunGenerator.hpp"
 #include "hribf_buffers.h"
 
 using namespace std;
 
+///The largest file that we write before moving on to the next one, the same limit that poll2 uses.
+static const long long MAX_FILE_SIZE = 2147483648ll;
+
+///The size of the two EOF buffers that close an ldf file, which poll2 leaves room for as well.
+static const long long EOF_BUFFER_BYTES = 65552;
+
+///Prints the command line options.
+///@param[in] name : The name of the program
+void help(const char *name) {
+    cout << "\n SYNTAX: " << name << " [options]\n"
+         << "  --output (-o) <prefix>        | Prefix of the output files (default=synthetic)\n"
+         << "  --path (-p) <directory>       | Directory for the output files (default=./)\n"
+         << "  --format (-f) <pld|ldf|both>  | Format of the output files (default=pld)\n"
+         << "  --title <title>               | Title of the run\n"
+         << "  --duration (-d) <seconds>     | Length of the run (default=10)\n"
+         << "  --size (-s) <MB>              | Stop once this much data is written (default=no limit)\n"
+         << "  --modules (-m) <number>       | Number of modules in the crate (default=1)\n"
+         << "  --firmware <revision>         | Firmware of every module (default=30474)\n"
+         << "  --frequency <MS/s>            | Sampling frequency of every module (default=250)\n"
+         << "  --module <mod:firmware:freq>  | Firmware and frequency of one module, may be repeated\n"
+         << "  --channels (-c) <number>      | Number of channels in each module that fire (default=16)\n"
+         << "  --rate (-r) <events/s>        | Rate of physics events (default=10000)\n"
+         << "  --multiplicity <mean>         | Mean number of hits in each event (default=1)\n"
+         << "  --pileup <fraction>           | Fraction of hits that pile up (default=0)\n"
+         << "  --trace-length (-t) <samples> | Number of samples in each trace (default=0, no traces)\n"
+         << "  --trace-fraction <fraction>   | Fraction of the channels that record traces (default=1)\n"
+         << "  --qdc                         | Add the QDC words to every hit\n"
+         << "  --esums                       | Add the energy sums and baseline to every hit\n"
+         << "  --ets                         | Add the external time stamp to every hit\n"
+         << "  --spill-time <seconds>        | Length of the run in each spill (default=0.1)\n"
+         << "  --spill-words <number>        | Largest spill, like poll2's FIFO threshold (default=100000)\n"
+         << "  --compress                    | Compress the traces in pld files\n"
+         << "  --seed <number>               | Seed of the random numbers (default=1)\n"
+         << "  --help (-h)                   | Display this help dialogue.\n\n";
+}
+
+///Opens the next output file, or the first one of the run.
+///@param[in] file : The output file to open
+///@param[in] title : The title of the run
+///@param[in] runNumber : The run number, set to the run number of the file
+///@param[in] prefix : The prefix of the file names
+///@param[in] path : The directory for the files
+///@param[in] isContinued : True if this is the next file of the same run
+void OpenFile(PollOutputFile &file, const string &title, unsigned int &runNumber, const string &prefix,
+              const string &path, const bool &isContinued) {
+    if (!file.OpenNewFile(title, runNumber, prefix, path, isContinued))
+        throw runtime_error("dataGenerator - Unable to open an output file in " + path + " with the prefix " + prefix);
+    cout << "dataGenerator - Writing " << file.GetCurrentFilename() << endl;
+}
+
 int main(int argc, char *argv[]) {
-    const unsigned int channelNumber = 0;
-    vector<unsigned int> encodedData;
-    const unsigned int energy = 55;
-    const string firmware = "30474";
-    const unsigned int frequency = 250;
-    const unsigned int ldfFormatCode = 0;
-    const unsigned int moduleNumber = 0;
-    const unsigned int numberOfDataWords = 4;
-    const unsigned int numberOfDataBuffers = 2;
-    const string outputName = "dataGeneratorTest";
-    const string outputPath = "/tmp/";
-    const unsigned int pldFormatCode = 1;
-    const unsigned int slotNumber = moduleNumber + 2;
-    unsigned int runNumber = 0;
-    const string runTitle = "Constant Data with Energy = 55, Mod=Chan=Crate=0";
-    const unsigned int totalNumberOfWords = 6;
-
-    XiaListModeDataEncoder encoder(firmware, frequency);
-    XiaData data;
-
-    PollOutputFile pld;
-    pld.SetFileFormat(pldFormatCode);
-    pld.OpenNewFile(runTitle, runNumber, outputName, outputPath);
-
-    PollOutputFile ldf;
-    ldf.SetFileFormat(ldfFormatCode);
-    ldf.OpenNewFile(runTitle, runNumber, outputName, outputPath);
-
-    for(unsigned int i = 0; i < numberOfDataBuffers; i++) {
-        data.SetEnergy(energy);
-        data.SetEventTimeLow(i);
-        data.SetSlotNumber(slotNumber);
-        data.SetChannelNumber(channelNumber);
-
-        try {
-            encodedData = encoder.EncodeXiaData(data);
-        } catch (invalid_argument &invalidArgument) {
-            cout << invalidArgument.what() << endl;
-            return 1;
+    SyntheticRunSettings settings;
+    string outputName = "synthetic";
+    string outputPath = "./";
+    string format = "pld";
+    string runTitle;
+    string firmware = "30474";
+    unsigned int frequency = 250;
+    unsigned int numberOfModules = 1;
+    vector<pair<unsigned int, SyntheticModule> > moduleOverrides;
+    double duration = 10;
+    double maxMegabytes = 0;
+    bool compressTraces = false;
+
+    struct option longOpts[] = {
+            {"output",         required_argument, NULL, 'o'},
+            {"path",           required_argument, NULL, 'p'},
+            {"format",         required_argument, NULL, 'f'},
+            {"title",          required_argument, NULL, 0},
+            {"duration",       required_argument, NULL, 'd'},
+            {"size",           required_argument, NULL, 's'},
+            {"modules",        required_argument, NULL, 'm'},
+            {"firmware",       required_argument, NULL, 0},
+            {"frequency",      required_argument, NULL, 0},
+            {"module",         required_argument, NULL, 0},
+            {"channels",       required_argument, NULL, 'c'},
+            {"rate",           required_argument, NULL, 'r'},
+            {"multiplicity",   required_argument, NULL, 0},
+            {"pileup",         required_argument, NULL, 0},
+            {"trace-length",   required_argument, NULL, 't'},
+            {"trace-fraction", required_argument, NULL, 0},
+            {"qdc",            no_argument,       NULL, 0},
+            {"esums",          no_argument,       NULL, 0},
+            {"ets",            no_argument,       NULL, 0},
+            {"spill-time",     required_argument, NULL, 0},
+            {"spill-words",    required_argument, NULL, 0},
+            {"compress",       no_argument,       NULL, 0},
+            {"seed",           required_argument, NULL, 0},
+            {"help",           no_argument,       NULL, 'h'},
+            {NULL,             no_argument,       NULL, 0}
+    };
+
+    int idx = 0;
+    int retval = 0;
+    try {
+        while ((retval = getopt_long(argc, argv, "o:p:f:d:s:m:c:r:t:h", longOpts, &idx)) != -1) {
+            const string name = retval == 0 ? longOpts[idx].name : "";
+            if (retval == 'o')
+                outputName = optarg;
+            else if (retval == 'p')
+                outputPath = optarg;
+            else if (retval == 'f')
+                format = optarg;
+            else if (retval == 'd')
+                duration = stod(optarg);
+            else if (retval == 's')
+                maxMegabytes = stod(optarg);
+            else if (retval == 'm')
+                numberOfModules = (unsigned int) stoul(optarg);
+            else if (retval == 'c')
+                settings.channelsPerModule = (unsigned int) stoul(optarg);
+            else if (retval == 'r')
+                settings.eventRate = stod(optarg);
+            else if (retval == 't')
+                settings.traceLength = (unsigned int) stoul(optarg);
+            else if (name == "title")
+                runTitle = optarg;
+            else if (name == "firmware")
+                firmware = optarg;
+            else if (name == "frequency")
+                frequency = (unsigned int) stoul(optarg);
+            else if (name == "module") {
+                vector<string> tokens = StringManipulation::TokenizeString(optarg, ":");
+                if (tokens.size() != 3)
+                    throw invalid_argument("dataGenerator - A module is given as <mod:firmware:freq>, not " +
+                                           string(optarg));
+                moduleOverrides.push_back(make_pair((unsigned int) stoul(tokens[0]),
+                                                    SyntheticModule(tokens[1], (unsigned int) stoul(tokens[2]))));
+            } else if (name == "multiplicity")
+                settings.multiplicity = stod(optarg);
+            else if (name == "pileup")
+                settings.pileupFraction = stod(optarg);
+            else if (name == "trace-fraction")
+                settings.traceFraction = stod(optarg);
+            else if (name == "qdc")
+                settings.hasQdc = true;
+            else if (name == "esums")
+                settings.hasEnergySums = true;
+            else if (name == "ets")
+                settings.hasExternalTimestamp = true;
+            else if (name == "spill-time")
+                settings.spillDuration = stod(optarg);
+            else if (name == "spill-words")
+                settings.maxSpillWords = (unsigned int) stoul(optarg);
+            else if (name == "compress")
+                compressTraces = true;
+            else if (name == "seed")
+                settings.seed = (unsigned int) stoul(optarg);
+            else {
+                help(argv[0]);
+                return retval == 'h' ? 0 : 1;
+            }
+        }
+
+        if (format != "pld" && format != "ldf" && format != "both")
+            throw invalid_argument("dataGenerator - Unknown output format " + format + ", use pld, ldf or both.");
+        if (duration <= 0 && maxMegabytes <= 0)
+            throw invalid_argument("dataGenerator - The run needs a duration or a size.");
+
+        settings.modules.assign(numberOfModules, SyntheticModule(firmware, frequency));
+        for (vector<pair<unsigned int, SyntheticModule> >::iterator it = moduleOverrides.begin();
+             it != moduleOverrides.end(); it++) {
+            if (it->first >= settings.modules.size())
+                settings.modules.resize(it->first + 1, SyntheticModule(firmware, frequency));
+            settings.modules[it->first] = it->second;
         }
 
-        encodedData.emplace(encodedData.begin(), numberOfDataWords);
-        encodedData.emplace(encodedData.begin() + 1, moduleNumber);
+        SyntheticRunGenerator generator(settings);
 
-        array<char*, totalNumberOfWords> dataArray{reinterpret_cast<char*>(&encodedData[0]),
-                                                   reinterpret_cast<char*>(&encodedData[1]),
-                                                   reinterpret_cast<char*>(&encodedData[2]),
-                                                   reinterpret_cast<char*>(&encodedData[3]),
-                                                   reinterpret_cast<char*>(&encodedData[4]),
-                                                   reinterpret_cast<char*>(&encodedData[5])};
+        if (runTitle.empty())
+            runTitle = "Synthetic data with seed " + to_string(settings.seed);
+        for (unsigned int i = 0; i < settings.modules.size(); i++)
+            cout << "dataGenerator - Module " << i << " : firmware " << settings.modules[i].firmware << " at "
+                 << settings.modules[i].frequency << " MS/s" << endl;
 
-        pld.Write(dataArray[0], totalNumberOfWords);
-        ldf.Write(dataArray[0], totalNumberOfWords);
+        vector<PollOutputFile *> files;
+        if (format != "ldf")
+            files.push_back(new PollOutputFile());
+        if (format != "pld")
+            files.push_back(new PollOutputFile());
+        vector<unsigned int> runNumbers(files.size(), 0);
+
+        for (unsigned int i = 0; i < files.size(); i++) {
+            const bool isPld = format != "ldf" && i == 0;
+            files[i]->SetFileFormat(isPld ? 1 : 0);
+            files[i]->SetCompressTraces(isPld && compressTraces);
+            OpenFile(*files[i], runTitle, runNumbers[i], outputName, outputPath, false);
+        }
+
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        const double maxBytes = maxMegabytes * 1024. * 1024.;
+        double bytes = 0;
+
+        while ((duration <= 0 || generator.GetRunTime() < duration) && (maxBytes <= 0 || bytes < maxBytes)) {
+            const vector<unsigned int> &spill = generator.NextSpill();
+            bytes += 4. * spill.size();
+
+            for (unsigned int i = 0; i < files.size(); i++) {
+                if (files[i]->GetFilesize() + (streampos) (4 * spill.size() + EOF_BUFFER_BYTES) > MAX_FILE_SIZE) {
+                    files[i]->CloseFile((float) generator.GetRunTime());
+                    OpenFile(*files[i], runTitle, runNumbers[i], outputName, outputPath, true);
+                }
+                if (files[i]->Write((char *) &spill[0], (unsigned int) spill.size()) < 0)
+                    throw runtime_error("dataGenerator - Unable to write to " + files[i]->GetCurrentFilename());
+            }
+        }
+
+        for (unsigned int i = 0; i < files.size(); i++) {
+            files[i]->CloseFile((float) generator.GetRunTime());
+            delete files[i];
+        }
+
+        const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "dataGenerator - Generated " << generator.GetNumberOfSpills() << " spills, "
+             << generator.GetNumberOfEvents() << " events and " << generator.GetNumberOfHits() << " hits ("
+             << generator.GetNumberOfPileups() << " piled up) covering " << generator.GetRunTime() << " s." << endl
+             << "dataGenerator - Wrote " << StringManipulation::FormatHumanReadableSizes(bytes) << " of data in "
+             << elapsed << " s (" << StringManipulation::FormatHumanReadableSizes(bytes / elapsed) << "/s)." << endl;
+    } catch (exception &ex) {
+        cerr << ex.what() << endl;
+        return 1;
     }
-    pld.CloseFile();
-    ldf.CloseFile();
-}
\ No newline at end of file
+
+    return 0;
+}
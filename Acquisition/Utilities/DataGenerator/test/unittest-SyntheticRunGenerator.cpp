@@ -0,0 +1,142 @@
+///@file unittest-SyntheticRunGenerator.cpp
+///@brief Unit tests for the generator of synthetic runs
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <stdexcept>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "SyntheticRunGenerator.hpp"
+#include "XiaListModeDataDecoder.hpp"
+
+using namespace std;
+
+///Decodes every module buffer of a spill with the mask of its module, and checks that nothing was skipped.
+///@return The hits in the spill, which the caller deletes.
+static vector<XiaData *> DecodeSpill(const vector<unsigned int> &spill, const SyntheticRunSettings &settings) {
+    vector<unsigned int> words(spill);
+    vector<XiaData *> hits;
+    unsigned int position = 0;
+    unsigned int module = 0;
+    while (position < words.size()) {
+        CHECK_EQUAL(module, words[position + 1]);
+        XiaListModeDataMask mask(settings.modules[module].firmware, settings.modules[module].frequency);
+        XiaListModeDataDecoder decoder;
+        vector<XiaData *> decoded = decoder.DecodeBuffer(&words[position], mask);
+        CHECK_EQUAL(0u, decoder.GetNumberOfSkippedBuffers());
+        hits.insert(hits.end(), decoded.begin(), decoded.end());
+        position += words[position];
+        module++;
+    }
+    CHECK_EQUAL((unsigned int) words.size(), position);
+    CHECK_EQUAL((unsigned int) settings.modules.size(), module);
+    return hits;
+}
+
+static void DeleteHits(vector<XiaData *> &hits) {
+    for (vector<XiaData *>::iterator it = hits.begin(); it != hits.end(); it++)
+        delete *it;
+    hits.clear();
+}
+
+TEST(TestReproducibleRuns) {
+    SyntheticRunSettings settings;
+    settings.modules.resize(3);
+    settings.traceLength = 250;
+    settings.traceFraction = 0.5;
+    settings.pileupFraction = 0.1;
+    settings.multiplicity = 2.5;
+
+    SyntheticRunGenerator first(settings);
+    SyntheticRunGenerator second(settings);
+    settings.seed = 2;
+    SyntheticRunGenerator other(settings);
+
+    for (unsigned int i = 0; i < 5; i++) {
+        const vector<unsigned int> spill = first.NextSpill();
+        CHECK(spill == second.NextSpill());
+        CHECK(spill != other.NextSpill());
+    }
+    CHECK_EQUAL(first.GetNumberOfHits(), second.GetNumberOfHits());
+    CHECK_EQUAL(first.GetRunTime(), second.GetRunTime());
+    CHECK(first.GetRunTime() > 0);
+}
+
+TEST(TestDecodedSpills) {
+    SyntheticRunSettings settings;
+    settings.modules.clear();
+    settings.modules.push_back(SyntheticModule("30474", 250));
+    settings.modules.push_back(SyntheticModule("29432", 100));
+    settings.modules.push_back(SyntheticModule("R34688", 500));
+    settings.traceLength = 124;
+    settings.hasQdc = settings.hasEnergySums = settings.hasExternalTimestamp = true;
+    settings.pileupFraction = 0.2;
+    settings.multiplicity = 3;
+    settings.eventRate = 2.e4;
+
+    SyntheticRunGenerator generator(settings);
+    unsigned long long hitCount = 0;
+    unsigned long long pileupCount = 0;
+    for (unsigned int i = 0; i < 3; i++) {
+        vector<XiaData *> hits = DecodeSpill(generator.NextSpill(), settings);
+        for (vector<XiaData *>::const_iterator it = hits.begin(); it != hits.end(); it++) {
+            CHECK_EQUAL(settings.traceLength, (*it)->GetTraceLength());
+            CHECK_EQUAL((size_t) 8, (*it)->GetQdc().size());
+            CHECK((*it)->GetExternalTimeLow() != 0);
+            CHECK((*it)->GetEnergy() > 0);
+            if ((*it)->IsPileup())
+                pileupCount++;
+        }
+        hitCount += hits.size();
+        DeleteHits(hits);
+    }
+
+    CHECK_EQUAL(generator.GetNumberOfHits(), hitCount);
+    CHECK_EQUAL(generator.GetNumberOfPileups(), pileupCount);
+    CHECK(generator.GetNumberOfHits() > 2 * generator.GetNumberOfEvents());
+    CHECK(pileupCount > 0);
+}
+
+TEST(TestFullSpills) {
+    SyntheticRunSettings settings;
+    settings.traceLength = 1000;
+    settings.eventRate = 1.e6;
+    settings.maxSpillWords = 20000;
+
+    SyntheticRunGenerator generator(settings);
+    const vector<unsigned int> &spill = generator.NextSpill();
+    CHECK(spill.size() <= settings.maxSpillWords);
+    CHECK(generator.GetRunTime() < settings.spillDuration);
+
+    vector<XiaData *> hits = DecodeSpill(spill, settings);
+    CHECK_EQUAL(generator.GetNumberOfHits(), (unsigned long long) hits.size());
+    DeleteHits(hits);
+}
+
+TEST(TestBadSettings) {
+    SyntheticRunSettings settings;
+    settings.traceLength = 11;
+    CHECK_THROW(SyntheticRunGenerator generator(settings), invalid_argument);
+
+    settings = SyntheticRunSettings();
+    settings.modules.assign(1, SyntheticModule("30474", 123));
+    CHECK_THROW(SyntheticRunGenerator generator(settings), invalid_argument);
+
+    settings = SyntheticRunSettings();
+    settings.modules.resize(15);
+    CHECK_THROW(SyntheticRunGenerator generator(settings), invalid_argument);
+
+    settings = SyntheticRunSettings();
+    settings.pileupFraction = 1.5;
+    CHECK_THROW(SyntheticRunGenerator generator(settings), invalid_argument);
+
+    settings = SyntheticRunSettings();
+    settings.traceLength = 8000;
+    settings.maxSpillWords = 1000;
+    CHECK_THROW(SyntheticRunGenerator generator(settings), invalid_argument);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,223 @@
+///@file BenchmarkReport.hpp
+///@brief Collects the throughput of each stage of the scan, writes it out as JSON and compares it with the results
+/// of an earlier build.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_BENCHMARKREPORT_HPP
+#define PIXIESUITE_BENCHMARKREPORT_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+///The throughput of one stage of the scan on one workload.
+struct BenchmarkResult {
+    std::string stage; ///< The stage of the scan, e.g. read, decode, build, analyze or process
+    std::string name; ///< The class or method that was measured
+    std::string workload; ///< A short description of the data that went through the stage
+    double seconds; ///< The time spent in the stage
+    unsigned long long bytes; ///< The number of bytes of raw data that went through the stage
+    unsigned long long hits; ///< The number of channel hits that went through the stage
+    bool isDerived; ///< True if the time is the difference of two measurements rather than measured on its own
+
+    ///@return The key that identifies the result between runs of the benchmark.
+    std::string GetKey() const { return stage + "/" + name + "/" + workload; }
+
+    ///@return The throughput in MB/s, zero when the stage doesn't see the raw data.
+    double GetMegabytesPerSecond() const { return seconds > 0 ? bytes / seconds / 1048576. : 0; }
+
+    ///@return The throughput in hits/s.
+    double GetHitsPerSecond() const { return seconds > 0 ? hits / seconds : 0; }
+};
+
+///Collects the results of a benchmark program. The command line options are shared by every benchmark:
+///  --output <file>    : Writes the results as JSON, one result per line so that they're easy to diff and parse
+///  --baseline <file>  : Compares the hits/s of every result with the same key in an earlier output
+///  --tolerance <pct>  : The slowdown that counts as a regression, 10 percent by default
+///  --repeats <number> : The number of times that each stage is timed, the fastest one is reported
+/// Anything else that starts with two dashes and has a value can be looked up with GetOption.
+class BenchmarkReport {
+public:
+    ///Constructor that parses the command line.
+    ///@param[in] suite : The name of the benchmark program
+    ///@param[in] argc : The number of command line arguments
+    ///@param[in] argv : The command line arguments
+    ///@throws invalid_argument if an option is missing its value
+    BenchmarkReport(const std::string &suite, int argc, char *argv[]) : suite_(suite) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc)
+                throw std::invalid_argument("BenchmarkReport::BenchmarkReport - Options are given as --<name> "
+                                                    "<value>, which " + arg + " isn't.");
+            options_[arg.substr(2)] = argv[++i];
+        }
+    }
+
+    ///@param[in] name : The name of the option without the dashes
+    ///@param[in] defaultValue : The value if the option wasn't given
+    ///@return The value of the option.
+    std::string GetOption(const std::string &name, const std::string &defaultValue = "") const {
+        std::map<std::string, std::string>::const_iterator it = options_.find(name);
+        return it == options_.end() ? defaultValue : it->second;
+    }
+
+    ///@return The number of times that each stage should be timed.
+    unsigned int GetRepeats() const { return (unsigned int) std::max(1, atoi(GetOption("repeats", "5").c_str())); }
+
+    ///Adds a result to the report.
+    ///@param[in] stage : The stage of the scan
+    ///@param[in] name : The class or method that was measured
+    ///@param[in] workload : The description of the data
+    ///@param[in] seconds : The time spent in the stage
+    ///@param[in] bytes : The number of bytes of raw data that went through the stage
+    ///@param[in] hits : The number of hits that went through the stage
+    ///@param[in] isDerived : True if the time is the difference of two measurements
+    void Add(const std::string &stage, const std::string &name, const std::string &workload, const double &seconds,
+             const unsigned long long &bytes, const unsigned long long &hits, const bool &isDerived = false) {
+        BenchmarkResult result = {stage, name, workload, seconds, bytes, hits, isDerived};
+        results_.push_back(result);
+    }
+
+    ///@return The results that have been added so far.
+    const std::vector<BenchmarkResult> &GetResults() const { return results_; }
+
+    ///Prints the results, writes them out if we were asked to, and compares them with the baseline.
+    ///@return Zero if there were no regressions, one otherwise, so that main can return it.
+    int Finish() const {
+        std::cout << std::left << std::setw(10) << "Stage" << std::setw(38) << "Name" << std::setw(22)
+                  << "Workload" << std::right << std::setw(12) << "MB/s" << std::setw(15) << "Hits/s" << std::endl;
+        for (std::vector<BenchmarkResult>::const_iterator it = results_.begin(); it != results_.end(); it++)
+            std::cout << std::left << std::setw(10) << it->stage << std::setw(38)
+                      << (it->isDerived ? it->name + " *" : it->name) << std::setw(22) << it->workload << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(12) << it->GetMegabytesPerSecond()
+                      << std::setprecision(0) << std::setw(15) << it->GetHitsPerSecond() << std::endl;
+        std::cout << "* The difference between two measurements." << std::endl;
+
+        if (!GetOption("output").empty())
+            Write(GetOption("output"));
+        return GetOption("baseline").empty() ? 0 : Compare(GetOption("baseline"));
+    }
+
+private:
+    std::string suite_; ///< The name of the benchmark program
+    std::map<std::string, std::string> options_; ///< The command line options
+    std::vector<BenchmarkResult> results_; ///< The results that have been added
+
+    ///@return The string with the characters that JSON doesn't allow in strings escaped.
+    static std::string Escape(const std::string &str) {
+        std::string escaped;
+        for (std::string::const_iterator it = str.begin(); it != str.end(); it++) {
+            if (*it == '"' || *it == '\\')
+                escaped += '\\';
+            escaped += *it;
+        }
+        return escaped;
+    }
+
+    ///Writes the results, each on its own line so that Compare can read them back without a JSON parser.
+    void Write(const std::string &fileName) const {
+        std::ofstream out(fileName.c_str());
+        if (!out)
+            throw std::invalid_argument("BenchmarkReport::Write - Unable to open " + fileName);
+
+        const std::time_t now = std::time(NULL);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        out << "{\n  \"suite\": \"" << Escape(suite_) << "\",\n  \"date\": \"" << date << "\",\n"
+            << "  \"compiler\": \"" << Escape(__VERSION__) << "\",\n  \"results\": [\n";
+        for (std::vector<BenchmarkResult>::const_iterator it = results_.begin(); it != results_.end(); it++)
+            out << "    {\"stage\": \"" << Escape(it->stage) << "\", \"name\": \"" << Escape(it->name)
+                << "\", \"workload\": \"" << Escape(it->workload) << "\", \"seconds\": " << std::setprecision(9)
+                << it->seconds << ", \"bytes\": " << it->bytes << ", \"hits\": " << it->hits << ", \"mb_per_s\": "
+                << std::fixed << std::setprecision(3) << it->GetMegabytesPerSecond() << ", \"hits_per_s\": "
+                << it->GetHitsPerSecond() << std::defaultfloat << ", \"derived\": "
+                << (it->isDerived ? "true" : "false") << "}" << (it + 1 == results_.end() ? "" : ",") << "\n";
+        out << "  ]\n}\n";
+    }
+
+    ///@return The value of a key on one of the result lines that Write made.
+    static std::string Find(const std::string &line, const std::string &key) {
+        const std::string tag = "\"" + key + "\": ";
+        size_t start = line.find(tag);
+        if (start == std::string::npos)
+            return "";
+        start += tag.size();
+        if (line[start] == '"') {
+            std::string value;
+            for (size_t i = start + 1; i < line.size() && line[i] != '"'; i++) {
+                if (line[i] == '\\' && i + 1 < line.size())
+                    i++;
+                value += line[i];
+            }
+            return value;
+        }
+        return line.substr(start, line.find_first_of(",}", start) - start);
+    }
+
+    ///Compares the hits/s of every result with the one that has the same key in the baseline.
+    int Compare(const std::string &fileName) const {
+        std::ifstream in(fileName.c_str());
+        if (!in)
+            throw std::invalid_argument("BenchmarkReport::Compare - Unable to open the baseline " + fileName);
+
+        std::map<std::string, double> baseline;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (Find(line, "stage").empty())
+                continue;
+            baseline[Find(line, "stage") + "/" + Find(line, "name") + "/" + Find(line, "workload")] =
+                    atof(Find(line, "hits_per_s").c_str());
+        }
+
+        const double tolerance = atof(GetOption("tolerance", "10").c_str());
+        int retval = 0;
+        std::cout << std::endl << "Comparison with " << fileName << " (regressions are more than " << tolerance
+                  << "% slower)" << std::endl;
+        for (std::vector<BenchmarkResult>::const_iterator it = results_.begin(); it != results_.end(); it++) {
+            std::map<std::string, double>::const_iterator match = baseline.find(it->GetKey());
+            if (match == baseline.end() || match->second <= 0) {
+                std::cout << std::left << std::setw(70) << it->GetKey() << " not in the baseline" << std::endl;
+                continue;
+            }
+            const double change = 100. * (it->GetHitsPerSecond() / match->second - 1);
+            const bool isRegression = change < -tolerance;
+            std::cout << std::left << std::setw(70) << it->GetKey() << std::right << std::showpos << std::fixed
+                      << std::setprecision(1) << std::setw(8) << change << "%" << std::noshowpos
+                      << (isRegression ? "  REGRESSION" : "") << std::endl;
+            if (isRegression)
+                retval = 1;
+        }
+        return retval;
+    }
+};
+
+///Times a piece of work a few times and keeps the fastest, which is the least disturbed by everything else going on
+/// in the machine.
+///@param[in] repeats : The number of times to do the work
+///@param[in] work : Does the work once, anything that needs to be reset between repeats must happen inside of it
+///@return The shortest time in seconds.
+template<typename Work>
+double TimeFastest(const unsigned int &repeats, Work work) {
+    double fastest = 0;
+    for (unsigned int i = 0; i < repeats; i++) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        work();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < fastest)
+            fastest = elapsed;
+    }
+    return fastest;
+}
+
+#endif //PIXIESUITE_BENCHMARKREPORT_HPP
@@ -0,0 +1,107 @@
+///@file SyntheticSpill.hpp
+///@brief Builds reproducible Pixie-16 spills for the scan library benchmarks.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_SYNTHETICSPILL_HPP
+#define PIXIESUITE_SYNTHETICSPILL_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cmath>
+
+#include "XiaData.hpp"
+#include "XiaListModeDataEncoder.hpp"
+
+///A spill in the same layout that ScanInterface hands to Unpacker::ReadSpill. Each module contributes a buffer that
+/// starts with the two words inserted by poll2 (buffer length and VSN), and the spill is terminated by the 2, 9999
+/// end of spill marker.
+struct SyntheticSpill {
+    std::vector<unsigned int> words; ///< The raw spill words
+    std::vector<unsigned int> moduleOffsets; ///< The offset of each module buffer in words
+    unsigned int numberOfHits; ///< The total number of channel hits in the spill
+};
+
+///Generates spills of list mode data with the XiaListModeDataEncoder. The time stamps continue from one spill to the
+/// next so that consecutive spills look like a real run. The random number generator is seeded so that every run of
+/// a benchmark sees exactly the same data.
+class SyntheticSpillGenerator {
+public:
+    ///Constructor
+    ///@param[in] numberOfModules : The number of modules in the crate
+    ///@param[in] hitsPerModule : The number of channel hits that each module contributes to a spill
+    ///@param[in] traceLength : The number of samples in each trace, 0 disables traces.
+    ///@param[in] meanTimeBetweenHits : The mean time between hits in a single module in clock ticks
+    ///@param[in] firmware : The firmware that we are going to encode
+    ///@param[in] frequency : The sampling frequency that we are going to encode
+    SyntheticSpillGenerator(const unsigned int &numberOfModules, const unsigned int &hitsPerModule,
+                            const unsigned int &traceLength = 0, const double &meanTimeBetweenHits = 500,
+                            const std::string &firmware = "30474", const unsigned int &frequency = 250) :
+            numberOfModules_(numberOfModules), hitsPerModule_(hitsPerModule), traceLength_(traceLength),
+            encoder_(firmware, frequency), generator_(20161223), timeBetweenHits_(1. / meanTimeBetweenHits),
+            moduleTimes_(numberOfModules, 1000) {}
+
+    ///@return The next spill in the run
+    SyntheticSpill Next() {
+        SyntheticSpill spill;
+        spill.numberOfHits = 0;
+
+        std::uniform_int_distribution<unsigned int> channel(0, 15);
+        std::uniform_real_distribution<double> energy(50, 16000);
+        XiaData data;
+
+        for (unsigned int mod = 0; mod < numberOfModules_; mod++) {
+            unsigned int offset = spill.words.size();
+            spill.moduleOffsets.push_back(offset);
+            spill.words.push_back(0);
+            spill.words.push_back(mod);
+
+            for (unsigned int hit = 0; hit < hitsPerModule_; hit++, spill.numberOfHits++) {
+                moduleTimes_[mod] += (unsigned long long) timeBetweenHits_(generator_) + 1;
+
+                data.Initialize();
+                data.SetSlotNumber(mod + 2);
+                data.SetChannelNumber(channel(generator_));
+                data.SetEnergy((unsigned int) energy(generator_));
+                data.SetEventTimeLow((unsigned int) (moduleTimes_[mod] & 0xFFFFFFFF));
+                data.SetEventTimeHigh((unsigned int) (moduleTimes_[mod] >> 32));
+                if (traceLength_ != 0)
+                    data.SetTrace(Pulse(data.GetEnergy()));
+
+                std::vector<unsigned int> encoded = encoder_.EncodeXiaData(data);
+                spill.words.insert(spill.words.end(), encoded.begin(), encoded.end());
+            }
+            spill.words[offset] = spill.words.size() - offset;
+        }
+
+        spill.words.push_back(2);
+        spill.words.push_back(9999);
+        return spill;
+    }
+
+private:
+    ///@return A double exponential pulse sitting on a noisy baseline.
+    std::vector<unsigned int> Pulse(const double &amplitude) {
+        std::normal_distribution<double> noise(0, 2);
+        std::vector<unsigned int> trace(traceLength_);
+        const double start = traceLength_ * 0.2;
+        for (unsigned int i = 0; i < traceLength_; i++) {
+            double value = 400 + noise(generator_);
+            if (i >= start)
+                value += 0.25 * amplitude * (std::exp(-(i - start) / 20.) - std::exp(-(i - start) / 2.));
+            trace[i] = value < 0 ? 0 : (value > 65535 ? 65535 : (unsigned int) value);
+        }
+        return trace;
+    }
+
+    unsigned int numberOfModules_; ///< The number of modules in the spill
+    unsigned int hitsPerModule_; ///< The number of hits that each module provides
+    unsigned int traceLength_; ///< The number of samples in each trace
+    XiaListModeDataEncoder encoder_; ///< The encoder used to build the list mode data
+    std::mt19937 generator_; ///< The random number generator
+    std::exponential_distribution<double> timeBetweenHits_; ///< Distribution of the time between hits in a module
+    std::vector<unsigned long long> moduleTimes_; ///< The time of the last hit in each module
+};
+
+#endif //PIXIESUITE_SYNTHETICSPILL_HPP
@@ -0,0 +1,171 @@
+///@file benchmark-MappedFile.cpp
+///@brief Compares reading PLD and LDF files through std::ifstream against reading them from a memory mapped file.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <cstdio>
+
+#include "hribf_buffers.h"
+#include "MappedFile.h"
+#include "SyntheticSpill.hpp"
+
+using namespace std;
+
+///Holds the results of a single benchmark so that they can be output in a table.
+struct Result {
+    string name;
+    unsigned long numberOfSpills;
+    unsigned long long checksum;
+    double megabytesPerSecond;
+};
+
+///Adds up every word in the spill. This makes sure that each read actually touches the data, which is what the
+/// Unpacker will do with it.
+static unsigned long long Checksum(const unsigned int *data, const unsigned int &nWords) {
+    unsigned long long sum = 0;
+    for (unsigned int i = 0; i < nWords; i++)
+        sum += data[i];
+    return sum;
+}
+
+static void WriteFiles(const string &pld, const string &ldf, const unsigned int &numberOfSpills,
+                       SyntheticSpillGenerator &generator, unsigned int &maxSpillSize) {
+    ofstream pldFile(pld.c_str(), ios::binary), ldfFile(ldf.c_str(), ios::binary);
+    PLD_data pldData;
+    DATA_buffer ldfData;
+    EOF_buffer eof;
+    int buffersWritten;
+    maxSpillSize = 0;
+
+    for (unsigned int i = 0; i < numberOfSpills; i++) {
+        SyntheticSpill spill = generator.Next();
+        //The files hold the spill without the end of spill flag, which the scan code adds on its own.
+        unsigned int nWords = spill.words.size() - 2;
+        pldData.Write(&pldFile, (char *) &spill.words[0], nWords);
+        ldfData.Write(&ldfFile, (char *) &spill.words[0], nWords, buffersWritten);
+        if (nWords > maxSpillSize)
+            maxSpillSize = nWords;
+    }
+
+    ldfData.Close(&ldfFile);
+    eof.Write(&pldFile);
+    eof.Write(&ldfFile);
+    eof.Write(&ldfFile);
+}
+
+static Result Finish(const string &name, const unsigned long &spills, const unsigned long long &checksum,
+                     const unsigned long &bytes, const chrono::steady_clock::time_point &start) {
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    Result result = {name, spills, checksum, bytes / elapsed.count() / 1048576.};
+    return result;
+}
+
+static Result ReadPldStream(const string &fname, const unsigned int &maxSpillSize) {
+    ifstream file(fname.c_str(), ios::binary);
+    PLD_data reader;
+    vector<unsigned int> data(maxSpillSize + 2);
+    unsigned int nBytes;
+    unsigned long spills = 0, bytes = 0;
+    unsigned long long checksum = 0;
+
+    auto start = chrono::steady_clock::now();
+    while (reader.Read(&file, (char *) &data[0], nBytes, 4 * maxSpillSize)) {
+        checksum += Checksum(&data[0], nBytes / 4);
+        bytes += nBytes;
+        spills++;
+    }
+    return Finish("PLD ifstream", spills, checksum, bytes, start);
+}
+
+static Result ReadPldMapped(const string &fname, const unsigned int &maxSpillSize) {
+    auto start = chrono::steady_clock::now();
+    MappedFile file;
+    file.Open(fname);
+    PLD_data reader;
+    unsigned int *data;
+    unsigned int nBytes;
+    unsigned long spills = 0, bytes = 0;
+    unsigned long long checksum = 0;
+
+    while (reader.Read(&file, data, nBytes, 4 * maxSpillSize)) {
+        checksum += Checksum(data, nBytes / 4);
+        bytes += nBytes;
+        spills++;
+    }
+    return Finish("PLD MappedFile", spills, checksum, bytes, start);
+}
+
+template<typename T>
+static Result ReadLdf(const string &name, T &file) {
+    DATA_buffer reader;
+    vector<unsigned int> data(250000);
+    unsigned int nBytes;
+    bool fullSpill, badSpill;
+    unsigned long spills = 0, bytes = 0;
+    unsigned long long checksum = 0;
+
+    auto start = chrono::steady_clock::now();
+    while (true) {
+        if (!reader.Read(&file, (char *) &data[0], nBytes, 1000000, fullSpill, badSpill)) {
+            if (reader.GetRetval() == 2 || reader.GetRetval() == 6)
+                break;
+            continue;
+        }
+        //Don't count the end of spill flag that the reader stitches onto the spill.
+        checksum += Checksum(&data[0], nBytes / 4 - 2);
+        bytes += nBytes - 8;
+        spills++;
+    }
+    return Finish(name, spills, checksum, bytes, start);
+}
+
+int main(int argc, char *argv[]) {
+    const string prefix = argc > 1 ? argv[1] : "/tmp/benchmark-MappedFile";
+    const unsigned int numberOfSpills = 150;
+    const string pld = prefix + ".pld", ldf = prefix + ".ldf";
+
+    //Keep the spills under the 250000 words that ScanInterface allocates for an ldf spill.
+    SyntheticSpillGenerator generator(13, 100, 250);
+    unsigned int maxSpillSize;
+    WriteFiles(pld, ldf, numberOfSpills, generator, maxSpillSize);
+
+    cout << "Files : " << numberOfSpills << " spills of up to " << maxSpillSize << " words in " << prefix
+         << ".{pld,ldf}" << endl;
+
+    //The first pass of each file warms up the page cache, since we're interested in re-scan speed.
+    ReadPldStream(pld, maxSpillSize);
+
+    vector<Result> results;
+    results.push_back(ReadPldStream(pld, maxSpillSize));
+    results.push_back(ReadPldMapped(pld, maxSpillSize));
+
+    ifstream ldfStream(ldf.c_str(), ios::binary);
+    ReadLdf("", ldfStream);
+    ldfStream.clear();
+    ldfStream.seekg(0);
+    results.push_back(ReadLdf("LDF ifstream", ldfStream));
+    MappedFile ldfMapped;
+    ldfMapped.Open(ldf);
+    results.push_back(ReadLdf("LDF MappedFile", ldfMapped));
+
+    remove(pld.c_str());
+    remove(ldf.c_str());
+
+    cout << left << setw(20) << "Benchmark" << right << setw(10) << "Spills" << setw(25) << "Checksum"
+         << setw(15) << "MB/s" << endl;
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++)
+        cout << left << setw(20) << it->name << right << setw(10) << it->numberOfSpills << setw(25)
+             << it->checksum << fixed << setprecision(1) << setw(15) << it->megabytesPerSecond << endl;
+
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++) {
+        if (it->numberOfSpills != numberOfSpills || it->checksum != results.front().checksum) {
+            cerr << it->name << " did not read the same data that was written!" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
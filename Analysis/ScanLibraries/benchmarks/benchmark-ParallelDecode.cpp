@@ -0,0 +1,102 @@
+///@file benchmark-ParallelDecode.cpp
+///@brief Measures how fast Unpacker::ReadSpill decodes trace heavy spills when the module buffers are decoded in
+/// parallel.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "SyntheticSpill.hpp"
+#include "Unpacker.hpp"
+#include "XiaData.hpp"
+
+using namespace std;
+
+///An Unpacker that only adds up what it's given, so that the benchmark is dominated by the decoding. The checksum
+/// lets us make sure that every mode built exactly the same events.
+class ChecksumUnpacker : public Unpacker {
+public:
+    ChecksumUnpacker() : Unpacker(), numberOfEvents(0), checksum(0) {}
+
+    unsigned long numberOfEvents;
+    unsigned long long checksum;
+
+private:
+    void ProcessRawEvent() {
+        for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+            checksum += (unsigned long long) (*it)->GetFilterTime() + (unsigned long long) (*it)->GetEnergy()
+                        + (*it)->GetRawTrace().size() + (*it)->GetId();
+        numberOfEvents++;
+        rawEvent.clear();
+    }
+};
+
+///Holds the results of a single benchmark so that they can be output in a table.
+struct Result {
+    unsigned int numberOfThreads;
+    unsigned long numberOfEvents;
+    unsigned long long checksum;
+    double megabytesPerSecond;
+};
+
+static Result Unpack(vector<SyntheticSpill> &spills, const unsigned int &numberOfThreads) {
+    ChecksumUnpacker unpacker;
+    unpacker.InitializeDataMask("30474", 250);
+    unpacker.SetDecodeThreads(numberOfThreads);
+
+    //Warm up the pools with the first spill.
+    unpacker.ReadSpill(&spills[0].words[0], spills[0].words.size(), false);
+    unpacker.numberOfEvents = 0;
+    unpacker.checksum = 0;
+
+    unsigned long bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for (vector<SyntheticSpill>::iterator it = spills.begin() + 1; it != spills.end(); it++) {
+        unpacker.ReadSpill(&it->words[0], it->words.size(), false);
+        bytes += it->words.size() * sizeof(unsigned int);
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    Result result = {unpacker.GetDecodeThreads(), unpacker.numberOfEvents, unpacker.checksum,
+                     bytes / elapsed.count() / 1048576.};
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const unsigned int numberOfSpills = 41;
+    const unsigned int numberOfModules = 13;
+    const unsigned int hitsPerModule = 150;
+    //Keep the spills under the Unpacker's limit of a million words.
+    const unsigned int traceLength = 500;
+
+    SyntheticSpillGenerator generator(numberOfModules, hitsPerModule, traceLength);
+    vector<SyntheticSpill> spills;
+    for (unsigned int i = 0; i < numberOfSpills; i++)
+        spills.push_back(generator.Next());
+
+    cout << "Spill : " << numberOfModules << " modules x " << hitsPerModule << " hits, " << traceLength
+         << " sample traces, " << thread::hardware_concurrency() << " hardware threads" << endl;
+
+    vector<Result> results;
+    const unsigned int threads[] = {1, 2, 4, 8, 13};
+    for (unsigned int i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+        results.push_back(Unpack(spills, threads[i]));
+
+    cout << right << setw(10) << "Threads" << setw(12) << "Events" << setw(25) << "Checksum" << setw(12) << "MB/s"
+         << setw(12) << "Speedup" << endl;
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++)
+        cout << setw(10) << it->numberOfThreads << setw(12) << it->numberOfEvents << setw(25) << it->checksum << fixed
+             << setprecision(1) << setw(12) << it->megabytesPerSecond << setprecision(2) << setw(12)
+             << it->megabytesPerSecond / results.front().megabytesPerSecond << endl;
+
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++) {
+        if (it->numberOfEvents == 0 || it->numberOfEvents != results.front().numberOfEvents
+            || it->checksum != results.front().checksum) {
+            cerr << "Decoding on " << it->numberOfThreads << " threads did not build the same events!" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
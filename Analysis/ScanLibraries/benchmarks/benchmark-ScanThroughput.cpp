@@ -0,0 +1,181 @@
+///@file benchmark-ScanThroughput.cpp
+///@brief Measures the MB/s and hits/s of each stage that a spill goes through in the scan libraries: reading it from
+/// a PLD or LDF file, decoding the module buffers and building the raw events.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <fstream>
+#include <iostream>
+
+#include <cstdio>
+
+#include "BenchmarkReport.hpp"
+#include "hribf_buffers.h"
+#include "SyntheticSpill.hpp"
+#include "Unpacker.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
+
+using namespace std;
+
+///The data that every stage of the benchmark runs over.
+struct Workload {
+    string name; ///< The name of the workload in the report
+    vector<SyntheticSpill> spills; ///< The spills, each ends with the end of spill flag
+    unsigned long long bytes; ///< The number of bytes in the spills, without the end of spill flags
+    unsigned long long hits; ///< The number of hits in the spills
+};
+
+///An Unpacker that only counts the events that it built, so that we time the decoding and the event building.
+class CountingUnpacker : public Unpacker {
+public:
+    CountingUnpacker() : Unpacker(), numberOfHits(0) {}
+
+    unsigned long long numberOfHits;
+
+private:
+    void ProcessRawEvent() {
+        numberOfHits += rawEvent.size();
+        rawEvent.clear();
+    }
+};
+
+static Workload MakeWorkload(const string &name, const unsigned int &numberOfSpills, const unsigned int &modules,
+                             const unsigned int &hitsPerModule, const unsigned int &traceLength) {
+    SyntheticSpillGenerator generator(modules, hitsPerModule, traceLength);
+    Workload workload = {name, vector<SyntheticSpill>(), 0, 0};
+    for (unsigned int i = 0; i < numberOfSpills; i++) {
+        workload.spills.push_back(generator.Next());
+        workload.bytes += 4 * (workload.spills.back().words.size() - 2);
+        workload.hits += workload.spills.back().numberOfHits;
+    }
+    return workload;
+}
+
+///Writes the workload in the same way that poll2 does, the files don't have the end of spill flags.
+static void WriteFiles(const Workload &workload, const string &pld, const string &ldf) {
+    ofstream pldFile(pld.c_str(), ios::binary), ldfFile(ldf.c_str(), ios::binary);
+    PLD_data pldData;
+    DATA_buffer ldfData;
+    EOF_buffer eof;
+    int buffersWritten;
+
+    for (vector<SyntheticSpill>::const_iterator it = workload.spills.begin(); it != workload.spills.end(); it++) {
+        pldData.Write(&pldFile, (char *) &it->words[0], it->words.size() - 2);
+        ldfData.Write(&ldfFile, (char *) &it->words[0], it->words.size() - 2, buffersWritten);
+    }
+
+    ldfData.Close(&ldfFile);
+    eof.Write(&pldFile);
+    eof.Write(&ldfFile);
+    eof.Write(&ldfFile);
+}
+
+///Reads every spill in a PLD file the way ScanInterface does when it isn't memory mapped.
+static unsigned long long ReadPld(const string &fname) {
+    ifstream file(fname.c_str(), ios::binary);
+    PLD_data reader;
+    vector<unsigned int> data(1000002);
+    unsigned int nBytes;
+    unsigned long long bytes = 0;
+    while (reader.Read(&file, (char *) &data[0], nBytes, 4000000))
+        bytes += nBytes;
+    return bytes;
+}
+
+///Reads every spill in a LDF file the way ScanInterface does when it isn't memory mapped.
+static unsigned long long ReadLdf(const string &fname) {
+    ifstream file(fname.c_str(), ios::binary);
+    DATA_buffer reader;
+    vector<unsigned int> data(250000);
+    unsigned int nBytes;
+    bool fullSpill, badSpill;
+    unsigned long long bytes = 0;
+    while (true) {
+        if (!reader.Read(&file, (char *) &data[0], nBytes, 1000000, fullSpill, badSpill)) {
+            if (reader.GetRetval() == 2 || reader.GetRetval() == 6)
+                break;
+            continue;
+        }
+        bytes += nBytes - 8;
+    }
+    return bytes;
+}
+
+///Checks that a stage saw all of the data, a benchmark that skipped some of it would look a lot faster than it is.
+static void Check(const string &stage, const unsigned long long &expected, const unsigned long long &actual) {
+    if (expected != actual)
+        throw runtime_error("benchmark-ScanThroughput - The " + stage + " stage saw " + to_string(actual)
+                            + " rather than " + to_string(expected) + ".");
+}
+
+static void Run(BenchmarkReport &report, Workload &workload, const string &prefix) {
+    const unsigned int repeats = report.GetRepeats();
+    const string pld = prefix + ".pld", ldf = prefix + ".ldf";
+    WriteFiles(workload, pld, ldf);
+
+    //The first pass of each file warms up the page cache, we want the speed of the readers rather than of the disk.
+    unsigned long long bytes = ReadPld(pld);
+    Check("PLD read", workload.bytes, bytes);
+    report.Add("read", "PLD_data::Read", workload.name, TimeFastest(repeats, [&]() { ReadPld(pld); }),
+               workload.bytes, workload.hits);
+
+    bytes = ReadLdf(ldf);
+    Check("LDF read", workload.bytes, bytes);
+    report.Add("read", "DATA_buffer::Read", workload.name, TimeFastest(repeats, [&]() { ReadLdf(ldf); }),
+               workload.bytes, workload.hits);
+
+    remove(pld.c_str());
+    remove(ldf.c_str());
+
+    //Decode the module buffers with a resolved layout into a pool, which is what the Unpacker does.
+    const XiaListModeDataMask mask("30474", 250);
+    const XiaListModeDataLayout layout(mask);
+    XiaListModeDataDecoder decoder;
+    XiaDataPool pool;
+    unsigned long long hits = 0;
+    const double decodeTime = TimeFastest(repeats, [&]() {
+        hits = 0;
+        for (vector<SyntheticSpill>::iterator it = workload.spills.begin(); it != workload.spills.end(); it++) {
+            pool.Reset();
+            for (vector<unsigned int>::const_iterator offset = it->moduleOffsets.begin();
+                 offset != it->moduleOffsets.end(); offset++)
+                hits += decoder.DecodeBuffer(&it->words[*offset], layout, &pool).size();
+        }
+    });
+    Check("decode", workload.hits, hits);
+    report.Add("decode", "XiaListModeDataDecoder::DecodeBuffer", workload.name, decodeTime, workload.bytes,
+               workload.hits);
+
+    //The event builder can't be called on its own, so its time is what ReadSpill takes on top of the decoding.
+    const double readSpillTime = TimeFastest(repeats, [&]() {
+        CountingUnpacker unpacker;
+        unpacker.InitializeDataMask("30474", 250);
+        for (vector<SyntheticSpill>::iterator it = workload.spills.begin(); it != workload.spills.end(); it++)
+            unpacker.ReadSpill(&it->words[0], it->words.size(), false);
+        hits = unpacker.numberOfHits;
+    });
+    Check("build", workload.hits, hits);
+    report.Add("unpack", "Unpacker::ReadSpill", workload.name, readSpillTime, workload.bytes, workload.hits);
+    report.Add("build", "Unpacker::BuildRawEvents", workload.name, max(readSpillTime - decodeTime, 1.e-9),
+               workload.bytes, workload.hits, true);
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        BenchmarkReport report("ScanThroughput", argc, argv);
+        const string prefix = report.GetOption("prefix", "/tmp/benchmark-ScanThroughput");
+
+        //The spills stay under the 250000 words that ScanInterface allocates for an ldf spill.
+        Workload headers = MakeWorkload("13x1000 headers", 200, 13, 1000, 0);
+        Workload traces = MakeWorkload("13x100 250 samples", 200, 13, 100, 250);
+
+        cout << "benchmark-ScanThroughput - Timing each stage " << report.GetRepeats()
+             << " times and keeping the fastest" << endl;
+        Run(report, headers, prefix);
+        Run(report, traces, prefix);
+        return report.Finish();
+    } catch (exception &ex) {
+        cerr << ex.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,101 @@
+///@file benchmark-UnpackerPipeline.cpp
+///@brief Compares the spill throughput of the Unpacker with and without the decode/build/process pipeline.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "SyntheticSpill.hpp"
+#include "Unpacker.hpp"
+#include "XiaData.hpp"
+
+using namespace std;
+
+///An Unpacker that does a bit of trace analysis on each channel, which stands in for the DetectorDriver. The checksum
+/// lets us make sure that both modes processed exactly the same events.
+class AnalysisUnpacker : public Unpacker {
+public:
+    AnalysisUnpacker() : Unpacker(), numberOfEvents(0), checksum(0) {}
+
+    unsigned long numberOfEvents;
+    unsigned long long checksum;
+
+private:
+    void ProcessRawEvent() {
+        for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++) {
+            const vector<unsigned short> &trace = (*it)->GetRawTrace();
+            unsigned long long baseline = 0, area = 0;
+            for (unsigned int i = 0; i < trace.size(); i++) {
+                if (i < 20)
+                    baseline += trace[i];
+                area += trace[i];
+            }
+            checksum += area - (trace.size() / 20) * baseline + (unsigned long long) (*it)->GetFilterTime();
+        }
+        checksum += (unsigned long long) GetEventStartTime();
+        numberOfEvents++;
+        rawEvent.clear();
+    }
+};
+
+///Holds the results of a single benchmark so that they can be output in a table.
+struct Result {
+    string name;
+    unsigned long numberOfEvents;
+    unsigned long long checksum;
+    double spillsPerSecond;
+};
+
+static Result Unpack(const string &name, vector<SyntheticSpill> &spills, const unsigned int &depth) {
+    AnalysisUnpacker unpacker;
+    unpacker.InitializeDataMask("30474", 250);
+    if (depth != 0)
+        unpacker.StartPipeline(depth);
+
+    auto start = chrono::steady_clock::now();
+    for (vector<SyntheticSpill>::iterator it = spills.begin(); it != spills.end(); it++)
+        unpacker.ReadSpill(&it->words[0], it->words.size(), false);
+    unpacker.WaitForPipeline();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    unpacker.StopPipeline();
+    Result result = {name, unpacker.numberOfEvents, unpacker.checksum, spills.size() / elapsed.count()};
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const unsigned int numberOfSpills = 100;
+    const unsigned int numberOfModules = 13;
+    const unsigned int hitsPerModule = 200;
+    const unsigned int traceLength = 250;
+
+    SyntheticSpillGenerator generator(numberOfModules, hitsPerModule, traceLength);
+    vector<SyntheticSpill> spills;
+    for (unsigned int i = 0; i < numberOfSpills; i++)
+        spills.push_back(generator.Next());
+
+    cout << "Spill : " << numberOfModules << " modules x " << hitsPerModule << " hits, " << traceLength
+         << " sample traces, " << numberOfSpills << " spills" << endl;
+
+    vector<Result> results;
+    results.push_back(Unpack("Synchronous", spills, 0));
+    results.push_back(Unpack("Pipeline (depth 2)", spills, 2));
+    results.push_back(Unpack("Pipeline (depth 4)", spills, 4));
+    results.push_back(Unpack("Pipeline (depth 8)", spills, 8));
+
+    cout << left << setw(25) << "Benchmark" << right << setw(12) << "Events" << setw(25) << "Checksum"
+         << setw(15) << "Spills/s" << setw(12) << "Speedup" << endl;
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++)
+        cout << left << setw(25) << it->name << right << setw(12) << it->numberOfEvents << setw(25) << it->checksum
+             << fixed << setprecision(1) << setw(15) << it->spillsPerSecond << setprecision(2) << setw(12)
+             << it->spillsPerSecond / results.front().spillsPerSecond << endl;
+
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++) {
+        if (it->numberOfEvents != results.front().numberOfEvents || it->checksum != results.front().checksum) {
+            cerr << it->name << " did not process the same events as the synchronous unpacker!" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+///@file benchmark-XiaDataMerger.cpp
+///@brief Compares the event building throughput of the k-way merge against the original module by module scan.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+#include "SyntheticSpill.hpp"
+#include "XiaDataMerger.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
+
+using namespace std;
+
+typedef vector<deque<XiaData *> > EventList;
+
+///Holds the results of a single benchmark so that they can be output in a table.
+struct Result {
+    string name;
+    unsigned long numberOfEvents;
+    double eventsPerSecond;
+    double hitsPerSecond;
+};
+
+///Builds the events in the same way that Unpacker::BuildRawEvent did before the merger. Every module is sorted, the
+/// start of each event is found by scanning the head of every module, and then every module is walked to collect the
+/// hits that fall inside of the window.
+static unsigned long LegacyBuild(EventList &eventList, const double &eventWidth, vector<XiaData *> &rawEvent) {
+    unsigned long numberOfEvents = 0;
+    for (EventList::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
+        sort(iter->begin(), iter->end(), &XiaData::CompareTime);
+
+    while (true) {
+        double eventStartTime = numeric_limits<double>::max();
+        bool empty = true;
+        for (EventList::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
+            if (iter->empty())
+                continue;
+            empty = false;
+            if (iter->front()->GetFilterTime() < eventStartTime)
+                eventStartTime = iter->front()->GetFilterTime();
+        }
+        if (empty)
+            break;
+
+        rawEvent.clear();
+        for (EventList::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
+            while (!iter->empty()) {
+                if (iter->front()->GetFilterTime() - eventStartTime > eventWidth)
+                    break;
+                rawEvent.push_back(iter->front());
+                iter->pop_front();
+            }
+        }
+        numberOfEvents++;
+    }
+    return numberOfEvents;
+}
+
+///Builds the events with the XiaDataMerger in the same way as the current Unpacker::BuildRawEvent.
+static unsigned long MergerBuild(EventList &eventList, const double &eventWidth, vector<XiaData *> &rawEvent) {
+    static XiaDataMerger merger;
+    unsigned long numberOfEvents = 0;
+    merger.Initialize(eventList);
+
+    while (!merger.IsEmpty()) {
+        double eventStartTime = merger.GetNextTime();
+        rawEvent.clear();
+        while (!merger.IsEmpty() && merger.GetNextTime() - eventStartTime <= eventWidth)
+            rawEvent.push_back(merger.Pop());
+        numberOfEvents++;
+    }
+    return numberOfEvents;
+}
+
+///Runs the builder over copies of the decoded spills so that every builder sees identical input.
+static Result Run(const string &name, const vector<EventList> &spills, const unsigned long &hitsPerSpill,
+                  const double &eventWidth, unsigned long (*builder)(EventList &, const double &, vector<XiaData *> &)) {
+    vector<XiaData *> rawEvent;
+    unsigned long numberOfEvents = 0;
+    chrono::duration<double> elapsed(0);
+
+    for (vector<EventList>::const_iterator it = spills.begin(); it != spills.end(); it++) {
+        EventList eventList = *it;
+        auto startTime = chrono::steady_clock::now();
+        numberOfEvents += builder(eventList, eventWidth, rawEvent);
+        elapsed += chrono::steady_clock::now() - startTime;
+    }
+
+    Result result = {name, numberOfEvents, numberOfEvents / elapsed.count(),
+                     hitsPerSpill * spills.size() / elapsed.count()};
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const unsigned int numberOfSpills = 50;
+    const unsigned int numberOfModules = 16;
+    const unsigned int hitsPerModule = 2000;
+    const double eventWidth = 100;
+
+    static const XiaListModeDataMask mask("30474", 250);
+    XiaListModeDataDecoder decoder;
+    SyntheticSpillGenerator generator(numberOfModules, hitsPerModule);
+    vector<XiaDataPool *> pools;
+    vector<EventList> spills;
+
+    for (unsigned int i = 0; i < numberOfSpills; i++) {
+        SyntheticSpill spill = generator.Next();
+        pools.push_back(new XiaDataPool());
+        EventList eventList(numberOfModules);
+        for (unsigned int mod = 0; mod < numberOfModules; mod++) {
+            vector<XiaData *> decoded = decoder.DecodeBuffer(&spill.words[spill.moduleOffsets[mod]], mask,
+                                                             pools.back());
+            eventList[mod].insert(eventList[mod].end(), decoded.begin(), decoded.end());
+        }
+        spills.push_back(eventList);
+    }
+
+    cout << "Spill : " << numberOfModules << " modules x " << hitsPerModule << " hits, event width = " << eventWidth
+         << " clock ticks" << endl;
+
+    vector<Result> results;
+    results.push_back(Run("Module scan", spills, numberOfModules * hitsPerModule, eventWidth, &LegacyBuild));
+    results.push_back(Run("XiaDataMerger", spills, numberOfModules * hitsPerModule, eventWidth, &MergerBuild));
+
+    cout << left << setw(20) << "Benchmark" << right << setw(15) << "Events" << setw(15) << "Events/s"
+         << setw(15) << "Hits/s" << endl;
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++)
+        cout << left << setw(20) << it->name << right << setw(15) << it->numberOfEvents << fixed
+             << setprecision(0) << setw(15) << it->eventsPerSecond << setw(15) << it->hitsPerSecond << endl;
+
+    for (vector<XiaDataPool *>::iterator it = pools.begin(); it != pools.end(); it++)
+        delete *it;
+
+    if (results[0].numberOfEvents != results[1].numberOfEvents) {
+        cerr << "The two builders did not produce the same number of events!" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+///@file benchmark-XiaDataPool.cpp
+///@brief Measures the number of heap allocations per spill with and without the XiaDataPool.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include <cstdlib>
+
+#include "SyntheticSpill.hpp"
+#include "Unpacker.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
+
+using namespace std;
+
+///Counts every call to the global operator new so that we can report allocations per spill.
+static unsigned long numberOfAllocations = 0;
+
+void *operator new(size_t size) {
+    numberOfAllocations++;
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (!ptr)
+        throw bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete[](void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+///Holds the results of a single benchmark so that they can be output in a table.
+struct Result {
+    string name;
+    double allocationsPerSpill;
+    double nanosecondsPerHit;
+};
+
+///Decodes every module buffer in the spill. When the pool is NULL we mimic what the Unpacker used to do: allocate
+/// every XiaData with new and delete them one at a time when the spill is finished.
+static Result DecodeSpills(const string &name, const vector<SyntheticSpill> &spills, XiaDataPool *pool) {
+    static const XiaListModeDataMask mask("30474", 250);
+    XiaListModeDataDecoder decoder;
+    vector<XiaData *> events;
+    unsigned long allocations = 0, hits = 0;
+    chrono::duration<double, nano> elapsed(0);
+
+    for (unsigned int i = 0; i < spills.size(); i++) {
+        SyntheticSpill spill = spills[i];
+        unsigned long start = numberOfAllocations;
+        auto startTime = chrono::steady_clock::now();
+
+        for (vector<unsigned int>::const_iterator it = spill.moduleOffsets.begin(); it != spill.moduleOffsets.end(); it++) {
+            vector<XiaData *> decoded = decoder.DecodeBuffer(&spill.words[*it], mask, pool);
+            events.insert(events.end(), decoded.begin(), decoded.end());
+        }
+
+        if (pool)
+            pool->Reset();
+        else
+            for (vector<XiaData *>::iterator it = events.begin(); it != events.end(); it++)
+                delete *it;
+        events.clear();
+
+        //The first spill warms up the pool and the vectors, so we don't count it.
+        if (i == 0)
+            continue;
+        elapsed += chrono::steady_clock::now() - startTime;
+        allocations += numberOfAllocations - start;
+        hits += spill.numberOfHits;
+    }
+
+    Result result = {name, allocations / double(spills.size() - 1), elapsed.count() / hits};
+    return result;
+}
+
+///Runs the spills through the full Unpacker, which now decodes into its own XiaDataPool.
+static Result UnpackSpills(const vector<SyntheticSpill> &spills) {
+    Unpacker unpacker;
+    unpacker.InitializeDataMask("30474", 250);
+    unsigned long allocations = 0, hits = 0;
+    chrono::duration<double, nano> elapsed(0);
+
+    for (unsigned int i = 0; i < spills.size(); i++) {
+        SyntheticSpill spill = spills[i];
+        unsigned long start = numberOfAllocations;
+        auto startTime = chrono::steady_clock::now();
+
+        unpacker.ReadSpill(&spill.words[0], spill.words.size(), false);
+
+        if (i == 0)
+            continue;
+        elapsed += chrono::steady_clock::now() - startTime;
+        allocations += numberOfAllocations - start;
+        hits += spill.numberOfHits;
+    }
+
+    Result result = {"Unpacker::ReadSpill", allocations / double(spills.size() - 1), elapsed.count() / hits};
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    const unsigned int numberOfSpills = 20;
+    const unsigned int numberOfModules = 13;
+    const unsigned int hitsPerModule = 400;
+    const unsigned int traceLength = 250;
+
+    SyntheticSpillGenerator generator(numberOfModules, hitsPerModule, traceLength);
+    vector<SyntheticSpill> spills;
+    for (unsigned int i = 0; i < numberOfSpills; i++)
+        spills.push_back(generator.Next());
+
+    cout << "Spill : " << numberOfModules << " modules x " << hitsPerModule << " hits, " << traceLength
+         << " sample traces" << endl;
+
+    vector<Result> results;
+    results.push_back(DecodeSpills("Decode (new/delete)", spills, NULL));
+    XiaDataPool pool;
+    results.push_back(DecodeSpills("Decode (XiaDataPool)", spills, &pool));
+    results.push_back(UnpackSpills(spills));
+
+    cout << left << setw(25) << "Benchmark" << right << setw(20) << "Allocations/Spill" << setw(15) << "ns/Hit" << endl;
+    for (vector<Result>::iterator it = results.begin(); it != results.end(); it++)
+        cout << left << setw(25) << it->name << right << fixed << setprecision(1) << setw(20)
+             << it->allocationsPerSpill << setw(15) << it->nanosecondsPerHit << endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+///@file benchmark-XiaListModeDataLayout.cpp
+///@brief Compares decoding module buffers with the resolved XiaListModeDataLayout against looking up every field in
+/// the XiaListModeDataMask, for each of the firmware and frequency combinations.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+#include "HelperEnumerations.hpp"
+#include "HelperFunctions.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
+#include "XiaListModeDataEncoder.hpp"
+
+using namespace std;
+using namespace DataProcessing;
+
+///This is how XiaListModeDataDecoder::DecodeBuffer decoded a buffer before the layout was added. Every field of every
+/// hit asks the mask for its mask and shift. It only handles the basic four word header, which is all that we
+/// generate below.
+static vector<XiaData *> LegacyDecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool &pool) {
+    unsigned int *bufStart = buf;
+    unsigned int bufLen = *buf++;
+    buf++;
+    vector<XiaData *> events;
+
+    while (buf < bufStart + bufLen) {
+        XiaData *data = pool.Acquire();
+        unsigned int word = buf[0];
+        data->SetChannelNumber(word & mask.GetChannelNumberMask().first);
+        data->SetSlotNumber((word & mask.GetSlotIdMask().first) >> mask.GetSlotIdMask().second);
+        data->SetCrateNumber((word & mask.GetCrateIdMask().first) >> mask.GetCrateIdMask().second);
+        data->SetPileup((word & mask.GetFinishCodeMask().first) != 0);
+        switch (mask.GetFirmware()) {
+            case R17562:
+            case R20466:
+            case R27361:
+                data->SetSaturation((bool) ((word & mask.GetTraceOutOfRangeFlagMask().first)
+                        >> mask.GetTraceOutOfRangeFlagMask().second));
+                break;
+            default:
+                break;
+        }
+        unsigned int headerLength = (word & mask.GetHeaderLengthMask().first) >> mask.GetHeaderLengthMask().second;
+        unsigned int eventLength = (word & mask.GetEventLengthMask().first) >> mask.GetEventLengthMask().second;
+
+        data->SetEventTimeLow(buf[1]);
+
+        word = buf[2];
+        data->SetEventTimeHigh(word & mask.GetEventTimeHighMask().first);
+        data->SetCfdFractionalTime((word & mask.GetCfdFractionalTimeMask().first)
+                                   >> mask.GetCfdFractionalTimeMask().second);
+        data->SetCfdForcedTriggerBit(
+                (bool) ((word & mask.GetCfdForcedTriggerBitMask().first) >> mask.GetCfdForcedTriggerBitMask().second));
+        data->SetCfdTriggerSourceBit(
+                (bool) (word & mask.GetCfdTriggerSourceMask().first) >> mask.GetCfdTriggerSourceMask().second);
+
+        word = buf[3];
+        data->SetEnergy(word & mask.GetEventEnergyMask().first);
+        switch (mask.GetFirmware()) {
+            case R17562:
+            case R20466:
+            case R27361:
+                break;
+            default:
+                data->SetSaturation((bool) ((word & mask.GetTraceOutOfRangeFlagMask().first)
+                        >> mask.GetTraceOutOfRangeFlagMask().second));
+                break;
+        }
+        unsigned int traceLength = (word & mask.GetTraceLengthMask().first) >> mask.GetTraceLengthMask().second;
+
+        if (headerLength != HEADER || traceLength / 2 + headerLength != eventLength)
+            throw length_error("LegacyDecodeBuffer - The benchmark only generates basic headers.");
+
+        if (data->IsSaturated())
+            data->SetEnergy(65536);
+
+        pair<double, double> times = XiaListModeDataDecoder::CalculateTimeInSamples(mask, *data);
+        data->SetFilterTime(times.first);
+        data->SetTime(times.second);
+
+        buf += headerLength;
+        events.push_back(data);
+    }
+    return events;
+}
+
+///Builds a module buffer full of basic headers with random CFD information, so that every field gets decoded.
+static vector<unsigned int> MakeBuffer(const XiaListModeDataMask &mask, const unsigned int &numberOfHits) {
+    XiaListModeDataEncoder encoder(mask);
+    mt19937 generator(20161223);
+    uniform_int_distribution<unsigned int> channel(0, 15), energy(1, 30000), flag(0, 15);
+    uniform_int_distribution<unsigned int> cfd(0, mask.GetCfdFractionalTimeMask().first
+                                                  >> mask.GetCfdFractionalTimeMask().second);
+    vector<unsigned int> buffer(2, 0);
+    unsigned long long time = 1000;
+
+    XiaData data;
+    for (unsigned int i = 0; i < numberOfHits; i++) {
+        time += 100 + flag(generator);
+        data.Initialize();
+        data.SetSlotNumber(2);
+        data.SetChannelNumber(channel(generator));
+        data.SetEnergy(energy(generator));
+        data.SetEventTimeLow((unsigned int) (time & 0xFFFFFFFF));
+        data.SetEventTimeHigh((unsigned int) (time >> 32));
+        data.SetCfdFractionalTime(cfd(generator));
+        data.SetCfdForcedTriggerBit(flag(generator) == 0);
+        data.SetCfdTriggerSourceBit(flag(generator) < 8);
+        //The encoder always puts the out of range flag in Word 3, which is wrong for the oldest firmwares.
+        data.SetSaturation(flag(generator) == 0 && mask.GetFirmware() != R17562 && mask.GetFirmware() != R20466
+                           && mask.GetFirmware() != R27361);
+
+        vector<unsigned int> encoded = encoder.EncodeXiaData(data);
+        buffer.insert(buffer.end(), encoded.begin(), encoded.end());
+    }
+    buffer[0] = buffer.size();
+    return buffer;
+}
+
+///@return True if the two hits decoded to exactly the same values.
+static bool Same(const XiaData &lhs, const XiaData &rhs) {
+    return lhs == rhs && lhs.GetTime() == rhs.GetTime() && lhs.GetCfdFractionalTime() == rhs.GetCfdFractionalTime()
+           && lhs.GetCfdForcedTriggerBit() == rhs.GetCfdForcedTriggerBit()
+           && lhs.GetCfdTriggerSourceBit() == rhs.GetCfdTriggerSourceBit() && lhs.IsSaturated() == rhs.IsSaturated()
+           && lhs.IsPileup() == rhs.IsPileup() && lhs.GetEventTimeLow() == rhs.GetEventTimeLow()
+           && lhs.GetEventTimeHigh() == rhs.GetEventTimeHigh();
+}
+
+int main(int argc, char *argv[]) {
+    const unsigned int numberOfHits = 4000;
+    const unsigned int numberOfRepeats = 200;
+    const FIRMWARE firmwares[] = {R17562, R20466, R27361, R29432, R30474, R30980, R30981, R34688};
+    const unsigned int frequencies[] = {100, 250, 500};
+
+    cout << "Buffer : " << numberOfHits << " hits with four word headers, decoded " << numberOfRepeats << " times"
+         << endl;
+    cout << left << setw(12) << "Firmware" << right << setw(10) << "Frequency" << setw(15) << "Mask ns/Hit"
+         << setw(15) << "Layout ns/Hit" << setw(10) << "Speedup" << endl;
+
+    int retval = 0;
+    for (unsigned int i = 0; i < sizeof(firmwares) / sizeof(firmwares[0]); i++) {
+        for (unsigned int j = 0; j < sizeof(frequencies) / sizeof(frequencies[0]); j++) {
+            XiaListModeDataMask mask(firmwares[i], frequencies[j]);
+            //Not every firmware was released for every frequency, those combinations don't have a CFD mask.
+            if (mask.GetCfdFractionalTimeMask().first == 0)
+                continue;
+
+            vector<unsigned int> buffer = MakeBuffer(mask, numberOfHits);
+            XiaListModeDataDecoder decoder;
+            XiaListModeDataLayout layout(mask);
+            XiaDataPool legacyPool, layoutPool;
+            chrono::duration<double, nano> legacyTime(0), layoutTime(0);
+
+            for (unsigned int repeat = 0; repeat < numberOfRepeats; repeat++) {
+                legacyPool.Reset();
+                layoutPool.Reset();
+
+                auto start = chrono::steady_clock::now();
+                vector<XiaData *> legacy = LegacyDecodeBuffer(&buffer[0], mask, legacyPool);
+                legacyTime += chrono::steady_clock::now() - start;
+
+                start = chrono::steady_clock::now();
+                vector<XiaData *> decoded = decoder.DecodeBuffer(&buffer[0], layout, &layoutPool);
+                layoutTime += chrono::steady_clock::now() - start;
+
+                if (repeat != 0)
+                    continue;
+                bool same = legacy.size() == decoded.size();
+                for (unsigned int k = 0; same && k < decoded.size(); k++)
+                    same = Same(*legacy[k], *decoded[k]);
+                if (!same) {
+                    cerr << "R" << firmwares[i] << " at " << frequencies[j] << " MS/s did not decode the same hits!"
+                         << endl;
+                    retval = 1;
+                }
+            }
+
+            double legacyPerHit = legacyTime.count() / (numberOfHits * numberOfRepeats);
+            double layoutPerHit = layoutTime.count() / (numberOfHits * numberOfRepeats);
+            cout << left << setw(12) << ("R" + to_string(firmwares[i])) << right << setw(10) << frequencies[j]
+                 << fixed << setprecision(2) << setw(15) << legacyPerHit << setw(15) << layoutPerHit << setw(10)
+                 << legacyPerHit / layoutPerHit << endl;
+        }
+    }
+    return retval;
+}
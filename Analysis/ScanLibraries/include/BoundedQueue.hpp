@@ -0,0 +1,98 @@
+///@file BoundedQueue.hpp
+///@brief A fixed capacity, thread safe FIFO used to pass work between the stages of the scan pipeline.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_BOUNDEDQUEUE_HPP
+#define PIXIESUITE_BOUNDEDQUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+///A blocking queue with a fixed capacity. Push blocks while the queue is full and Pop blocks while it is empty, so a
+/// fast producer can never get more than capacity items ahead of a slow consumer. Closing the queue wakes everybody
+/// up: Push fails immediately and Pop keeps returning items until the queue is empty, which lets a chain of stages
+/// shut down in order.
+template<typename T>
+class BoundedQueue {
+public:
+    ///Constructor
+    ///@param[in] capacity : The maximum number of items that can wait in the queue.
+    BoundedQueue(const size_t &capacity = 1) : capacity_(capacity == 0 ? 1 : capacity), closed_(false) {}
+
+    ///Default destructor
+    ~BoundedQueue() {}
+
+    ///Adds an item to the back of the queue, waiting for space if the queue is full.
+    ///@param[in] item : The item to add
+    ///@return False if the queue was closed before the item could be added.
+    bool Push(const T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!closed_ && queue_.size() >= capacity_)
+            notFull_.wait(lock);
+        if (closed_)
+            return false;
+        queue_.push_back(item);
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    ///Removes the item at the front of the queue, waiting for one to arrive if the queue is empty.
+    ///@param[out] item : The item that was removed
+    ///@return False if the queue is closed and there is nothing left in it.
+    bool Pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!closed_ && queue_.empty())
+            notEmpty_.wait(lock);
+        if (queue_.empty())
+            return false;
+        item = queue_.front();
+        queue_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    ///Closes the queue and wakes up every thread waiting on it.
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    ///Empties and reopens the queue. This must not be called while another thread is using the queue.
+    ///@param[in] capacity : The new capacity of the queue
+    void Reset(const size_t &capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        capacity_ = capacity == 0 ? 1 : capacity;
+        closed_ = false;
+    }
+
+    ///@return The number of items currently waiting in the queue.
+    size_t GetSize() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    ///@return True if the queue has been closed.
+    bool IsClosed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+private:
+    size_t capacity_; ///< The maximum number of items in the queue
+    bool closed_; ///< True once Close has been called
+    std::deque<T> queue_; ///< The items waiting in the queue
+    std::mutex mutex_; ///< Protects everything above
+    std::condition_variable notEmpty_; ///< Signaled when an item is added or the queue is closed
+    std::condition_variable notFull_; ///< Signaled when an item is removed or the queue is closed
+
+    ///Copying a queue that threads may be waiting on makes no sense.
+    BoundedQueue(const BoundedQueue &);
+
+    BoundedQueue &operator=(const BoundedQueue &);
+};
+
+#endif //PIXIESUITE_BOUNDEDQUEUE_HPP
@@ -0,0 +1,222 @@
+///@file DenseHistogram.hpp
+///@brief A histogram of unit width bins that only counts, so that the DAMM style histograms can be filled without
+/// going through ROOT.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_DENSEHISTOGRAM_HPP
+#define PIXIESUITE_DENSEHISTOGRAM_HPP
+
+#include <map>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+///Counts fills into bins of unit width that start at zero, in one, two or three dimensions. The bins are laid out
+/// like the global bins of ROOT's TH1, with an underflow and an overflow bin on each axis, so that a cell can be added
+/// straight into a ROOT histogram with the same binning. The counters are 32 bits wide, the rare counter that wraps
+/// around is carried into a 64 bit count on the side. The sums that ROOT works out the mean and RMS from are kept as
+/// well, so that they don't have to be worked out again from the bin centres.
+class DenseHistogram {
+public:
+    ///The sums of the fills that landed inside the bins, which ROOT leaves the underflows and overflows out of. Every
+    /// term is rounded to a fixed point number before it's added, so the sums are integers. They come out the same
+    /// whatever the order of the fills, and however the fills were shared out between histograms that are added
+    /// together afterwards, which sums of doubles wouldn't.
+    class Sums {
+    public:
+        ///The number of sums that Get copies out, which is the number for a 3D histogram.
+        static const size_t numberOfStats = 11;
+
+        ///Constructor
+        ///@param[in] maxBins : The most bins on any axis, which sets how many fractional bits the products can keep
+        explicit Sums(const unsigned int &maxBins);
+
+        ///Adds a fill of a 1D histogram.
+        ///@param[in] x : The x value
+        void Tally(const double &x) {
+            count_++;
+            sums_[0] += Linear(x);
+            sums_[1] += Quadratic(x * x);
+        }
+
+        ///Adds a fill of a 2D histogram.
+        ///@param[in] x : The x value
+        ///@param[in] y : The y value
+        void Tally(const double &x, const double &y) {
+            Tally(x);
+            sums_[2] += Linear(y);
+            sums_[3] += Quadratic(y * y);
+            sums_[4] += Quadratic(x * y);
+        }
+
+        ///Adds a fill of a 3D histogram.
+        ///@param[in] x : The x value
+        ///@param[in] y : The y value
+        ///@param[in] z : The z value
+        void Tally(const double &x, const double &y, const double &z) {
+            Tally(x, y);
+            sums_[5] += Linear(z);
+            sums_[6] += Quadratic(z * z);
+            sums_[7] += Quadratic(x * z);
+            sums_[8] += Quadratic(y * z);
+        }
+
+        ///Adds the sums of another histogram with the same bins.
+        ///@param[in] rhs : The sums to add
+        ///@throws invalid_argument if the sums keep a different number of fractional bits
+        void Add(const Sums &rhs);
+
+        ///Copies the sums out in the order that TH1::GetStats uses for a histogram of the same dimension: sumw,
+        /// sumw2, sumwx, sumwx2, then sumwy, sumwy2, sumwxy for 2D and 3D, then sumwz, sumwz2, sumwxz, sumwyz for 3D.
+        /// Every fill has a weight of one.
+        ///@param[out] stats : The sums, which needs room for numberOfStats values
+        void Get(double *stats) const;
+
+        ///Sets every sum back to zero.
+        void Reset();
+
+    private:
+        __extension__ typedef unsigned __int128 FixedPoint; ///< Holds a sum of up to 2^64 terms without overflowing
+
+        static const int linearBits = 32; ///< The fractional bits of the values, which are less than 2^32
+
+        ///@return A value in fixed point, rounded to the nearest.
+        FixedPoint Linear(const double &value) const { return (uint64_t) (value * linearScale_ + 0.5); }
+
+        ///@return A product of two values in fixed point, rounded to the nearest.
+        FixedPoint Quadratic(const double &value) const { return (uint64_t) (value * quadraticScale_ + 0.5); }
+
+        uint64_t count_; ///< The number of fills inside the bins
+        FixedPoint sums_[9]; ///< sumwx, sumwx2, sumwy, sumwy2, sumwxy, sumwz, sumwz2, sumwxz, sumwyz in fixed point
+        int quadraticBits_; ///< The fractional bits of the products, as many as fit in 64 bits for the bins
+        double linearScale_; ///< 2^linearBits
+        double quadraticScale_; ///< 2^quadraticBits_
+    };
+
+    ///Constructor
+    ///@param[in] xBins : The number of bins in x
+    ///@param[in] yBins : The number of bins in y, 0 for a 1D histogram
+    ///@param[in] zBins : The number of bins in z, 0 for a 1D or 2D histogram
+    ///@throws invalid_argument if there are no x bins, or z bins without y bins
+    DenseHistogram(const unsigned int &xBins, const unsigned int &yBins = 0, const unsigned int &zBins = 0);
+
+    ///Default destructor
+    ~DenseHistogram() {}
+
+    ///Counts a value in a 1D histogram.
+    ///@param[in] x : The x value
+    void Fill(const double &x) {
+        const size_t xBin = GetBin(x, xBins_);
+        Increment(xBin);
+        if (IsInside(xBin, xBins_))
+            sums_.Tally(x);
+    }
+
+    ///Counts a pair of values in a 2D histogram.
+    ///@param[in] x : The x value
+    ///@param[in] y : The y value
+    void Fill(const double &x, const double &y) {
+        const size_t xBin = GetBin(x, xBins_);
+        const size_t yBin = GetBin(y, yBins_);
+        Increment(xBin + xStride_ * yBin);
+        if (IsInside(xBin, xBins_) && IsInside(yBin, yBins_))
+            sums_.Tally(x, y);
+    }
+
+    ///Counts a triplet of values in a 3D histogram.
+    ///@param[in] x : The x value
+    ///@param[in] y : The y value
+    ///@param[in] z : The z value
+    void Fill(const double &x, const double &y, const double &z) {
+        const size_t xBin = GetBin(x, xBins_);
+        const size_t yBin = GetBin(y, yBins_);
+        const size_t zBin = GetBin(z, zBins_);
+        Increment(xBin + xStride_ * yBin + yStride_ * zBin);
+        if (IsInside(xBin, xBins_) && IsInside(yBin, yBins_) && IsInside(zBin, zBins_))
+            sums_.Tally(x, y, z);
+    }
+
+    ///Counts many values in a 1D histogram. The bins are worked out a block at a time before any of them are counted,
+    /// which the compiler can vectorize.
+    ///@param[in] x : The x values
+    ///@param[in] n : The number of values
+    void Fill(const double *x, const size_t &n);
+
+    ///@return The number of dimensions of the histogram.
+    unsigned int GetDimension() const { return zBins_ ? 3 : (yBins_ ? 2 : 1); }
+
+    ///@return The number of bins in x, not counting the underflow and overflow.
+    unsigned int GetXBins() const { return xBins_; }
+
+    ///@return The number of bins in y, 0 for a 1D histogram.
+    unsigned int GetYBins() const { return yBins_; }
+
+    ///@return The number of bins in z, 0 for a 1D or 2D histogram.
+    unsigned int GetZBins() const { return zBins_; }
+
+    ///@return The number of cells, including the underflows and overflows.
+    size_t GetNumberOfCells() const { return counts_.size(); }
+
+    ///@param[in] cell : The global bin number of the cell, as ROOT would number it
+    ///@return The count in the cell.
+    uint64_t GetCellContent(const size_t &cell) const;
+
+    ///@return The number of fills since the histogram was created or reset.
+    uint64_t GetEntries() const { return entries_; }
+
+    ///@return The sums of the fills that landed inside the bins.
+    const Sums &GetSums() const { return sums_; }
+
+    ///@return True if nothing has been filled since the histogram was created or reset.
+    bool IsEmpty() const { return entries_ == 0; }
+
+    ///Calls a function with every cell that has a count, in the order of the cells.
+    ///@param[in] function : Called with the global bin number and the count of each cell
+    template<typename Function>
+    void ForEachFilledCell(Function function) const {
+        for (size_t cell = 0; cell < counts_.size(); cell++)
+            if (counts_[cell] != 0 || (!carries_.empty() && carries_.count(cell)))
+                function(cell, GetCellContent(cell));
+    }
+
+    ///Adds the counts of another histogram with the same bins into this one.
+    ///@param[in] rhs : The histogram to add
+    ///@throws invalid_argument if the bins are not the same
+    void Add(const DenseHistogram &rhs);
+
+    ///Sets every count back to zero.
+    void Reset();
+
+private:
+    ///@return The bin of a value on an axis, 0 for the underflow and bins + 1 for the overflow, like ROOT's
+    /// TAxis::FindBin. NaN goes into the overflow as it does in ROOT.
+    static size_t GetBin(const double &value, const unsigned int &bins) {
+        if (value >= 0 && value < bins)
+            return (size_t) value + 1;
+        return value < 0 ? 0 : bins + 1;
+    }
+
+    ///@return True if the bin isn't the underflow or the overflow.
+    static bool IsInside(const size_t &bin, const unsigned int &bins) { return bin != 0 && bin <= bins; }
+
+    ///Counts one fill into a cell.
+    ///@param[in] cell : The global bin number of the cell
+    void Increment(const size_t &cell) {
+        entries_++;
+        if (++counts_[cell] == 0)
+            carries_[cell]++;
+    }
+
+    unsigned int xBins_; ///< The number of bins in x
+    unsigned int yBins_; ///< The number of bins in y
+    unsigned int zBins_; ///< The number of bins in z
+    size_t xStride_; ///< The number of cells in a row of x, including the underflow and overflow
+    size_t yStride_; ///< The number of cells in a plane of x and y
+    std::vector<uint32_t> counts_; ///< The low 32 bits of the count of each cell
+    std::map<size_t, uint64_t> carries_; ///< The number of times that the count of a cell wrapped around
+    uint64_t entries_; ///< The number of fills
+    Sums sums_; ///< The sums of the fills inside the bins
+};
+
+#endif //PIXIESUITE_DENSEHISTOGRAM_HPP
@@ -0,0 +1,120 @@
+///@file LazyTrace.hpp
+///@brief Holds the 16-bit samples of a trace, which may still be sitting in the spill buffer that they were read from.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_LAZYTRACE_HPP
+#define PIXIESUITE_LAZYTRACE_HPP
+
+#include <cstddef>
+#include <vector>
+
+///The samples of a trace are either stored here or referenced in the spill buffer that the module wrote them to. A
+/// reference is only copied out of the buffer the first time that somebody asks for the samples, so traces that
+/// nobody looks at cost us nothing more than a pointer. Whoever sets a reference is responsible for keeping the
+/// buffer alive until the reference is resolved or cleared. Copying or moving a LazyTrace always resolves the
+/// reference first, so the copies never point into the buffer.
+class LazyTrace {
+public:
+    ///Default constructor
+    LazyTrace() : reference_(NULL), referenceLength_(0) {}
+
+    ///Copy constructor, resolves the reference in rhs before copying the samples.
+    ///@param[in] rhs : The trace that we're copying
+    LazyTrace(const LazyTrace &rhs) : samples_(rhs.Get()), reference_(NULL), referenceLength_(0) {}
+
+    ///Move constructor, resolves the reference in rhs and then takes its samples.
+    ///@param[in] rhs : The trace that we're taking the samples from
+    LazyTrace(LazyTrace &&rhs) : reference_(NULL), referenceLength_(0) {
+        rhs.Resolve();
+        samples_.swap(rhs.samples_);
+    }
+
+    ///Copy assignment, resolves the reference in rhs before copying the samples.
+    ///@param[in] rhs : The trace that we're copying
+    ///@return A reference to this trace
+    LazyTrace &operator=(const LazyTrace &rhs) {
+        if (this != &rhs) {
+            samples_ = rhs.Get();
+            Clear(false);
+        }
+        return *this;
+    }
+
+    ///Move assignment, resolves the reference in rhs and then takes its samples.
+    ///@param[in] rhs : The trace that we're taking the samples from
+    ///@return A reference to this trace
+    LazyTrace &operator=(LazyTrace &&rhs) {
+        if (this != &rhs) {
+            rhs.Resolve();
+            samples_.swap(rhs.samples_);
+            rhs.samples_.clear();
+            Clear(false);
+        }
+        return *this;
+    }
+
+    ///@return The samples, copied out of the spill buffer if this is the first time that they've been asked for.
+    const std::vector<unsigned short> &Get() const {
+        Resolve();
+        return samples_;
+    }
+
+    ///@return The number of samples in the trace, without copying them out of the spill buffer.
+    size_t GetLength() const { return reference_ ? referenceLength_ : samples_.size(); }
+
+    ///@return A pointer to the first of GetLength() samples, wherever they are. It's only valid until the trace is
+    /// changed or resolved.
+    const unsigned short *GetData() const { return reference_ ? reference_ : samples_.data(); }
+
+    ///@return True if the samples are still only referenced in the spill buffer.
+    bool IsReference() const { return reference_ != NULL; }
+
+    ///Stores a copy of the samples. The storage is reused when possible.
+    ///@param[in] first : Pointer to the first sample
+    ///@param[in] last : Pointer to one past the last sample
+    void Assign(const unsigned short *first, const unsigned short *last) {
+        Clear(false);
+        samples_.assign(first, last);
+    }
+
+    ///Stores the samples.
+    ///@param[in] samples : The samples to store
+    void Assign(const std::vector<unsigned short> &samples) {
+        Clear(false);
+        samples_ = samples;
+    }
+
+    ///Refers to samples in a buffer that will outlive this trace, or at least outlive the next call to Clear.
+    ///@param[in] first : Pointer to the first sample
+    ///@param[in] last : Pointer to one past the last sample
+    void Refer(const unsigned short *first, const unsigned short *last) {
+        samples_.clear();
+        reference_ = first;
+        referenceLength_ = (unsigned int) (last - first);
+    }
+
+    ///Drops the samples and any reference, the storage is kept for the next trace.
+    ///@param[in] clearSamples : False if we only want to drop the reference.
+    void Clear(const bool &clearSamples = true) {
+        if (clearSamples)
+            samples_.clear();
+        reference_ = NULL;
+        referenceLength_ = 0;
+    }
+
+private:
+    ///Copies the referenced samples into our own storage.
+    void Resolve() const {
+        if (!reference_)
+            return;
+        samples_.assign(reference_, reference_ + referenceLength_);
+        reference_ = NULL;
+        referenceLength_ = 0;
+    }
+
+    mutable std::vector<unsigned short> samples_; ///< The samples that we own
+    mutable const unsigned short *reference_; ///< The samples in the spill buffer, NULL if we own them
+    mutable unsigned int referenceLength_; ///< The number of samples at reference_
+};
+
+#endif //PIXIESUITE_LAZYTRACE_HPP
@@ -5,7 +5,10 @@
 #ifndef PIXIESUITE_PROCESSEDXIADATA_HPP
 #define PIXIESUITE_PROCESSEDXIADATA_HPP
 
+#include <utility>
+
 #include "Trace.hpp"
+#include "TraceSamples.hpp"
 #include "XiaData.hpp"
 
 ///This class contains additional information about the XiaData after
@@ -15,14 +18,23 @@
 class ProcessedXiaData : public XiaData {
 public:
     /// Default constructor.
-    ProcessedXiaData() {}
+    ProcessedXiaData() : isTraceWidened_(false) {}
+
+    ///Constructor taking the base class as an argument so that we can set
+    /// the trace information properly. The trace, energy sums and QDCs are
+    /// copied from evt.
+    ///@param[in] evt : The event that we are going to assign here.
+    ProcessedXiaData(const XiaData &evt) : XiaData(evt), isTraceWidened_(false) {
+        trace_.SetIsSaturated(IsSaturated());
+        walkCorrectedTime_ = 0;
+    };
 
     ///Constructor taking the base class as an argument so that we can set
-    /// the trace information properly
+    /// the trace information properly. The trace, energy sums and QDCs are
+    /// moved out of evt rather than copied, evt keeps everything else.
     ///@param[in] evt : The event that we are going to assign here.
-    ProcessedXiaData(XiaData &evt) : XiaData(evt) {
-        trace_ = evt.GetTrace();
-        trace_.SetIsSaturated(evt.IsSaturated());
+    ProcessedXiaData(XiaData &&evt) : XiaData(std::move(evt)), isTraceWidened_(false) {
+        trace_.SetIsSaturated(IsSaturated());
         walkCorrectedTime_ = 0;
     };
 
@@ -35,11 +47,18 @@ public:
     ///@return The sub-sampling arrival time of the signal in nanoseconds.
     double GetHighResTimeInNs() const { return highResTimeInNs_; }
 
-    ///@return A constant reference to the trace.
-    const Trace &GetTrace() const { return trace_; }
+    ///@return A constant reference to the trace. The raw samples are
+    /// widened the first time that the trace is asked for.
+    const Trace &GetTrace() const {
+        WidenTrace();
+        return trace_;
+    }
 
     ///@return An editable trace.
-    Trace &GetTrace() { return trace_; }
+    Trace &GetTrace() {
+        WidenTrace();
+        return trace_;
+    }
 
     ///@return The Walk corrected time of the channel
     double GetWalkCorrectedTime() const { return walkCorrectedTime_; }
@@ -62,14 +81,30 @@ public:
 
     ///Sets the trace appropriately
     ///@param[in] a : The trace that we want to set
-    void SetTrace(const std::vector<unsigned int> &a) { trace_ = a; }
+    void SetTrace(const std::vector<unsigned int> &a) {
+        XiaData::SetTrace(a);
+        trace_ = a;
+        isTraceWidened_ = true;
+    }
 
     ///Set the Walk corrected time
     ///@param [in] a : the walk corrected time */
     void SetWalkCorrectedTime(const double &a) { walkCorrectedTime_ = a; }
 
 private:
-    Trace trace_; ///< A Trace object to handle the Trace related stuff.
+    ///Widens the raw 16-bit samples into the Trace, this only happens once.
+    void WidenTrace() const {
+        if (isTraceWidened_)
+            return;
+        const std::vector<unsigned short> &raw = GetRawTrace();
+        trace_.resize(raw.size());
+        if (!raw.empty())
+            TraceSamples::Widen(raw.data(), raw.data() + raw.size(), trace_.data());
+        isTraceWidened_ = true;
+    }
+
+    mutable Trace trace_; ///< A Trace object to handle the Trace related stuff.
+    mutable bool isTraceWidened_; ///< True once the raw samples have been widened into trace_
 
     bool isIgnored_; ///< True if we ignore this event.
     bool isValidData_; ///< True if the energy and High Res time are valid.
@@ -22,13 +22,16 @@
 #include <getopt.h>
 
 #include "hribf_buffers.h"
+#include "MappedFile.h"
+#include "SpillIndex.h"
+#include "SpillRing.h"
+#include "SpillRingSpool.hpp"
 #include "XiaData.hpp"
+#include "XiaDataColumns.hpp"
 
 #define SCAN_VERSION "1.2.29"
 #define SCAN_DATE "Aug. 11th, 2016"
 
-class Server;
-
 class Terminal;
 
 class Unpacker;
@@ -106,9 +109,27 @@ public:
     /// Return true if shared memory mode is enabled.
     bool ShmMode() { return shm_mode; }
 
+    /// Return the name of what happens to the spills that shared memory mode can't keep up with, e.g. lossless.
+    std::string GetShmPolicyName();
+
+    /// Return true if input files are memory mapped.
+    bool MmapMode() { return mmap_mode; }
+
+    /// Return the number of spills that the unpacker pipeline may hold. Zero if the pipeline is not used.
+    unsigned int PipelineDepth() { return pipeline_depth; }
+
+    /// Return the number of threads that decode the module buffers in a spill. Zero or one if they are decoded in turn.
+    unsigned int DecodeThreads() { return decode_threads; }
+
+    /// Return true if raw events are built across spill boundaries.
+    bool StreamMode() { return stream_mode; }
+
     /// Return true if batch processing mode is enabled.
     bool BatchMode() { return batch_mode; }
 
+    /// Return true if only part of the input file is to be scanned, based on its spill index.
+    bool RangeMode() { return range_mode; }
+
     /// Return the header string used to prefix output messages.
     std::string GetMessageHeader() { return msgHeader; }
 
@@ -145,6 +166,9 @@ public:
     /// Enable or disable shared memory mode.
     bool SetShmMode(bool state_ = true) { return (shm_mode = state_); }
 
+    /// Enable or disable memory mapping of input files. Takes effect when the next file is opened.
+    bool SetMmapMode(bool state_ = true) { return (mmap_mode = state_); }
+
     /// Enable or disable batch processing mode.
     bool SetBatchMode(bool state_ = true) { return (batch_mode = state_); }
 
@@ -274,9 +298,6 @@ protected:
     ///@param[in] arg : The argument that we didn't recognize
     void OutputUnkownCommandMessage(const std::string &arg);
 private:
-    unsigned int maxShmSizeL; /// Max size of shared memory buffer in pixie words (4050 + 2 header words)
-    unsigned int maxShmSize; /// Max size of shared memory buffer in bytes
-
     std::string prefix; /// Input filename prefix (without extension).
     std::string extension; /// Input file extension.
     std::string workDir; /// Linux system current working directory.
@@ -286,11 +307,22 @@ private:
     std::string outputPath_;
 
     int max_spill_size; /// Maximum size of a spill to read.
-    int file_format; /// Input file format to use (0=.ldf, 1=.pld, 2=.root).
+    int file_format; /// Input file format to use (0=.ldf, 1=.pld, 2=.xcol).
 
     unsigned long num_spills_recvd; /// The total number of good spills received from either the input file or shared memory.
     unsigned long file_start_offset; /// The first word in the file at which to start scanning.
 
+    unsigned long long start_time; /// Scan only the spills with hits at or after this time (in clock ticks).
+    unsigned long long stop_time; /// Scan only the spills with hits at or before this time (in clock ticks).
+    size_t first_spill; /// The first spill in the file to scan.
+    size_t last_spill; /// The last spill in the file to scan.
+    size_t spills_to_scan; /// The number of spills left to scan in the requested range.
+    unsigned long long first_time; /// The time of the first event in the run (in clock ticks), if given by the user.
+    bool use_first_time; /// Set to true if the user gave the time of the first event in the run.
+    bool range_mode; /// Set to true if only the spills selected by time or spill number are to be scanned.
+    bool range_pending; /// Set to true if the next scan has to start by seeking to the first spill in the range.
+    bool range_active; /// Set to true while a scan is limited to the requested range of spills.
+
     bool write_counts; /// Set to true if raw channel counts are to be written to file.
 
     bool total_stopped; /// Set to true if when the scan finishes.
@@ -299,16 +331,33 @@ private:
     bool debug_mode; /// Set to true if the user wishes to display debug information.
     bool dry_run_mode; /// Set to true if a dry run is to be performed i.e. data is to be read but not processed.
     bool shm_mode; /// Set to true if shared memory mode is to be used.
+    bool mmap_mode; /// Set to true if input files are to be memory mapped instead of read through input_file.
+    unsigned int pipeline_depth; /// The number of spills in the unpacker pipeline. Zero unpacks each spill in turn.
+    unsigned int decode_threads; /// The number of threads that decode the module buffers in a spill.
+    bool stream_mode; /// Set to true if raw events are to be built across spill boundaries.
     bool batch_mode; /// Set to true if the program is to be run with no interactive command line.
     bool file_open; /// Set to true when an input binary file is successfully opened for reading.
 
     bool kill_all; /// Set to true when user has sent kill command.
     bool run_ctrl_exit; /// Set to true when run control thread has exited.
 
-    Server *poll_server; /// Poll2 shared memory server.
+    SpillRingReader spill_ring; /// The shared memory ring that poll2 writes its spills to.
+    SpillRingSpool spill_spool; /// Copies the ring to a spool file on disk for the SPILL_RING_SPOOL policy.
+    unsigned int shm_policy; /// What happens to the spills that we can't keep up with, one of the SpillRingPolicy.
+    unsigned int shm_sampling; /// Scan every Nth spill for the SPILL_RING_SAMPLED policy.
+    std::string spool_dir; /// The directory of the spool file for the SPILL_RING_SPOOL policy.
 
     std::ifstream input_file; /// Main input binary data file.
     std::streampos file_length; /// Main input file length (in bytes).
+    MappedFile mapped_file; /// Memory mapping of the main input file. Only open in mmap mode or for a column file.
+    std::string input_fname; /// The name of the main input file.
+    SpillIndex spill_index; /// The index of the spills in the main input file.
+
+    std::string export_fname; /// The column file that the decoded hits are exported to, empty if they aren't.
+    bool export_traces; /// Set to true if the traces are exported to the column file as well.
+    XiaDataColumnWriter column_writer; /// Writes the decoded hits to the column file.
+
+    std::string timers_fname; /// The JSON file that the stage timers are written to at exit, empty if they aren't.
 
     fileInformation finfo; /// Data structure for storing binary file header information.
 
@@ -336,6 +385,18 @@ private:
     /// Open a new binary input file for reading.
     bool open_input_file(const std::string &fname_);
 
+    /// Return the current read position in the input file (in bytes).
+    std::streampos get_file_position();
+
+    /// Move input_file to the read position of the mapped file so the two agree once a mapped scan stops.
+    void sync_input_file();
+
+    /// Read the spill index of the main input file, building it if the file doesn't have one yet.
+    bool load_spill_index();
+
+    /// Move input_file to the first spill in the requested range and work out how many spills to scan.
+    void seek_spill_range();
+
     ///Sets output Filename and path that were passed using the -o flag.
     ///@param[in] a : The parameter that we are going to set
     void SetOutputInformation(const std::string &a);
@@ -0,0 +1,87 @@
+///@file SpillRingSpool.hpp
+///@brief Reads every spill in the poll2 spill ring without holding up poll2, by copying each one to a file on disk as
+/// soon as it is written and handing them out from there.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_SPILLRINGSPOOL_HPP
+#define PIXIESUITE_SPILLRINGSPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+#include "SpillRing.h"
+
+///A consumer of the spill ring with the SPILL_RING_SPOOL policy. A thread reads the ring as a lossless consumer and
+/// appends each record to a spool file, which only takes as long as the write to the page cache, so poll2 hardly
+/// ever has to wait on us. Next hands the records out of the spool file in order, however far behind the scan is.
+/// The spool file is deleted as soon as it's created, and starts over whenever the scan catches up.
+class SpillRingSpool {
+public:
+    ///Default constructor
+    SpillRingSpool();
+
+    ///Destructor, stops the thread and closes the spool file.
+    ~SpillRingSpool();
+
+    ///Registers with the ring and starts copying it to a new spool file.
+    ///@param[in] directory : The directory to put the spool file in
+    ///@param[in] consumer : The name that poll2 shows for us
+    ///@param[in] name : The name of the ring
+    ///@return False if there is no ring of that name or there is no room for another consumer.
+    ///@throws runtime_error if the spool file can't be created
+    bool Open(const std::string &directory, const std::string &consumer,
+              const std::string &name = SPILL_RING_DEFAULT_NAME);
+
+    ///Stops the thread, unregisters from the ring and throws away whatever is left in the spool file.
+    void Close();
+
+    ///@return True if we're registered with a ring.
+    bool IsOpen() { return reader_.IsOpen(); }
+
+    ///@return True if the name of the ring now belongs to a different ring, see SpillRingReader::IsStale.
+    bool IsStale() { return reader_.IsStale(); }
+
+    ///Gets the oldest record that we haven't handed out yet. Its data stays valid until the next call.
+    ///@param[in] record : The record to fill in
+    ///@param[in] timeout : The longest time to wait for a record in ms, negative to wait forever
+    ///@return False if there was no record in time.
+    ///@throws runtime_error if the spool file can't be read
+    bool Next(SpillRingRecord &record, const int &timeout);
+
+    ///@return The number of records that were written over before we could copy them, or that couldn't be written
+    /// to the spool file.
+    uint64_t GetNumberOfLostRecords() const { return lostRecords_.load(std::memory_order_relaxed); }
+
+    ///@return The number of bytes in the spool file that haven't been handed out yet.
+    uint64_t GetSpooledBytes();
+
+private:
+    ///The loop that copies the records from the ring to the spool file until we're closed or poll2 closes the ring.
+    void Spool();
+
+    SpillRingReader reader_; ///< Our registration with the ring, only used by the thread while it's running
+    std::thread thread_; ///< Copies the records from the ring to the spool file
+    int fd_; ///< The spool file, -1 if it isn't open
+    std::vector<unsigned int> buffer_; ///< The data of the record that Next handed out last
+
+    std::mutex mutex_; ///< Protects everything below
+    std::condition_variable spooled_; ///< Signaled when a record has been added to the spool file
+    uint64_t readOffset_; ///< The offset of the next record that Next will hand out
+    uint64_t writeOffset_; ///< The end of the records in the spool file
+    uint64_t fileSize_; ///< The largest that the spool file has been since it was last truncated
+    bool isWriting_; ///< True while the thread is writing a record after writeOffset_
+    bool stopping_; ///< True when the thread should stop
+    std::atomic<uint64_t> lostRecords_; ///< The number of records that didn't make it into the spool file
+
+    SpillRingSpool(const SpillRingSpool &);
+
+    SpillRingSpool &operator=(const SpillRingSpool &);
+};
+
+#endif //PIXIESUITE_SPILLRINGSPOOL_HPP
@@ -0,0 +1,154 @@
+///@file StageTimer.hpp
+///@brief Nanosecond timers for each stage of the scan: the unpacker, the trace analyzers, the event processors and
+/// the histogram flushes. They're kept in one place so that they can be printed from the command line or written
+/// to a JSON file at the end of the scan.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_STAGETIMER_HPP
+#define PIXIESUITE_STAGETIMER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+///Counts the calls to one stage of the scan and the time that they took. Each call's latency goes into a histogram
+/// with four bins per power of two, so the percentiles are good to within 25%. Add may be called from any number of
+/// threads at once.
+class StageTimer {
+public:
+    ///The number of bins in the latency histogram, the last one holds everything longer than about an hour.
+    static const unsigned int NUMBER_OF_BINS = 164;
+
+    ///Constructor
+    ///@param[in] group : The part of the scan that the stage belongs to, e.g. unpacker, analyzer or processor
+    ///@param[in] name : The name of the stage within the group
+    StageTimer(const std::string &group, const std::string &name);
+
+    ///Records a single call to the stage.
+    ///@param[in] nanoseconds : The time that the call took.
+    void Add(const uint64_t &nanoseconds);
+
+    ///Sets all of the counters back to zero.
+    void Reset();
+
+    ///@return The part of the scan that the stage belongs to.
+    const std::string &GetGroup() const { return group_; }
+
+    ///@return The name of the stage.
+    const std::string &GetName() const { return name_; }
+
+    ///@return The number of calls that have been recorded.
+    uint64_t GetNumberOfCalls() const { return calls_.load(std::memory_order_relaxed); }
+
+    ///@return The total time of all of the calls in nanoseconds.
+    uint64_t GetTotalNanoseconds() const { return total_.load(std::memory_order_relaxed); }
+
+    ///@return The shortest call in nanoseconds, zero if there weren't any calls.
+    uint64_t GetMinimumNanoseconds() const;
+
+    ///@return The longest call in nanoseconds.
+    uint64_t GetMaximumNanoseconds() const { return maximum_.load(std::memory_order_relaxed); }
+
+    ///@return The mean time of a call in nanoseconds.
+    double GetMeanNanoseconds() const;
+
+    ///@param[in] fraction : The fraction of the calls, e.g. 0.99 for the 99th percentile
+    ///@return The upper edge of the histogram bin that the percentile falls into, but never more than the longest
+    /// call, in nanoseconds.
+    uint64_t GetPercentileNanoseconds(const double &fraction) const;
+
+    ///@return The number of calls in each of the bins of the latency histogram.
+    std::vector<uint64_t> GetHistogram() const;
+
+    ///@param[in] nanoseconds : The latency
+    ///@return The bin of the latency histogram that the latency goes into.
+    static unsigned int GetBin(const uint64_t &nanoseconds);
+
+    ///@param[in] bin : The bin of the latency histogram
+    ///@return The shortest latency that goes into the bin, in nanoseconds.
+    static uint64_t GetBinLowEdge(const unsigned int &bin);
+
+private:
+    std::string group_; ///< The part of the scan that the stage belongs to
+    std::string name_; ///< The name of the stage
+    std::atomic<uint64_t> calls_; ///< The number of calls
+    std::atomic<uint64_t> total_; ///< The total time of the calls in ns
+    std::atomic<uint64_t> minimum_; ///< The shortest call in ns, UINT64_MAX before the first call
+    std::atomic<uint64_t> maximum_; ///< The longest call in ns
+    std::atomic<uint64_t> histogram_[NUMBER_OF_BINS]; ///< The number of calls in each latency bin
+};
+
+///Times the scope that it lives in and adds it to a StageTimer when the scope is left, even by an exception.
+class ScopedStageTimer {
+public:
+    ///Constructor that starts the clock.
+    ///@param[in] timer : The timer to add the time to, nothing is timed if this is NULL.
+    explicit ScopedStageTimer(StageTimer *timer) : timer_(timer) {
+        if (timer_)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    ///Destructor that stops the clock and adds the time to the timer.
+    ~ScopedStageTimer() {
+        if (timer_)
+            timer_->Add((uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_).count());
+    }
+
+private:
+    StageTimer *timer_; ///< The timer that we add to
+    std::chrono::steady_clock::time_point start_; ///< The time that the scope was entered
+
+    ScopedStageTimer(const ScopedStageTimer &);
+
+    ScopedStageTimer &operator=(const ScopedStageTimer &);
+};
+
+///Owns every StageTimer in the program. The timers are looked up by name once, when the stage is set up, and the
+/// pointer is used from then on. A pointer stays valid until the program exits.
+class StageTimers {
+public:
+    ///@return The only instance of the class.
+    static StageTimers *get();
+
+    ///@param[in] group : The part of the scan that the stage belongs to
+    ///@param[in] name : The name of the stage
+    ///@return The timer for the stage, which is created the first time that it's asked for.
+    StageTimer *Get(const std::string &group, const std::string &name);
+
+    ///@return Every timer, in the order that they were created.
+    std::vector<StageTimer *> GetTimers() const;
+
+    ///Sets every timer back to zero.
+    void Reset();
+
+    ///Prints a table of the timers that have been called. The timers in each group are sorted by their total time,
+    /// so the stage that takes the most time in each group is on top.
+    ///@param[in] out : The stream to print to
+    void Print(std::ostream &out) const;
+
+    ///Writes every timer that has been called to a JSON file, including the non-empty bins of its histogram.
+    ///@param[in] fileName : The file to write
+    ///@throws invalid_argument if the file can't be opened
+    void Write(const std::string &fileName) const;
+
+private:
+    ///Default constructor
+    StageTimers() {}
+
+    StageTimers(const StageTimers &);
+
+    StageTimers &operator=(const StageTimers &);
+
+    mutable std::mutex mutex_; ///< Protects the list of timers, the timers themselves don't need it
+    std::vector<StageTimer *> timers_; ///< Every timer in the order that they were created
+    std::map<std::string, StageTimer *> timerMap_; ///< The timers by group and name
+};
+
+#endif //PIXIESUITE_STAGETIMER_HPP
@@ -0,0 +1,67 @@
+///@file ThreadPool.hpp
+///@brief A small pool of worker threads that runs batches of independent tasks.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_THREADPOOL_HPP
+#define PIXIESUITE_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+
+///A fixed set of worker threads that run a batch of tasks and then go back to sleep. The thread that calls
+/// ParallelFor helps with the batch, so a pool with N threads keeps N + 1 cores busy. Only one batch runs at a time,
+/// and ParallelFor doesn't return until every task in the batch has finished.
+class ThreadPool {
+public:
+    ///Constructor
+    ///@param[in] numberOfThreads : The number of worker threads to start, in addition to the calling thread.
+    ThreadPool(const unsigned int &numberOfThreads);
+
+    ///Destructor, stops and joins all of the worker threads.
+    ~ThreadPool();
+
+    ///Runs task(i) for i = 0, ..., numberOfTasks - 1 on the workers and the calling thread. The tasks may run in any
+    /// order and on any thread. If a task throws, the remaining tasks still run and the first exception is rethrown
+    /// once the batch has finished.
+    ///@param[in] numberOfTasks : The number of tasks in the batch
+    ///@param[in] task : The function to call for each task.
+    void ParallelFor(const size_t &numberOfTasks, const std::function<void(const size_t &)> &task);
+
+    ///@return The number of worker threads, not counting the thread that calls ParallelFor.
+    unsigned int GetNumberOfThreads() const { return (unsigned int) threads_.size(); }
+
+private:
+    ///The loop that each of the worker threads runs until the pool is destroyed.
+    void Work();
+
+    ///Takes tasks from the current batch until there are none left. The lock must be held when this is called, and
+    /// it is held again when this returns.
+    ///@param[in] lock : The lock on mutex_
+    void RunTasks(std::unique_lock<std::mutex> &lock);
+
+    std::vector<std::thread> threads_; ///< The worker threads
+    std::mutex mutex_; ///< Protects everything below
+    std::condition_variable batchReady_; ///< Signaled when a batch is started or the pool is stopped
+    std::condition_variable batchDone_; ///< Signaled when the last task in a batch has finished
+
+    const std::function<void(const size_t &)> *task_; ///< The task for the current batch
+    size_t numberOfTasks_; ///< The number of tasks in the current batch
+    size_t nextTask_; ///< The next task that will be handed out
+    size_t numberFinished_; ///< The number of tasks that have finished in the current batch
+    unsigned long batch_; ///< Counts the batches so that the workers know when a new one has started
+    bool stopping_; ///< True when the pool is being destroyed
+    std::exception_ptr error_; ///< The first exception thrown by a task in the current batch
+
+    ///Copying a pool of running threads makes no sense.
+    ThreadPool(const ThreadPool &);
+
+    ThreadPool &operator=(const ThreadPool &);
+};
+
+#endif //PIXIESUITE_THREADPOOL_HPP
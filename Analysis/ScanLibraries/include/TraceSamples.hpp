@@ -0,0 +1,33 @@
+///@file TraceSamples.hpp
+///@brief Converts trace samples between the 16-bit words that the modules record and the wider types that the
+/// analysis works with.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_TRACESAMPLES_HPP
+#define PIXIESUITE_TRACESAMPLES_HPP
+
+#include <vector>
+
+///The Pixie-16 ADCs never produce more than 16 bits, so we keep the samples in the same 16-bit words that they arrive
+/// in and only widen them when somebody needs to do arithmetic on them.
+namespace TraceSamples {
+    ///@brief Widens the samples in [first, last) into 32-bit words. This uses SSE2, AVX2 or NEON when the compiler
+    /// targets them and falls back to a plain loop otherwise.
+    ///@param[in] first : Pointer to the first sample
+    ///@param[in] last : Pointer to one past the last sample
+    ///@param[out] out : Where we'll put the widened samples, it must have room for last - first samples.
+    void Widen(const unsigned short *first, const unsigned short *last, unsigned int *out);
+
+    ///@brief Widens a vector of samples into 32-bit words.
+    ///@param[in] samples : The samples to widen
+    ///@return A vector containing the widened samples
+    std::vector<unsigned int> Widen(const std::vector<unsigned short> &samples);
+
+    ///@brief Narrows 32-bit samples into the 16-bit words used for storage. Anything above 65535 is clamped to
+    /// 65535, which is what a saturated ADC would have recorded anyway.
+    ///@param[in] samples : The samples to narrow
+    ///@return A vector containing the narrowed samples
+    std::vector<unsigned short> Narrow(const std::vector<unsigned int> &samples);
+}
+
+#endif //PIXIESUITE_TRACESAMPLES_HPP
@@ -13,11 +13,22 @@
 #ifndef UNPACKER_HPP
 #define UNPACKER_HPP
 
+#include <condition_variable>
 #include <deque>
+#include <exception>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "BoundedQueue.hpp"
+#include "StageTimer.hpp"
+#include "ThreadPool.hpp"
+#include "XiaDataColumns.hpp"
+#include "XiaDataMerger.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
 #include "XiaListModeDataMask.hpp"
 
 #ifndef MAX_PIXIE_MOD
@@ -51,6 +62,15 @@ public:
     /// Return the time of the first fired channel event.
     double GetFirstTime() { return firstTime; }
 
+    ///Sets the time of the first event in the run instead of taking it from the first raw event that is built. A scan
+    /// of part of a run uses this so that its run time spectra line up with those of a scan of the whole run. This
+    /// has to be called before the first spill is read.
+    ///@param[in] time : The time of the first event in the run in clock ticks.
+    void SetFirstTime(const double &time);
+
+    ///@return True if the time of the first event in the run is known.
+    bool HasFirstTime() { return haveFirstTime_; }
+
     /// Get the start time of the current raw event.
     double GetEventStartTime() { return eventStartTime; }
 
@@ -76,14 +96,121 @@ public:
 
     /** ReadSpill is responsible for constructing a list of pixie16 events from
       * a raw data spill. This method performs sanity checks on the spill and
-      * calls ReadBuffer in order to construct the event list.
+      * calls ReadBuffer in order to construct the event list. In pipeline mode the
+      * spill is copied and queued for the decoder thread, and we return right away.
       * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
       * \param[in]  nWords     The number of words in the array.
       * \param[in]  is_verbose Toggle the verbosity flag on/off.
-      * \return True if the spill was read successfully and false otherwise.
+      * \return True if the spill was read (or queued) successfully and false otherwise.
       */
     bool ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbose = true);
 
+    /** ReadColumns does for a chunk of a column file what ReadSpill does for a raw spill. The hits in the chunk were
+      * decoded when the file was written, so they only need to be filled in before the events are built from
+      * them. The traces are referenced in the chunk rather than copied, so the chunk's memory has to stay put until
+      * the spill has been processed, e.g. until WaitForPipeline returns in pipeline mode.
+      * \param[in]  chunk      The chunk to read.
+      * \param[in]  is_verbose Toggle the verbosity flag on/off.
+      * \return True if the chunk was read (or queued) successfully and false otherwise.
+      */
+    bool ReadColumns(const XiaDataColumnChunk &chunk, bool is_verbose = true);
+
+    /** Write the decoded hits of every spill to a column file, before any events are built from them. Reading the
+      * file back with ReadColumns gives the same raw events without decoding the spills again. The writer isn't
+      * owned by the unpacker, and it must stay open until the last spill has been decoded. This may not be called
+      * while the pipeline is running.
+      * \param[in]  writer The writer to use, or NULL to stop writing.
+      * \return Nothing.
+      */
+    void SetColumnWriter(XiaDataColumnWriter *writer);
+
+    /** Decode, build and process spills on three threads that are connected by bounded queues. ReadSpill only
+      * copies the spill, so the caller can read the next one while the previous spills are in the pipeline.
+      * ProcessRawEvent and RawStats are always called from the processing thread, in the same order as
+      * without the pipeline. The caller's own methods (e.g. ScanInterface::IdleTask) now run alongside them.
+      * \param[in]  depth The maximum number of spills in the pipeline at once.
+      * \return Nothing.
+      */
+    void StartPipeline(const unsigned int &depth = 4);
+
+    /** Wait until every spill passed to ReadSpill has been processed. If one of the pipeline threads threw an
+      * exception, the pipeline is stopped and the exception is rethrown here.
+      * \return Nothing.
+      */
+    void WaitForPipeline();
+
+    /** Finish processing the spills in the pipeline and join the threads. ReadSpill is synchronous again
+      * afterwards. This must be called before a derived class tears down anything that ProcessRawEvent uses.
+      * \return Nothing.
+      */
+    void StopPipeline();
+
+    /// Return true if the pipeline threads are running.
+    bool IsPipelined() { return !pipelineThreads_.empty(); }
+
+    /** Decode the module buffers of each spill in parallel. The buffers are decoded into separate lists and
+      * added to the event list in module order afterwards, so the events are the same as with a single thread.
+      * This may not be called while the pipeline is running.
+      * \param[in]  numberOfThreads The number of threads to decode with, including the one calling ReadSpill.
+      *                             Zero or one decodes each buffer in turn.
+      * \return Nothing.
+      */
+    void SetDecodeThreads(const unsigned int &numberOfThreads);
+
+    /// Return the number of threads that decode the module buffers.
+    unsigned int GetDecodeThreads() { return decodeThreads_ ? decodeThreads_->GetNumberOfThreads() + 1 : 1; }
+
+    /// Return the number of corrupted module buffers that the decoders have skipped.
+    unsigned int GetNumberOfSkippedBuffers() { return numSkippedBuffers_; }
+
+    /** Tell the decoders which channels need their traces. The traces of every other channel are skipped while
+      * decoding, which saves both the time and the memory to copy them. The traces that we do keep are only
+      * copied out of the spill the first time somebody asks for them. This may not be called while the pipeline
+      * is running.
+      * \param[in]  channels The channels that need traces, indexed by XiaData::GetId. Empty means every channel.
+      * \return Nothing.
+      */
+    void SetTraceChannels(const std::vector<bool> &channels);
+
+    /// Return the channels whose traces are decoded, indexed by XiaData::GetId. Empty means every channel.
+    const std::vector<bool> &GetTraceChannels() const { return decoder_.GetTraceChannels(); }
+
+    /** Tell the decoders that the traces in the spills may be compressed with TraceCodec, as poll2 writes them to
+      * .pld files whose header says so. The setting is taken by each spill as it's read, so it may be changed while
+      * the pipeline is running, e.g. when the next file is opened.
+      * \param[in]  compressed True if the traces may be compressed.
+      * \return Nothing.
+      */
+    void SetCompressedTraces(const bool &compressed) { hasCompressedTraces_ = compressed; }
+
+    /// Return true if the traces in the spills that are read from now on may be compressed.
+    bool HasCompressedTraces() const { return hasCompressedTraces_; }
+
+    /** Build raw events across spill boundaries instead of within each spill. The hits at the end of a spill are
+      * held back until every module that reports hits in a later spill has moved past their event window, so a
+      * coincidence that straddles two spills ends up in a single raw event. Turning this off builds the hits that
+      * are held back. This may not be called while the pipeline is running.
+      * \param[in]  streaming True to build events across spills.
+      * \return Nothing.
+      */
+    void SetStreamingEvents(const bool &streaming);
+
+    /// Return true if raw events are built across spill boundaries.
+    bool IsStreamingEvents() { return isStreaming_; }
+
+    /** Build and process the hits that the streaming event builder is holding back. Call this at the end of a run,
+      * after the last spill has been passed to ReadSpill. In pipeline mode this is queued behind the spills that are
+      * already in the pipeline, so it returns before the events are processed.
+      * \return Nothing.
+      */
+    void FlushEvents();
+
+    /** Finish the processing of any events that the derived class is still holding on to. Called at the end of each
+      * scan, once FlushEvents and WaitForPipeline have returned. Unused by default.
+      * \return Nothing.
+      */
+    virtual void FinishEvents() {}
+
     /** Write all recorded channel counts to a file.
       * \return Nothing.
       */
@@ -101,12 +228,13 @@ public:
 
 protected:
     bool debug_mode; ///< True if debug mode is set.
-    std::vector<std::deque<XiaData *>> eventList; ///< The list of all events in a spill.
     double eventWidth_; ///< The width of the raw event in pixie clock ticks
     XiaListModeDataMask mask_; ///< Object providing the masks necessary to decode the data.
     std::map<unsigned int, std::pair<std::string, unsigned int> > maskMap_;///< Maps firmware/frequency to module number
+    std::map<unsigned int, XiaListModeDataLayout> layoutMap_; ///< The resolved masks for each module in maskMap_
+    XiaListModeDataLayout layout_; ///< The resolved masks for mask_, used when there isn't a maskMap_
     unsigned int maxModuleNumberInFile_; ///< The maximum module number that we've encountered in the data file.
-    std::deque<XiaData *> rawEvent; ///< The list of all events in the event window.
+    std::deque<XiaData *> rawEvent; ///< The list of all events in the event window. Memory is owned by the spill.
     bool running; ///< True if the scan is running.
 
     /** Process all events in the event list.
@@ -122,17 +250,57 @@ protected:
       */
     virtual void RawStats(XiaData *event_) {}
 
-    /** Called form ReadSpill. Scan the current spill and construct a list of
-      * events which fired by obtaining the module, channel, trace, etc. of the
-      * timestamped event. This method will construct the event list for
-      * later processing.
-      * \param[in]  buf    Pointer to an array of unsigned ints containing raw buffer data.
-      * \param[out] bufLen The number of words in the buffer.
-      * \return The number of XiaDatas read from the buffer.
-      */
-    int ReadBuffer(unsigned int *buf, const unsigned int &vsn);
-
 private:
+    ///Information about a single raw event that was built from a spill.
+    struct RawEventInfo {
+        size_t first; ///< The index of the first hit of the event in SpillData::hits
+        size_t size; ///< The number of hits in the event
+        double startTime; ///< The start time of the event window
+        double realStartTime; ///< The time of the first hit in the event
+        double realStopTime; ///< The time of the last hit in the event
+    };
+
+    ///A module buffer that is waiting to be decoded on one of the decode threads. Each task has its own decoder and
+    /// pool so that the tasks don't share any state.
+    struct ModuleTask {
+        unsigned int *buffer; ///< The start of the module buffer in the spill
+        XiaListModeDataLayout layout; ///< The resolved masks for the module that wrote the buffer
+        XiaListModeDataDecoder decoder; ///< Decodes the buffer
+        XiaDataPool pool; ///< Owns the XiaData decoded from the buffer
+        std::vector<XiaData *> events; ///< The decoded hits
+        unsigned int numSkippedBuffers; ///< The number of corrupted buffers that the decoder skipped
+    };
+
+    ///Everything that belongs to a single spill. The pipeline keeps several of these in flight, one in each stage.
+    struct SpillData {
+        SpillData() : isVerbose(true), isFlush(false), isColumns(false), hasCompressedTraces(false),
+                      maxModuleNumber(0), firstTime(0), numberOfModuleTasks(0) {}
+
+        ///Deletes the module tasks.
+        ~SpillData();
+
+        std::vector<unsigned int> words; ///< Copy of the raw spill. Only used in pipeline mode.
+        bool isVerbose; ///< The verbosity flag that was passed to ReadSpill with this spill.
+        bool isFlush; ///< True if this isn't a spill, but a request to build the hits held back by the builder.
+        bool isColumns; ///< True if the hits come from a chunk of a column file rather than from words.
+        XiaDataColumnChunk columns; ///< The chunk of a column file to read the hits from.
+        bool hasCompressedTraces; ///< True if the traces in the spill may be compressed.
+        XiaDataPool pool; ///< Owns all of the XiaData objects decoded from the spill.
+        std::vector<std::deque<XiaData *> > eventList; ///< The decoded hits from each module.
+        std::vector<XiaData *> hits; ///< The hits of every raw event in the spill, in event order.
+        std::vector<RawEventInfo> events; ///< The raw events built from the spill.
+        unsigned int maxModuleNumber; ///< The largest module number decoded so far in the file.
+        double firstTime; ///< The time of the first hit in the file.
+        std::vector<ModuleTask *> moduleTasks; ///< The module tasks, kept from one spill to the next.
+        size_t numberOfModuleTasks; ///< The number of module tasks in use for this spill.
+
+        ///@return A module task that is ready for a new buffer.
+        ModuleTask *NextModuleTask();
+
+        ///Clears the spill and returns the XiaData to the pool. Every pointer obtained from the spill is now invalid.
+        void Clear();
+    };
+
     unsigned int TOTALREAD; /// Maximum number of data words to read.
     unsigned int maxWords; /// Maximum number of data words for revision D.
     unsigned int numRawEvt; /// The total count of raw events read from file.
@@ -144,45 +312,176 @@ private:
     double realStartTime; /// The time of the first xia event in the raw event.
     double realStopTime; /// The time of the last xia event in the raw event.
 
-    /** Scan the event list and sort it by timestamp.
+    SpillData spill_; /// The spill that is being read when we are not using the pipeline.
+    XiaListModeDataDecoder decoder_; /// Decodes the module buffers when we decode them one at a time.
+    ThreadPool *decodeThreads_; /// Decodes the module buffers in parallel. NULL if we decode them one at a time.
+    unsigned int numSkippedBuffers_; /// The number of corrupted module buffers that the decoders have skipped.
+    unsigned int maxModuleDecoded_; /// The largest module number that the decoder has seen.
+    XiaDataMerger merger_; /// Merges the per-module event lists into a single time ordered stream.
+    bool haveFirstTime_; /// True once the builder has found the first event time in the file.
+    double builderFirstTime_; /// The first event time found by the builder.
+    bool isStreaming_; /// True if the builder carries unfinished events over to the next spill.
+    XiaDataPool carryPool_; /// Owns the hits that the builder carries over to the next spill.
+    std::vector<std::deque<XiaData *> > carryList_; /// The hits carried over to the next spill, for each module.
+    XiaDataColumnWriter *columnWriter_; /// Writes the decoded hits of each spill to a column file, NULL if we don't.
+    bool hasCompressedTraces_; /// True if the traces in the spills that we read from now on may be compressed.
+
+    std::vector<SpillData *> pipelineSpills_; /// Every spill owned by the pipeline.
+    std::vector<std::thread> pipelineThreads_; /// The decoder, builder and processing threads.
+    BoundedQueue<SpillData *> freeSpills_; /// Spills that are ready to be filled by ReadSpill.
+    BoundedQueue<SpillData *> decodeQueue_; /// Spills waiting to be decoded.
+    BoundedQueue<SpillData *> buildQueue_; /// Spills waiting for their raw events to be built.
+    BoundedQueue<SpillData *> processQueue_; /// Spills waiting for their raw events to be processed.
+    std::mutex pipelineMutex_; /// Protects spillsInFlight_ and pipelineError_.
+    std::condition_variable pipelineIdle_; /// Signaled when a spill leaves the pipeline or a thread fails.
+    unsigned int spillsInFlight_; /// The number of spills between ReadSpill and the end of processing.
+    std::exception_ptr pipelineError_; /// The first exception thrown by a pipeline thread.
+
+    StageTimer *decodeTimer_; /// Times DecodeSpill and DecodeColumns.
+    StageTimer *buildTimer_; /// Times BuildRawEvents.
+    StageTimer *processTimer_; /// Times ProcessRawEvents, which includes everything that the derived class does.
+    StageTimer *eventTimer_; /// Times each call to ProcessRawEvent.
+
+    /** Performs the sanity checks on a raw spill and decodes each of the module buffers into the spill's event
+      * list. This is the first stage of the pipeline.
+      * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
+      * \param[in]  nWords     The number of words in the array.
+      * \param[in]  is_verbose Toggle the verbosity flag on/off.
+      * \param[out] spill      The spill that will hold the decoded hits.
+      * \return True if the spill should be built and processed and false otherwise.
+      */
+    bool DecodeSpill(unsigned int *data, unsigned int nWords, bool is_verbose, SpillData &spill);
+
+    /** Fills the spill's event list with the hits of a chunk from a column file. This takes the place of DecodeSpill
+      * for spills that were decoded when the column file was written.
+      * \param[in]  chunk The chunk to read the hits from.
+      * \param[out] spill The spill that will hold the hits.
+      * \return True if the spill should be built and processed and false otherwise.
+      */
+    bool DecodeColumns(const XiaDataColumnChunk &chunk, SpillData &spill);
+
+    /** Called from DecodeSpill. Scan the current module buffer and construct a list of
+      * events which fired by obtaining the module, channel, trace, etc. of the
+      * timestamped event. This method will construct the event list for
+      * later processing.
+      * \param[in]  buf   Pointer to an array of unsigned ints containing raw buffer data.
+      * \param[in]  vsn   The module number of the buffer.
+      * \param[out] spill The spill that will hold the decoded hits.
+      * \return The number of XiaDatas read from the buffer.
+      */
+    int ReadBuffer(unsigned int *buf, const unsigned int &vsn, SpillData &spill);
+
+    /** Called from DecodeSpill when we decode in parallel. Sets up a module task for the buffer, which is decoded
+      * by DecodeModuleTasks once we've found all of the buffers in the spill.
+      * \param[in]  buf   Pointer to an array of unsigned ints containing raw buffer data.
+      * \param[in]  vsn   The module number of the buffer.
+      * \param[out] spill The spill that will hold the decoded hits.
       * \return Nothing.
       */
-    void TimeSort();
+    void QueueBuffer(unsigned int *buf, const unsigned int &vsn, SpillData &spill);
 
-    /** Scan the time sorted event list and package the events into a raw
-      * event with a size governed by the event width.
-      * \return True if the event list is not empty and false otherwise.
+    /** Decode all of the module tasks in the spill on the decode threads, and then add the hits to the event list
+      * in the order that the buffers appear in the spill.
+      * \param[in,out] spill The spill whose buffers we're decoding.
+      * \return The number of XiaDatas read from the buffers.
       */
-    bool BuildRawEvent();
+    unsigned long DecodeModuleTasks(SpillData &spill);
+
+    /** Get the resolved masks for a module. If we have a map of the modules, mask_ is set to the module's firmware
+      * and frequency as well.
+      * \param[in] vsn The module number
+      * \return The layout that decodes the module's data.
+      */
+    const XiaListModeDataLayout &GetLayout(const unsigned int &vsn);
 
     /** Push an event into the event list.
       * \param[in]  event_ The XiaData to push onto the back of the event list.
+      * \param[out] spill  The spill whose event list we're adding to.
       * \return True if the XiaData's module number is valid and false otherwise.
       */
-    bool AddEvent(XiaData *event_);
+    bool AddEvent(XiaData *event_, SpillData &spill);
+
+    /** Sort the event lists and build all of the raw events in the spill. This is the second stage of the pipeline.
+      * \param[in,out] spill The spill to build the events for.
+      * \return Nothing.
+      */
+    void BuildRawEvents(SpillData &spill);
 
-    /** Clear all events in the spill event list. WARNING! This method will delete all events in the
-      * event list. This could cause seg faults if the events are used elsewhere.
+    /** Pull hits from the merged, time ordered event list and package them into a raw
+      * event with a size governed by the event width.
+      * \param[in,out] spill     The spill that we are building events for.
+      * \param[in]     watermark Only events whose window closes before this time are built.
+      * \return True if an event was built and false otherwise.
+      */
+    bool BuildRawEvent(SpillData &spill, const double &watermark);
+
+    /** Find the time that every module reporting hits in the spill has moved past. None of those modules can send
+      * us a hit earlier than its latest one, so an event whose window closes before this time is complete.
+      * \param[in] spill The spill that we are building events for.
+      * \return The earliest of the latest hit times in each module.
+      */
+    double FindWatermark(const SpillData &spill);
+
+    /** Move the hits carried over from the previous spill to the front of the spill's event list.
+      * \param[in,out] spill The spill that we are building events for.
+      * \return Nothing.
+      */
+    void RestoreCarriedHits(SpillData &spill);
+
+    /** Move the hits that weren't built into events out of the spill, so that they survive it being cleared.
+      * \param[in,out] spill The spill that we are building events for.
+      * \return Nothing.
+      */
+    void CarryHits(SpillData &spill);
+
+    /** Hand each of the raw events in the spill to RawStats and ProcessRawEvent. This is the last stage of the
+      * pipeline, and the only one that touches the members that derived classes can see.
+      * \param[in] spill The spill whose events we're processing.
       * \return Nothing.
       */
-    void ClearEventList();
+    void ProcessRawEvents(SpillData &spill);
 
-    /** Clear all events in the raw event list. WARNING! This method will delete all events in the
-      * event list. This could cause seg faults if the events are used elsewhere.
+    /** Clear all events in the raw event list. The events themselves are owned by the spill pool and are reclaimed
+      * when the spill is cleared.
       * \return Nothing.
       */
     void ClearRawEvent();
 
-    /** Get the minimum channel time from the event list.
-      * \param[out] time The minimum time from the event list in system clock ticks.
-      * \return True if the event list is not empty and false otherwise.
+    /** Runs one stage of the pipeline. Spills are taken from the input, handed to the stage, and then passed on to
+      * the output. A spill is returned to freeSpills_ when there is no output or the stage returns false.
+      * \param[in] input  The queue that feeds this stage.
+      * \param[in] output The queue that feeds the next stage, NULL for the last stage.
+      * \param[in] stage  The method to call for each spill.
+      * \return Nothing.
       */
-    bool GetFirstTime(double &time);
+    void RunPipelineStage(BoundedQueue<SpillData *> *input, BoundedQueue<SpillData *> *output,
+                          bool (Unpacker::*stage)(SpillData &));
+
+    ///Pipeline wrapper around DecodeSpill.
+    bool DecodeStage(SpillData &spill);
+
+    ///Pipeline wrapper around BuildRawEvents.
+    bool BuildStage(SpillData &spill);
 
-    /** Check whether or not the eventList is empty.
-      * \return True if the eventList is empty, and false otherwise.
+    ///Pipeline wrapper around ProcessRawEvents.
+    bool ProcessStage(SpillData &spill);
+
+    /** Clears a spill and makes it available to ReadSpill again.
+      * \param[in] spill The spill that has left the pipeline.
+      * \return Nothing.
+      */
+    void RecycleSpill(SpillData *spill);
+
+    /** Records an exception thrown on a pipeline thread and closes every queue so that all of the threads exit.
+      * \param[in] error The exception that was thrown.
+      * \return Nothing.
+      */
+    void AbortPipeline(std::exception_ptr error);
+
+    /** Stops the pipeline and rethrows the exception if one of the pipeline threads failed.
+      * \return Nothing.
       */
-    bool IsEmpty();
+    void CheckPipeline();
 };
 
 #endif
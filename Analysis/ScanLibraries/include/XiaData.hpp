@@ -6,6 +6,9 @@
 
 #include <vector>
 
+#include "LazyTrace.hpp"
+#include "TraceSamples.hpp"
+
 /*! \brief A pixie16 channel event
  *
  * All data is grouped together into channels.  For each pixie16 channel that
@@ -23,6 +26,18 @@ public:
     ///Default Destructor.
     ~XiaData() {};
 
+    ///Default copy constructor.
+    XiaData(const XiaData &) = default;
+
+    ///Default move constructor, the vectors (trace included) are handed over rather than copied.
+    XiaData(XiaData &&) = default;
+
+    ///Default copy assignment.
+    XiaData &operator=(const XiaData &) = default;
+
+    ///Default move assignment.
+    XiaData &operator=(XiaData &&) = default;
+
     ///@brief Equality operator that compares checks if we have the same
     /// channel (i.e. the ID and Time are identical)
     ///@param[in] rhs : The right hand side of the comparison
@@ -139,8 +154,19 @@ public:
     ///@return the QDC recorded on the module
     std::vector<unsigned int> GetQdc() const { return qdc_; }
 
-    ///@return The trace that was sampled on the module
-    std::vector<unsigned int> GetTrace() const { return trace_; }
+    ///@return The 16-bit samples of the trace exactly as they were recorded on the module. If the trace still refers
+    /// to the spill buffer, this is when the samples get copied out of it.
+    const std::vector<unsigned short> &GetRawTrace() const { return trace_.Get(); }
+
+    ///@return A pointer to the GetTraceLength() samples of the trace, wherever they are. This never copies the samples
+    /// out of the spill buffer, and the pointer is only valid until the trace is changed or copied out.
+    const unsigned short *GetRawTraceData() const { return trace_.GetData(); }
+
+    ///@return A copy of the trace that was sampled on the module, widened to 32-bit words.
+    std::vector<unsigned int> GetTrace() const { return TraceSamples::Widen(trace_.Get()); }
+
+    ///@return The number of samples in the trace. This never copies the samples out of the spill buffer.
+    size_t GetTraceLength() const { return trace_.GetLength(); }
 
     ///@brief This value is set to true if the CFD was forced to trigger
     ///@param[in] a : The value to set
@@ -179,6 +205,11 @@ public:
     ///@param[in] a : The value to set
     void SetEnergySums(const std::vector<unsigned int> &a) { eSums_ = a; }
 
+    ///@brief Sets the energy sums directly from the data buffer. The existing storage is reused when possible.
+    ///@param[in] first : Pointer to the first word of the energy sums
+    ///@param[in] last : Pointer to one past the last word of the energy sums
+    void SetEnergySums(const unsigned int *first, const unsigned int *last) { eSums_.assign(first, last); }
+
     ///@brief Sets the upper 16 bits of the event time
     ///@param[in] a : The value to set
     void SetEventTimeHigh(const unsigned int &a) { eventTimeHigh_ = a; }
@@ -203,6 +234,11 @@ public:
     ///@param[in] a : The value to set
     void SetQdc(const std::vector<unsigned int> &a) { qdc_ = a; }
 
+    ///@brief Sets the QDCs directly from the data buffer. The existing storage is reused when possible.
+    ///@param[in] first : Pointer to the first QDC word
+    ///@param[in] last : Pointer to one past the last QDC word
+    void SetQdc(const unsigned int *first, const unsigned int *last) { qdc_.assign(first, last); }
+
     ///@brief Sets the saturation flag
     ///@param[in] a : True if we found a saturation on board
     void SetSaturation(const bool &a) { isSaturated_ = a; }
@@ -221,8 +257,21 @@ public:
     void SetFilterTime(const double &a) { filterTime_ = a; }
 
     ///@brief Sets the trace recorded on board
-    ///@param[in] a : The value to set
-    void SetTrace(const std::vector<unsigned int> &a) { trace_ = a; }
+    ///@param[in] a : The value to set, samples above 16-bits are clamped.
+    void SetTrace(const std::vector<unsigned int> &a) { trace_.Assign(TraceSamples::Narrow(a)); }
+
+    ///@brief Sets the trace directly from the 16-bit samples in the data buffer. The existing storage is reused
+    /// when possible.
+    ///@param[in] first : Pointer to the first sample
+    ///@param[in] last : Pointer to one past the last sample
+    void SetTrace(const unsigned short *first, const unsigned short *last) { trace_.Assign(first, last); }
+
+    ///@brief Refers to the 16-bit samples in the data buffer instead of copying them. They're copied the first time
+    /// that somebody asks for the trace, or when this XiaData is copied. The buffer must stay put until then or
+    /// until Initialize is called.
+    ///@param[in] first : Pointer to the first sample
+    ///@param[in] last : Pointer to one past the last sample
+    void SetTraceReference(const unsigned short *first, const unsigned short *last) { trace_.Refer(first, last); }
 
     ///@brief Sets the flag for channels generated on-board
     ///@param[in] a : True if we this channel was generated on-board
@@ -255,7 +304,7 @@ private:
 
     std::vector<unsigned int> eSums_;///Energy sums recorded by the module
     std::vector<unsigned int> qdc_; ///QDCs recorded by the module
-    std::vector<unsigned int> trace_; /// ADC trace capture.
+    LazyTrace trace_; /// ADC trace capture, in the 16-bit words the module recorded it in.
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+///@file XiaDataColumns.hpp
+///@brief Writes the decoded XiaData of each spill to a chunked, column oriented binary file and reads them back.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_XIADATACOLUMNS_HPP
+#define PIXIESUITE_XIADATACOLUMNS_HPP
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+#include "XiaData.hpp"
+
+///Constants that describe the layout of a column file. The file starts with a header of FILE_HEADER_SIZE bytes
+/// (magic number, version, flags and a reserved word) and is followed by one chunk for each spill. A chunk has a
+/// header of CHUNK_HEADER_SIZE bytes (magic number, number of hits, flags, a reserved word and the length of the
+/// chunk in bytes) followed by the columns. Every column is padded to a multiple of eight bytes, so that a chunk
+/// that starts on an eight byte boundary can be used in place. The columns are, in order:
+///  - time, filter time, energy, filter baseline and external time stamp as doubles
+///  - event time low, event time high, external time low, external time high and CFD fractional time as 32-bit words
+///  - crate, slot, channel and the flags of the hit as bytes
+///  - the offsets of the QDCs and of the energy sums of each hit, with one extra entry at the end for the total
+///  - the QDCs and the energy sums
+///  - if the chunk has traces, the sample offsets of each trace (with the total at the end) and the 16-bit samples
+namespace XiaDataColumns {
+    static const unsigned int FILE_MAGIC = 0x4C4F4358; ///< "XCOL"
+    static const unsigned int CHUNK_MAGIC = 0x4B4E4843; ///< "CHNK"
+    static const unsigned int VERSION = 1; ///< The version of the layout that we read and write
+    static const unsigned int HAS_TRACES = 0x1; ///< Flag for files and chunks that have the trace columns
+    static const size_t FILE_HEADER_SIZE = 16; ///< The size of the file header in bytes
+    static const size_t CHUNK_HEADER_SIZE = 24; ///< The size of the chunk header in bytes
+
+    ///The bits of the flag column.
+    enum HitFlags {
+        CFD_FORCED_TRIGGER = 0x1, PILEUP = 0x2, SATURATED = 0x4, VIRTUAL_CHANNEL = 0x8, CFD_TRIGGER_SOURCE = 0x10
+    };
+
+    ///Checks the header of a column file.
+    ///@param[in] data : Pointer to the start of the file
+    ///@param[in] nBytes : The number of bytes available at data
+    ///@param[out] flags : The flags of the file
+    ///@return True if the header is that of a column file of a version that we can read.
+    bool ReadFileHeader(const char *data, const size_t &nBytes, unsigned int &flags);
+}
+
+///Writes the decoded hits of each spill as a single chunk of a column file. The hits are written module by module,
+/// in the order that they were decoded, so that reading a chunk back gives the event builder exactly the same
+/// lists that the decoder gave it. A hit that doesn't have a trace still gets an (empty) entry in the trace columns.
+class XiaDataColumnWriter {
+public:
+    ///Default constructor
+    XiaDataColumnWriter() : withTraces_(false), numberOfChunks_(0), numberOfHits_(0) {}
+
+    ///Default destructor, closes the file.
+    ~XiaDataColumnWriter() { Close(); }
+
+    ///Opens a new column file and writes its header.
+    ///@param[in] fileName : The name of the file to write
+    ///@param[in] withTraces : True if the traces should be written as well
+    ///@return True if the file was opened.
+    bool Open(const std::string &fileName, const bool &withTraces = false);
+
+    ///Closes the file, if one is open.
+    void Close();
+
+    ///@return True if a file is open for writing.
+    bool IsOpen() const { return file_.is_open(); }
+
+    ///@return True if the traces are written to the file.
+    bool HasTraces() const { return withTraces_; }
+
+    ///@return The number of chunks written since the file was opened.
+    size_t GetNumberOfChunks() const { return numberOfChunks_; }
+
+    ///@return The number of hits written since the file was opened.
+    unsigned long long GetNumberOfHits() const { return numberOfHits_; }
+
+    ///Writes the hits of a spill as a single chunk. Nothing is written if there aren't any hits.
+    ///@param[in] eventList : The decoded hits of the spill, one list for each module
+    ///@throws runtime_error if the file isn't open or the chunk couldn't be written
+    void Write(const std::vector<std::deque<XiaData *> > &eventList);
+
+private:
+    std::ofstream file_; ///< The file that we're writing
+    bool withTraces_; ///< True if the traces are written
+    size_t numberOfChunks_; ///< The number of chunks written so far
+    unsigned long long numberOfHits_; ///< The number of hits written so far
+    std::vector<const XiaData *> hits_; ///< The hits of the chunk that we're writing, kept to reuse the storage
+    std::vector<unsigned int> qdcs_; ///< The QDCs of the chunk that we're writing, kept to reuse the storage
+    std::vector<unsigned int> sums_; ///< The energy sums of the chunk that we're writing, kept to reuse the storage
+    std::vector<unsigned int> qdcOffsets_; ///< The index of the first QDC of each hit, kept to reuse the storage
+    std::vector<unsigned int> sumOffsets_; ///< The index of the first energy sum of each hit, kept to reuse the storage
+    std::vector<char> chunk_; ///< The chunk that we're writing, kept to reuse the storage
+};
+
+///A chunk of a column file that is sitting in memory, usually in a memory mapped file. The chunk doesn't own or
+/// copy anything, the memory must stay put for as long as the chunk, or any XiaData filled from it, is in use. The
+/// columns can be used directly, or the hits can be turned back into XiaData with Fill.
+class XiaDataColumnChunk {
+public:
+    ///Default constructor
+    XiaDataColumnChunk() { Clear(); }
+
+    ///Finds the columns of the chunk that starts at data.
+    ///@param[in] data : Pointer to the start of the chunk, which must be on an eight byte boundary
+    ///@param[in] nBytes : The number of bytes available at data
+    ///@return The length of the chunk in bytes, or zero if there isn't a complete and valid chunk at data.
+    size_t Parse(const char *data, const size_t &nBytes);
+
+    ///Forgets the chunk.
+    void Clear();
+
+    ///Fills a XiaData with one of the hits in the chunk. The trace, if the chunk has one for the hit, is referenced
+    /// rather than copied.
+    ///@param[in] i : The index of the hit in the chunk
+    ///@param[out] data : The XiaData to fill, which should have been initialized
+    void Fill(const size_t &i, XiaData *data) const;
+
+    ///@return The number of hits in the chunk.
+    size_t GetNumberOfHits() const { return numberOfHits_; }
+
+    ///@return True if the chunk has the trace columns.
+    bool HasTraces() const { return traceOffsets_ != NULL; }
+
+    ///@return The time column, which includes the CFD information.
+    const double *GetTimes() const { return times_; }
+
+    ///@return The filter time column.
+    const double *GetFilterTimes() const { return filterTimes_; }
+
+    ///@return The energy column.
+    const double *GetEnergies() const { return energies_; }
+
+    ///@return The crate number column.
+    const unsigned char *GetCrateNumbers() const { return crates_; }
+
+    ///@return The slot number column.
+    const unsigned char *GetSlotNumbers() const { return slots_; }
+
+    ///@return The channel number column.
+    const unsigned char *GetChannelNumbers() const { return channels_; }
+
+    ///@return The flag column, see XiaDataColumns::HitFlags.
+    const unsigned char *GetFlags() const { return flags_; }
+
+private:
+    size_t numberOfHits_; ///< The number of hits in the chunk
+    const double *times_; ///< The time column
+    const double *filterTimes_; ///< The filter time column
+    const double *energies_; ///< The energy column
+    const double *baselines_; ///< The filter baseline column
+    const double *externalTimestamps_; ///< The external time stamp column
+    const unsigned int *eventTimeLows_; ///< The event time low column
+    const unsigned int *eventTimeHighs_; ///< The event time high column
+    const unsigned int *externalTimeLows_; ///< The external time low column
+    const unsigned int *externalTimeHighs_; ///< The external time high column
+    const unsigned int *cfdTimes_; ///< The CFD fractional time column
+    const unsigned char *crates_; ///< The crate number column
+    const unsigned char *slots_; ///< The slot number column
+    const unsigned char *channels_; ///< The channel number column
+    const unsigned char *flags_; ///< The flag column
+    const unsigned int *qdcOffsets_; ///< The index of the first QDC of each hit
+    const unsigned int *sumOffsets_; ///< The index of the first energy sum of each hit
+    const unsigned int *qdcs_; ///< The QDCs of every hit
+    const unsigned int *sums_; ///< The energy sums of every hit
+    const unsigned int *traceOffsets_; ///< The index of the first sample of each trace, NULL without traces
+    const unsigned short *samples_; ///< The samples of every trace
+};
+
+#endif //PIXIESUITE_XIADATACOLUMNS_HPP
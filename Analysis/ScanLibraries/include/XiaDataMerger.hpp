@@ -0,0 +1,60 @@
+///@file XiaDataMerger.hpp
+///@brief Merges the time sorted hits from each module into a single time ordered stream.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_XIADATAMERGER_HPP
+#define PIXIESUITE_XIADATAMERGER_HPP
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "XiaData.hpp"
+
+///A k-way merge over the per-module event lists that the Unpacker builds for each spill. Each module's list is sorted
+/// on its own, and a binary heap keeps the earliest remaining hit from every module at its top. Finding the next hit
+/// in time is O(1) and removing it is O(log k), where k is the number of modules, so building events no longer
+/// requires scanning every module for every event. Hits with identical times are returned in order of increasing
+/// module number.
+class XiaDataMerger {
+public:
+    ///Default constructor
+    XiaDataMerger() : streams_(NULL) {}
+
+    ///Default destructor
+    ~XiaDataMerger() {}
+
+    ///Sorts each of the streams by time and seeds the heap with the first hit from each of them. The merger keeps a
+    /// pointer to the streams and removes hits from them as they are popped.
+    ///@param[in] streams : The per-module lists of hits that we are going to merge.
+    void Initialize(std::vector<std::deque<XiaData *> > &streams);
+
+    ///Removes all entries from the heap. This does not touch the streams themselves.
+    void Clear();
+
+    ///@return True if there are no more hits in any of the streams.
+    bool IsEmpty() const { return heap_.empty(); }
+
+    ///@return The filter time of the earliest hit remaining in the streams. Only valid if IsEmpty is false.
+    double GetNextTime() const { return heap_.front().first; }
+
+    ///Removes the earliest hit from its stream and returns it.
+    ///@return A pointer to the earliest hit, or NULL if the streams are empty.
+    XiaData *Pop();
+
+private:
+    typedef std::pair<double, unsigned int> HeapEntry;
+
+    ///Orders the heap so that the earliest time (and lowest module for ties) is at the top.
+    struct Later {
+        bool operator()(const HeapEntry &lhs, const HeapEntry &rhs) const { return lhs > rhs; }
+    };
+
+    ///Moves the entry at the top of the heap down until the heap is ordered again.
+    void SiftDown();
+
+    std::vector<std::deque<XiaData *> > *streams_; ///< The streams that we are merging
+    std::vector<HeapEntry> heap_; ///< The time and stream index of the head of each stream
+};
+
+#endif //PIXIESUITE_XIADATAMERGER_HPP
@@ -0,0 +1,59 @@
+///@file XiaDataPool.hpp
+///@brief A spill scoped pool that owns all of the XiaData objects decoded from a spill.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_XIADATAPOOL_HPP
+#define PIXIESUITE_XIADATAPOOL_HPP
+
+#include <vector>
+
+#include <cstddef>
+
+#include "XiaData.hpp"
+
+///This class owns every XiaData object that is decoded from a single spill. Objects are handed out from large blocks
+/// that are allocated once and then recycled for every subsequent spill. Recycled objects are re-initialized with
+/// XiaData::Initialize, which clears the QDC, energy sum and trace vectors without releasing their storage. After the
+/// first few spills the decoder no longer touches the heap at all. Releasing the objects at the end of a spill is a
+/// single assignment, no matter how many hits the spill contained.
+///
+/// WARNING! Pointers handed out by the pool are only valid until the next call to Reset. Anybody that needs the
+/// information after the spill has been processed must make a copy of it.
+class XiaDataPool {
+public:
+    ///Default constructor
+    ///@param[in] blockSize : The number of XiaData objects allocated each time the pool needs to grow.
+    XiaDataPool(const size_t &blockSize = 1024) : blockSize_(blockSize), numInUse_(0) {}
+
+    ///Default destructor, frees all of the blocks that were allocated.
+    ~XiaDataPool();
+
+    ///@return A pointer to an initialized XiaData object that is owned by the pool.
+    XiaData *Acquire();
+
+    ///Returns all of the objects to the pool. This does not free any memory, so it doesn't matter how many
+    /// objects were acquired.
+    void Reset() { numInUse_ = 0; }
+
+    ///@return The number of objects that have been handed out since the last Reset.
+    size_t GetNumberInUse() const { return numInUse_; }
+
+    ///@return The total number of objects that the pool can hand out without allocating more memory.
+    size_t GetCapacity() const { return blocks_.size() * blockSize_; }
+
+    ///@return The number of blocks that the pool has allocated over its lifetime.
+    size_t GetNumberOfBlocks() const { return blocks_.size(); }
+
+private:
+    ///The pool owns raw memory so copying it would lead to a double free.
+    XiaDataPool(const XiaDataPool &);
+
+    ///The pool owns raw memory so copying it would lead to a double free.
+    XiaDataPool &operator=(const XiaDataPool &);
+
+    size_t blockSize_; ///< The number of objects in each of the blocks
+    size_t numInUse_; ///< The number of objects handed out since the last reset
+    std::vector<XiaData *> blocks_; ///< The blocks of objects that we've allocated
+};
+
+#endif //PIXIESUITE_XIADATAPOOL_HPP
@@ -9,13 +9,16 @@
 #include <vector>
 
 #include "XiaData.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataLayout.hpp"
 #include "XiaListModeDataMask.hpp"
 
-///Class to decode Xia List mode Data
+///Class to decode Xia List mode Data. A decoder keeps a count of the buffers that it had to skip, so each thread that
+/// decodes data needs its own decoder.
 class XiaListModeDataDecoder {
 public:
     ///Default constructor
-    XiaListModeDataDecoder() {};
+    XiaListModeDataDecoder() : numSkippedBuffers_(0), hasTraceReferences_(false), hasCompressedTraces_(false) {};
 
     ///Default destructor
     ~XiaListModeDataDecoder() {};
@@ -23,8 +26,20 @@ public:
     ///Main decoding method
     ///@param[in] buf : Pointer to the beginning of the data buffer.
     ///@param[in] mask : The mask set that we need to decode the data
+    ///@param[in] pool : The pool that will own the decoded events. If this is NULL the events are allocated with
+    /// new and the caller is responsible for deleting them.
     ///@return A vector containing all of the decoded XiaData events.
-    std::vector<XiaData *> DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask);
+    std::vector<XiaData *> DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool *pool = NULL);
+
+    ///Decoding method for when the masks have already been resolved. This is the faster method, the Unpacker builds
+    /// a layout for each module once and uses it for every buffer from that module.
+    ///@param[in] buf : Pointer to the beginning of the data buffer.
+    ///@param[in] layout : The resolved masks for the module's firmware and frequency
+    ///@param[in] pool : The pool that will own the decoded events. If this is NULL the events are allocated with
+    /// new and the caller is responsible for deleting them.
+    ///@return A vector containing all of the decoded XiaData events.
+    std::vector<XiaData *> DecodeBuffer(unsigned int *buf, const XiaListModeDataLayout &layout,
+                                        XiaDataPool *pool = NULL);
 
     ///Method to calculate the arrival time of the signal in samples
     ///@param[in] mask : The data mask containing the necessary information
@@ -43,32 +58,60 @@ public:
     ///@return The calculated time in nanoseconds
     static double CalculateTimeInNs(const XiaListModeDataMask &mask, const XiaData &data);
 
-private:
-    ///Method to decode word zero from the header.
-    ///@param[in] word : The word that we need to decode
-    ///@param[in] data : The XiaData object that we are going to fill.
-    ///@return The pair of the header length and event length for use in
-    /// subsequent processing.
-    std::pair<unsigned int, unsigned int> DecodeWordZero(const unsigned int &word, XiaData &data,
-                                                         const XiaListModeDataMask &mask);
+    ///@return The number of buffers that this decoder skipped because they were corrupted.
+    unsigned int GetNumberOfSkippedBuffers() const { return numSkippedBuffers_; }
 
-    ///Method to decode word two from the header.
-    ///@param[in] word : The word that we need to decode
-    ///@param[in] data : The XiaData object that we are going to fill.
-    ///@param[in] mask : The data mask to decode the data
-    void DecodeWordTwo(const unsigned int &word, XiaData &data, const XiaListModeDataMask &mask);
+    ///Sets the number of skipped buffers back to zero.
+    void ResetNumberOfSkippedBuffers() { numSkippedBuffers_ = 0; }
 
-    ///Method to decode word three from the header.
-    ///@param[in] word : The word that we need to decode
-    ///@param[in] data : The XiaData object that we are going to fill.
-    ///@param[in] mask : The data mask to decode the data
-    ///@return The trace length
-    unsigned int DecodeWordThree(const unsigned int &word, XiaData &data, const XiaListModeDataMask &mask);
+    ///@return The channels whose traces we decode, indexed by XiaData::GetId. Empty means every channel.
+    const std::vector<bool> &GetTraceChannels() const { return traceChannels_; }
+
+    ///Sets the channels whose traces we decode. The traces of the other channels are skipped, and those XiaData
+    /// come back without a trace. Channels past the end of the vector keep their traces.
+    ///@param[in] a : The channels that need traces, indexed by XiaData::GetId. Empty means every channel.
+    void SetTraceChannels(const std::vector<bool> &a) { traceChannels_ = a; }
+
+    ///@return True if the decoded XiaData refer to the traces in the buffer instead of copying them.
+    bool HasTraceReferences() const { return hasTraceReferences_; }
+
+    ///When this is set the decoded XiaData only refer to the trace in the buffer, and the samples are copied the
+    /// first time that somebody asks for them. The buffer must not change until every XiaData decoded from it has
+    /// been released.
+    ///@param[in] a : True if we should refer to the traces instead of copying them.
+    void SetTraceReferences(const bool &a) { hasTraceReferences_ = a; }
+
+    ///@return True if we expect traces that were compressed with TraceCodec.
+    bool HasCompressedTraces() const { return hasCompressedTraces_; }
+
+    ///When this is set a hit whose event length is shorter than its header and trace lengths call for is taken to
+    /// have a compressed trace. Those traces are always copied, since there's nothing in the buffer to refer to.
+    ///@param[in] a : True if the data may contain compressed traces.
+    void SetCompressedTraces(const bool &a) { hasCompressedTraces_ = a; }
+
+private:
+    unsigned int numSkippedBuffers_; ///< The number of buffers that we've skipped because they were corrupted.
+    bool hasTraceReferences_; ///< True if the XiaData refer to the traces in the buffer
+    bool hasCompressedTraces_; ///< True if the traces may be compressed
+    std::vector<bool> traceChannels_; ///< The channels whose traces we decode, empty for all of them.
+    std::vector<unsigned short> samples_; ///< Holds the last decompressed trace, kept to reuse the storage
+
+    ///The decoding loop for a single frequency. There is one of these compiled for each of the supported frequencies,
+    /// and the firmware differences are all handled by the masks in the layout.
+    ///@param[in] buf : Pointer to the beginning of the data buffer.
+    ///@param[in] layout : The resolved masks for the module's firmware and frequency
+    ///@param[in] pool : The pool that will own the decoded events, may be NULL.
+    ///@return A vector containing all of the decoded XiaData events.
+    template<unsigned int Frequency>
+    std::vector<XiaData *> DecodeEvents(unsigned int *buf, const XiaListModeDataLayout &layout, XiaDataPool *pool);
 
-    ///Method to decode word three from the header.
-    ///@param[in] word : The word that we need to decode
+    ///Method to decode the trace that follows the header.
+    ///@param[in] buf : Pointer to the first word of the trace
     ///@param[in] data : The XiaData object that we are going to fill.
-    void DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength);
+    ///@param[in] traceLength : The number of samples in the trace
+    ///@param[in] traceWords : The number of words that the trace takes up, less than traceLength / 2 if compressed
+    ///@return False if the trace is compressed and couldn't be decompressed.
+    bool DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength, const unsigned int &traceWords);
 };
 
 #endif //PIXIESUITE_XIALISTMODEDATADECODER_HPP
@@ -0,0 +1,63 @@
+///@file XiaListModeDataLayout.hpp
+///@brief The masks and shifts needed to decode the list mode data of a single firmware and frequency.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef PIXIESUITE_XIALISTMODEDATALAYOUT_HPP
+#define PIXIESUITE_XIALISTMODEDATALAYOUT_HPP
+
+#include "HelperEnumerations.hpp"
+#include "XiaListModeDataMask.hpp"
+
+///Every getter in the XiaListModeDataMask checks the firmware and frequency, walks a switch and builds a pair. That's
+/// fine once per module, but not once per field of every hit. This structure asks the mask for everything once and
+/// keeps the results as plain numbers, so decoding a header word is only a handful of ands and shifts. Build one of
+/// these for each module when its firmware and frequency are known, and hand it to the decoder with each buffer.
+///
+/// Fields that a firmware doesn't have are given a mask of zero, which always decodes to zero. This lets the decoder
+/// use the same code for every firmware. For example, the Trace-out-of-range flag lives in Word 0 for the oldest
+/// firmwares and in Word 3 for the others, so one of the two saturation masks is always zero.
+struct XiaListModeDataLayout {
+    ///Default constructor, the layout can't decode anything until a mask has been assigned.
+    XiaListModeDataLayout();
+
+    ///Constructor that resolves all of the masks.
+    ///@param[in] mask : The mask for the firmware and frequency that we want to decode.
+    ///@throws invalid_argument if the mask's firmware or frequency is not set.
+    explicit XiaListModeDataLayout(const XiaListModeDataMask &mask);
+
+    DataProcessing::FIRMWARE firmware; ///< The firmware that the layout decodes
+    unsigned int frequency; ///< The sampling frequency of the module in MS/s
+
+    unsigned int channelNumberMask; ///< Word 0 : The channel number
+    unsigned int slotIdMask; ///< Word 0 : The slot number
+    unsigned int slotIdShift; ///< Word 0 : The bit that the slot number starts on
+    unsigned int crateIdMask; ///< Word 0 : The crate number
+    unsigned int crateIdShift; ///< Word 0 : The bit that the crate number starts on
+    unsigned int headerLengthMask; ///< Word 0 : The header length
+    unsigned int headerLengthShift; ///< Word 0 : The bit that the header length starts on
+    unsigned int eventLengthMask; ///< Word 0 : The event length
+    unsigned int eventLengthShift; ///< Word 0 : The bit that the event length starts on
+    unsigned int finishCodeMask; ///< Word 0 : The pileup flag
+    unsigned int wordZeroSaturationMask; ///< Word 0 : The Trace-out-of-range flag, zero if it's in Word 3
+
+    unsigned int eventTimeHighMask; ///< Word 2 : The high bits of the time stamp
+    unsigned int cfdFractionalTimeMask; ///< Word 2 : The CFD fractional time
+    unsigned int cfdFractionalTimeShift; ///< Word 2 : The bit that the CFD fractional time starts on
+    unsigned int cfdForcedTriggerBitMask; ///< Word 2 : The CFD forced trigger bit
+    unsigned int cfdForcedTriggerBitShift; ///< Word 2 : The bit that holds the CFD forced trigger bit
+    unsigned int cfdTriggerSourceMask; ///< Word 2 : The CFD trigger source
+    unsigned int cfdTriggerSourceShift; ///< Word 2 : The bit that the CFD trigger source starts on
+
+    unsigned int eventEnergyMask; ///< Word 3 : The energy
+    unsigned int wordThreeSaturationMask; ///< Word 3 : The Trace-out-of-range flag, zero if it's in Word 0
+    unsigned int traceLengthMask; ///< Word 3 : The trace length
+    unsigned int traceLengthShift; ///< Word 3 : The bit that the trace length starts on
+
+    unsigned int numberOfExternalTimestampWords; ///< The number of words in the external time stamp
+    unsigned int numberOfEnergySumWords; ///< The number of words in the energy sums
+    unsigned int numberOfQdcWords; ///< The number of words in the QDC
+
+    double cfdSize; ///< The value that the CFD fractional time is divided by
+};
+
+#endif //PIXIESUITE_XIALISTMODEDATALAYOUT_HPP
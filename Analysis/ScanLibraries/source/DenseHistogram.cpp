@@ -0,0 +1,111 @@
+///@file DenseHistogram.cpp
+///@brief A histogram of unit width bins that only counts, so that the DAMM style histograms can be filled without
+/// going through ROOT.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "DenseHistogram.hpp"
+
+using namespace std;
+
+///The products are less than maxBins^2, so they can keep 64 bits less the bits of maxBins^2 and still fit in 64 bits.
+/// That's capped at the bits of the values, which is what any histogram of up to 2^16 bins on an axis gets.
+DenseHistogram::Sums::Sums(const unsigned int &maxBins) : count_(0) {
+    int bits = 0;
+    while (bits < 32 && (uint64_t) maxBins > (1ull << bits))
+        bits++;
+    quadraticBits_ = min(linearBits, 64 - 2 * bits);
+    linearScale_ = ldexp(1., linearBits);
+    quadraticScale_ = ldexp(1., quadraticBits_);
+    fill(sums_, sums_ + 9, 0);
+}
+
+void DenseHistogram::Sums::Add(const Sums &rhs) {
+    if (rhs.quadraticBits_ != quadraticBits_)
+        throw invalid_argument("DenseHistogram::Sums::Add - The sums don't have the same number of fractional bits.");
+    count_ += rhs.count_;
+    for (size_t i = 0; i < 9; i++)
+        sums_[i] += rhs.sums_[i];
+}
+
+void DenseHistogram::Sums::Get(double *stats) const {
+    const int bits[9] = {linearBits, quadraticBits_, linearBits, quadraticBits_, quadraticBits_, linearBits,
+                         quadraticBits_, quadraticBits_, quadraticBits_};
+    stats[0] = stats[1] = count_;
+    for (size_t i = 0; i < 9; i++)
+        stats[i + 2] = ldexp((double) sums_[i], -bits[i]);
+}
+
+void DenseHistogram::Sums::Reset() {
+    count_ = 0;
+    fill(sums_, sums_ + 9, 0);
+}
+
+DenseHistogram::DenseHistogram(const unsigned int &xBins, const unsigned int &yBins/*=0*/,
+                               const unsigned int &zBins/*=0*/) : xBins_(xBins), yBins_(yBins), zBins_(zBins),
+                                                                  entries_(0), sums_(max(xBins, max(yBins, zBins))) {
+    if (xBins_ == 0)
+        throw invalid_argument("DenseHistogram::DenseHistogram - A histogram needs at least one bin in x.");
+    if (zBins_ != 0 && yBins_ == 0)
+        throw invalid_argument("DenseHistogram::DenseHistogram - A histogram with z bins needs y bins too.");
+
+    xStride_ = xBins_ + 2;
+    yStride_ = xStride_ * (yBins_ ? yBins_ + 2 : 1);
+    counts_.assign(yStride_ * (zBins_ ? zBins_ + 2 : 1), 0);
+}
+
+///The block is small enough to stay in L1 while it's counted.
+void DenseHistogram::Fill(const double *x, const size_t &n) {
+    static const size_t blockSize = 256;
+    uint32_t bins[blockSize];
+    const double upper = xBins_;
+
+    for (size_t start = 0; start < n; start += blockSize) {
+        const size_t size = min(blockSize, n - start);
+        for (size_t i = 0; i < size; i++) {
+            const double value = x[start + i];
+            bins[i] = value >= 0 && value < upper ? (uint32_t) value + 1 : (value < 0 ? 0 : xBins_ + 1);
+        }
+        for (size_t i = 0; i < size; i++) {
+            Increment(bins[i]);
+            if (IsInside(bins[i], xBins_))
+                sums_.Tally(x[start + i]);
+        }
+    }
+}
+
+uint64_t DenseHistogram::GetCellContent(const size_t &cell) const {
+    if (carries_.empty())
+        return counts_.at(cell);
+    map<size_t, uint64_t>::const_iterator carry = carries_.find(cell);
+    return counts_.at(cell) + (carry == carries_.end() ? 0 : carry->second << 32);
+}
+
+void DenseHistogram::Add(const DenseHistogram &rhs) {
+    if (rhs.xBins_ != xBins_ || rhs.yBins_ != yBins_ || rhs.zBins_ != zBins_)
+        throw invalid_argument("DenseHistogram::Add - The histograms don't have the same bins.");
+
+    for (size_t cell = 0; cell < counts_.size(); cell++) {
+        const uint32_t before = counts_[cell];
+        counts_[cell] += rhs.counts_[cell];
+        if (counts_[cell] < before)
+            carries_[cell]++;
+    }
+    for (map<size_t, uint64_t>::const_iterator it = rhs.carries_.begin(); it != rhs.carries_.end(); it++)
+        carries_[it->first] += it->second;
+    entries_ += rhs.entries_;
+    sums_.Add(rhs.sums_);
+}
+
+///A histogram that hasn't been filled is left alone, so that resetting all of them is cheap when most are empty.
+void DenseHistogram::Reset() {
+    if (entries_ == 0)
+        return;
+    fill(counts_.begin(), counts_.end(), 0);
+    carries_.clear();
+    entries_ = 0;
+    sums_.Reset();
+}
@@ -12,14 +12,17 @@
  */
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <cstring>
 
 #include <unistd.h>
 #include <getopt.h>
 
+#include "StageTimer.hpp"
 #include "Unpacker.hpp"
 #include "poll2_socket.h"
 #include "CTerminal.h"
@@ -227,11 +230,14 @@ bool ScanInterface::open_input_file(const string &fname_) {
         file_format = 0;
     } else if (extension == "pld") { // Pixie list data file format
         file_format = 1;
+    } else if (extension == "xcol") { // Decoded hits written with --export-columns
+        file_format = 2;
     } else {
         cout << " ERROR! Invalid file format '" << extension << "'\n";
         cout << "  The current valid data formats are:\n";
         cout << "   ldf - list data format (HRIBF)\n";
         cout << "   pld - pixie list data format\n";
+        cout << "   xcol - decoded hits exported with --export-columns\n";
         return false;
     }
 
@@ -239,9 +245,14 @@ bool ScanInterface::open_input_file(const string &fname_) {
     if (file_open) {
         cout << " Note: Closing previously opened file.\n";
         input_file.close();
+        mapped_file.Close();
     }
 
     file_open = true;
+    input_fname = fname_;
+    spill_index.Clear();
+    range_pending = false;
+    range_active = false;
 
     // Load the input file.
     input_file.open(fname_.c_str(), ios::binary);
@@ -259,6 +270,9 @@ bool ScanInterface::open_input_file(const string &fname_) {
         // Clear the file information container.
         finfo.clear();
 
+        // Only a pld file can say that its traces are compressed.
+        unpacker_->SetCompressedTraces(false);
+
         // Start reading the file
         // Every poll2 ldf file starts with a DIR buffer followed by a HEAD buffer
         int num_buffers;
@@ -283,6 +297,8 @@ bool ScanInterface::open_input_file(const string &fname_) {
 
             max_spill_size = pldHead.GetMaxSpillSize();
 
+            unpacker_->SetCompressedTraces(pldHead.HasCompressedTraces());
+
             // Store the file information for later use.
             finfo.push_back("Facility", pldHead.GetFacility());
             finfo.push_back("Format", pldHead.GetFormat());
@@ -295,15 +311,131 @@ bool ScanInterface::open_input_file(const string &fname_) {
 
             pldHead.Print();
             cout << endl;
+        } else if (file_format == 2) {
+            // Column files are only ever read through the mapping, the chunks are used right where they sit.
+            unsigned int flags = 0;
+            if (!mapped_file.Open(fname_) ||
+                !XiaDataColumns::ReadFileHeader(mapped_file.Read(XiaDataColumns::FILE_HEADER_SIZE),
+                                                XiaDataColumns::FILE_HEADER_SIZE, flags)) {
+                cout << " ERROR! Failed to read the header of column file '" << fname_ << "'!\n";
+                mapped_file.Close();
+                input_file.close();
+                file_open = false;
+                return false;
+            }
+
+            finfo.push_back("Format", "xcol");
+            finfo.push_back("Version", XiaDataColumns::VERSION);
+            finfo.push_back("Traces", (flags & XiaDataColumns::HAS_TRACES) ? "yes" : "no");
+            cout << " Column file with" << ((flags & XiaDataColumns::HAS_TRACES) ? "" : "out") << " traces\n\n";
         }
     }
 
+    // Map the file, the headers have already been read through input_file.
+    if (mmap_mode && !mapped_file.IsOpen() && !mapped_file.Open(fname_))
+        cout << " WARNING! Failed to memory map input file '" << fname_ << "', reading it as a stream instead.\n";
+
+    // The first scan of the file jumps to the requested range. Column files don't have a spill index.
+    if (range_mode && file_format == 2) {
+        cout << " WARNING! Spill and time ranges can't be used with column files, scanning all of '" << fname_
+             << "'.\n";
+    } else if (range_mode) {
+        if (load_spill_index())
+            range_pending = true;
+        else
+            cout << " WARNING! Scanning all of input file '" << fname_ << "' since it has no spill index.\n";
+    }
+
     // Notify that the user has loaded a new file.
     Notify("LOAD_FILE");
 
     return true;
 }
 
+/** Get the current read position in the input file. In mmap mode input_file is only
+  * synchronized with the mapping when a scan stops, so we ask the mapping.
+  * \return The read position in bytes.
+  */
+streampos ScanInterface::get_file_position() {
+    if (mapped_file.IsOpen())
+        return mapped_file.GetPosition();
+    return input_file.tellg();
+}
+
+/** Read the spill index of the main input file. If the file doesn't have one, e.g. it was written by an older
+  * version of poll2, the index is built with a single pass through the file and written next to it.
+  * \return True if the index was read or built and false otherwise.
+  */
+bool ScanInterface::load_spill_index() {
+    const string index_fname = SpillIndex::GetIndexFilename(input_fname);
+    if (spill_index.Read(index_fname)) {
+        cout << msgHeader << "Read " << spill_index.GetNumberOfSpills() << " spills from the index '" << index_fname
+             << "'.\n";
+        return true;
+    }
+
+    cout << msgHeader << "Building the spill index of '" << input_fname << "'.\n";
+    if (!spill_index.Build(input_fname)) {
+        cout << " ERROR! Failed to build the spill index of '" << input_fname << "'!\n";
+        return false;
+    }
+
+    if (!spill_index.Write(index_fname))
+        cout << " WARNING! Failed to write the spill index to '" << index_fname << "'.\n";
+    return true;
+}
+
+/** Move input_file to the first spill that is in both the requested time range and the requested spill range. The
+  * offset of a .ldf spill is that of its first chunk, so we move to the start of the buffer that holds it and let the
+  * buffer reader skip ahead to it.
+  * \return Nothing.
+  */
+void ScanInterface::seek_spill_range() {
+    range_pending = false;
+    range_active = true;
+    spills_to_scan = 0;
+
+    size_t first = max(first_spill, spill_index.FindFirstSpill(start_time));
+    size_t end = spill_index.FindEndSpill(stop_time);
+    if (last_spill < end)
+        end = last_spill + 1;
+
+    if (first >= end) {
+        cout << msgHeader << "No spills in the input file are in the requested range.\n";
+        return;
+    }
+
+    // Run times are measured from the start of the run rather than from the start of the range, unless the user asked
+    // for something else or we've already scanned part of the run.
+    if (!unpacker_->HasFirstTime())
+        unpacker_->SetFirstTime(spill_index.GetSpill(0).firstTime);
+
+    const SpillIndexEntry &entry = spill_index.GetSpill(first);
+    spills_to_scan = end - first;
+    cout << msgHeader << "Scanning spills " << first << " to " << end - 1 << " (" << entry.firstTime << " to "
+         << spill_index.GetSpill(end - 1).lastTime << " clock ticks).\n";
+
+    input_file.clear();
+    if (file_format == 0) {
+        const unsigned long long buffer_start = entry.offset - entry.offset % (4 * ACTUAL_BUFF_SIZE);
+        input_file.seekg(buffer_start, input_file.beg);
+        databuff.SetStartWord((unsigned int) ((entry.offset - buffer_start) / 4));
+    } else { input_file.seekg(entry.offset, input_file.beg); }
+}
+
+/** Move input_file to the read position of the mapped file. The stream is still used
+  * for rewinding, the EOF buffer check and the state checks in start_scan.
+  * \return Nothing.
+  */
+void ScanInterface::sync_input_file() {
+    if (!mapped_file.IsOpen())
+        return;
+    input_file.clear();
+    input_file.seekg(mapped_file.GetPosition(), input_file.beg);
+    if (mapped_file.Eof())
+        input_file.peek(); // Sets the eof flag just as reading to the end of the stream would.
+}
+
 /** Add a command line option to the option list.
   * \param[in]  opt_ The option to add to the list.
   * \return Nothing.
@@ -367,15 +499,24 @@ ScanInterface::ScanInterface() {
     // Get the home directory.
     homeDir = getenv("HOME");
 
-    maxShmSizeL = 4052;
-    maxShmSize = maxShmSizeL * 4;
-
     max_spill_size = 0;
     file_format = -1;
 
     file_start_offset = 0;
     num_spills_recvd = 0;
 
+    start_time = 0;
+    stop_time = numeric_limits<unsigned long long>::max();
+    first_spill = 0;
+    last_spill = numeric_limits<size_t>::max();
+    spills_to_scan = 0;
+    first_time = 0;
+    use_first_time = false;
+    range_mode = false;
+    range_pending = false;
+    range_active = false;
+    export_traces = false;
+
     total_stopped = true;
     write_counts = false;
     is_running = false;
@@ -383,6 +524,13 @@ ScanInterface::ScanInterface() {
     debug_mode = false;
     dry_run_mode = false;
     shm_mode = false;
+    shm_policy = SPILL_RING_BEST_EFFORT;
+    shm_sampling = 1;
+    spool_dir = "/tmp";
+    mmap_mode = false;
+    pipeline_depth = 0;
+    decode_threads = 0;
+    stream_mode = false;
     batch_mode = false;
     scan_init = false;
     file_open = false;
@@ -395,7 +543,6 @@ ScanInterface::ScanInterface() {
     kill_all = false;
     run_ctrl_exit = false;
 
-    poll_server = NULL;
     term = NULL;
 
     //Setup all the arguments that are known to the program.
@@ -404,19 +551,42 @@ ScanInterface::ScanInterface() {
             optionExt("config", required_argument, NULL, 'c', "<path>", "Specify path to setup to use for scan"),
             optionExt("counts", no_argument, NULL, 0, "", "Write all recorded channel counts to a file"),
             optionExt("debug", no_argument, NULL, 0, "", "Enable readout debug mode"),
+            optionExt("decode-threads", required_argument, NULL, 0, "<threads>",
+                      "Decode the module buffers in each spill on <threads> threads"),
             optionExt("dry-run", no_argument, NULL, 0, "", "Extract spills from file, but do no processing"),
+            optionExt("export-columns", required_argument, NULL, 0, "<filename>",
+                      "Write the decoded hits to a column file (.xcol) that can be scanned without decoding them again"),
+            optionExt("export-traces", no_argument, NULL, 0, "", "Write the traces to the column file as well"),
             optionExt("fast-fwd", required_argument, NULL, 0, "<word>",
                       "Skip ahead to a specified word in the file (start of file at zero)"),
+            optionExt("first-time", required_argument, NULL, 0, "<ticks>",
+                      "Measure run times from <ticks> instead of from the first event that is scanned"),
             optionExt("firmware", required_argument, NULL, 'f', "<firmware>", "Sets the firmware revision for decoding the data. "
                               "See the wiki or HelperEnumerations.hpp for more information."),
             optionExt("frequency", required_argument, NULL, 0, "<frequency in MHz or MS/s>",
                       "Specifies the sampling frequency used to collect the data."),
             optionExt("help", no_argument, NULL, 'h', "", "Display this dialogue"),
             optionExt("input", required_argument, NULL, 'i', "<filename>", "Specifies the input file to analyze"),
+            optionExt("mmap", no_argument, NULL, 0, "", "Memory map the input file instead of reading it as a stream"),
+            optionExt("pipeline", required_argument, NULL, 0, "<depth>",
+                      "Decode, build and process up to <depth> spills at once on separate threads"),
             optionExt("output", required_argument, NULL, 'o', "<filename>",
                       "Specifies the name of the output file. Default is \"out\""),
             optionExt("quiet", no_argument, NULL, 'q', "", "Toggle off verbosity flag"),
             optionExt("shm", no_argument, NULL, 's', "", "Enable shared memory readout"),
+            optionExt("shm-policy", required_argument, NULL, 0, "<policy>",
+                      "What to do with the spills that shared memory readout can't keep up with: best-effort "
+                      "(default), lossless, spool[:<directory>], latest or sample:<N>"),
+            optionExt("spill-range", required_argument, NULL, 0, "<first>:<last>",
+                      "Scan only spills <first> through <last> of the input file (first spill at zero)"),
+            optionExt("start-time", required_argument, NULL, 0, "<ticks>",
+                      "Start scanning the input file at the first spill with hits at or after <ticks>"),
+            optionExt("stop-time", required_argument, NULL, 0, "<ticks>",
+                      "Stop scanning the input file after the last spill with hits at or before <ticks>"),
+            optionExt("stream-events", no_argument, NULL, 0, "",
+                      "Build events across spill boundaries instead of within each spill"),
+            optionExt("timers", required_argument, NULL, 0, "<filename>",
+                      "Write the time spent in each stage of the scan to a JSON file at exit"),
             optionExt("version", no_argument, NULL, 'v', "", "Display version information")
     };
 
@@ -431,6 +601,9 @@ ScanInterface::ScanInterface() {
     knownArgumentMap_.insert(make_pair("rewind", "Usage : rewind [offset] | Rewind to the beginning of the file or to the "
             "requested number of words"));
     knownArgumentMap_.insert(make_pair("sync", "Wait for the current run to finish"));
+    knownArgumentMap_.insert(make_pair("index", "Print a summary of the spill index of the input file"));
+    knownArgumentMap_.insert(make_pair("timers", "Usage : timers [reset | <fileName>] | Print the time spent in each "
+            "stage of the scan, reset the timers, or write them to a JSON file"));
 
     optstr = "bc:f:hi:o:qsv";
 
@@ -469,16 +642,11 @@ void ScanInterface::RunControl() {
             continue;
         } else if (shm_mode) {
             cout << endl;
-            unsigned int data[250000]; // Array for storing spill data. Larger than any RevF spill should be.
-            unsigned int *shm_data = new unsigned int[maxShmSizeL]; // Array to store the temporary shm data (~16 kB)
-            int dummy;
-            int previous_chunk;
-            int current_chunk;
-            int total_chunks;
-            int nWords;
-            unsigned int nTotalWords;
-
-            bool full_spill = false;
+            SpillRingRecord record;
+            const bool is_spooled = (shm_policy == SPILL_RING_SPOOL);
+            // Unless poll2 waits for us, it may write over a spill while we're reading it.
+            const bool is_lossless = is_spooled || shm_policy == SPILL_RING_LOSSLESS;
+            vector<unsigned int> spill_copy;
 
             while (true) {
                 if (kill_all == true) {
@@ -489,14 +657,24 @@ void ScanInterface::RunControl() {
                     continue;
                 }
 
-                int select_dummy;
-                previous_chunk = 0;
-                current_chunk = 0;
-                total_chunks = -1;
-                nTotalWords = 0;
-                full_spill = true;
+                // poll2 may not have created the ring yet, or may have been restarted since we mapped it.
+                if (is_spooled ? !spill_spool.IsOpen() || spill_spool.IsStale() :
+                    !spill_ring.IsOpen() || spill_ring.IsStale()) {
+                    if (is_spooled ? !spill_spool.Open(spool_dir, progName) :
+                        !spill_ring.Open(SPILL_RING_DEFAULT_NAME, shm_policy, shm_sampling, progName)) {
+                        if (!batch_mode) {
+                            term->SetStatus("\033[0;33m[IDLE]\033[0m Waiting for poll2...");
+                        } else {
+                            cout << "\r\033[0;33m[IDLE]\033[0m Waiting for poll2...";
+                        }
+                        IdleTask();
+                        usleep(100000); //0.1 seconds
+                        continue;
+                    }
+                    if (debug_mode) { cout << "debug: Mapped the poll2 spill ring\n"; }
+                }
 
-                if (!poll_server->Select(dummy)) {
+                if (is_spooled ? !spill_spool.Next(record, 1000) : !spill_ring.Next(record, 1000)) {
                     if (!batch_mode) {
                         term->SetStatus("\033[0;33m[IDLE]\033[0m Waiting for a spill...");
                     } else {
@@ -506,82 +684,48 @@ void ScanInterface::RunControl() {
                     continue;
                 }
 
-                if (!poll_server->Select(
-                        select_dummy)) { continue; } // Server timeout
-
-                // Get the spill
-                while (current_chunk != total_chunks) {
-                    if (!poll_server->Select(select_dummy)) { // Server timeout
-                        cout << msgHeader << "Network timeout before recv full spill!\n";
-                        full_spill = false;
-                        break;
-                    }
-
-                    nWords = poll_server->RecvMessage((char *) shm_data, maxShmSize) / 4; // Read from the socket
-                    if (strcmp((char *) shm_data, "$CLOSE_FILE") == 0 || strcmp((char *) shm_data, "$OPEN_FILE") == 0 ||
-                        strcmp((char *) shm_data, "$KILL_SOCKET") == 0) { continue; } // Poll2 network flags
-                        // Did not read enough bytes
-                    else if (nWords < 2) {
-                        continue;
-                    }
-
-                    if (debug_mode) {
-                        cout << "debug: Received " << nWords << " words from the network\n";
-                    }
-                    memcpy((char *) &current_chunk, &shm_data[0], 4);
-                    memcpy((char *) &total_chunks, &shm_data[1], 4);
-
-                    if (previous_chunk == -1 && current_chunk != 1) {
-                        // Started reading in the middle of a spill, ignore the rest of it
-                        if (debug_mode) {
-                            cout << "debug: Skipping chunk " << current_chunk << " of " << total_chunks << endl;
-                        }
-                        continue;
-                    } else if (previous_chunk != current_chunk - 1) { // We missed a spill chunk somewhere
-                        if (debug_mode) {
-                            cout << "debug: Found chunk " << current_chunk << " but expected chunk "
-                                 << previous_chunk + 1 << endl;
-                        }
-                        break;
-                    }
-
-                    previous_chunk = current_chunk;
-
-                    // Copy the shm spill chunk into the data array
-                    if (nTotalWords + 2 + nWords <= 250000) { // This spill chunk will fit into the data buffer
-                        memcpy(&data[nTotalWords], &shm_data[2], (nWords - 2) * 4);
-                        nTotalWords += (nWords - 2);
-                    } else {
-                        if (debug_mode) {
-                            cout << "debug: Abnormally full spill buffer with " << nTotalWords + 2 + nWords << " words!\n";
-                        }
-                        break;
-                    }
+                if (record.type == SPILL_RING_CLOSE) { // poll2 is exiting, its next ring will be a new one.
+                    if (is_spooled) { spill_spool.Close(); }
+                    else { spill_ring.Close(); }
+                    continue;
+                } else if (record.type != SPILL_RING_SPILL) { // Poll2 file flags
+                    continue;
                 }
 
                 stringstream status;
-                status << "\033[0;32m" << "[RECV] " << "\033[0m" << nTotalWords
-                       << " words";
+                status << "\033[0;32m" << "[RECV] " << "\033[0m" << record.nWords << " words";
                 if (!batch_mode) { term->SetStatus(status.str()); }
                 else { cout << "\r" << status.str(); }
 
                 if (debug_mode) {
-                    cout << "debug: Retrieved spill of " << nTotalWords << " words (" << nTotalWords * 4 << " bytes)\n";
+                    cout << "debug: Retrieved spill of " << record.nWords << " words (" << record.nWords * 4
+                         << " bytes)\n";
                 }
-                if (!dry_run_mode && full_spill) {
-                    int word1 = 2, word2 = 9999;
-                    memcpy(&data[nTotalWords], (char *) &word1, 4);
-                    memcpy(&data[nTotalWords + 1], (char *) &word2, 4);
-                    unpacker_->ReadSpill(data, nTotalWords + 2, is_verbose);
-                    IdleTask();
+
+                // The spill already ends with the end of spill flag. When poll2 waits for us it's read straight out
+                // of the ring, since the unpacker is done with it when ReadSpill returns. Otherwise it's copied out
+                // first, and the copy is only used if poll2 didn't lap us while we were making it. The spool file
+                // only has the spills that made it there in one piece.
+                unsigned int *spill_data = const_cast<unsigned int *>(record.data);
+                if (!is_lossless) {
+                    spill_copy.assign(record.data, record.data + record.nWords);
+                    if (!spill_ring.IsValid(record)) {
+                        cout << msgHeader << "Spill was overwritten by poll2 before it could be copied!\n";
+                        spill_ring.AddLostRecord();
+                        IdleTask();
+                        continue;
+                    }
+                    spill_data = spill_copy.data();
                 }
 
-                if (!full_spill) {
-                    cout << msgHeader << "Not processing spill fragment!\n";
-                } else { num_spills_recvd++; }
+                if (!dry_run_mode)
+                    unpacker_->ReadSpill(spill_data, record.nWords, is_verbose);
+                num_spills_recvd++;
+                IdleTask();
             }
 
-            delete[] shm_data;
+            spill_spool.Close();
+            spill_ring.Close();
         } else if (file_format == 0) {
             unsigned int *data = NULL;
             bool full_spill;
@@ -593,6 +737,13 @@ void ScanInterface::RunControl() {
             // Reset the buffer reader to default values.
             databuff.Reset();
 
+            if (range_pending)
+                seek_spill_range();
+
+            // Pick up where input_file was left, e.g. after a rewind.
+            if (mapped_file.IsOpen())
+                mapped_file.Seek(input_file.tellg());
+
             while (true) {
                 if (kill_all == true) {
                     break;
@@ -600,9 +751,19 @@ void ScanInterface::RunControl() {
                     IdleTask();
                     usleep(100000); //0.1 seconds
                     continue;
+                } else if (range_active && spills_to_scan == 0) {
+                    break;
                 }
 
-                if (!databuff.Read(&input_file, (char *) data, nBytes, 1000000, full_spill, bad_spill, dry_run_mode)) {
+                bool read_status;
+                if (mapped_file.IsOpen())
+                    read_status = databuff.Read(&mapped_file, (char *) data, nBytes, 1000000, full_spill, bad_spill,
+                                                dry_run_mode);
+                else
+                    read_status = databuff.Read(&input_file, (char *) data, nBytes, 1000000, full_spill, bad_spill,
+                                                dry_run_mode);
+
+                if (!read_status) {
                     if (databuff.GetRetval() == 1) {
                         if (debug_mode) {
                             cout << "debug: Encountered single EOF buffer (end of run).\n";
@@ -635,7 +796,7 @@ void ScanInterface::RunControl() {
 
                 stringstream status;
                 status << "\033[0;32m" << "[READ] " << "\033[0m" << nBytes / 4 << " words ("
-                       << 100 * input_file.tellg() / file_length << "%), ";
+                       << 100 * get_file_position() / file_length << "%), ";
                 status << "GOOD = " << databuff.GetNumChunks() << ", LOST = " << databuff.GetNumMissing();
                 if (!batch_mode) { term->SetStatus(status.str()); }
                 else { cout << "\r" << status.str(); }
@@ -643,26 +804,32 @@ void ScanInterface::RunControl() {
                 if (full_spill) {
                     if (debug_mode) {
                         cout << "debug: Retrieved spill of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
-                        cout << "debug: Read up to word number " << input_file.tellg() / 4 << " in input file\n";
+                        cout << "debug: Read up to word number " << get_file_position() / 4 << " in input file\n";
                     }
+                    // Only the spills that could be unpacked are in the index.
+                    if (range_active && !bad_spill)
+                        spills_to_scan--;
                     if (!dry_run_mode) {
                         if (!bad_spill) {
                             unpacker_->ReadSpill(data, nBytes / 4, is_verbose);
                             IdleTask();
                         } else {
-                            cout << " WARNING: Spill has been flagged as corrupt, skipping (at word " << input_file.tellg() / 4
+                            cout << " WARNING: Spill has been flagged as corrupt, skipping (at word " << get_file_position() / 4
                                  << " in file)!\n";
                         }
                     }
                 } else if (debug_mode) {
                     cout << "debug: Retrieved spill fragment of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
-                    cout << "debug: Read up to word number " << input_file.tellg() / 4 << " in input file\n";
+                    cout << "debug: Read up to word number " << get_file_position() / 4 << " in input file\n";
                 }
                 num_spills_recvd++;
             }
 
             if (!dry_run_mode) { delete[] data; }
 
+            sync_input_file();
+            range_active = false;
+
             if (!batch_mode) {
                 term->SetStatus("\033[0;33m[IDLE]\033[0m Finished scanning file.");
             } else { cout << endl << endl; }
@@ -675,7 +842,19 @@ void ScanInterface::RunControl() {
             // Reset the buffer reader to default values.
             pldData.Reset();
 
-            while (pldData.Read(&input_file, (char *) data, nBytes, 4 * max_spill_size, dry_run_mode)) {
+            if (range_pending)
+                seek_spill_range();
+
+            // Pick up where input_file was left, e.g. after a rewind.
+            if (mapped_file.IsOpen())
+                mapped_file.Seek(input_file.tellg());
+
+            // In mmap mode the spill points straight into the mapped file rather than at data.
+            unsigned int *spill = data;
+
+            while (!(range_active && spills_to_scan == 0) &&
+                   (mapped_file.IsOpen() ? pldData.Read(&mapped_file, spill, nBytes, 4 * max_spill_size) :
+                    pldData.Read(&input_file, (char *) data, nBytes, 4 * max_spill_size, dry_run_mode))) {
                 if (kill_all == true) {
                     break;
                 } else if (!is_running) {
@@ -686,30 +865,50 @@ void ScanInterface::RunControl() {
 
                 stringstream status;
                 status << "\033[0;32m" << "[READ] " << "\033[0m" << nBytes / 4 << " words ("
-                       << 100 * input_file.tellg() / file_length << "%)";
+                       << 100 * get_file_position() / file_length << "%)";
                 if (!batch_mode) { term->SetStatus(status.str()); }
                 else { cout << "\r" << status.str(); }
 
                 if (debug_mode) {
                     cout << "debug: Retrieved spill of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
-                    cout << "debug: Read up to word number " << input_file.tellg() / 4 << " in input file\n";
+                    cout << "debug: Read up to word number " << get_file_position() / 4 << " in input file\n";
                 }
 
                 if (!dry_run_mode) {
-                    int word1 = 2, word2 = 9999;
-                    memcpy(&data[(nBytes / 4)], (char *) &word1, 4);
-                    memcpy(&data[(nBytes / 4) + 1], (char *) &word2, 4);
-                    unpacker_->ReadSpill(data, nBytes / 4 + 2, is_verbose);
+                    unsigned int nWords = nBytes / 4;
+
+                    // A mapped spill is followed by its end of buffer word and the first word of the next buffer.
+                    // Those two words are overwritten by the end of spill flag and restored after the spill is
+                    // unpacked. The mapping is private, so only the page holding them is copied. A spill at the very
+                    // end of a truncated file has nothing after it, so we fall back to copying it.
+                    if (spill != data && mapped_file.GetBytesRemaining() < 4) {
+                        memcpy(data, spill, nBytes);
+                        spill = data;
+                    }
+
+                    unsigned int saved_words[2] = {spill[nWords], spill[nWords + 1]};
+                    spill[nWords] = 2;
+                    spill[nWords + 1] = 9999;
+                    unpacker_->ReadSpill(spill, nWords + 2, is_verbose);
+                    spill[nWords] = saved_words[0];
+                    spill[nWords + 1] = saved_words[1];
                     IdleTask();
                 }
                 num_spills_recvd++;
+                if (range_active)
+                    spills_to_scan--;
             }
 
-            if (eofbuff.ReadHeader(&input_file)) {
+            sync_input_file();
+
+            if (range_active && spills_to_scan == 0) {
+                cout << msgHeader << "Finished scanning the requested range of spills.\n";
+            } else if (eofbuff.ReadHeader(&input_file)) {
                 cout << msgHeader << "Encountered EOF buffer.\n";
             } else {
                 cout << msgHeader << "Failed to find end of file buffer!\n";
             }
+            range_active = false;
 
             if (!dry_run_mode) { delete[] data; }
 
@@ -717,8 +916,63 @@ void ScanInterface::RunControl() {
                 term->SetStatus("\033[0;33m[IDLE]\033[0m Finished scanning file.");
             } else { cout << endl << endl; }
         } else if (file_format == 2) {
+            // Pick up where input_file was left, e.g. after a rewind, but never inside the file header.
+            mapped_file.Seek(max((size_t) input_file.tellg(), XiaDataColumns::FILE_HEADER_SIZE));
+
+            // The chunks are parsed in place and handed to the unpacker without copying them.
+            XiaDataColumnChunk chunk;
+            bool bad_chunk = false;
+            while (!mapped_file.Eof()) {
+                if (kill_all == true) {
+                    break;
+                } else if (!is_running) {
+                    IdleTask();
+                    usleep(100000); //0.1 seconds
+                    continue;
+                }
+
+                const size_t position = mapped_file.GetPosition();
+                const size_t length = chunk.Parse(mapped_file.Peek(), mapped_file.GetBytesRemaining());
+                if (length == 0) {
+                    cout << msgHeader << "Encountered a bad chunk at byte " << position << " of the column file!\n";
+                    bad_chunk = true;
+                    break;
+                }
+                mapped_file.Read(length);
+
+                stringstream status;
+                status << "\033[0;32m" << "[READ] " << "\033[0m" << chunk.GetNumberOfHits() << " hits ("
+                       << 100 * get_file_position() / file_length << "%)";
+                if (!batch_mode) { term->SetStatus(status.str()); }
+                else { cout << "\r" << status.str(); }
+
+                if (debug_mode)
+                    cout << "debug: Retrieved chunk of " << length << " bytes (" << chunk.GetNumberOfHits()
+                         << " hits)\n";
+
+                if (!dry_run_mode) {
+                    unpacker_->ReadColumns(chunk, is_verbose);
+                    IdleTask();
+                }
+                num_spills_recvd++;
+            }
+
+            sync_input_file();
+
+            if (!bad_chunk && mapped_file.Eof())
+                cout << msgHeader << "Reached the end of the column file.\n";
+
+            if (!batch_mode) {
+                term->SetStatus("\033[0;33m[IDLE]\033[0m Finished scanning file.");
+            } else { cout << endl << endl; }
         }
 
+        // Build the events that were held back at the end of the last spill, and let the unpacker finish the spills
+        // that are still in the pipeline and the events that it is still holding.
+        unpacker_->FlushEvents();
+        unpacker_->WaitForPipeline();
+        unpacker_->FinishEvents();
+
         // Notify that the scan has completed.
         Notify("SCAN_COMPLETE");
 
@@ -835,6 +1089,26 @@ void ScanInterface::CmdControl() {
             if (p_args > 0) {
                 rewind(strtoul(arguments.at(0).c_str(), NULL, 0));
             } else { rewind(); }
+        } else if (cmd == "index") { // Print the spill index of the input file.
+            if (!file_open) {
+                cout << msgHeader << "No input file loaded.\n";
+            } else if (spill_index.GetNumberOfSpills() != 0 || load_spill_index()) {
+                spill_index.Print();
+            }
+        } else if (cmd == "timers") { // Print, reset or write out the stage timers.
+            if (p_args == 0) {
+                StageTimers::get()->Print(cout);
+            } else if (arguments.at(0) == "reset") {
+                StageTimers::get()->Reset();
+                cout << msgHeader << "Reset the stage timers.\n";
+            } else {
+                try {
+                    StageTimers::get()->Write(arguments.at(0));
+                    cout << msgHeader << "Wrote the stage timers to '" << arguments.at(0) << "'.\n";
+                } catch (invalid_argument &ex) {
+                    cout << msgHeader << ex.what() << "\n";
+                }
+            }
         } else if (cmd == "sync") { // Wait until the current run is completed.
             if (is_running) {
                 cout << msgHeader
@@ -911,8 +1185,62 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
                 debug_mode = true;
             } else if (strcmp("dry-run", longOpts[idx].name) == 0) {
                 dry_run_mode = true;
+            } else if (strcmp("export-columns", longOpts[idx].name) == 0) {
+                export_fname = optarg;
+            } else if (strcmp("export-traces", longOpts[idx].name) == 0) {
+                export_traces = true;
             } else if (strcmp("fast-fwd", longOpts[idx].name) == 0) {
                 file_start_offset = atoll(optarg);
+            } else if (strcmp("mmap", longOpts[idx].name) == 0) {
+                mmap_mode = true;
+            } else if (strcmp("pipeline", longOpts[idx].name) == 0) {
+                pipeline_depth = (unsigned int) atoi(optarg);
+            } else if (strcmp("decode-threads", longOpts[idx].name) == 0) {
+                decode_threads = (unsigned int) atoi(optarg);
+            } else if (strcmp("stream-events", longOpts[idx].name) == 0) {
+                stream_mode = true;
+            } else if (strcmp("timers", longOpts[idx].name) == 0) {
+                timers_fname = optarg;
+            } else if (strcmp("shm-policy", longOpts[idx].name) == 0) {
+                const string policy = optarg;
+                if (policy == "best-effort")
+                    shm_policy = SPILL_RING_BEST_EFFORT;
+                else if (policy == "lossless")
+                    shm_policy = SPILL_RING_LOSSLESS;
+                else if (policy == "latest")
+                    shm_policy = SPILL_RING_LATEST;
+                else if (policy == "spool" || policy.compare(0, 6, "spool:") == 0) {
+                    shm_policy = SPILL_RING_SPOOL;
+                    if (policy.size() > 6)
+                        spool_dir = policy.substr(6);
+                } else if (policy.compare(0, 7, "sample:") == 0) {
+                    shm_policy = SPILL_RING_SAMPLED;
+                    shm_sampling = (unsigned int) strtoul(policy.substr(7).c_str(), NULL, 0);
+                    if (shm_sampling == 0)
+                        throw invalid_argument("ScanInterface::Setup - The sampling needs to be given as sample:<N>, "
+                                                       "with N larger than zero.");
+                } else
+                    throw invalid_argument("ScanInterface::Setup - Unknown shared memory policy '" + policy +
+                                           "', use best-effort, lossless, spool[:<directory>], latest or "
+                                           "sample:<N>.");
+            } else if (strcmp("first-time", longOpts[idx].name) == 0) {
+                first_time = strtoull(optarg, NULL, 0);
+                use_first_time = true;
+            } else if (strcmp("start-time", longOpts[idx].name) == 0) {
+                start_time = strtoull(optarg, NULL, 0);
+                range_mode = true;
+            } else if (strcmp("stop-time", longOpts[idx].name) == 0) {
+                stop_time = strtoull(optarg, NULL, 0);
+                range_mode = true;
+            } else if (strcmp("spill-range", longOpts[idx].name) == 0) {
+                const string range = optarg;
+                const size_t colon = range.find(':');
+                if (colon == string::npos)
+                    throw invalid_argument("ScanInterface::Setup - The spill range needs to be given as <first>:<last>.");
+                first_spill = strtoul(range.substr(0, colon).c_str(), NULL, 0);
+                if (colon + 1 < range.size())
+                    last_spill = strtoul(range.substr(colon + 1).c_str(), NULL, 0);
+                range_mode = true;
             } else if (strcmp("frequency", longOpts[idx].name) == 0)
                 samplingFrequency = (unsigned int) stoi(optarg);
             else if (strcmp("firmware", longOpts[idx].name) == 0)
@@ -997,6 +1325,9 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     if (debug_mode)
         unpacker_->SetDebugMode();
 
+    if (use_first_time)
+        unpacker_->SetFirstTime(first_time);
+
     // Parse for any extra arguments that are known to the derived class.
     ExtraArguments();
 
@@ -1010,11 +1341,6 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
 
 #ifndef USE_HRIBF
     if (shm_mode) {
-        poll_server = new Server();
-        if (!poll_server->Init(5555, 1)) {
-            cout << " FATAL ERROR! Failed to open shm socket 5555!\n" << "\nCleaning up...\n";
-            return false;
-        }
         if (batch_mode) {
             cout << msgHeader << "Unable to enable batch mode for shared-memory mode!\n";
             batch_mode = false;
@@ -1036,9 +1362,45 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
 
     if (debug_mode) { cout << msgHeader << "Using debug mode.\n\n"; }
     if (dry_run_mode) { cout << msgHeader << "Doing a dry run.\n\n"; }
+    if (mmap_mode) { cout << msgHeader << "Using memory mapped input.\n\n"; }
+    if (decode_threads > 1) {
+        unpacker_->SetDecodeThreads(decode_threads);
+        cout << msgHeader << "Decoding module buffers on " << decode_threads << " threads.\n\n";
+    }
+    if (stream_mode) {
+        unpacker_->SetStreamingEvents(true);
+        cout << msgHeader << "Building events across spill boundaries.\n\n";
+    }
+    if (range_mode) {
+        if (shm_mode) {
+            cout << msgHeader << "Spill and time ranges can only be used with input files!\n\n";
+            range_mode = false;
+        } else if (start_time > stop_time || first_spill > last_spill) {
+            cout << " FATAL ERROR! The start of the requested range is after its end!\n" << "\nCleaning up...\n";
+            return false;
+        } else { cout << msgHeader << "Scanning only the requested range of the input file.\n\n"; }
+    }
+    if (!export_fname.empty()) {
+        if (!column_writer.Open(export_fname, export_traces)) {
+            cout << " FATAL ERROR! Failed to open column file '" << export_fname << "'!\n" << "\nCleaning up...\n";
+            return false;
+        }
+        unpacker_->SetColumnWriter(&column_writer);
+        cout << msgHeader << "Exporting the decoded hits" << (export_traces ? " and traces" : "") << " to '"
+             << export_fname << "'.\n\n";
+    }
+    if (pipeline_depth > 0) {
+        unpacker_->StartPipeline(pipeline_depth);
+        cout << msgHeader << "Using a spill pipeline with a depth of " << pipeline_depth << ".\n\n";
+    }
     if (shm_mode) {
         cout << msgHeader << "Using shared-memory mode.\n\n";
-        cout << msgHeader << "Listening on poll2 SHM port 5555\n\n";
+        cout << msgHeader << "Reading spills from the poll2 ring " << SPILL_RING_DEFAULT_NAME << " with the "
+             << GetShmPolicyName() << " policy.\n\n";
+        if (shm_policy == SPILL_RING_SPOOL && access(spool_dir.c_str(), W_OK) != 0) {
+            cout << " FATAL ERROR! Unable to write the spool file to '" << spool_dir << "'!\n\nCleaning up...\n";
+            return false;
+        }
     }
 
     // Load the input file, if the user has supplied a filename.
@@ -1097,6 +1459,24 @@ int ScanInterface::Execute() {
     return 0;
 }
 
+/** Get the name of the shared memory policy, the way that it is given to --shm-policy.
+  * \return The name of the policy.
+  */
+string ScanInterface::GetShmPolicyName() {
+    switch (shm_policy) {
+        case SPILL_RING_LOSSLESS :
+            return "lossless";
+        case SPILL_RING_SPOOL :
+            return "spool:" + spool_dir;
+        case SPILL_RING_LATEST :
+            return "latest";
+        case SPILL_RING_SAMPLED :
+            return "sample:" + to_string(shm_sampling);
+        default :
+            return "best-effort";
+    }
+}
+
 /** Shutdown cleanly. Uninitialize the ScanInterface object.
   * \return True upon success and false if ScanInterface has not been initialized.
   */
@@ -1109,9 +1489,15 @@ bool ScanInterface::Close() {
         term->Close();
     }
 
-    // Only close the server if this is shared memory mode. Otherwise
-    // the server would never have been initialized.
-    if (shm_mode) { poll_server->Close(); }
+    if (shm_mode) {
+        cout << msgHeader << "Lost " << (shm_policy == SPILL_RING_SPOOL ? spill_spool.GetNumberOfLostRecords() :
+                                         spill_ring.GetNumberOfLostRecords()) << " spills that poll2 wrote over.\n";
+        if (shm_policy == SPILL_RING_LATEST || shm_policy == SPILL_RING_SAMPLED)
+            cout << msgHeader << "Skipped " << spill_ring.GetNumberOfSkippedRecords() << " spills because of the "
+                 << GetShmPolicyName() << " policy.\n";
+        spill_spool.Close();
+        spill_ring.Close();
+    }
 
     //Reprint the leader as the carriage was returned
     cout << "Running " << progName << " v" << SCAN_VERSION << " (" << SCAN_DATE << ")\n";
@@ -1127,10 +1513,30 @@ bool ScanInterface::Close() {
     cout << msgHeader << "Read " << databuff.GetNumChunks() << " spill chunks.\n";
     cout << msgHeader << "Lost at least " << databuff.GetNumMissing() << " spill chunks.\n";
 
+    // Finish any spills that are still in the pipeline before we write anything out.
+    unpacker_->StopPipeline();
+    mapped_file.Close(); // The spills from a column file refer to the mapping until they've been processed.
+    cout << msgHeader << "Skipped " << unpacker_->GetNumberOfSkippedBuffers() << " corrupted module buffers.\n";
+
+    if (column_writer.IsOpen()) {
+        unpacker_->SetColumnWriter(NULL);
+        cout << msgHeader << "Exported " << column_writer.GetNumberOfHits() << " hits in "
+             << column_writer.GetNumberOfChunks() << " spills to '" << export_fname << "'.\n";
+        column_writer.Close();
+    }
+
     if (write_counts)
         unpacker_->Write();
 
-    if (poll_server) { delete poll_server; }
+    if (!timers_fname.empty()) {
+        try {
+            StageTimers::get()->Write(timers_fname);
+            cout << msgHeader << "Wrote the stage timers to '" << timers_fname << "'.\n";
+        } catch (invalid_argument &ex) {
+            cout << msgHeader << ex.what() << "\n";
+        }
+    }
+
     if (term) { delete term; }
 #endif
     scan_init = false;
@@ -0,0 +1,208 @@
+///@file SpillRingSpool.cpp
+///@brief Reads every spill in the poll2 spill ring without holding up poll2, by copying each one to a file on disk as
+/// soon as it is written and handing them out from there.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <stdexcept>
+
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "SpillRingSpool.hpp"
+
+using namespace std;
+
+///Every record in the spool file starts with this, the words of the record follow it.
+struct SpoolRecordHeader {
+    uint64_t sequence; ///< The sequence number of the record in the ring
+    uint32_t type; ///< One of the SpillRingRecordType
+    uint32_t nWords; ///< The number of words in the record
+};
+
+///The spool file is truncated once the scan catches up, if it has grown larger than this.
+static const uint64_t MAXIMUM_IDLE_SPOOL_SIZE = SPILL_RING_DEFAULT_SIZE;
+
+///@return True if all of the bytes were written.
+static bool WriteAll(const int &fd, const char *data, size_t bytes, uint64_t offset) {
+    while (bytes > 0) {
+        const ssize_t written = pwrite(fd, data, bytes, (off_t) offset);
+        if (written <= 0)
+            return false;
+        data += written;
+        bytes -= (size_t) written;
+        offset += (uint64_t) written;
+    }
+    return true;
+}
+
+///@return True if all of the bytes were read.
+static bool ReadAll(const int &fd, char *data, size_t bytes, uint64_t offset) {
+    while (bytes > 0) {
+        const ssize_t numberRead = pread(fd, data, bytes, (off_t) offset);
+        if (numberRead <= 0)
+            return false;
+        data += numberRead;
+        bytes -= (size_t) numberRead;
+        offset += (uint64_t) numberRead;
+    }
+    return true;
+}
+
+SpillRingSpool::SpillRingSpool() : fd_(-1), readOffset_(0), writeOffset_(0), fileSize_(0), isWriting_(false),
+                                   stopping_(false), lostRecords_(0) {
+}
+
+SpillRingSpool::~SpillRingSpool() {
+    Close();
+}
+
+bool SpillRingSpool::Open(const std::string &directory, const std::string &consumer,
+                          const std::string &name/*=SPILL_RING_DEFAULT_NAME*/) {
+    Close();
+
+    string fileName = directory + "/paass-spool-XXXXXX";
+    vector<char> pattern(fileName.begin(), fileName.end());
+    pattern.push_back('\0');
+    fd_ = mkstemp(&pattern[0]);
+    if (fd_ < 0)
+        throw runtime_error("SpillRingSpool::Open - Unable to create a spool file in " + directory);
+    unlink(&pattern[0]);
+
+    if (!reader_.Open(name, SPILL_RING_SPOOL, 1, consumer)) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    readOffset_ = writeOffset_ = fileSize_ = 0;
+    isWriting_ = stopping_ = false;
+    lostRecords_ = 0;
+    thread_ = thread(&SpillRingSpool::Spool, this);
+    return true;
+}
+
+void SpillRingSpool::Close() {
+    if (thread_.joinable()) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        thread_.join();
+    }
+    reader_.Close();
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool SpillRingSpool::Next(SpillRingRecord &record, const int &timeout) {
+    if (fd_ < 0)
+        return false;
+
+    uint64_t offset;
+    {
+        unique_lock<mutex> lock(mutex_);
+
+        //We've handed out everything in the file, so it can start over. It's only truncated after a long backlog,
+        // so that the file doesn't have to be allocated again for each spill.
+        if (readOffset_ == writeOffset_ && !isWriting_ && writeOffset_ > 0) {
+            if (fileSize_ > MAXIMUM_IDLE_SPOOL_SIZE) {
+                if (ftruncate(fd_, 0) != 0)
+                    throw runtime_error("SpillRingSpool::Next - Unable to truncate the spool file");
+                fileSize_ = 0;
+            }
+            readOffset_ = writeOffset_ = 0;
+        }
+
+        auto hasRecord = [this]() { return readOffset_ < writeOffset_; };
+        if (timeout < 0)
+            spooled_.wait(lock, hasRecord);
+        else if (!spooled_.wait_for(lock, chrono::milliseconds(timeout), hasRecord))
+            return false;
+        offset = readOffset_;
+    }
+
+    //Everything before writeOffset_ stays put until we've read it, so the file is read without the lock.
+    SpoolRecordHeader header;
+    if (!ReadAll(fd_, (char *) &header, sizeof(header), offset))
+        throw runtime_error("SpillRingSpool::Next - Unable to read the spool file");
+    buffer_.resize(header.nWords);
+    if (header.nWords > 0 &&
+        !ReadAll(fd_, (char *) &buffer_[0], 4 * (size_t) header.nWords, offset + sizeof(header)))
+        throw runtime_error("SpillRingSpool::Next - Unable to read the spool file");
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        readOffset_ = offset + sizeof(header) + 4 * (uint64_t) header.nWords;
+    }
+
+    record.sequence = header.sequence;
+    record.position = offset;
+    record.type = header.type;
+    record.nWords = header.nWords;
+    record.data = (buffer_.empty() ? NULL : &buffer_[0]);
+    return true;
+}
+
+uint64_t SpillRingSpool::GetSpooledBytes() {
+    lock_guard<mutex> lock(mutex_);
+    return writeOffset_ - readOffset_;
+}
+
+///Each record is given back to poll2 as soon as it has been written to the file, by the next call to
+/// SpillRingReader::Next.
+void SpillRingSpool::Spool() {
+    SpillRingRecord record;
+    while (true) {
+        uint64_t offset;
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (stopping_)
+                return;
+        }
+
+        if (!reader_.Next(record, 100))
+            continue;
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            offset = writeOffset_;
+            isWriting_ = true;
+        }
+
+        SpoolRecordHeader header;
+        header.sequence = record.sequence;
+        header.type = record.type;
+        header.nWords = record.nWords;
+        const uint64_t bytes = sizeof(header) + 4 * (uint64_t) record.nWords;
+        bool isSpooled = WriteAll(fd_, (const char *) &header, sizeof(header), offset) &&
+                         (record.nWords == 0 ||
+                          WriteAll(fd_, (const char *) record.data, 4 * (size_t) record.nWords,
+                                   offset + sizeof(header)));
+
+        //poll2 only writes over a record that we haven't given back if it gave up on waiting for us.
+        if (!isSpooled || !reader_.IsValid(record)) {
+            reader_.AddLostRecord();
+            isSpooled = false;
+        }
+        lostRecords_.store(reader_.GetNumberOfLostRecords(), memory_order_relaxed);
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            isWriting_ = false;
+            if (isSpooled) {
+                writeOffset_ = offset + bytes;
+                if (writeOffset_ > fileSize_)
+                    fileSize_ = writeOffset_;
+            }
+        }
+        spooled_.notify_all();
+
+        //poll2 is done with the ring, the scan picks up the new one once it has read the close record.
+        if (record.type == SPILL_RING_CLOSE)
+            return;
+    }
+}
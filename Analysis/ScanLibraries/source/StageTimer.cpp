@@ -0,0 +1,198 @@
+///@file StageTimer.cpp
+///@brief Nanosecond timers for each stage of the scan.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+#include "StageTimer.hpp"
+
+using namespace std;
+
+StageTimer::StageTimer(const std::string &group, const std::string &name) : group_(group), name_(name) {
+    Reset();
+}
+
+///The minimum and maximum are updated with a compare and swap, so that two threads finishing at the same time can't
+/// lose either of their calls.
+void StageTimer::Add(const uint64_t &nanoseconds) {
+    calls_.fetch_add(1, memory_order_relaxed);
+    total_.fetch_add(nanoseconds, memory_order_relaxed);
+    histogram_[GetBin(nanoseconds)].fetch_add(1, memory_order_relaxed);
+
+    uint64_t current = minimum_.load(memory_order_relaxed);
+    while (nanoseconds < current && !minimum_.compare_exchange_weak(current, nanoseconds, memory_order_relaxed));
+    current = maximum_.load(memory_order_relaxed);
+    while (nanoseconds > current && !maximum_.compare_exchange_weak(current, nanoseconds, memory_order_relaxed));
+}
+
+void StageTimer::Reset() {
+    calls_ = 0;
+    total_ = 0;
+    minimum_ = numeric_limits<uint64_t>::max();
+    maximum_ = 0;
+    for (unsigned int i = 0; i < NUMBER_OF_BINS; i++)
+        histogram_[i] = 0;
+}
+
+uint64_t StageTimer::GetMinimumNanoseconds() const {
+    return GetNumberOfCalls() == 0 ? 0 : minimum_.load(memory_order_relaxed);
+}
+
+double StageTimer::GetMeanNanoseconds() const {
+    const uint64_t calls = GetNumberOfCalls();
+    return calls == 0 ? 0 : GetTotalNanoseconds() / (double) calls;
+}
+
+uint64_t StageTimer::GetPercentileNanoseconds(const double &fraction) const {
+    const vector<uint64_t> histogram = GetHistogram();
+    uint64_t calls = 0;
+    for (unsigned int i = 0; i < NUMBER_OF_BINS; i++)
+        calls += histogram[i];
+    if (calls == 0)
+        return 0;
+
+    const double target = max(1., fraction * calls);
+    uint64_t sum = 0;
+    for (unsigned int i = 0; i < NUMBER_OF_BINS - 1; i++) {
+        sum += histogram[i];
+        if (sum >= target)
+            return min(GetBinLowEdge(i + 1) - 1, GetMaximumNanoseconds());
+    }
+    return GetMaximumNanoseconds();
+}
+
+vector<uint64_t> StageTimer::GetHistogram() const {
+    vector<uint64_t> histogram(NUMBER_OF_BINS);
+    for (unsigned int i = 0; i < NUMBER_OF_BINS; i++)
+        histogram[i] = histogram_[i].load(memory_order_relaxed);
+    return histogram;
+}
+
+///Latencies below 4 ns get a bin of their own. Above that, the two bits below the leading one pick one of the four
+/// bins in each power of two, e.g. 8 - 9, 10 - 11, 12 - 13 and 14 - 15 ns.
+unsigned int StageTimer::GetBin(const uint64_t &nanoseconds) {
+    if (nanoseconds < 4)
+        return (unsigned int) nanoseconds;
+    const unsigned int leadingBit = 63 - __builtin_clzll(nanoseconds);
+    const unsigned int bin = 4 * (leadingBit - 1) + (unsigned int) ((nanoseconds >> (leadingBit - 2)) & 3);
+    return min(bin, NUMBER_OF_BINS - 1);
+}
+
+uint64_t StageTimer::GetBinLowEdge(const unsigned int &bin) {
+    if (bin < 4)
+        return bin;
+    return (uint64_t) (4 + bin % 4) << (bin / 4 - 1);
+}
+
+StageTimers *StageTimers::get() {
+    static StageTimers *instance = new StageTimers();
+    return instance;
+}
+
+StageTimer *StageTimers::Get(const std::string &group, const std::string &name) {
+    lock_guard<mutex> lock(mutex_);
+    const string key = group + "/" + name;
+    map<string, StageTimer *>::iterator it = timerMap_.find(key);
+    if (it != timerMap_.end())
+        return it->second;
+
+    StageTimer *timer = new StageTimer(group, name);
+    timers_.push_back(timer);
+    timerMap_.insert(make_pair(key, timer));
+    return timer;
+}
+
+vector<StageTimer *> StageTimers::GetTimers() const {
+    lock_guard<mutex> lock(mutex_);
+    return timers_;
+}
+
+void StageTimers::Reset() {
+    lock_guard<mutex> lock(mutex_);
+    for (vector<StageTimer *>::iterator it = timers_.begin(); it != timers_.end(); it++)
+        (*it)->Reset();
+}
+
+void StageTimers::Print(std::ostream &out) const {
+    const vector<StageTimer *> timers = GetTimers();
+
+    //Keep the groups in the order that they first showed up, and sort each one by the total time.
+    vector<string> groups;
+    map<string, vector<StageTimer *> > grouped;
+    map<string, uint64_t> groupTotals;
+    for (vector<StageTimer *>::const_iterator it = timers.begin(); it != timers.end(); it++) {
+        if ((*it)->GetNumberOfCalls() == 0)
+            continue;
+        if (grouped.find((*it)->GetGroup()) == grouped.end())
+            groups.push_back((*it)->GetGroup());
+        grouped[(*it)->GetGroup()].push_back(*it);
+        groupTotals[(*it)->GetGroup()] += (*it)->GetTotalNanoseconds();
+    }
+
+    if (groups.empty()) {
+        out << "None of the stage timers have been called yet.\n";
+        return;
+    }
+
+    const ios_base::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+    out << left << setw(12) << "Group" << setw(28) << "Name" << right << setw(12) << "Calls" << setw(11)
+        << "Total (s)" << setw(8) << "Group%" << setw(11) << "Mean (us)" << setw(11) << "p50 (us)" << setw(11)
+        << "p99 (us)" << setw(11) << "Max (us)" << "\n";
+    for (vector<string>::const_iterator group = groups.begin(); group != groups.end(); group++) {
+        vector<StageTimer *> &list = grouped[*group];
+        sort(list.begin(), list.end(), [](const StageTimer *a, const StageTimer *b) {
+            return a->GetTotalNanoseconds() > b->GetTotalNanoseconds();
+        });
+        for (vector<StageTimer *>::const_iterator it = list.begin(); it != list.end(); it++)
+            out << left << setw(12) << (*it)->GetGroup() << setw(28) << (*it)->GetName() << right << fixed
+                << setw(12) << (*it)->GetNumberOfCalls() << setprecision(3) << setw(11)
+                << (*it)->GetTotalNanoseconds() * 1e-9 << setprecision(1) << setw(8)
+                << (groupTotals[*group] ? 100. * (*it)->GetTotalNanoseconds() / groupTotals[*group] : 0.)
+                << setprecision(3) << setw(11) << (*it)->GetMeanNanoseconds() * 1e-3 << setw(11)
+                << (*it)->GetPercentileNanoseconds(0.5) * 1e-3 << setw(11)
+                << (*it)->GetPercentileNanoseconds(0.99) * 1e-3 << setw(11)
+                << (*it)->GetMaximumNanoseconds() * 1e-3 << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+///Each timer is on its own line so that the file is easy to diff and grep, like the output of the benchmarks.
+void StageTimers::Write(const std::string &fileName) const {
+    ofstream out(fileName.c_str());
+    if (!out)
+        throw invalid_argument("StageTimers::Write - Unable to open " + fileName);
+
+    const vector<StageTimer *> timers = GetTimers();
+    bool isFirst = true;
+    out << "{\n  \"timers\": [\n";
+    for (vector<StageTimer *>::const_iterator it = timers.begin(); it != timers.end(); it++) {
+        if ((*it)->GetNumberOfCalls() == 0)
+            continue;
+        out << (isFirst ? "" : ",\n") << "    {\"group\": \"" << (*it)->GetGroup() << "\", \"name\": \""
+            << (*it)->GetName() << "\", \"calls\": " << (*it)->GetNumberOfCalls() << ", \"total_ns\": "
+            << (*it)->GetTotalNanoseconds() << ", \"min_ns\": " << (*it)->GetMinimumNanoseconds()
+            << ", \"mean_ns\": " << fixed << setprecision(1) << (*it)->GetMeanNanoseconds() << ", \"p50_ns\": "
+            << (*it)->GetPercentileNanoseconds(0.5) << ", \"p90_ns\": " << (*it)->GetPercentileNanoseconds(0.9)
+            << ", \"p99_ns\": " << (*it)->GetPercentileNanoseconds(0.99) << ", \"max_ns\": "
+            << (*it)->GetMaximumNanoseconds() << ", \"histogram\": [";
+        isFirst = false;
+
+        //Only the bins that have calls in them, as [low edge in ns, calls].
+        const vector<uint64_t> histogram = (*it)->GetHistogram();
+        bool isFirstBin = true;
+        for (unsigned int i = 0; i < histogram.size(); i++) {
+            if (histogram[i] == 0)
+                continue;
+            out << (isFirstBin ? "" : ", ") << "[" << StageTimer::GetBinLowEdge(i) << ", " << histogram[i] << "]";
+            isFirstBin = false;
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,85 @@
+///@file ThreadPool.cpp
+///@brief A small pool of worker threads that runs batches of independent tasks.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+ThreadPool::ThreadPool(const unsigned int &numberOfThreads) : task_(NULL), numberOfTasks_(0), nextTask_(0),
+                                                              numberFinished_(0), batch_(0), stopping_(false) {
+    for (unsigned int i = 0; i < numberOfThreads; i++)
+        threads_.push_back(thread(&ThreadPool::Work, this));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+        batchReady_.notify_all();
+    }
+
+    for (vector<thread>::iterator it = threads_.begin(); it != threads_.end(); it++)
+        it->join();
+}
+
+void ThreadPool::ParallelFor(const size_t &numberOfTasks, const function<void(const size_t &)> &task) {
+    if (numberOfTasks == 0)
+        return;
+
+    unique_lock<mutex> lock(mutex_);
+    task_ = &task;
+    numberOfTasks_ = numberOfTasks;
+    nextTask_ = numberFinished_ = 0;
+    error_ = exception_ptr();
+    batch_++;
+    batchReady_.notify_all();
+
+    RunTasks(lock);
+    while (numberFinished_ != numberOfTasks_)
+        batchDone_.wait(lock);
+
+    task_ = NULL;
+    exception_ptr error = error_;
+    error_ = exception_ptr();
+    lock.unlock();
+
+    if (error)
+        rethrow_exception(error);
+}
+
+void ThreadPool::Work() {
+    unsigned long lastBatch = 0;
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        while (!stopping_ && batch_ == lastBatch)
+            batchReady_.wait(lock);
+        if (stopping_)
+            return;
+        lastBatch = batch_;
+        RunTasks(lock);
+    }
+}
+
+///A worker that wakes up late may find that the batch has already been handed out, in which case there's nothing for
+/// it to do. The task is always read under the lock, so a late worker can never run a task from an old batch.
+void ThreadPool::RunTasks(unique_lock<mutex> &lock) {
+    while (task_ && nextTask_ < numberOfTasks_) {
+        const function<void(const size_t &)> &task = *task_;
+        size_t index = nextTask_++;
+        lock.unlock();
+
+        exception_ptr error;
+        try {
+            task(index);
+        } catch (...) {
+            error = current_exception();
+        }
+
+        lock.lock();
+        if (error && !error_)
+            error_ = error;
+        if (++numberFinished_ == numberOfTasks_)
+            batchDone_.notify_all();
+    }
+}
@@ -0,0 +1,60 @@
+///@file TraceSamples.cpp
+///@brief Converts trace samples between the 16-bit words that the modules record and the wider types that the
+/// analysis works with.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include "TraceSamples.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+void TraceSamples::Widen(const unsigned short *first, const unsigned short *last, unsigned int *out) {
+    const size_t size = last - first;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 16 <= size; i += 16) {
+        __m256i samples = _mm256_loadu_si256((const __m256i *) (first + i));
+        _mm256_storeu_si256((__m256i *) (out + i), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(samples)));
+        _mm256_storeu_si256((__m256i *) (out + i + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(samples, 1)));
+    }
+#elif defined(__SSE2__)
+    //Interleaving the samples with zeros is the same as zero extending them on a little endian machine.
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= size; i += 8) {
+        __m128i samples = _mm_loadu_si128((const __m128i *) (first + i));
+        _mm_storeu_si128((__m128i *) (out + i), _mm_unpacklo_epi16(samples, zero));
+        _mm_storeu_si128((__m128i *) (out + i + 4), _mm_unpackhi_epi16(samples, zero));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= size; i += 8) {
+        uint16x8_t samples = vld1q_u16(first + i);
+        vst1q_u32(out + i, vmovl_u16(vget_low_u16(samples)));
+        vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(samples)));
+    }
+#endif
+
+    for (; i < size; i++)
+        out[i] = first[i];
+}
+
+vector<unsigned int> TraceSamples::Widen(const vector<unsigned short> &samples) {
+    vector<unsigned int> widened(samples.size());
+    if (!samples.empty())
+        Widen(samples.data(), samples.data() + samples.size(), widened.data());
+    return widened;
+}
+
+vector<unsigned short> TraceSamples::Narrow(const vector<unsigned int> &samples) {
+    vector<unsigned short> narrowed(samples.size());
+    for (size_t i = 0; i < samples.size(); i++)
+        narrowed[i] = (unsigned short) (samples[i] > 65535 ? 65535 : samples[i]);
+    return narrowed;
+}
@@ -23,198 +23,392 @@
 
 using namespace std;
 
-void clearDeque(deque<XiaData *> &list) {
-    while (!list.empty()) {
-        delete list.front();
-        list.pop_front();
+/// Clear the spill and return all of the XiaData to the pool. WARNING! Any XiaData pointer obtained from this spill
+/// is invalid after this call. This could cause seg faults if the events are used elsewhere.
+void Unpacker::SpillData::Clear() {
+    for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
+        iter->clear();
+    hits.clear();
+    events.clear();
+    pool.Reset();
+    for (size_t i = 0; i < numberOfModuleTasks; i++) {
+        moduleTasks[i]->events.clear();
+        moduleTasks[i]->pool.Reset();
     }
+    numberOfModuleTasks = 0;
+    isFlush = false;
+    isColumns = false;
+    columns.Clear();
+}
+
+Unpacker::SpillData::~SpillData() {
+    for (std::vector<ModuleTask *>::iterator it = moduleTasks.begin(); it != moduleTasks.end(); it++)
+        delete *it;
 }
 
-///Scan the event list and sort it by timestamp.
-/// @return Nothing.
-void Unpacker::TimeSort() {
-    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
-        sort(iter->begin(), iter->end(), &XiaData::CompareTime);
+///The tasks are reused from one spill to the next, so that their pools only allocate memory for the first few spills.
+Unpacker::ModuleTask *Unpacker::SpillData::NextModuleTask() {
+    if (numberOfModuleTasks == moduleTasks.size())
+        moduleTasks.push_back(new ModuleTask());
+    return moduleTasks[numberOfModuleTasks++];
 }
 
-/** Scan the time sorted event list and package the events into a raw
-  * event with a size governed by the event width.
-  * \return True if the event list is not empty and false otherwise.
+/** Sort the event lists and build all of the raw events in the spill.
+  * \param[in,out] spill The spill to build the events for.
+  * \return Nothing.
   */
-bool Unpacker::BuildRawEvent() {
-    if (!rawEvent.empty())
-        ClearRawEvent();
-
-    if (numRawEvt == 0) {// This is the first rawEvent. Do some special processing.
-        // Find the first XiaData event. The eventList is time sorted by module.
-        // The first component of each deque will be the earliest time from that module.
-        // The first event time will be the minimum of these first components.
-        if (!GetFirstTime(firstTime))
-            return false;
-        std::cout << "BuildRawEvent: First event time is " << firstTime << " clock ticks.\n";
-        eventStartTime = firstTime;
-    } else {
-        // Move the event window forward to the next valid channel fire.
-        if (!GetFirstTime(eventStartTime))
-            return false;
+void Unpacker::BuildRawEvents(SpillData &spill) {
+    ScopedStageTimer timer(buildTimer_);
+    // Without streaming every event in the spill is complete. A flush builds everything that was held back.
+    double watermark = numeric_limits<double>::max();
+    if (isStreaming_) {
+        if (!spill.isFlush)
+            watermark = FindWatermark(spill);
+        RestoreCarriedHits(spill);
     }
 
-    realStartTime = eventStartTime + eventWidth_;
-    realStopTime = eventStartTime;
+    // Sort the event list of each module by timestamp and seed the merger with the earliest hit from each module.
+    merger_.Initialize(spill.eventList);
 
-    unsigned int mod, chan;
-    string type, subtype, tag;
-    XiaData *current_event = NULL;
+    while (BuildRawEvent(spill, watermark)) {}
 
-    // Loop over all  time-sorted modules.
-    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
-        if (iter->empty())
+    merger_.Clear();
+    if (isStreaming_)
+        CarryHits(spill);
+    spill.firstTime = builderFirstTime_;
+}
+
+///Modules that didn't report any hits in the spill don't hold the builder back, otherwise a detector that stopped
+/// firing would keep every later hit in memory. Their next hit could still fall into a window that we've already
+/// closed, which is no worse than building each spill on its own.
+double Unpacker::FindWatermark(const SpillData &spill) {
+    double watermark = numeric_limits<double>::max();
+    for (vector<deque<XiaData *> >::const_iterator it = spill.eventList.begin(); it != spill.eventList.end(); it++) {
+        if (it->empty())
             continue;
+        double latest = (*max_element(it->begin(), it->end(), &XiaData::CompareTime))->GetFilterTime();
+        if (latest < watermark)
+            watermark = latest;
+    }
+    return watermark;
+}
 
-        // Loop over the list of channels that fired in this buffer
-        while (!iter->empty()) {
-            current_event = iter->front();
-            mod = current_event->GetModuleNumber();
-            chan = current_event->GetChannelNumber();
-
-            if (mod > MAX_PIXIE_MOD ||
-                chan > MAX_PIXIE_CHAN) { // Skip this channel
-                cout << "BuildRawEvent: Encountered non-physical Pixie ID (mod = "
-                     << mod << ", chan = " << chan << ")\n";
-                delete current_event;
-                iter->pop_front();
-                continue;
-            }
+///The carried hits came from earlier spills, so they go in front of the module's new hits. Moving them into the
+/// spill's pool means that every hit of an event is owned by the spill that the event is processed with.
+void Unpacker::RestoreCarriedHits(SpillData &spill) {
+    if (spill.eventList.size() < carryList_.size())
+        spill.eventList.resize(carryList_.size());
+
+    for (size_t mod = 0; mod < carryList_.size(); mod++) {
+        for (deque<XiaData *>::reverse_iterator it = carryList_[mod].rbegin(); it != carryList_[mod].rend(); it++) {
+            XiaData *data = spill.pool.Acquire();
+            *data = std::move(**it);
+            spill.eventList[mod].push_front(data);
+        }
+        carryList_[mod].clear();
+    }
+    carryPool_.Reset();
+}
 
-            double currtime = current_event->GetFilterTime();
+///Moving a hit copies its trace out of the spill, which is about to be reused.
+void Unpacker::CarryHits(SpillData &spill) {
+    if (carryList_.size() < spill.eventList.size())
+        carryList_.resize(spill.eventList.size());
 
-            // @TODO Check for backwards time-skip. This is un-handled currently and needs fixed CRT!!!
-            if (currtime < eventStartTime)
-                cout << "BuildRawEvent: Detected backwards time-skip from start=" << eventStartTime << " to "
-                     << current_event->GetFilterTime() << "???\n";
+    for (size_t mod = 0; mod < spill.eventList.size(); mod++) {
+        for (deque<XiaData *>::iterator it = spill.eventList[mod].begin(); it != spill.eventList[mod].end(); it++) {
+            XiaData *data = carryPool_.Acquire();
+            *data = std::move(**it);
+            carryList_[mod].push_back(data);
+        }
+        spill.eventList[mod].clear();
+    }
+}
 
-            // If the time difference between the current and previous event is
-            // larger than the event width, finalize the current event, otherwise
-            // treat this as part of the current event
-            if ((currtime - eventStartTime) > eventWidth_)
-                break;
+/** Pull hits from the merged, time ordered event list and package them into a raw
+  * event with a size governed by the event width. The merger hands us the hits in time order, so the
+  * event is complete as soon as the next hit falls outside of the window.
+  * \param[in,out] spill     The spill that we are building events for.
+  * \param[in]     watermark Only events whose window closes before this time are built.
+  * \return True if an event was built and false otherwise.
+  */
+bool Unpacker::BuildRawEvent(SpillData &spill, const double &watermark) {
+    // A module may still send us a hit inside the window of this event, so we leave it for the next spill.
+    if (merger_.IsEmpty() || merger_.GetNextTime() + eventWidth_ >= watermark)
+        return false;
 
-            // Check for the minimum time in this raw event.
-            if (currtime < realStartTime)
-                realStartTime = currtime;
+    RawEventInfo event;
+    event.first = spill.hits.size();
+    event.startTime = merger_.GetNextTime();
 
-            // Check for the maximum time in this raw event.
-            if (currtime > realStopTime)
-                realStopTime = currtime;
+    if (!haveFirstTime_) {// This is the first rawEvent. Do some special processing.
+        // The first event time is the earliest time across all of the modules.
+        builderFirstTime_ = event.startTime;
+        haveFirstTime_ = true;
+        std::cout << "BuildRawEvent: First event time is " << builderFirstTime_ << " clock ticks.\n";
+    }
 
-            // Update raw stats output with the new event before adding it to the raw event.
-            RawStats(current_event);
+    event.realStartTime = event.startTime + eventWidth_;
+    event.realStopTime = event.startTime;
 
-            // Push this channel event into the rawEvent.
-            rawEvent.push_back(current_event);
+    unsigned int mod, chan;
+    XiaData *current_event = NULL;
+
+    // Pull hits in time order until the next one falls outside of the event window.
+    while (!merger_.IsEmpty() && (merger_.GetNextTime() - event.startTime) <= eventWidth_) {
+        current_event = merger_.Pop();
+        mod = current_event->GetModuleNumber();
+        chan = current_event->GetChannelNumber();
 
-            // Remove this event from the event list but do not delete it yet.
-            // Deleting of the channel events will be handled by clearing the rawEvent.
-            iter->pop_front();
+        if (mod > MAX_PIXIE_MOD || chan > MAX_PIXIE_CHAN) { // Skip this channel
+            cout << "BuildRawEvent: Encountered non-physical Pixie ID (mod = "
+                 << mod << ", chan = " << chan << ")\n";
+            continue;
         }
+
+        double currtime = current_event->GetFilterTime();
+
+        // Check for the minimum time in this raw event.
+        if (currtime < event.realStartTime)
+            event.realStartTime = currtime;
+
+        // Check for the maximum time in this raw event.
+        if (currtime > event.realStopTime)
+            event.realStopTime = currtime;
+
+        // Push this channel event into the raw event. The memory is reclaimed by the pool when the spill is cleared.
+        spill.hits.push_back(current_event);
     }
 
-    numRawEvt++;
+    event.size = spill.hits.size() - event.first;
+    spill.events.push_back(event);
 
     return true;
 }
 
+/** Hand each of the raw events in the spill to RawStats and ProcessRawEvent.
+  * \param[in] spill The spill whose events we're processing.
+  * \return Nothing.
+  */
+void Unpacker::ProcessRawEvents(SpillData &spill) {
+    ScopedStageTimer timer(processTimer_);
+    maxModuleNumberInFile_ = spill.maxModuleNumber;
+    firstTime = spill.firstTime;
+
+    for (vector<RawEventInfo>::iterator event = spill.events.begin(); event != spill.events.end(); event++) {
+        eventStartTime = event->startTime;
+        realStartTime = event->realStartTime;
+        realStopTime = event->realStopTime;
+
+        rawEvent.assign(spill.hits.begin() + event->first, spill.hits.begin() + event->first + event->size);
+
+        // Update raw stats output with the new events before processing the raw event.
+        for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+            RawStats(*it);
+
+        numRawEvt++;
+        ScopedStageTimer eventTimer(eventTimer_);
+        ProcessRawEvent();
+    }
+
+    ClearRawEvent();
+}
+
 /** Push an event into the event list.
   * \param[in]  event_ The XiaData to push onto the back of the event list.
+  * \param[out] spill  The spill whose event list we're adding to.
   * \return True if the XiaData's module number is valid and false otherwise. */
-bool Unpacker::AddEvent(XiaData *event_) {
+bool Unpacker::AddEvent(XiaData *event_, SpillData &spill) {
     if (event_->GetModuleNumber() > MAX_PIXIE_MOD)
         return false;
 
     // Check for the need to add a new deque to the event list.
-    if (event_->GetModuleNumber() + 1 > (unsigned int) eventList.size())
-        while (eventList.size() < event_->GetModuleNumber() + 1)
-            eventList.push_back(std::deque<XiaData *>());
+    if (event_->GetModuleNumber() + 1 > (unsigned int) spill.eventList.size())
+        while (spill.eventList.size() < event_->GetModuleNumber() + 1)
+            spill.eventList.push_back(std::deque<XiaData *>());
 
-    eventList.at(event_->GetModuleNumber()).push_back(event_);
+    spill.eventList.at(event_->GetModuleNumber()).push_back(event_);
 
     return true;
 }
 
-/** Clear all events in the spill event list. WARNING! This method will delete all events in the
-  * event list. This could cause seg faults if the events are used elsewhere.
+/** Clear all events in the raw event list. The events themselves are owned by the spill pool and are reclaimed
+  * when the spill is cleared.
   * \return Nothing. */
-void Unpacker::ClearEventList() {
-    for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
-        clearDeque((*iter));
+void Unpacker::ClearRawEvent() {
+    rawEvent.clear();
 }
 
-/** Clear all events in the raw event list. WARNING! This method will delete all events in the
-  * event list. This could cause seg faults if the events are used elsewhere.
-  * \return Nothing. */
-void Unpacker::ClearRawEvent() {
-    clearDeque(rawEvent);
+///Process all events in the event list.
+void Unpacker::ProcessRawEvent() {
+    ClearRawEvent();
 }
 
-/** Get the minimum channel time from the event list.
-  * \param[out] time The minimum time from the event list in system clock ticks.
-  * \return True if the event list is not empty and false otherwise. */
-bool Unpacker::GetFirstTime(double &time) {
-    if (IsEmpty())
-        return false;
+///Called from DecodeSpill. Scan the current module buffer and construct a list of events which fired by obtaining
+/// the module, channel, trace, etc. of the timestamped event. This method will construct the event list for later
+/// processing.
+///@param[in] buf : Pointer to an array of unsigned ints containing raw buffer data.
+///@param[in] vsn : The module number of the buffer.
+///@param[out] spill : The spill that will hold the decoded hits.
+///@return The number of XiaDatas read from the buffer.
+int Unpacker::ReadBuffer(unsigned int *buf, const unsigned int &vsn, SpillData &spill) {
+    const unsigned int skipped = decoder_.GetNumberOfSkippedBuffers();
+    std::vector<XiaData *> decodedList = decoder_.DecodeBuffer(buf, GetLayout(vsn), &spill.pool);
+    numSkippedBuffers_ += decoder_.GetNumberOfSkippedBuffers() - skipped;
 
-    time = std::numeric_limits<double>::max();
-    for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
-        if (iter->empty())
-            continue;
-        if (iter->front()->GetFilterTime() < time)
-            time = iter->front()->GetFilterTime();
+    for (vector<XiaData *>::iterator it = decodedList.begin(); it != decodedList.end(); it++)
+        AddEvent(*it, spill);
+    return (int) decodedList.size();
+}
+
+///We look up the layout here, rather than on the decode threads, so that a module missing from the map throws from
+/// the same place as it does when we decode one buffer at a time.
+void Unpacker::QueueBuffer(unsigned int *buf, const unsigned int &vsn, SpillData &spill) {
+    ModuleTask *task = spill.NextModuleTask();
+    task->buffer = buf;
+    task->layout = GetLayout(vsn);
+    task->numSkippedBuffers = 0;
+
+    // The tasks outlive calls to SetTraceChannels, so we bring their decoders up to date here.
+    task->decoder.SetTraceReferences(true);
+    task->decoder.SetCompressedTraces(spill.hasCompressedTraces);
+    if (task->decoder.GetTraceChannels() != decoder_.GetTraceChannels())
+        task->decoder.SetTraceChannels(decoder_.GetTraceChannels());
+}
+
+///Each task only touches its own decoder, pool and event list, so the threads don't need to talk to each other. If a
+/// buffer throws, the first exception is rethrown once all of the buffers have been decoded.
+unsigned long Unpacker::DecodeModuleTasks(SpillData &spill) {
+    decodeThreads_->ParallelFor(spill.numberOfModuleTasks, [&spill](const size_t &i) {
+        ModuleTask *task = spill.moduleTasks[i];
+        const unsigned int skipped = task->decoder.GetNumberOfSkippedBuffers();
+        task->events = task->decoder.DecodeBuffer(task->buffer, task->layout, &task->pool);
+        task->numSkippedBuffers = task->decoder.GetNumberOfSkippedBuffers() - skipped;
+    });
+
+    unsigned long numEvents = 0;
+    for (size_t i = 0; i < spill.numberOfModuleTasks; i++) {
+        ModuleTask *task = spill.moduleTasks[i];
+        for (vector<XiaData *>::iterator it = task->events.begin(); it != task->events.end(); it++)
+            AddEvent(*it, spill);
+        numEvents += task->events.size();
+        numSkippedBuffers_ += task->numSkippedBuffers;
     }
 
-    return true;
+    return numEvents;
 }
 
-/** Check whether or not the eventList is empty.
-  * \return True if the eventList is empty, and false otherwise. */
-bool Unpacker::IsEmpty() {
-    for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
-        if (!iter->empty())
-            return false;
-    return true;
+///The layouts are normally built by InitializeDataMask, so this is only a map lookup. We still point mask_ at the
+/// module's firmware and frequency, since derived classes may look at it.
+const XiaListModeDataLayout &Unpacker::GetLayout(const unsigned int &vsn) {
+    if (maskMap_.size() != 0) {
+        std::map<unsigned int, XiaListModeDataLayout>::iterator layout = layoutMap_.find(vsn);
+        if (layout == layoutMap_.end()) {
+            auto found = maskMap_.find(vsn);
+            if (found == maskMap_.end())
+                throw invalid_argument("Unpacker::ReadBuffer - Unable to locate VSN = " + to_string(vsn)
+                                       + " in the maskMap. Ensure that it's defined in your configuration file!");
+            layout = layoutMap_.insert(make_pair(vsn, XiaListModeDataLayout(
+                    XiaListModeDataMask((*found).second.first, (*found).second.second)))).first;
+        }
+        mask_.SetFirmware(layout->second.firmware);
+        mask_.SetFrequency(layout->second.frequency);
+        return layout->second;
+    }
+
+    // Every module uses mask_, we only need a new layout if somebody changed it. This throws if the mask isn't set.
+    if (layout_.firmware == DataProcessing::UNKNOWN || layout_.firmware != mask_.GetFirmware()
+        || layout_.frequency != mask_.GetFrequency())
+        layout_ = XiaListModeDataLayout(mask_);
+    return layout_;
 }
 
-///Process all events in the event list.
-void Unpacker::ProcessRawEvent() {
-    ClearRawEvent();
+void Unpacker::SetTraceChannels(const std::vector<bool> &channels) {
+    if (IsPipelined())
+        throw runtime_error("Unpacker::SetTraceChannels - The trace channels cannot be changed while the pipeline is "
+                                    "running.");
+    decoder_.SetTraceChannels(channels);
 }
 
-///Called form ReadSpill. Scan the current spill and construct a list of events which fired by obtaining the module,
-/// channel, trace, etc. of the timestamped event. This method will construct the event list for later processing.
-///@param[in] buf : Pointer to an array of unsigned ints containing raw buffer data.
-///@return The number of XiaDatas read from the buffer.
-int Unpacker::ReadBuffer(unsigned int *buf, const unsigned int &vsn) {
-    static XiaListModeDataDecoder decoder;
+void Unpacker::SetFirstTime(const double &time) {
+    builderFirstTime_ = firstTime = time;
+    haveFirstTime_ = true;
+}
 
-    if (maskMap_.size() != 0) {
-        auto found = maskMap_.find(vsn);
-        if(found == maskMap_.end())
-            throw invalid_argument("Unpacker::ReadBuffer - Unable to locate VSN = " + to_string(vsn)
-                                   + " in the maskMap. Ensure that it's defined in your configuration file!");
-        mask_.SetFirmware((*found).second.first);
-        mask_.SetFrequency((*found).second.second);
+void Unpacker::SetStreamingEvents(const bool &streaming) {
+    if (IsPipelined())
+        throw runtime_error("Unpacker::SetStreamingEvents - The event builder cannot be changed while the pipeline is "
+                                    "running.");
+    if (!streaming)
+        FlushEvents();
+    isStreaming_ = streaming;
+}
+
+///In pipeline mode the flush has to go through every stage, so that it's built after the spills that are ahead of it.
+void Unpacker::FlushEvents() {
+    if (!isStreaming_)
+        return;
+
+    if (!IsPipelined()) {
+        spill_.isFlush = true;
+        spill_.maxModuleNumber = maxModuleDecoded_;
+        BuildRawEvents(spill_);
+        ProcessRawEvents(spill_);
+        spill_.Clear();
+        return;
     }
 
-    std::vector<XiaData *> decodedList = decoder.DecodeBuffer(buf, mask_);
-    for (vector<XiaData *>::iterator it = decodedList.begin(); it != decodedList.end(); it++)
-        AddEvent(*it);
-    return (int) decodedList.size();
+    CheckPipeline();
+
+    SpillData *spill;
+    if (!freeSpills_.Pop(spill)) {
+        CheckPipeline();
+        return;
+    }
+    spill->isFlush = true;
+
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        spillsInFlight_++;
+    }
+
+    if (!decodeQueue_.Push(spill))
+        CheckPipeline();
+}
+
+void Unpacker::SetColumnWriter(XiaDataColumnWriter *writer) {
+    if (IsPipelined())
+        throw runtime_error("Unpacker::SetColumnWriter - The column writer cannot be changed while the pipeline is "
+                                    "running.");
+    columnWriter_ = writer;
+}
+
+void Unpacker::SetDecodeThreads(const unsigned int &numberOfThreads) {
+    if (IsPipelined())
+        throw runtime_error("Unpacker::SetDecodeThreads - The number of decode threads cannot be changed while the "
+                                    "pipeline is running.");
+
+    delete decodeThreads_;
+    decodeThreads_ = numberOfThreads > 1 ? new ThreadPool(numberOfThreads - 1) : NULL;
 }
 
 Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), running(true),
                        TOTALREAD(1000000), // Maximum number of data words to read.
                        maxWords(131072), // Maximum number of data words for revision D.
                        numRawEvt(0), // Count of raw events read from file.
-                       firstTime(0), eventStartTime(0), realStartTime(0), realStopTime(0) {
+                       firstTime(0), eventStartTime(0), realStartTime(0), realStopTime(0),
+                       decodeThreads_(NULL), numSkippedBuffers_(0), maxModuleDecoded_(0), haveFirstTime_(false),
+                       builderFirstTime_(0), isStreaming_(false), columnWriter_(NULL), hasCompressedTraces_(false),
+                       spillsInFlight_(0) {
+    decodeTimer_ = StageTimers::get()->Get("unpacker", "DecodeSpill");
+    buildTimer_ = StageTimers::get()->Get("unpacker", "BuildRawEvents");
+    processTimer_ = StageTimers::get()->Get("unpacker", "ProcessRawEvents");
+    eventTimer_ = StageTimers::get()->Get("unpacker", "ProcessRawEvent");
+
+    // The spill, or our copy of it, stays put until all of its events have been processed. So the XiaData can refer
+    // to the traces in it rather than copying them.
+    decoder_.SetTraceReferences(true);
+
 
     for (unsigned int i = 0; i <= MAX_PIXIE_MOD; i++)
         for (unsigned int j = 0; j <= MAX_PIXIE_CHAN; j++)
@@ -222,8 +416,9 @@ Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), running(true),
 }
 
 Unpacker::~Unpacker() {
-    ClearRawEvent();
-    ClearEventList();
+    StopPipeline();
+    spill_.Clear();
+    delete decodeThreads_;
 }
 
 void Unpacker::InitializeDataMask(const std::string &firmware, const unsigned int &frequency) {
@@ -245,21 +440,136 @@ void Unpacker::InitializeDataMask(const std::string &firmware, const unsigned in
                                       make_pair(it->attribute("firmware").as_string(),
                                                 it->attribute("frequency").as_uint())));
         }
+
+        // Resolve the masks for each module now, so that the decoder never has to.
+        layoutMap_.clear();
+        for (auto it = maskMap_.begin(); it != maskMap_.end(); it++)
+            layoutMap_.insert(make_pair(it->first, XiaListModeDataLayout(
+                    XiaListModeDataMask(it->second.first, it->second.second))));
     } else {
         mask_.SetFrequency(frequency);
         mask_.SetFirmware(firmware);
+        layout_ = XiaListModeDataLayout(mask_);
     }
 }
 
 /** ReadSpill is responsible for constructing a list of pixie16 events from
   * a raw data spill. This method performs sanity checks on the spill and
-  * calls ReadBuffer in order to construct the event list.
+  * calls ReadBuffer in order to construct the event list. In pipeline mode the
+  * spill is copied and queued for the decoder thread, and we return right away.
   * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
   * \param[in]  nWords     The number of words in the array.
   * \param[in]  is_verbose Toggle the verbosity flag on/off.
-  * \return True if the spill was read successfully and false otherwise.
+  * \return True if the spill was read (or queued) successfully and false otherwise.
   */
 bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbose/*=true*/) {
+    if (!IsPipelined()) {
+        spill_.hasCompressedTraces = hasCompressedTraces_;
+        bool retval = DecodeSpill(data, nWords, is_verbose, spill_);
+        if (retval) {
+            BuildRawEvents(spill_);
+            ProcessRawEvents(spill_);
+        }
+        spill_.Clear();
+        return retval;
+    }
+
+    CheckPipeline();
+
+    // Wait for one of the spills to come out of the pipeline. This is what keeps us from reading too far ahead.
+    SpillData *spill;
+    if (!freeSpills_.Pop(spill)) {
+        CheckPipeline();
+        return false;
+    }
+
+    // The decoder may look at the two words after the end of the spill if the end of spill flag is missing. The
+    // caller's array is always larger than the spill, so we add the flag to the copy to be safe.
+    spill->words.assign(data, data + nWords);
+    spill->words.push_back(2);
+    spill->words.push_back(9999);
+    spill->isVerbose = is_verbose;
+    spill->hasCompressedTraces = hasCompressedTraces_;
+
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        spillsInFlight_++;
+    }
+
+    if (!decodeQueue_.Push(spill))
+        CheckPipeline();
+
+    return true;
+}
+
+/** ReadColumns does for a chunk of a column file what ReadSpill does for a raw spill. In pipeline mode only the
+  * chunk, which refers to the caller's memory, is queued for the decoder thread.
+  * \param[in]  chunk      The chunk to read.
+  * \param[in]  is_verbose Toggle the verbosity flag on/off.
+  * \return True if the chunk was read (or queued) successfully and false otherwise.
+  */
+bool Unpacker::ReadColumns(const XiaDataColumnChunk &chunk, bool is_verbose/*=true*/) {
+    if (!IsPipelined()) {
+        bool retval = DecodeColumns(chunk, spill_);
+        if (retval) {
+            BuildRawEvents(spill_);
+            ProcessRawEvents(spill_);
+        }
+        spill_.Clear();
+        return retval;
+    }
+
+    CheckPipeline();
+
+    SpillData *spill;
+    if (!freeSpills_.Pop(spill)) {
+        CheckPipeline();
+        return false;
+    }
+
+    spill->isColumns = true;
+    spill->columns = chunk;
+    spill->isVerbose = is_verbose;
+
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        spillsInFlight_++;
+    }
+
+    if (!decodeQueue_.Push(spill))
+        CheckPipeline();
+
+    return true;
+}
+
+///The hits go into the event list in the order that they were written, which is the order that the decoder gave
+/// them to us when the file was written.
+bool Unpacker::DecodeColumns(const XiaDataColumnChunk &chunk, SpillData &spill) {
+    ScopedStageTimer timer(decodeTimer_);
+    for (size_t i = 0; i < chunk.GetNumberOfHits(); i++) {
+        XiaData *data = spill.pool.Acquire();
+        chunk.Fill(i, data);
+        if (data->GetModuleNumber() > maxModuleDecoded_ && data->GetModuleNumber() <= MAX_PIXIE_MOD)
+            maxModuleDecoded_ = data->GetModuleNumber();
+        AddEvent(data, spill);
+    }
+
+    if (columnWriter_)
+        columnWriter_->Write(spill.eventList);
+
+    spill.maxModuleNumber = maxModuleDecoded_;
+    return chunk.GetNumberOfHits() != 0;
+}
+
+/** Performs the sanity checks on a raw spill and decodes each of the module buffers into the spill's event list.
+  * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
+  * \param[in]  nWords     The number of words in the array.
+  * \param[in]  is_verbose Toggle the verbosity flag on/off.
+  * \param[out] spill      The spill that will hold the decoded hits.
+  * \return True if the spill should be built and processed and false otherwise.
+  */
+bool Unpacker::DecodeSpill(unsigned int *data, unsigned int nWords, bool is_verbose, SpillData &spill) {
+    ScopedStageTimer timer(decodeTimer_);
     const unsigned int maxVsn = 14; // No more than 14 pixie modules per crate
     unsigned int nWords_read = 0;
 
@@ -273,9 +583,10 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
     time_t theTime = 0;
 
     if (counter == 0)
-        maxModuleNumberInFile_ = 0;
+        maxModuleDecoded_ = 0;
 
     counter++;
+    decoder_.SetCompressedTraces(spill.hasCompressedTraces);
 
     unsigned int lenRec = 0xFFFFFFFF;
     unsigned int vsn = 0xFFFFFFFF;
@@ -291,8 +602,8 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
         lenRec = data[nWords_read]; // Number of words in this record
         vsn = data[nWords_read + 1]; // Module number
 
-        if (vsn > maxModuleNumberInFile_ && vsn != 9999 && vsn != 1000)
-            maxModuleNumberInFile_ = vsn;
+        if (vsn > maxModuleDecoded_ && vsn != 9999 && vsn != 1000)
+            maxModuleDecoded_ = vsn;
 
         // Check sanity of record length and vsn
         if (lenRec > maxWords || (vsn > maxVsn && vsn != 9999 && vsn != 1000)) {
@@ -318,13 +629,17 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
                 if (is_verbose)
                     cout << "ReadSpill: MISSING BUFFER " << lastVsn + 1 << ", lastVsn = " << lastVsn << ", vsn = "
                          << vsn << ", lenrec = " << lenRec << endl;
-                ClearEventList();
+                spill.Clear();
                 fullSpill = false; // WHY WAS THIS TRUE!?!? CRT
             }
 
             // Read the buffer.	After read, the vector eventList will
             //contain pointers to all channels that fired in this buffer
-            retval = ReadBuffer(&data[nWords_read], vsn);
+            // When we decode in parallel the buffer is only queued here, and decoded once we've found them all.
+            if (decodeThreads_)
+                QueueBuffer(&data[nWords_read], vsn, spill);
+            else
+                retval = ReadBuffer(&data[nWords_read], vsn, spill);
 
             // If the return value is less than the error code,
             //reading the buffer failed for some reason.
@@ -335,7 +650,7 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
                 if (retval == -100) {
                     if (is_verbose)
                         cout << "ReadSpill:  Remove list " << lastVsn << " " << vsn << endl;
-                    ClearEventList();
+                    spill.Clear();
                 }
                 return false;
             } else if (retval > 0) {
@@ -367,6 +682,9 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
         }
     } // while still have words
 
+    if (decodeThreads_)
+        numEvents += DecodeModuleTasks(spill);
+
     if (nWords > TOTALREAD || nWords_read > TOTALREAD) {
         cout << "ReadSpill: Values of nn - " << nWords << " nk - " << nWords_read << " TOTALREAD - " << TOTALREAD
              << endl;
@@ -388,19 +706,8 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
     // If there are events to process, continue
     if (numEvents > 0) {
         if (fullSpill) { // if full spill process events
-            // Sort the vector of pointers eventlist according to time
-            //double lastTimestamp = (*(eventList.rbegin()))->time;
-
-            // Sort the event list in time
-            TimeSort();
-
-            // Once the vector of pointers eventlist is sorted based on time,
-            // begin the event processing in ScanList().
-            // ScanList will also clear the event list for us.
-            while (BuildRawEvent())
-                ProcessRawEvent();
-
-            ClearEventList();
+            // The spill is complete, the events are built and processed by the next stages.
+            spill.maxModuleNumber = maxModuleDecoded_;
 
             // Once the eventlist has been scanned, reset the number
             // of events to zero and update the event counter
@@ -414,19 +721,188 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
         } else {
             if (is_verbose)
                 cout << "ReadSpill: Spill split between buffers" << endl;
-            ClearEventList(); // This tosses out all events read into the deque so far
+            spill.Clear(); // This tosses out all events read into the deque so far
             return false;
         }
     } else if (retval != -10) {
         if (is_verbose)
             cout << "ReadSpill: bad buffer, numEvents = " << numEvents << endl;
-        ClearEventList(); // This tosses out all events read into the deque so far
+        spill.Clear(); // This tosses out all events read into the deque so far
         return false;
     }
 
+    // The hits are written before the event builder sorts them or carries any of them over to the next spill.
+    if (columnWriter_)
+        columnWriter_->Write(spill.eventList);
+
+    spill.maxModuleNumber = maxModuleDecoded_;
     return true;
 }
 
+///Pipeline wrapper around DecodeSpill. The copy of the spill has the end of spill flag added to it, which we don't
+/// count towards the length of the spill. A flush has nothing to decode and goes straight to the builder, and a chunk
+/// of a column file only needs its hits filled in.
+bool Unpacker::DecodeStage(SpillData &spill) {
+    if (spill.isFlush) {
+        spill.maxModuleNumber = maxModuleDecoded_;
+        return true;
+    }
+    if (spill.isColumns)
+        return DecodeColumns(spill.columns, spill);
+    return DecodeSpill(&spill.words[0], spill.words.size() - 2, spill.isVerbose, spill);
+}
+
+///Pipeline wrapper around BuildRawEvents.
+bool Unpacker::BuildStage(SpillData &spill) {
+    BuildRawEvents(spill);
+    return true;
+}
+
+///Pipeline wrapper around ProcessRawEvents.
+bool Unpacker::ProcessStage(SpillData &spill) {
+    ProcessRawEvents(spill);
+    return false;
+}
+
+/** Decode, build and process spills on three threads that are connected by bounded queues.
+  * \param[in]  depth The maximum number of spills in the pipeline at once.
+  * \return Nothing.
+  */
+void Unpacker::StartPipeline(const unsigned int &depth/*=4*/) {
+    if (IsPipelined())
+        return;
+
+    const unsigned int numberOfSpills = depth == 0 ? 1 : depth;
+    freeSpills_.Reset(numberOfSpills);
+    decodeQueue_.Reset(numberOfSpills);
+    buildQueue_.Reset(numberOfSpills);
+    processQueue_.Reset(numberOfSpills);
+    spillsInFlight_ = 0;
+    pipelineError_ = std::exception_ptr();
+
+    for (unsigned int i = 0; i < numberOfSpills; i++) {
+        pipelineSpills_.push_back(new SpillData());
+        freeSpills_.Push(pipelineSpills_.back());
+    }
+
+    pipelineThreads_.push_back(std::thread(&Unpacker::RunPipelineStage, this, &decodeQueue_, &buildQueue_,
+                                           &Unpacker::DecodeStage));
+    pipelineThreads_.push_back(std::thread(&Unpacker::RunPipelineStage, this, &buildQueue_, &processQueue_,
+                                           &Unpacker::BuildStage));
+    pipelineThreads_.push_back(std::thread(&Unpacker::RunPipelineStage, this, &processQueue_,
+                                           (BoundedQueue<SpillData *> *) NULL, &Unpacker::ProcessStage));
+}
+
+/** Wait until every spill passed to ReadSpill has been processed.
+  * \return Nothing.
+  */
+void Unpacker::WaitForPipeline() {
+    if (!IsPipelined())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(pipelineMutex_);
+        while (spillsInFlight_ != 0 && !pipelineError_)
+            pipelineIdle_.wait(lock);
+    }
+
+    CheckPipeline();
+}
+
+/** Finish processing the spills in the pipeline and join the threads. Closing the decoder's queue lets each stage
+  * drain its input and then close the queue of the stage after it.
+  * \return Nothing.
+  */
+void Unpacker::StopPipeline() {
+    if (!IsPipelined())
+        return;
+
+    decodeQueue_.Close();
+    for (vector<std::thread>::iterator it = pipelineThreads_.begin(); it != pipelineThreads_.end(); it++)
+        it->join();
+    pipelineThreads_.clear();
+
+    for (vector<SpillData *>::iterator it = pipelineSpills_.begin(); it != pipelineSpills_.end(); it++) {
+        (*it)->Clear();
+        delete *it;
+    }
+    pipelineSpills_.clear();
+    spillsInFlight_ = 0;
+}
+
+/** Runs one stage of the pipeline.
+  * \param[in] input  The queue that feeds this stage.
+  * \param[in] output The queue that feeds the next stage, NULL for the last stage.
+  * \param[in] stage  The method to call for each spill.
+  * \return Nothing.
+  */
+void Unpacker::RunPipelineStage(BoundedQueue<SpillData *> *input, BoundedQueue<SpillData *> *output,
+                                bool (Unpacker::*stage)(SpillData &)) {
+    SpillData *spill;
+    while (input->Pop(spill)) {
+        try {
+            if (!(this->*stage)(*spill) || !output)
+                RecycleSpill(spill);
+            else
+                output->Push(spill);
+        } catch (...) {
+            AbortPipeline(std::current_exception());
+            return;
+        }
+    }
+
+    if (output)
+        output->Close();
+}
+
+/** Clears a spill and makes it available to ReadSpill again.
+  * \param[in] spill The spill that has left the pipeline.
+  * \return Nothing.
+  */
+void Unpacker::RecycleSpill(SpillData *spill) {
+    spill->Clear();
+    freeSpills_.Push(spill);
+
+    std::lock_guard<std::mutex> lock(pipelineMutex_);
+    spillsInFlight_--;
+    pipelineIdle_.notify_all();
+}
+
+/** Records an exception thrown on a pipeline thread and closes every queue so that all of the threads exit.
+  * \param[in] error The exception that was thrown.
+  * \return Nothing.
+  */
+void Unpacker::AbortPipeline(std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        if (!pipelineError_)
+            pipelineError_ = error;
+        pipelineIdle_.notify_all();
+    }
+
+    freeSpills_.Close();
+    decodeQueue_.Close();
+    buildQueue_.Close();
+    processQueue_.Close();
+}
+
+/** Stops the pipeline and rethrows the exception if one of the pipeline threads failed.
+  * \return Nothing.
+  */
+void Unpacker::CheckPipeline() {
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        error = pipelineError_;
+        pipelineError_ = std::exception_ptr();
+    }
+
+    if (error) {
+        StopPipeline();
+        std::rethrow_exception(error);
+    }
+}
+
 /** Write all recorded channel counts to a file.
   * \return Nothing.
   */
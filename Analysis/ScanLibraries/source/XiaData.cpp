@@ -17,5 +17,5 @@ void XiaData::Initialize() {
 
     eSums_.clear();
     qdc_.clear();
-    trace_.clear();
+    trace_.Clear();
 }
\ No newline at end of file
@@ -0,0 +1,296 @@
+///@file XiaDataColumns.cpp
+///@brief Writes the decoded XiaData of each spill to a chunked, column oriented binary file and reads them back.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <stdexcept>
+
+#include <cstring>
+
+#include "XiaDataColumns.hpp"
+
+using namespace std;
+using namespace XiaDataColumns;
+
+namespace {
+    ///@return The number of bytes taken by a column of n values, padded to a multiple of eight.
+    template<typename T>
+    size_t ColumnSize(const size_t &n) { return (n * sizeof(T) + 7) & ~((size_t) 7); }
+
+    ///@return The column at the cursor, which is moved to the start of the next column.
+    template<typename T>
+    T *TakeColumn(char *&cursor, const size_t &n) {
+        T *column = reinterpret_cast<T *>(cursor);
+        cursor += ColumnSize<T>(n);
+        return column;
+    }
+
+    ///@return The column at the cursor, which is moved to the start of the next column.
+    template<typename T>
+    const T *TakeColumn(const char *&cursor, const size_t &n) {
+        const T *column = reinterpret_cast<const T *>(cursor);
+        cursor += ColumnSize<T>(n);
+        return column;
+    }
+
+    ///@return The size of the columns whose length only depends on the number of hits.
+    size_t FixedColumnsSize(const size_t &n) {
+        return 5 * ColumnSize<double>(n) + 5 * ColumnSize<unsigned int>(n) + 4 * ColumnSize<unsigned char>(n)
+               + 2 * ColumnSize<unsigned int>(n + 1);
+    }
+
+    ///@return True if the n + 1 offsets never decrease.
+    bool AreOffsetsOrdered(const unsigned int *offsets, const size_t &n) {
+        for (size_t i = 0; i < n; i++)
+            if (offsets[i] > offsets[i + 1])
+                return false;
+        return true;
+    }
+}
+
+bool XiaDataColumns::ReadFileHeader(const char *data, const size_t &nBytes, unsigned int &flags) {
+    if (!data || nBytes < FILE_HEADER_SIZE)
+        return false;
+
+    unsigned int header[4];
+    memcpy(header, data, FILE_HEADER_SIZE);
+    if (header[0] != FILE_MAGIC || header[1] != VERSION)
+        return false;
+
+    flags = header[2];
+    return true;
+}
+
+bool XiaDataColumnWriter::Open(const std::string &fileName, const bool &withTraces/*=false*/) {
+    Close();
+
+    file_.open(fileName.c_str(), ios::binary | ios::trunc);
+    if (!file_.is_open())
+        return false;
+
+    withTraces_ = withTraces;
+    numberOfChunks_ = 0;
+    numberOfHits_ = 0;
+
+    const unsigned int header[4] = {FILE_MAGIC, VERSION, withTraces_ ? HAS_TRACES : 0, 0};
+    file_.write((const char *) header, FILE_HEADER_SIZE);
+    return file_.good();
+}
+
+void XiaDataColumnWriter::Close() {
+    if (file_.is_open())
+        file_.close();
+}
+
+///The variable length columns are gathered first, so that we know how big the chunk is. The chunk is then built in
+/// memory and written in one go.
+void XiaDataColumnWriter::Write(const std::vector<std::deque<XiaData *> > &eventList) {
+    if (!IsOpen())
+        throw runtime_error("XiaDataColumnWriter::Write - The column file isn't open.");
+
+    hits_.clear();
+    for (vector<deque<XiaData *> >::const_iterator it = eventList.begin(); it != eventList.end(); it++)
+        hits_.insert(hits_.end(), it->begin(), it->end());
+    if (hits_.empty())
+        return;
+
+    const size_t n = hits_.size();
+    size_t numberOfSamples = 0;
+    qdcs_.clear();
+    sums_.clear();
+    qdcOffsets_.clear();
+    sumOffsets_.clear();
+    for (vector<const XiaData *>::const_iterator it = hits_.begin(); it != hits_.end(); it++) {
+        const vector<unsigned int> qdc = (*it)->GetQdc();
+        const vector<unsigned int> sums = (*it)->GetEnergySums();
+        qdcOffsets_.push_back((unsigned int) qdcs_.size());
+        sumOffsets_.push_back((unsigned int) sums_.size());
+        qdcs_.insert(qdcs_.end(), qdc.begin(), qdc.end());
+        sums_.insert(sums_.end(), sums.begin(), sums.end());
+        if (withTraces_)
+            numberOfSamples += (*it)->GetTraceLength();
+    }
+    qdcOffsets_.push_back((unsigned int) qdcs_.size());
+    sumOffsets_.push_back((unsigned int) sums_.size());
+
+    size_t length = CHUNK_HEADER_SIZE + FixedColumnsSize(n) + ColumnSize<unsigned int>(qdcs_.size())
+                    + ColumnSize<unsigned int>(sums_.size());
+    if (withTraces_)
+        length += ColumnSize<unsigned int>(n + 1) + ColumnSize<unsigned short>(numberOfSamples);
+    chunk_.assign(length, 0);
+
+    const unsigned int header[4] = {CHUNK_MAGIC, (unsigned int) n, withTraces_ ? HAS_TRACES : 0, 0};
+    const unsigned long long chunkLength = length;
+    memcpy(&chunk_[0], header, sizeof(header));
+    memcpy(&chunk_[sizeof(header)], &chunkLength, sizeof(chunkLength));
+
+    char *cursor = &chunk_[CHUNK_HEADER_SIZE];
+    double *times = TakeColumn<double>(cursor, n);
+    double *filterTimes = TakeColumn<double>(cursor, n);
+    double *energies = TakeColumn<double>(cursor, n);
+    double *baselines = TakeColumn<double>(cursor, n);
+    double *externalTimestamps = TakeColumn<double>(cursor, n);
+    unsigned int *eventTimeLows = TakeColumn<unsigned int>(cursor, n);
+    unsigned int *eventTimeHighs = TakeColumn<unsigned int>(cursor, n);
+    unsigned int *externalTimeLows = TakeColumn<unsigned int>(cursor, n);
+    unsigned int *externalTimeHighs = TakeColumn<unsigned int>(cursor, n);
+    unsigned int *cfdTimes = TakeColumn<unsigned int>(cursor, n);
+    unsigned char *crates = TakeColumn<unsigned char>(cursor, n);
+    unsigned char *slots = TakeColumn<unsigned char>(cursor, n);
+    unsigned char *channels = TakeColumn<unsigned char>(cursor, n);
+    unsigned char *flags = TakeColumn<unsigned char>(cursor, n);
+    unsigned int *qdcOffsets = TakeColumn<unsigned int>(cursor, n + 1);
+    unsigned int *sumOffsets = TakeColumn<unsigned int>(cursor, n + 1);
+    unsigned int *qdcs = TakeColumn<unsigned int>(cursor, qdcs_.size());
+    unsigned int *sums = TakeColumn<unsigned int>(cursor, sums_.size());
+    unsigned int *traceOffsets = withTraces_ ? TakeColumn<unsigned int>(cursor, n + 1) : NULL;
+    unsigned short *samples = withTraces_ ? TakeColumn<unsigned short>(cursor, numberOfSamples) : NULL;
+
+    unsigned int traceOffset = 0;
+    for (size_t i = 0; i < n; i++) {
+        const XiaData *hit = hits_[i];
+        times[i] = hit->GetTime();
+        filterTimes[i] = hit->GetFilterTime();
+        energies[i] = hit->GetEnergy();
+        baselines[i] = hit->GetFilterBaseline();
+        externalTimestamps[i] = hit->GetExternalTimestamp();
+        eventTimeLows[i] = hit->GetEventTimeLow();
+        eventTimeHighs[i] = hit->GetEventTimeHigh();
+        externalTimeLows[i] = hit->GetExternalTimeLow();
+        externalTimeHighs[i] = hit->GetExternalTimeHigh();
+        cfdTimes[i] = hit->GetCfdFractionalTime();
+        crates[i] = (unsigned char) hit->GetCrateNumber();
+        slots[i] = (unsigned char) hit->GetSlotNumber();
+        channels[i] = (unsigned char) hit->GetChannelNumber();
+        flags[i] = (unsigned char) ((hit->GetCfdForcedTriggerBit() ? CFD_FORCED_TRIGGER : 0)
+                                    | (hit->IsPileup() ? PILEUP : 0) | (hit->IsSaturated() ? SATURATED : 0)
+                                    | (hit->IsVirtualChannel() ? VIRTUAL_CHANNEL : 0)
+                                    | (hit->GetCfdTriggerSourceBit() ? CFD_TRIGGER_SOURCE : 0));
+
+        // The trace may still be in the spill buffer, we copy it from there rather than resolving the reference.
+        if (withTraces_) {
+            traceOffsets[i] = traceOffset;
+            if (hit->GetTraceLength() != 0)
+                memcpy(samples + traceOffset, hit->GetRawTraceData(), hit->GetTraceLength() * sizeof(unsigned short));
+            traceOffset += (unsigned int) hit->GetTraceLength();
+        }
+    }
+    if (withTraces_)
+        traceOffsets[n] = traceOffset;
+
+    memcpy(qdcOffsets, &qdcOffsets_[0], (n + 1) * sizeof(unsigned int));
+    memcpy(sumOffsets, &sumOffsets_[0], (n + 1) * sizeof(unsigned int));
+    if (!qdcs_.empty())
+        memcpy(qdcs, &qdcs_[0], qdcs_.size() * sizeof(unsigned int));
+    if (!sums_.empty())
+        memcpy(sums, &sums_[0], sums_.size() * sizeof(unsigned int));
+
+    file_.write(&chunk_[0], length);
+    if (!file_.good())
+        throw runtime_error("XiaDataColumnWriter::Write - Unable to write chunk #" + to_string(numberOfChunks_)
+                            + " to the column file.");
+    numberOfChunks_++;
+    numberOfHits_ += n;
+}
+
+void XiaDataColumnChunk::Clear() {
+    numberOfHits_ = 0;
+    times_ = filterTimes_ = energies_ = baselines_ = externalTimestamps_ = NULL;
+    eventTimeLows_ = eventTimeHighs_ = externalTimeLows_ = externalTimeHighs_ = cfdTimes_ = NULL;
+    crates_ = slots_ = channels_ = flags_ = NULL;
+    qdcOffsets_ = sumOffsets_ = qdcs_ = sums_ = traceOffsets_ = NULL;
+    samples_ = NULL;
+}
+
+///Every length and offset in the chunk is checked against the number of bytes that we were given, so that a
+/// truncated or corrupted file can't send Fill outside of the chunk.
+size_t XiaDataColumnChunk::Parse(const char *data, const size_t &nBytes) {
+    Clear();
+    if (!data || nBytes < CHUNK_HEADER_SIZE)
+        return 0;
+
+    unsigned int header[4];
+    unsigned long long length;
+    memcpy(header, data, sizeof(header));
+    memcpy(&length, data + sizeof(header), sizeof(length));
+
+    const size_t n = header[1];
+    size_t expected = CHUNK_HEADER_SIZE + FixedColumnsSize(n);
+    if (header[0] != CHUNK_MAGIC || length > nBytes || expected > length)
+        return 0;
+
+    const char *cursor = data + CHUNK_HEADER_SIZE;
+    times_ = TakeColumn<double>(cursor, n);
+    filterTimes_ = TakeColumn<double>(cursor, n);
+    energies_ = TakeColumn<double>(cursor, n);
+    baselines_ = TakeColumn<double>(cursor, n);
+    externalTimestamps_ = TakeColumn<double>(cursor, n);
+    eventTimeLows_ = TakeColumn<unsigned int>(cursor, n);
+    eventTimeHighs_ = TakeColumn<unsigned int>(cursor, n);
+    externalTimeLows_ = TakeColumn<unsigned int>(cursor, n);
+    externalTimeHighs_ = TakeColumn<unsigned int>(cursor, n);
+    cfdTimes_ = TakeColumn<unsigned int>(cursor, n);
+    crates_ = TakeColumn<unsigned char>(cursor, n);
+    slots_ = TakeColumn<unsigned char>(cursor, n);
+    channels_ = TakeColumn<unsigned char>(cursor, n);
+    flags_ = TakeColumn<unsigned char>(cursor, n);
+    qdcOffsets_ = TakeColumn<unsigned int>(cursor, n + 1);
+    sumOffsets_ = TakeColumn<unsigned int>(cursor, n + 1);
+
+    expected += ColumnSize<unsigned int>(qdcOffsets_[n]) + ColumnSize<unsigned int>(sumOffsets_[n]);
+    if (header[2] & HAS_TRACES)
+        expected += ColumnSize<unsigned int>(n + 1);
+    if (expected > length || !AreOffsetsOrdered(qdcOffsets_, n) || !AreOffsetsOrdered(sumOffsets_, n)) {
+        Clear();
+        return 0;
+    }
+
+    qdcs_ = TakeColumn<unsigned int>(cursor, qdcOffsets_[n]);
+    sums_ = TakeColumn<unsigned int>(cursor, sumOffsets_[n]);
+    if (header[2] & HAS_TRACES) {
+        traceOffsets_ = TakeColumn<unsigned int>(cursor, n + 1);
+        expected += ColumnSize<unsigned short>(traceOffsets_[n]);
+        if (expected > length || !AreOffsetsOrdered(traceOffsets_, n)) {
+            Clear();
+            return 0;
+        }
+        samples_ = TakeColumn<unsigned short>(cursor, traceOffsets_[n]);
+    }
+
+    if (expected != length) {
+        Clear();
+        return 0;
+    }
+
+    numberOfHits_ = n;
+    return length;
+}
+
+void XiaDataColumnChunk::Fill(const size_t &i, XiaData *data) const {
+    data->SetTime(times_[i]);
+    data->SetFilterTime(filterTimes_[i]);
+    data->SetEnergy(energies_[i]);
+    data->SetFilterBaseline(baselines_[i]);
+    data->SetExternalTimestamp(externalTimestamps_[i]);
+    data->SetEventTimeLow(eventTimeLows_[i]);
+    data->SetEventTimeHigh(eventTimeHighs_[i]);
+    data->SetExternalTimeLow(externalTimeLows_[i]);
+    data->SetExternalTimeHigh(externalTimeHighs_[i]);
+    data->SetCfdFractionalTime(cfdTimes_[i]);
+    data->SetCrateNumber(crates_[i]);
+    data->SetSlotNumber(slots_[i]);
+    data->SetChannelNumber(channels_[i]);
+
+    const unsigned char flags = flags_[i];
+    data->SetCfdForcedTriggerBit((flags & CFD_FORCED_TRIGGER) != 0);
+    data->SetPileup((flags & PILEUP) != 0);
+    data->SetSaturation((flags & SATURATED) != 0);
+    data->SetVirtualChannel((flags & VIRTUAL_CHANNEL) != 0);
+    data->SetCfdTriggerSourceBit((flags & CFD_TRIGGER_SOURCE) != 0);
+
+    if (qdcOffsets_[i] != qdcOffsets_[i + 1])
+        data->SetQdc(qdcs_ + qdcOffsets_[i], qdcs_ + qdcOffsets_[i + 1]);
+    if (sumOffsets_[i] != sumOffsets_[i + 1])
+        data->SetEnergySums(sums_ + sumOffsets_[i], sums_ + sumOffsets_[i + 1]);
+    if (traceOffsets_ && traceOffsets_[i] != traceOffsets_[i + 1])
+        data->SetTraceReference(samples_ + traceOffsets_[i], samples_ + traceOffsets_[i + 1]);
+}
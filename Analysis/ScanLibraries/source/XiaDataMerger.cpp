@@ -0,0 +1,70 @@
+///@file XiaDataMerger.cpp
+///@brief Merges the time sorted hits from each module into a single time ordered stream.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <algorithm>
+
+#include "XiaDataMerger.hpp"
+
+using namespace std;
+
+///The modules write their data out in time order, so the streams are usually sorted already. We check before sorting
+/// since std::is_sorted is much cheaper than std::sort on sorted input.
+void XiaDataMerger::Initialize(std::vector<std::deque<XiaData *> > &streams) {
+    streams_ = &streams;
+    heap_.clear();
+
+    for (unsigned int i = 0; i < streams.size(); i++) {
+        if (streams[i].empty())
+            continue;
+        if (!is_sorted(streams[i].begin(), streams[i].end(), &XiaData::CompareTime))
+            sort(streams[i].begin(), streams[i].end(), &XiaData::CompareTime);
+        heap_.push_back(make_pair(streams[i].front()->GetFilterTime(), i));
+    }
+
+    make_heap(heap_.begin(), heap_.end(), Later());
+}
+
+void XiaDataMerger::Clear() {
+    heap_.clear();
+}
+
+///The next hit always comes from the stream at the top of the heap. If that stream still has hits we replace the top
+/// with its new head and sift it down, which costs a single pass instead of a pop followed by a push. The heap
+/// therefore never holds more than one entry per stream.
+XiaData *XiaDataMerger::Pop() {
+    if (heap_.empty())
+        return NULL;
+
+    unsigned int index = heap_.front().second;
+    deque<XiaData *> &stream = (*streams_)[index];
+    XiaData *data = stream.front();
+    stream.pop_front();
+
+    if (stream.empty()) {
+        pop_heap(heap_.begin(), heap_.end(), Later());
+        heap_.pop_back();
+    } else {
+        heap_.front().first = stream.front()->GetFilterTime();
+        SiftDown();
+    }
+
+    return data;
+}
+
+void XiaDataMerger::SiftDown() {
+    const size_t size = heap_.size();
+    const HeapEntry top = heap_.front();
+    Later later;
+    size_t hole = 0;
+
+    for (size_t child = 1; child < size; child = 2 * hole + 1) {
+        if (child + 1 < size && later(heap_[child], heap_[child + 1]))
+            child++;
+        if (!later(top, heap_[child]))
+            break;
+        heap_[hole] = heap_[child];
+        hole = child;
+    }
+    heap_[hole] = top;
+}
@@ -0,0 +1,24 @@
+///@file XiaDataPool.cpp
+///@brief A spill scoped pool that owns all of the XiaData objects decoded from a spill.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include "XiaDataPool.hpp"
+
+using namespace std;
+
+XiaDataPool::~XiaDataPool() {
+    for (vector<XiaData *>::iterator it = blocks_.begin(); it != blocks_.end(); it++)
+        delete[] *it;
+}
+
+///We only allocate when every object in every block is in use. The new block is kept for the lifetime of the pool
+/// so that the next spill of similar size can be decoded without going to the heap.
+XiaData *XiaDataPool::Acquire() {
+    if (numInUse_ == GetCapacity())
+        blocks_.push_back(new XiaData[blockSize_]);
+
+    XiaData *data = &blocks_[numInUse_ / blockSize_][numInUse_ % blockSize_];
+    numInUse_++;
+    data->Initialize();
+    return data;
+}
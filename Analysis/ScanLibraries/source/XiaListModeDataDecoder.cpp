@@ -7,6 +7,7 @@
 
 #include "HelperEnumerations.hpp"
 #include "HelperFunctions.hpp"
+#include "TraceCodec.h"
 
 #include <iostream>
 #include <sstream>
@@ -17,43 +18,132 @@
 using namespace std;
 using namespace DataProcessing;
 
-vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask) {
-
-    unsigned int *bufStart = buf;
-    ///@NOTE : These two pieces here are the Pixie Module Data Header. They
-    /// tell us the number of words read from the module (bufLen) and the VSN
-    /// of the module (module number).
-    unsigned int bufLen = *buf++;
-    unsigned int modNum = *buf++;
+///Releases the events that we decoded before we hit a bad buffer. Events that came from a pool are left alone since
+/// the pool will reclaim them at the end of the spill.
+static vector<XiaData *> DiscardEvents(vector<XiaData *> &events, XiaData *current, XiaDataPool *pool) {
+    if (!pool) {
+        for (vector<XiaData *>::iterator it = events.begin(); it != events.end(); it++)
+            delete *it;
+        delete current;
+    }
+    return vector<XiaData *>();
+}
 
+///Checks the Pixie Module Data Header at the start of the buffer.
+///@param[in] buf : Pointer to the beginning of the data buffer.
+///@return False if the buffer is empty.
+static bool HasEvents(const unsigned int *buf) {
     //A buffer length of zero is an issue, we'll throw a length error.
-    if (bufLen == 0)
+    if (buf[0] == 0)
         throw length_error("Unpacker::ReadBuffer - The buffer length was sized 0. This is a huge issue.");
 
     //For empty buffers we just return an empty vector.
     static const unsigned int emptyBufferLength = 2;
-    if (bufLen == emptyBufferLength)
+    return buf[0] != emptyBufferLength;
+}
+
+///Sets the filter and CFD times of the hit. This is CalculateTimeInSamples with the frequency fixed at compile time,
+/// so that the compiler can drop the branches for the other frequencies.
+///@param[in] data : The hit that we are going to set the times for
+///@param[in] cfdSize : The value that the CFD fractional time is divided by
+template<unsigned int Frequency>
+static inline void SetTimes(XiaData &data, const double &cfdSize) {
+    double filterTime = Conversions::ConcatenateWords(data.GetEventTimeLow(), data.GetEventTimeHigh(), 32);
+    data.SetFilterTime(filterTime);
+
+    if (data.GetCfdFractionalTime() == 0 || data.GetCfdForcedTriggerBit()) {
+        data.SetTime(filterTime);
+        return;
+    }
+
+    double cfdTime = 0, multiplier = 1;
+    if (Frequency == 100)
+        cfdTime = data.GetCfdFractionalTime() / cfdSize;
+
+    if (Frequency == 250) {
+        multiplier = 2;
+        cfdTime = data.GetCfdFractionalTime() / cfdSize - data.GetCfdTriggerSourceBit();
+    }
+
+    if (Frequency == 500) {
+        multiplier = 10;
+        cfdTime = data.GetCfdFractionalTime() / cfdSize + data.GetCfdTriggerSourceBit() - 1;
+    }
+
+    data.SetTime(filterTime * multiplier + cfdTime);
+}
+
+///We resolve the mask here, after the empty buffer checks, so that an empty buffer never needs a valid mask.
+vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask,
+                                                       XiaDataPool *pool) {
+    if (!HasEvents(buf))
         return vector<XiaData *>();
+    return DecodeBuffer(buf, XiaListModeDataLayout(mask), pool);
+}
+
+///This is the only place that we look at the frequency. Everything below it is fixed when the kernel is compiled.
+vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataLayout &layout,
+                                                       XiaDataPool *pool) {
+    if (!HasEvents(buf))
+        return vector<XiaData *>();
+
+    switch (layout.frequency) {
+        case 100:
+            return DecodeEvents<100>(buf, layout, pool);
+        case 250:
+            return DecodeEvents<250>(buf, layout, pool);
+        case 500:
+            return DecodeEvents<500>(buf, layout, pool);
+        default:
+            return DecodeEvents<0>(buf, layout, pool);
+    }
+}
+
+template<unsigned int Frequency>
+vector<XiaData *> XiaListModeDataDecoder::DecodeEvents(unsigned int *buf, const XiaListModeDataLayout &layout,
+                                                       XiaDataPool *pool) {
+    unsigned int *bufStart = buf;
+    ///@NOTE : These two pieces here are the Pixie Module Data Header. They
+    /// tell us the number of words read from the module (bufLen) and the VSN
+    /// of the module (module number).
+    unsigned int bufLen = *buf++;
+    unsigned int modNum = *buf++;
 
-    stringstream msg;
     vector<XiaData *> events;
-    static unsigned int numSkippedBuffers = 0;
 
     while (buf < bufStart + bufLen) {
-        XiaData *data = new XiaData();
+        XiaData *data = pool ? pool->Acquire() : new XiaData();
         bool hasExternalTimestamp = false;
         bool hasQdc = false;
         bool hasEnergySums = false;
 
-        pair<unsigned int, unsigned int> lengths = DecodeWordZero(buf[0], *data, mask);
-        unsigned int headerLength = lengths.first;
-        unsigned int eventLength = lengths.second;
+        const unsigned int wordZero = buf[0];
+        const unsigned int wordTwo = buf[2];
+        const unsigned int wordThree = buf[3];
 
-        data->SetEventTimeLow(buf[1]);
-        DecodeWordTwo(buf[2], *data, mask);
-        unsigned int traceLength = DecodeWordThree(buf[3], *data, mask);
+        unsigned int headerLength = (wordZero & layout.headerLengthMask) >> layout.headerLengthShift;
+        unsigned int eventLength = (wordZero & layout.eventLengthMask) >> layout.eventLengthShift;
+        unsigned int traceLength = (wordThree & layout.traceLengthMask) >> layout.traceLengthShift;
+
+        data->SetChannelNumber(wordZero & layout.channelNumberMask);
+        data->SetSlotNumber((wordZero & layout.slotIdMask) >> layout.slotIdShift);
+        data->SetCrateNumber((wordZero & layout.crateIdMask) >> layout.crateIdShift);
+        data->SetPileup((wordZero & layout.finishCodeMask) != 0);
+        //Only one of the two masks is ever set, depending on where the firmware keeps the Trace-out-of-range flag.
+        data->SetSaturation(((wordZero & layout.wordZeroSaturationMask)
+                             | (wordThree & layout.wordThreeSaturationMask)) != 0);
 
-        unsigned int externalTimestampOffset = headerLength - mask.GetNumberOfExternalTimestampWords();
+        data->SetEventTimeLow(buf[1]);
+        data->SetEventTimeHigh(wordTwo & layout.eventTimeHighMask);
+        data->SetCfdFractionalTime((wordTwo & layout.cfdFractionalTimeMask) >> layout.cfdFractionalTimeShift);
+        data->SetCfdForcedTriggerBit((wordTwo & layout.cfdForcedTriggerBitMask) != 0);
+        ///@TODO The cast to bool happens before the shift, so the trigger source is always false. This is what the
+        /// decoder has always done. Fixing it changes the CFD times at 250 and 500 MS/s, so it needs to be
+        /// validated on its own.
+        data->SetCfdTriggerSourceBit((bool) (wordTwo & layout.cfdTriggerSourceMask) >> layout.cfdTriggerSourceShift);
+        data->SetEnergy(wordThree & layout.eventEnergyMask);
+
+        unsigned int externalTimestampOffset = headerLength - layout.numberOfExternalTimestampWords;
         unsigned int energySumsOffset = 0;
         unsigned int qdcOffset = 0;
 
@@ -61,6 +151,8 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
             case STATS_BLOCK :
                 // Manual statistics block inserted by poll
                 //stats.DoStatisticsBlock(&buf[1], modNum);
+                if (!pool)
+                    delete data;
                 buf += eventLength;
                 //numEvents = -10;
                 continue;
@@ -71,39 +163,39 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
                 break;
             case HEADER_W_QDC :
                 hasQdc = true;
-                qdcOffset = headerLength - mask.GetNumberOfQdcWords();
+                qdcOffset = headerLength - layout.numberOfQdcWords;
                 break;
             case HEADER_W_ESUM :
                 hasEnergySums = true;
-                energySumsOffset = headerLength - mask.GetNumberOfEnergySumWords();
+                energySumsOffset = headerLength - layout.numberOfEnergySumWords;
                 break;
             case HEADER_W_ESUM_ETS :
                 hasExternalTimestamp = hasEnergySums = true;
-                energySumsOffset = headerLength - mask.GetNumberOfEnergySumWords() - mask.GetNumberOfExternalTimestampWords();
+                energySumsOffset = headerLength - layout.numberOfEnergySumWords - layout.numberOfExternalTimestampWords;
                 break;
             case HEADER_W_ESUM_QDC :
                 hasEnergySums = hasQdc = true;
-                energySumsOffset = headerLength - mask.GetNumberOfEnergySumWords() - mask.GetNumberOfQdcWords();
-                qdcOffset = headerLength - mask.GetNumberOfQdcWords();
+                energySumsOffset = headerLength - layout.numberOfEnergySumWords - layout.numberOfQdcWords;
+                qdcOffset = headerLength - layout.numberOfQdcWords;
                 break;
             case HEADER_W_ESUM_QDC_ETS :
                 hasEnergySums = hasExternalTimestamp = hasQdc = true;
-                energySumsOffset = headerLength - mask.GetNumberOfExternalTimestampWords() - mask.GetNumberOfQdcWords() -
-                                                                                             mask .GetNumberOfEnergySumWords();
-                qdcOffset = headerLength - mask.GetNumberOfExternalTimestampWords() - mask.GetNumberOfQdcWords();
+                energySumsOffset = headerLength - layout.numberOfExternalTimestampWords - layout.numberOfQdcWords -
+                                   layout.numberOfEnergySumWords;
+                qdcOffset = headerLength - layout.numberOfExternalTimestampWords - layout.numberOfQdcWords;
                 break;
             case HEADER_W_QDC_ETS :
                 hasQdc = hasExternalTimestamp = true;
-                qdcOffset = headerLength - mask.GetNumberOfExternalTimestampWords() - mask.GetNumberOfQdcWords();
+                qdcOffset = headerLength - layout.numberOfExternalTimestampWords - layout.numberOfQdcWords;
                 break;
             default:
-                numSkippedBuffers++;
+                numSkippedBuffers_++;
                 cerr << "XiaListModeDataDecoder::ReadBuffer : We encountered an unrecognized header length (" << headerLength
-                     << "). " << endl << "Skipped " << numSkippedBuffers << " buffers in the file." << endl
+                     << "). " << endl << "Skipped " << numSkippedBuffers_ << " buffers with this decoder." << endl
                      << "Unexpected header length: " << headerLength << endl << "ReadBuffer:   Buffer " << modNum << " of length "
                      << bufLen << endl << "ReadBuffer:   CRATE:SLOT(MOD):CHAN " << data->GetCrateNumber() << ":"
                      << data->GetSlotNumber() << "(" << modNum << "):" << data->GetChannelNumber() << endl;
-                return vector<XiaData *>();
+                return DiscardEvents(events, data, pool);
         }
 
         if (hasExternalTimestamp) {
@@ -114,21 +206,13 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
         }
 
         if (hasEnergySums) {
-            vector<unsigned int> tmp;
-            for(unsigned int i = 0; i < mask.GetNumberOfEnergySumWords() - 1; i++)
-                tmp.push_back(buf[energySumsOffset + i]);
-            data->SetEnergySums(tmp);
+            data->SetEnergySums(&buf[energySumsOffset], &buf[energySumsOffset + layout.numberOfEnergySumWords - 1]);
             data->SetFilterBaseline(IeeeStandards::IeeeFloatingToDecimal(buf[energySumsOffset +
-                    mask.GetNumberOfEnergySumWords() - 1]));
+                    layout.numberOfEnergySumWords - 1]));
         }
 
-        if (hasQdc) {
-            vector<unsigned int> tmp;
-            for (unsigned int i = 0; i < mask.GetNumberOfQdcWords(); i++) {
-                tmp.push_back(buf[qdcOffset + i]);
-            }
-            data->SetQdc(tmp);
-        }
+        if (hasQdc)
+            data->SetQdc(&buf[qdcOffset], &buf[qdcOffset + layout.numberOfQdcWords]);
 
         ///@TODO Figure out where to put this...
         //channel_counts[modNum][chanNum]++;
@@ -140,98 +224,65 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
             data->SetEnergy(65536);
 
         //We set the time according to the revision and firmware.
-        pair<double, double> times = CalculateTimeInSamples(mask, *data);
-        data->SetFilterTime(times.first);
-        data->SetTime(times.second);
+        SetTimes<Frequency>(*data, layout.cfdSize);
 
         // One last check to ensure event length matches what we think it
-        // should be.
-        if (traceLength / 2 + headerLength != eventLength) {
-            numSkippedBuffers++;
+        // should be. A compressed trace is shorter than the samples would be, but never empty.
+        const bool isCompressed = hasCompressedTraces_ && traceLength > 0 && eventLength > headerLength
+                                  && eventLength < traceLength / 2 + headerLength;
+        if (traceLength / 2 + headerLength != eventLength && !isCompressed) {
+            numSkippedBuffers_++;
             cerr << "XiaListModeDataDecoder::ReadBuffer : Event"
                     "length (" << eventLength << ") does not correspond to "
                          "header length (" << headerLength
                  << ") and trace length ("
                  << traceLength / 2 << "). Skipped a total of "
-                 << numSkippedBuffers << " buffers in this file." << endl;
-            return vector<XiaData *>();
+                 << numSkippedBuffers_ << " buffers with this decoder." << endl;
+            return DiscardEvents(events, data, pool);
         } else //Advance the buffer past the header and to the trace
             buf += headerLength;
 
         if (traceLength > 0) {
-            DecodeTrace(buf, *data, traceLength);
-            buf += traceLength / 2;
+            if (!DecodeTrace(buf, *data, traceLength, eventLength - headerLength)) {
+                numSkippedBuffers_++;
+                cerr << "XiaListModeDataDecoder::ReadBuffer : Unable to decompress the trace of CRATE:SLOT(MOD):CHAN "
+                     << data->GetCrateNumber() << ":" << data->GetSlotNumber() << "(" << modNum << "):"
+                     << data->GetChannelNumber() << ". Skipped a total of " << numSkippedBuffers_
+                     << " buffers with this decoder." << endl;
+                return DiscardEvents(events, data, pool);
+            }
+            buf += eventLength - headerLength;
         }
         events.push_back(data);
     }// while(buf < bufStart + bufLen)
     return events;
 }
 
-std::pair<unsigned int, unsigned int> XiaListModeDataDecoder::DecodeWordZero(const unsigned int &word, XiaData &data,
-                                                                             const XiaListModeDataMask &mask) {
-
-    data.SetChannelNumber(word & mask.GetChannelNumberMask().first);
-    data.SetSlotNumber((word & mask.GetSlotIdMask().first) >> mask.GetSlotIdMask().second);
-    data.SetCrateNumber((word & mask.GetCrateIdMask().first) >> mask.GetCrateIdMask().second);
-    data.SetPileup((word & mask.GetFinishCodeMask().first) != 0);
-
-    //We have to check if we have one of these three firmwares since they
-    // have the Trace-Out-of-Range flag in this word.
-    switch (mask.GetFirmware()) {
-        case R17562:
-        case R20466:
-        case R27361:
-            data.SetSaturation((bool) ((word & mask.GetTraceOutOfRangeFlagMask().first)
-                    >> mask.GetTraceOutOfRangeFlagMask().second));
-            break;
-        default:
-            break;
-    }
-
-    return make_pair((word & mask.GetHeaderLengthMask().first) >> mask.GetHeaderLengthMask().second,
-                     (word & mask.GetEventLengthMask().first) >> mask.GetEventLengthMask().second);
-}
-
-void XiaListModeDataDecoder::DecodeWordTwo(const unsigned int &word, XiaData &data, const XiaListModeDataMask &mask) {
-    data.SetEventTimeHigh(word & mask.GetEventTimeHighMask().first);
-    data.SetCfdFractionalTime((word & mask.GetCfdFractionalTimeMask().first) >> mask.GetCfdFractionalTimeMask().second);
-    data.SetCfdForcedTriggerBit(
-            (bool) ((word & mask.GetCfdForcedTriggerBitMask().first) >> mask.GetCfdForcedTriggerBitMask().second));
-    data.SetCfdTriggerSourceBit(
-            (bool) (word & mask.GetCfdTriggerSourceMask().first) >> mask.GetCfdTriggerSourceMask().second);
-}
-
-unsigned int XiaListModeDataDecoder::DecodeWordThree(const unsigned int &word, XiaData &data,
-                                                     const XiaListModeDataMask &mask) {
-    data.SetEnergy(word & mask.GetEventEnergyMask().first);
-
-    //Reverse the logic that we used in DecodeWordZero, since if we do not
-    // have these three firmwares we need to check this word for the
-    // Trace-Out-of-Range flag.
-    switch (mask.GetFirmware()) {
-        case R17562:
-        case R20466:
-        case R27361:
-            break;
-        default:
-            data.SetSaturation((bool) ((word & mask.GetTraceOutOfRangeFlagMask().first)
-                    >> mask.GetTraceOutOfRangeFlagMask().second));
-            break;
-    }
-
-    return ((word & mask.GetTraceLengthMask().first) >> mask.GetTraceLengthMask().second);
-}
-
-void XiaListModeDataDecoder::DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength) {
-    vector<unsigned int> tmp;
+bool XiaListModeDataDecoder::DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength,
+                                         const unsigned int &traceWords) {
     // sbuf points to the beginning of trace data
     unsigned short *sbuf = (unsigned short *) buf;
 
-    // Read the trace data (2-bytes per sample, i.e. 2 samples per word)
-    for (unsigned int k = 0; k < traceLength; k++)
-        tmp.push_back((unsigned int &&) sbuf[k]);
+    // Channels that nobody analyzes don't get a trace at all, we don't even decompress it.
+    if (!traceChannels_.empty() && data.GetId() < traceChannels_.size() && !traceChannels_[data.GetId()])
+        return true;
+
+    if (traceWords != traceLength / 2) {
+        if (samples_.size() < traceLength)
+            samples_.resize(traceLength);
+        if (!TraceCodec::Decompress(buf, traceWords, &samples_[0], traceLength))
+            return false;
+        data.SetTrace(&samples_[0], &samples_[0] + traceLength);
+        return true;
+    }
 
-    data.SetTrace(tmp);
+    // Read the trace data (2-bytes per sample, i.e. 2 samples per word) straight into the trace storage. The samples
+    // are stored as 16-bit words so this is a plain copy, or no copy at all if we only refer to them.
+    if (hasTraceReferences_)
+        data.SetTraceReference(sbuf, sbuf + traceLength);
+    else
+        data.SetTrace(sbuf, sbuf + traceLength);
+    return true;
 }
 
 pair<double, double> XiaListModeDataDecoder::CalculateTimeInSamples(const XiaListModeDataMask &mask,
@@ -43,7 +43,7 @@ std::vector<unsigned int> XiaListModeDataEncoder::EncodeXiaData(const XiaData &d
         header.push_back(data.GetExternalTimeHigh());
     }
 
-    if (data.GetTrace().size() != 0) {
+    if (data.GetRawTrace().size() != 0) {
         vector<unsigned int> tmp = EncodeTrace(data.GetTrace(), mask_.GetTraceMask());
         header.insert(header.end(), tmp.begin(), tmp.end());
     }
@@ -62,7 +62,7 @@ unsigned int XiaListModeDataEncoder::EncodeWordZero(const XiaData &data, const X
         headerLength += mask.GetNumberOfEnergySumWords();
     if (data.GetQdc().size() != 0)
         headerLength += mask.GetNumberOfQdcWords();
-    unsigned int eventLength = (unsigned int) ceil(data.GetTrace().size() * 0.5) + headerLength;
+    unsigned int eventLength = (unsigned int) ceil(data.GetRawTrace().size() * 0.5) + headerLength;
 
     unsigned int word = 0;
     word |= data.GetChannelNumber() & mask.GetChannelNumberMask().first;
@@ -105,7 +105,7 @@ unsigned int XiaListModeDataEncoder::EncodeWordThree(
     word |= (unsigned int) data.GetEnergy() & mask.GetEventEnergyMask().first;
     word |= (data.IsSaturated() << mask.GetTraceOutOfRangeFlagMask()
             .second) & mask.GetTraceOutOfRangeFlagMask().first;
-    word |= (data.GetTrace().size() << mask.GetTraceLengthMask().second) &
+    word |= (data.GetRawTrace().size() << mask.GetTraceLengthMask().second) &
             mask.GetTraceLengthMask().first;
     return word;
 }
@@ -0,0 +1,65 @@
+///@file XiaListModeDataLayout.cpp
+///@brief The masks and shifts needed to decode the list mode data of a single firmware and frequency.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include "XiaListModeDataLayout.hpp"
+
+using namespace std;
+using namespace DataProcessing;
+
+XiaListModeDataLayout::XiaListModeDataLayout() :
+        firmware(UNKNOWN), frequency(0), channelNumberMask(0), slotIdMask(0), slotIdShift(0), crateIdMask(0),
+        crateIdShift(0), headerLengthMask(0), headerLengthShift(0), eventLengthMask(0), eventLengthShift(0),
+        finishCodeMask(0), wordZeroSaturationMask(0), eventTimeHighMask(0), cfdFractionalTimeMask(0),
+        cfdFractionalTimeShift(0), cfdForcedTriggerBitMask(0), cfdForcedTriggerBitShift(0), cfdTriggerSourceMask(0),
+        cfdTriggerSourceShift(0), eventEnergyMask(0), wordThreeSaturationMask(0), traceLengthMask(0),
+        traceLengthShift(0), numberOfExternalTimestampWords(0), numberOfEnergySumWords(0), numberOfQdcWords(0),
+        cfdSize(0) {}
+
+///The getters throw if the firmware or frequency are not set, so a bad mask is caught here rather than on the first
+/// hit that we try to decode.
+XiaListModeDataLayout::XiaListModeDataLayout(const XiaListModeDataMask &mask) :
+        firmware(mask.GetFirmware()), frequency(mask.GetFrequency()) {
+    channelNumberMask = mask.GetChannelNumberMask().first;
+    slotIdMask = mask.GetSlotIdMask().first;
+    slotIdShift = mask.GetSlotIdMask().second;
+    crateIdMask = mask.GetCrateIdMask().first;
+    crateIdShift = mask.GetCrateIdMask().second;
+    headerLengthMask = mask.GetHeaderLengthMask().first;
+    headerLengthShift = mask.GetHeaderLengthMask().second;
+    eventLengthMask = mask.GetEventLengthMask().first;
+    eventLengthShift = mask.GetEventLengthMask().second;
+    finishCodeMask = mask.GetFinishCodeMask().first;
+
+    eventTimeHighMask = mask.GetEventTimeHighMask().first;
+    cfdFractionalTimeMask = mask.GetCfdFractionalTimeMask().first;
+    cfdFractionalTimeShift = mask.GetCfdFractionalTimeMask().second;
+    cfdForcedTriggerBitMask = mask.GetCfdForcedTriggerBitMask().first;
+    cfdForcedTriggerBitShift = mask.GetCfdForcedTriggerBitMask().second;
+    cfdTriggerSourceMask = mask.GetCfdTriggerSourceMask().first;
+    cfdTriggerSourceShift = mask.GetCfdTriggerSourceMask().second;
+
+    eventEnergyMask = mask.GetEventEnergyMask().first;
+    traceLengthMask = mask.GetTraceLengthMask().first;
+    traceLengthShift = mask.GetTraceLengthMask().second;
+
+    //These three firmwares keep the Trace-out-of-range flag in Word 0, everybody else keeps it in Word 3.
+    switch (firmware) {
+        case R17562:
+        case R20466:
+        case R27361:
+            wordZeroSaturationMask = mask.GetTraceOutOfRangeFlagMask().first;
+            wordThreeSaturationMask = 0;
+            break;
+        default:
+            wordZeroSaturationMask = 0;
+            wordThreeSaturationMask = mask.GetTraceOutOfRangeFlagMask().first;
+            break;
+    }
+
+    numberOfExternalTimestampWords = mask.GetNumberOfExternalTimestampWords();
+    numberOfEnergySumWords = mask.GetNumberOfEnergySumWords();
+    numberOfQdcWords = mask.GetNumberOfQdcWords();
+
+    cfdSize = mask.GetCfdSize();
+}
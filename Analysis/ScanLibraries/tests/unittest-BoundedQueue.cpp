@@ -0,0 +1,85 @@
+///@file unittest-BoundedQueue.cpp
+///@brief Unit tests for the BoundedQueue class
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <thread>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "BoundedQueue.hpp"
+
+using namespace std;
+
+TEST(TestFifoOrder) {
+    BoundedQueue<int> queue(3);
+    CHECK(queue.Push(1));
+    CHECK(queue.Push(2));
+    CHECK(queue.Push(3));
+    CHECK_EQUAL(3, queue.GetSize());
+
+    int item;
+    for (int i = 1; i <= 3; i++) {
+        CHECK(queue.Pop(item));
+        CHECK_EQUAL(i, item);
+    }
+    CHECK_EQUAL(0, queue.GetSize());
+}
+
+TEST(TestClose) {
+    BoundedQueue<int> queue(2);
+    queue.Push(1);
+    queue.Close();
+    CHECK(queue.IsClosed());
+
+    //Nothing can be added once the queue is closed, but what's already there can still be removed.
+    CHECK(!queue.Push(2));
+    int item;
+    CHECK(queue.Pop(item));
+    CHECK_EQUAL(1, item);
+    CHECK(!queue.Pop(item));
+
+    queue.Reset(2);
+    CHECK(!queue.IsClosed());
+    CHECK(queue.Push(3));
+}
+
+TEST(TestCloseWakesConsumer) {
+    BoundedQueue<int> queue;
+    bool popped = true;
+    thread consumer([&queue, &popped]() {
+        int item;
+        popped = queue.Pop(item);
+    });
+    queue.Close();
+    consumer.join();
+    CHECK(!popped);
+}
+
+TEST(TestProducerConsumer) {
+    const int numberOfItems = 10000;
+    BoundedQueue<int> queue(4);
+    vector<int> received;
+
+    thread consumer([&queue, &received]() {
+        int item;
+        while (queue.Pop(item))
+            received.push_back(item);
+    });
+
+    for (int i = 0; i < numberOfItems; i++)
+        queue.Push(i);
+    queue.Close();
+    consumer.join();
+
+    CHECK_EQUAL(numberOfItems, (int) received.size());
+    bool inOrder = true;
+    for (int i = 0; i < (int) received.size(); i++)
+        if (received[i] != i)
+            inOrder = false;
+    CHECK(inOrder);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
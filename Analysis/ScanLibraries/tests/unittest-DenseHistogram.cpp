@@ -0,0 +1,193 @@
+///@file unittest-DenseHistogram.cpp
+///@brief Unit tests for the DenseHistogram class
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "DenseHistogram.hpp"
+
+using namespace std;
+
+TEST(TestConstructor) {
+    CHECK_THROW(DenseHistogram(0), invalid_argument);
+    CHECK_THROW(DenseHistogram(10, 0, 10), invalid_argument);
+
+    DenseHistogram hist1d(10);
+    CHECK_EQUAL(1, hist1d.GetDimension());
+    CHECK_EQUAL(12, hist1d.GetNumberOfCells());
+    CHECK(hist1d.IsEmpty());
+
+    DenseHistogram hist2d(10, 5);
+    CHECK_EQUAL(2, hist2d.GetDimension());
+    CHECK_EQUAL(12 * 7, hist2d.GetNumberOfCells());
+
+    DenseHistogram hist3d(10, 5, 3);
+    CHECK_EQUAL(3, hist3d.GetDimension());
+    CHECK_EQUAL(12 * 7 * 5, hist3d.GetNumberOfCells());
+}
+
+///The cells have to be the global bins that ROOT would give a histogram with the same binning.
+TEST(TestFill) {
+    DenseHistogram hist1d(10);
+    hist1d.Fill(0);
+    hist1d.Fill(0.99);
+    hist1d.Fill(9.5);
+    hist1d.Fill(-0.1);
+    hist1d.Fill(10);
+    hist1d.Fill(numeric_limits<double>::quiet_NaN());
+    CHECK_EQUAL(6, hist1d.GetEntries());
+    CHECK_EQUAL(1, hist1d.GetCellContent(0));
+    CHECK_EQUAL(2, hist1d.GetCellContent(1));
+    CHECK_EQUAL(1, hist1d.GetCellContent(10));
+    CHECK_EQUAL(2, hist1d.GetCellContent(11));
+
+    DenseHistogram hist2d(10, 5);
+    hist2d.Fill(3, 4);
+    CHECK_EQUAL(1, hist2d.GetCellContent(4 + 12 * 5));
+
+    DenseHistogram hist3d(10, 5, 3);
+    hist3d.Fill(1, 2, 3);
+    hist3d.Fill(1, 2, 3);
+    CHECK_EQUAL(2, hist3d.GetCellContent(2 + 12 * (3 + 7 * 4)));
+
+    vector<pair<size_t, uint64_t> > cells;
+    hist3d.ForEachFilledCell([&cells](size_t cell, uint64_t count) { cells.push_back(make_pair(cell, count)); });
+    CHECK_EQUAL(1, cells.size());
+    CHECK_EQUAL(2 + 12 * (3 + 7 * 4), cells[0].first);
+    CHECK_EQUAL(2, cells[0].second);
+
+    hist3d.Reset();
+    CHECK(hist3d.IsEmpty());
+    CHECK_EQUAL(0, hist3d.GetCellContent(2 + 12 * (3 + 7 * 4)));
+}
+
+TEST(TestBulkFill) {
+    vector<double> values;
+    for (unsigned int i = 0; i < 1000; i++)
+        values.push_back(i * 0.013 - 1);
+
+    DenseHistogram bulk(10);
+    bulk.Fill(&values[0], values.size());
+
+    DenseHistogram single(10);
+    for (vector<double>::const_iterator it = values.begin(); it != values.end(); it++)
+        single.Fill(*it);
+
+    CHECK_EQUAL(single.GetEntries(), bulk.GetEntries());
+    for (size_t cell = 0; cell < single.GetNumberOfCells(); cell++)
+        CHECK_EQUAL(single.GetCellContent(cell), bulk.GetCellContent(cell));
+}
+
+TEST(TestAdd) {
+    DenseHistogram lhs(10, 5);
+    DenseHistogram rhs(10, 5);
+    lhs.Fill(1, 1);
+    rhs.Fill(1, 1);
+    rhs.Fill(2, 3);
+    lhs.Add(rhs);
+    CHECK_EQUAL(3, lhs.GetEntries());
+    CHECK_EQUAL(2, lhs.GetCellContent(2 + 12 * 2));
+    CHECK_EQUAL(1, lhs.GetCellContent(3 + 12 * 4));
+    CHECK_THROW(lhs.Add(DenseHistogram(10)), invalid_argument);
+}
+
+///Filling one cell past 2^32 one value at a time takes too long for a unit test, so we add a smaller histogram into
+/// it over and over until it gets there instead.
+TEST(TestCarry) {
+    DenseHistogram part(1);
+    vector<double> values(1 << 20, 0.5);
+    part.Fill(&values[0], values.size());
+
+    DenseHistogram sum(1);
+    for (unsigned int i = 0; i < 4097; i++)
+        sum.Add(part);
+    const uint64_t count = 4097ull << 20;
+    CHECK_EQUAL(count, sum.GetCellContent(1));
+    CHECK_EQUAL(count, sum.GetEntries());
+
+    sum.Fill(0.5);
+    CHECK_EQUAL(count + 1, sum.GetCellContent(1));
+
+    DenseHistogram total(1);
+    total.Add(sum);
+    total.Add(sum);
+    CHECK_EQUAL(2 * (count + 1), total.GetCellContent(1));
+
+    vector<uint64_t> counts;
+    total.ForEachFilledCell([&counts](size_t cell, uint64_t content) { counts.push_back(content); });
+    CHECK_EQUAL(1, counts.size());
+}
+
+TEST(TestStats) {
+    double stats[DenseHistogram::Sums::numberOfStats];
+
+    DenseHistogram hist1d(10);
+    hist1d.Fill(3);
+    hist1d.Fill(5);
+    hist1d.Fill(-1);
+    hist1d.Fill(10);
+    hist1d.GetSums().Get(stats);
+    CHECK_EQUAL(2, stats[0]);
+    CHECK_EQUAL(2, stats[1]);
+    CHECK_EQUAL(8, stats[2]);
+    CHECK_EQUAL(34, stats[3]);
+
+    const double values[] = {3, 5, -1, 10};
+    DenseHistogram bulk(10);
+    bulk.Fill(values, 4);
+    double bulkStats[DenseHistogram::Sums::numberOfStats];
+    bulk.GetSums().Get(bulkStats);
+    CHECK_ARRAY_EQUAL(stats, bulkStats, 4);
+
+    DenseHistogram hist3d(10, 5, 5);
+    hist3d.Fill(1, 2, 3);
+    hist3d.Fill(1, 2, 0.5);
+    hist3d.GetSums().Get(stats);
+    const double expected[] = {2, 2, 2, 2, 4, 8, 4, 3.5, 9.25, 3.5, 7};
+    CHECK_ARRAY_EQUAL(expected, stats, 11);
+
+    DenseHistogram sum(10, 5, 5);
+    sum.Add(hist3d);
+    sum.Add(hist3d);
+    sum.GetSums().Get(stats);
+    CHECK_EQUAL(4, stats[0]);
+    CHECK_EQUAL(14, stats[10]);
+
+    sum.Reset();
+    sum.GetSums().Get(stats);
+    CHECK_EQUAL(0, stats[0]);
+    CHECK_EQUAL(0, stats[10]);
+}
+
+TEST(TestStatsDoNotDependOnTheOrder) {
+    //Sums of doubles like these come out different in the last bits depending on the order they're added in.
+    DenseHistogram forward(100, 100), backward(100, 100), first(100, 100), second(100, 100);
+    double sumx = 0;
+    for (unsigned int i = 0; i < 1000; i++) {
+        sumx += i % 97 * 0.1 + 0.01;
+        forward.Fill(i % 97 * 0.1 + 0.01, i % 89 * 1.1);
+        backward.Fill((999 - i) % 97 * 0.1 + 0.01, (999 - i) % 89 * 1.1);
+        (i % 3 ? first : second).Fill(i % 97 * 0.1 + 0.01, i % 89 * 1.1);
+    }
+    second.Add(first);
+
+    double forwardStats[DenseHistogram::Sums::numberOfStats], backwardStats[DenseHistogram::Sums::numberOfStats],
+            splitStats[DenseHistogram::Sums::numberOfStats];
+    forward.GetSums().Get(forwardStats);
+    backward.GetSums().Get(backwardStats);
+    second.GetSums().Get(splitStats);
+    for (size_t i = 0; i < DenseHistogram::Sums::numberOfStats; i++) {
+        CHECK_EQUAL(forwardStats[i], backwardStats[i]);
+        CHECK_EQUAL(forwardStats[i], splitStats[i]);
+    }
+    CHECK_CLOSE(sumx, forwardStats[2], 1e-6);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,64 @@
+///@file unittest-LazyTrace.cpp
+///@brief A program that will execute unit tests on LazyTrace
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "LazyTrace.hpp"
+
+using namespace std;
+
+static const unsigned short samples[] = {437, 436, 434, 434, 1200, 3000, 2000, 900, 500, 440, 437};
+static const unsigned int numberOfSamples = sizeof(samples) / sizeof(samples[0]);
+
+TEST_FIXTURE(LazyTrace, TestReference) {
+    vector<unsigned short> buffer(samples, samples + numberOfSamples);
+    Refer(&buffer[0], &buffer[0] + buffer.size());
+    CHECK(IsReference());
+    CHECK_EQUAL(buffer.size(), GetLength());
+
+    //The samples aren't copied until we ask for them.
+    buffer[0] = 1;
+    CHECK_EQUAL(1, Get()[0]);
+    CHECK(!IsReference());
+
+    buffer[1] = 2;
+    CHECK_EQUAL(samples[1], Get()[1]);
+    CHECK_ARRAY_EQUAL(&buffer[0] + 2, &Get()[0] + 2, numberOfSamples - 2);
+
+    Clear();
+    CHECK_EQUAL((size_t) 0, GetLength());
+    CHECK(Get().empty());
+}
+
+TEST(TestCopiesNeverRefer) {
+    vector<unsigned short> buffer(samples, samples + numberOfSamples);
+    LazyTrace trace;
+    trace.Refer(&buffer[0], &buffer[0] + buffer.size());
+
+    LazyTrace copy(trace);
+    CHECK(!copy.IsReference());
+    CHECK(!trace.IsReference());
+    CHECK_ARRAY_EQUAL(samples, copy.Get(), numberOfSamples);
+
+    trace.Refer(&buffer[0], &buffer[0] + buffer.size());
+    LazyTrace moved(std::move(trace));
+    CHECK(!moved.IsReference());
+    CHECK_ARRAY_EQUAL(samples, moved.Get(), numberOfSamples);
+
+    //Once we're done with the buffer, the copies still have their samples.
+    buffer.assign(buffer.size(), 0);
+    CHECK_ARRAY_EQUAL(samples, copy.Get(), numberOfSamples);
+
+    LazyTrace assigned;
+    assigned.Refer(&buffer[0], &buffer[0] + 2);
+    assigned = moved;
+    CHECK(!assigned.IsReference());
+    CHECK_EQUAL(numberOfSamples, assigned.GetLength());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
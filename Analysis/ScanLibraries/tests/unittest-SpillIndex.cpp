@@ -0,0 +1,161 @@
+///@file unittest-SpillIndex.cpp
+///@brief Unit tests for the spill index that poll2 writes next to its output files
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <cstdio>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "hribf_buffers.h"
+#include "SpillIndex.h"
+#include "XiaData.hpp"
+#include "XiaListModeDataEncoder.hpp"
+
+using namespace std;
+
+///Builds a spill with one buffer for each of two modules. Every hit has a 1000 sample trace so that the spills are
+/// split into chunks that span several ldf buffers.
+static vector<unsigned int> MakeSpill(const unsigned long long &firstTime, const unsigned int &hitsPerModule) {
+    XiaListModeDataEncoder encoder("30474", 250);
+    vector<unsigned int> spill;
+    XiaData data;
+
+    for (unsigned int mod = 0; mod < 2; mod++) {
+        size_t offset = spill.size();
+        spill.push_back(0);
+        spill.push_back(mod);
+        for (unsigned int i = 0; i < hitsPerModule; i++) {
+            unsigned long long time = firstTime + 100 * i + mod;
+            data.Initialize();
+            data.SetSlotNumber(mod + 2);
+            data.SetEnergy(1000);
+            data.SetEventTimeLow((unsigned int) (time & 0xFFFFFFFF));
+            data.SetEventTimeHigh((unsigned int) (time >> 32));
+            data.SetTrace(vector<unsigned int>(1000, 400 + i));
+            vector<unsigned int> encoded = encoder.EncodeXiaData(data);
+            spill.insert(spill.end(), encoded.begin(), encoded.end());
+        }
+        spill[offset] = (unsigned int) (spill.size() - offset);
+    }
+
+    return spill;
+}
+
+///Writes five spills with poll2's output file and returns the name of the file.
+static string WriteRun(const unsigned int &format, vector<vector<unsigned int> > &spills) {
+    PollOutputFile output;
+    output.SetFileFormat(format);
+
+    unsigned int runNumber = 1;
+    CHECK(output.OpenNewFile("spill index test", runNumber, "unittest-SpillIndex"));
+    for (unsigned int i = 0; i < 5; i++) {
+        spills.push_back(MakeSpill(0x100000000ull + 10000 * i, 3 + i));
+        output.Write((char *) &spills.back()[0], spills.back().size());
+    }
+    string fname = output.GetCurrentFilename();
+    output.CloseFile();
+    return fname;
+}
+
+///Checks that the index written along with the file matches the spills and the one built from the file.
+static void CheckIndex(const string &fname, const vector<vector<unsigned int> > &spills) {
+    SpillIndex written;
+    CHECK(written.Read(SpillIndex::GetIndexFilename(fname)));
+    CHECK_EQUAL(spills.size(), written.GetNumberOfSpills());
+
+    SpillIndex built;
+    CHECK(built.Build(fname));
+    CHECK_EQUAL(written.GetNumberOfSpills(), built.GetNumberOfSpills());
+
+    for (size_t i = 0; i < written.GetNumberOfSpills() && i < built.GetNumberOfSpills(); i++) {
+        const SpillIndexEntry &entry = written.GetSpill(i);
+        CHECK_EQUAL(spills[i].size(), (size_t) entry.nWords);
+        CHECK_EQUAL(0x100000000ull + 10000 * i, entry.firstTime);
+        CHECK_EQUAL(0x100000000ull + 10000 * i + 100 * (2 + i) + 1, entry.lastTime);
+        CHECK_EQUAL((size_t) 2, entry.moduleHits.size());
+        CHECK_EQUAL(2 * (3 + i), entry.GetNumberOfHits());
+
+        CHECK_EQUAL(entry.offset, built.GetSpill(i).offset);
+        CHECK_EQUAL(entry.nWords, built.GetSpill(i).nWords);
+        CHECK_EQUAL(entry.lastTime, built.GetSpill(i).lastTime);
+    }
+
+    CHECK_EQUAL((size_t) 0, written.FindFirstSpill(0));
+    CHECK_EQUAL((size_t) 2, written.FindFirstSpill(0x100000000ull + 15000));
+    CHECK_EQUAL((size_t) 2, written.FindEndSpill(0x100000000ull + 15000));
+    CHECK_EQUAL((size_t) 5, written.FindEndSpill(0x200000000ull));
+}
+
+TEST(TestSummarize) {
+    vector<unsigned int> spill = MakeSpill(5000, 2);
+    //A clock buffer and the end of spill words are not counted.
+    unsigned int clock[6] = {6, 1000, 0, 0, 0, 0};
+    spill.insert(spill.begin(), clock, clock + 6);
+    spill.push_back(2);
+    spill.push_back(9999);
+
+    SpillIndexEntry entry = SpillIndex::Summarize(&spill[0], spill.size(), 42);
+    CHECK_EQUAL(42ull, entry.offset);
+    CHECK_EQUAL(spill.size(), (size_t) entry.nWords);
+    CHECK_EQUAL(5000ull, entry.firstTime);
+    CHECK_EQUAL(5101ull, entry.lastTime);
+    CHECK_EQUAL((size_t) 2, entry.moduleHits.size());
+    CHECK_EQUAL(2u, entry.moduleHits[0]);
+    CHECK_EQUAL(2u, entry.moduleHits[1]);
+}
+
+TEST(TestPldIndex) {
+    vector<vector<unsigned int> > spills;
+    string fname = WriteRun(1, spills);
+    CheckIndex(fname, spills);
+
+    //Read the fourth spill directly from its offset.
+    SpillIndex index;
+    CHECK(index.Read(SpillIndex::GetIndexFilename(fname)));
+    ifstream file(fname.c_str(), ios::binary);
+    file.seekg(index.GetSpill(3).offset);
+    vector<unsigned int> data(spills[3].size() + 2);
+    unsigned int nBytes;
+    PLD_data pldData;
+    CHECK(pldData.Read(&file, (char *) &data[0], nBytes, 4 * data.size()));
+    CHECK_EQUAL(4 * spills[3].size(), (size_t) nBytes);
+    CHECK_ARRAY_EQUAL(spills[3], data, spills[3].size());
+
+    remove(fname.c_str());
+    remove(SpillIndex::GetIndexFilename(fname).c_str());
+}
+
+TEST(TestLdfIndex) {
+    vector<vector<unsigned int> > spills;
+    string fname = WriteRun(0, spills);
+    CheckIndex(fname, spills);
+
+    //Read the fourth spill starting from the ldf buffer that holds its first chunk.
+    SpillIndex index;
+    CHECK(index.Read(SpillIndex::GetIndexFilename(fname)));
+    unsigned long long offset = index.GetSpill(3).offset;
+    unsigned long long bufferStart = offset - offset % (4 * ACTUAL_BUFF_SIZE);
+    CHECK(offset != bufferStart + 8);
+
+    ifstream file(fname.c_str(), ios::binary);
+    file.seekg(bufferStart);
+    DATA_buffer dataBuff;
+    dataBuff.SetStartWord((unsigned int) ((offset - bufferStart) / 4));
+    vector<unsigned int> data(spills[3].size() + 2);
+    unsigned int nBytes;
+    bool fullSpill, badSpill;
+    CHECK(dataBuff.Read(&file, (char *) &data[0], nBytes, 4 * data.size(), fullSpill, badSpill));
+    CHECK(fullSpill);
+    CHECK(!badSpill);
+    CHECK_EQUAL(offset, dataBuff.GetSpillOffset());
+    CHECK_EQUAL(4 * (spills[3].size() + 2), (size_t) nBytes);
+    CHECK_ARRAY_EQUAL(spills[3], data, spills[3].size());
+
+    remove(fname.c_str());
+    remove(SpillIndex::GetIndexFilename(fname).c_str());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,276 @@
+///@file unittest-SpillRing.cpp
+///@brief Unit tests for the SpillRingWriter and SpillRingReader classes
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <UnitTest++.h>
+
+#include "SpillRing.h"
+
+using namespace std;
+
+///@return A name for the ring that won't clash with a poll2 running on the same machine.
+static string GetRingName() {
+    return "/paass-unittest-" + to_string(getpid());
+}
+
+///@return A spill of nWords that is easy to check, ending with the end of spill flag.
+static vector<unsigned int> MakeSpill(const unsigned int &nWords, const unsigned int &seed) {
+    vector<unsigned int> spill(nWords);
+    for (unsigned int i = 0; i < nWords - 2; i++)
+        spill[i] = seed * 100000 + i;
+    spill[nWords - 2] = 2;
+    spill[nWords - 1] = 9999;
+    return spill;
+}
+
+TEST(TestWriteAndRead) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 65536));
+    CHECK_EQUAL(65536, writer.GetSize());
+
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName()));
+
+    SpillRingRecord record;
+    CHECK(!reader.Next(record, 10));
+
+    vector<unsigned int> spill = MakeSpill(1000, 1);
+    CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    CHECK(writer.Write(SPILL_RING_CLOSE_FILE));
+
+    CHECK(reader.Next(record, 10));
+    CHECK_EQUAL(SPILL_RING_SPILL, record.type);
+    CHECK_EQUAL(0, record.sequence);
+    CHECK_EQUAL(spill.size(), record.nWords);
+    CHECK_ARRAY_EQUAL(&spill[0], record.data, spill.size());
+    CHECK(reader.IsValid(record));
+
+    CHECK(reader.Next(record, 10));
+    CHECK_EQUAL(SPILL_RING_CLOSE_FILE, record.type);
+    CHECK_EQUAL(0, record.nWords);
+    CHECK(!reader.Next(record, 10));
+    CHECK_EQUAL(0, reader.GetNumberOfLostRecords());
+}
+
+TEST(TestReserveAndCommit) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 65536));
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName()));
+
+    CHECK(writer.Reserve(65536 / 4) == NULL);
+    CHECK(!writer.Commit(SPILL_RING_SPILL, 10));
+
+    //poll2 reserves room for the end of spill flag, and may end up using less than it reserved.
+    unsigned int *output = writer.Reserve(12);
+    CHECK(output != NULL);
+    for (unsigned int i = 0; i < 8; i++)
+        output[i] = i;
+    output[8] = 2;
+    output[9] = 9999;
+    CHECK(writer.Commit(SPILL_RING_SPILL, 10));
+
+    SpillRingRecord record;
+    CHECK(reader.Next(record, 10));
+    CHECK_EQUAL(10, record.nWords);
+    CHECK_EQUAL(9999, record.data[9]);
+}
+
+TEST(TestWrapAround) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 4096));
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName()));
+
+    //The records don't divide the ring evenly, so they wrap around the end of it at different places.
+    SpillRingRecord record;
+    for (unsigned int i = 0; i < 50; i++) {
+        vector<unsigned int> spill = MakeSpill(301, i);
+        CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+        CHECK(reader.Next(record, 10));
+        CHECK_EQUAL(i, record.sequence);
+        CHECK_ARRAY_EQUAL(&spill[0], record.data, spill.size());
+        CHECK(reader.IsValid(record));
+    }
+    CHECK_EQUAL(50, writer.GetNumberOfRecords());
+    CHECK_EQUAL(0, reader.GetNumberOfLostRecords());
+}
+
+TEST(TestOverrun) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 4096));
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName()));
+
+    vector<unsigned int> spill = MakeSpill(301, 0);
+    CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    SpillRingRecord first;
+    CHECK(reader.Next(first, 10));
+    CHECK(reader.IsValid(first));
+
+    //Write more than a ring's worth while the reader isn't looking, it should skip to the newest record.
+    for (unsigned int i = 1; i <= 20; i++) {
+        spill = MakeSpill(301, i);
+        CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    }
+    CHECK(!reader.IsValid(first));
+
+    SpillRingRecord record;
+    CHECK(reader.Next(record, 10));
+    CHECK_EQUAL(20, record.sequence);
+    CHECK_ARRAY_EQUAL(&spill[0], record.data, spill.size());
+    CHECK_EQUAL(19, reader.GetNumberOfLostRecords());
+    CHECK(!reader.Next(record, 10));
+}
+
+TEST(TestWaitForWriter) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 65536));
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName()));
+
+    thread producer([&writer]() {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        vector<unsigned int> spill = MakeSpill(100, 7);
+        writer.Write(SPILL_RING_SPILL, &spill[0], spill.size());
+    });
+
+    SpillRingRecord record;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    CHECK(reader.Next(record, 5000));
+    producer.join();
+    CHECK(chrono::steady_clock::now() - start < chrono::seconds(4));
+    CHECK_EQUAL(100, record.nWords);
+    CHECK_EQUAL(700000, record.data[0]);
+}
+
+TEST(TestCloseAndReopen) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 65536));
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName()));
+    CHECK(!reader.IsStale());
+
+    writer.Close();
+    CHECK(!writer.IsOpen());
+    SpillRingRecord record;
+    CHECK(reader.Next(record, 10));
+    CHECK_EQUAL(SPILL_RING_CLOSE, record.type);
+    CHECK(reader.IsStale());
+
+    CHECK(writer.Open(GetRingName(), 65536));
+    CHECK(reader.IsStale());
+    CHECK(reader.Open(GetRingName()));
+    CHECK(!reader.IsStale());
+    writer.Close();
+
+    SpillRingReader missing;
+    CHECK(!missing.Open(GetRingName()));
+}
+
+TEST(TestLosslessConsumer) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 4096));
+    SpillRingReader reader;
+    CHECK(reader.Open(GetRingName(), SPILL_RING_LOSSLESS, 1, "lossless"));
+
+    //The writer has to wait for the reader once the ring is full, and it may not wait forever if the reader stops.
+    writer.SetMaximumWait(50);
+    SpillRingRecord record;
+    vector<unsigned int> spill = MakeSpill(301, 0);
+    CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    CHECK(reader.Next(record, 10));
+    for (unsigned int i = 1; i <= 3; i++) {
+        spill = MakeSpill(301, i);
+        CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    }
+    CHECK_EQUAL(1, writer.GetNumberOfWaits());
+    CHECK(!reader.IsValid(record));
+
+    //This time the reader keeps up, so every record gets through even though the ring only holds three of them.
+    writer.SetMaximumWait(-1);
+    CHECK(reader.Open(GetRingName(), SPILL_RING_LOSSLESS, 1, "lossless"));
+    const unsigned int numberOfSpills = 200;
+    thread producer([&writer]() {
+        for (unsigned int i = 0; i < numberOfSpills; i++) {
+            vector<unsigned int> spill = MakeSpill(301, i);
+            writer.Write(SPILL_RING_SPILL, &spill[0], spill.size());
+        }
+    });
+
+    unsigned int numberRead = 0;
+    while (numberRead < numberOfSpills && reader.Next(record, 1000)) {
+        spill = MakeSpill(301, numberRead);
+        CHECK_ARRAY_EQUAL(&spill[0], record.data, spill.size());
+        CHECK(reader.IsValid(record));
+        if (numberRead % 50 == 0)
+            this_thread::sleep_for(chrono::milliseconds(5));
+        numberRead++;
+    }
+    producer.join();
+    CHECK_EQUAL(numberOfSpills, numberRead);
+    CHECK_EQUAL(0, reader.GetNumberOfLostRecords());
+    CHECK(writer.GetNumberOfWaits() > 1);
+}
+
+TEST(TestLatestAndSampledConsumers) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 65536));
+    SpillRingReader latest, sampled;
+    CHECK(latest.Open(GetRingName(), SPILL_RING_LATEST, 1, "latest"));
+    CHECK(sampled.Open(GetRingName(), SPILL_RING_SAMPLED, 3, "sampled"));
+
+    for (unsigned int i = 0; i < 10; i++) {
+        vector<unsigned int> spill = MakeSpill(10, i);
+        CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    }
+    CHECK(writer.Write(SPILL_RING_CLOSE_FILE));
+
+    //The newest record is the file record, everything before it was skipped rather than lost.
+    SpillRingRecord record;
+    CHECK(latest.Next(record, 10));
+    CHECK_EQUAL(SPILL_RING_CLOSE_FILE, record.type);
+    CHECK(!latest.Next(record, 10));
+    CHECK_EQUAL(10, latest.GetNumberOfSkippedRecords());
+    CHECK_EQUAL(0, latest.GetNumberOfLostRecords());
+
+    //Spills 0, 3, 6 and 9, and then the file record.
+    for (unsigned int i = 0; i < 10; i += 3) {
+        CHECK(sampled.Next(record, 10));
+        CHECK_EQUAL(i * 100000, record.data[0]);
+    }
+    CHECK(sampled.Next(record, 10));
+    CHECK_EQUAL(SPILL_RING_CLOSE_FILE, record.type);
+    CHECK_EQUAL(6, sampled.GetNumberOfSkippedRecords());
+
+    vector<SpillRingConsumerInfo> consumers;
+    CHECK_EQUAL(2, writer.GetConsumers(consumers));
+    CHECK_EQUAL("latest", consumers[0].name);
+    CHECK_EQUAL(SPILL_RING_LATEST, consumers[0].policy);
+    CHECK_EQUAL(1, consumers[0].delivered);
+    CHECK_EQUAL(10, consumers[0].skipped);
+    CHECK_EQUAL("sampled", consumers[1].name);
+    CHECK_EQUAL(3, consumers[1].sampling);
+    CHECK_EQUAL(5, consumers[1].delivered);
+    CHECK_EQUAL(getpid(), consumers[1].pid);
+
+    sampled.Close();
+    CHECK_EQUAL(1, writer.GetConsumers(consumers));
+
+    //There's only room for so many consumers.
+    vector<SpillRingReader> readers(SPILL_RING_MAX_CONSUMERS);
+    for (unsigned int i = 0; i < SPILL_RING_MAX_CONSUMERS - 1; i++)
+        CHECK(readers[i].Open(GetRingName()));
+    CHECK(!readers.back().Open(GetRingName()));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
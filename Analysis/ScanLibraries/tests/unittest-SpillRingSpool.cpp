@@ -0,0 +1,95 @@
+///@file unittest-SpillRingSpool.cpp
+///@brief Unit tests for the SpillRingSpool class
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <UnitTest++.h>
+
+#include "SpillRingSpool.hpp"
+
+using namespace std;
+
+///@return A name for the ring that won't clash with a poll2 running on the same machine.
+static string GetRingName() {
+    return "/paass-unittest-spool-" + to_string(getpid());
+}
+
+///@return A spill of nWords that is easy to check, ending with the end of spill flag.
+static vector<unsigned int> MakeSpill(const unsigned int &nWords, const unsigned int &seed) {
+    vector<unsigned int> spill(nWords);
+    for (unsigned int i = 0; i < nWords - 2; i++)
+        spill[i] = seed * 100000 + i;
+    spill[nWords - 2] = 2;
+    spill[nWords - 1] = 9999;
+    return spill;
+}
+
+TEST(TestSpoolKeepsEverySpill) {
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 4096));
+
+    SpillRingSpool spool;
+    CHECK(spool.Open("/tmp", "unittest", GetRingName()));
+
+    //The ring only holds three of these, but nothing is read until they've all been written.
+    const unsigned int numberOfSpills = 100;
+    for (unsigned int i = 0; i < numberOfSpills; i++) {
+        vector<unsigned int> spill = MakeSpill(301, i);
+        CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    }
+    CHECK(writer.Write(SPILL_RING_CLOSE_FILE));
+
+    vector<SpillRingConsumerInfo> consumers;
+    CHECK_EQUAL(1, writer.GetConsumers(consumers));
+    CHECK_EQUAL("unittest", consumers[0].name);
+    CHECK_EQUAL(SPILL_RING_SPOOL, consumers[0].policy);
+
+    SpillRingRecord record;
+    for (unsigned int i = 0; i < numberOfSpills; i++) {
+        CHECK(spool.Next(record, 1000));
+        CHECK_EQUAL(i, record.sequence);
+        vector<unsigned int> spill = MakeSpill(301, i);
+        CHECK_EQUAL(spill.size(), record.nWords);
+        CHECK_ARRAY_EQUAL(&spill[0], record.data, spill.size());
+    }
+    CHECK(spool.Next(record, 1000));
+    CHECK_EQUAL(SPILL_RING_CLOSE_FILE, record.type);
+    CHECK(!spool.Next(record, 10));
+    CHECK_EQUAL(0, spool.GetNumberOfLostRecords());
+    CHECK_EQUAL(0, spool.GetSpooledBytes());
+
+    //Once we've caught up the spool file starts over.
+    vector<unsigned int> spill = MakeSpill(10, 7);
+    CHECK(writer.Write(SPILL_RING_SPILL, &spill[0], spill.size()));
+    CHECK(spool.Next(record, 1000));
+    CHECK_EQUAL(0, record.position);
+    CHECK_ARRAY_EQUAL(&spill[0], record.data, spill.size());
+}
+
+TEST(TestSpoolFollowsTheRing) {
+    SpillRingSpool spool;
+    CHECK(!spool.Open("/tmp", "unittest", GetRingName()));
+    CHECK_THROW(spool.Open("/nonexistent-directory", "unittest", GetRingName()), runtime_error);
+
+    SpillRingWriter writer;
+    CHECK(writer.Open(GetRingName(), 65536));
+    CHECK(spool.Open("/tmp", "unittest", GetRingName()));
+    CHECK(!spool.IsStale());
+
+    writer.Close();
+    SpillRingRecord record;
+    CHECK(spool.Next(record, 1000));
+    CHECK_EQUAL(SPILL_RING_CLOSE, record.type);
+    CHECK(spool.IsStale());
+    spool.Close();
+    CHECK(!spool.IsOpen());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
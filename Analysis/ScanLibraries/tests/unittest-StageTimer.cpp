@@ -0,0 +1,131 @@
+///@file unittest-StageTimer.cpp
+///@brief Unit tests for the StageTimer and StageTimers classes
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdio>
+
+#include <UnitTest++.h>
+
+#include "StageTimer.hpp"
+
+using namespace std;
+
+TEST(TestBins) {
+    for (uint64_t ns = 0; ns < 4; ns++)
+        CHECK_EQUAL(ns, StageTimer::GetBin(ns));
+
+    //Every latency has to land in the bin whose edges surround it, and the bins have to follow one another.
+    for (unsigned int bin = 0; bin < StageTimer::NUMBER_OF_BINS - 1; bin++) {
+        CHECK(StageTimer::GetBinLowEdge(bin) < StageTimer::GetBinLowEdge(bin + 1));
+        CHECK_EQUAL(bin, StageTimer::GetBin(StageTimer::GetBinLowEdge(bin)));
+        CHECK_EQUAL(bin, StageTimer::GetBin(StageTimer::GetBinLowEdge(bin + 1) - 1));
+    }
+    CHECK_EQUAL(8, StageTimer::GetBinLowEdge(8));
+    CHECK_EQUAL(14, StageTimer::GetBinLowEdge(11));
+    CHECK_EQUAL(StageTimer::NUMBER_OF_BINS - 1, StageTimer::GetBin(0xFFFFFFFFFFFFFFFF));
+}
+
+TEST(TestAddAndReset) {
+    StageTimer timer("group", "name");
+    CHECK_EQUAL(0, timer.GetNumberOfCalls());
+    CHECK_EQUAL(0, timer.GetMinimumNanoseconds());
+    CHECK_EQUAL(0, timer.GetPercentileNanoseconds(0.5));
+
+    for (uint64_t ns = 1; ns <= 100; ns++)
+        timer.Add(ns * 1000);
+    CHECK_EQUAL(100, timer.GetNumberOfCalls());
+    CHECK_EQUAL(5050000, timer.GetTotalNanoseconds());
+    CHECK_EQUAL(1000, timer.GetMinimumNanoseconds());
+    CHECK_EQUAL(100000, timer.GetMaximumNanoseconds());
+    CHECK_CLOSE(50500., timer.GetMeanNanoseconds(), 1e-6);
+
+    //The percentiles are the upper edge of their bin, which is at most 25% above the real value.
+    const uint64_t median = timer.GetPercentileNanoseconds(0.5);
+    CHECK(median >= 50000 && median <= 62500);
+    CHECK_EQUAL(100000, timer.GetPercentileNanoseconds(1.0));
+
+    vector<uint64_t> histogram = timer.GetHistogram();
+    uint64_t sum = 0;
+    for (vector<uint64_t>::const_iterator it = histogram.begin(); it != histogram.end(); it++)
+        sum += *it;
+    CHECK_EQUAL(100, sum);
+
+    timer.Reset();
+    CHECK_EQUAL(0, timer.GetNumberOfCalls());
+    CHECK_EQUAL(0, timer.GetTotalNanoseconds());
+    CHECK_EQUAL(0, timer.GetMaximumNanoseconds());
+}
+
+TEST(TestAddFromThreads) {
+    StageTimer timer("group", "threads");
+    vector<thread> threads;
+    for (unsigned int i = 0; i < 4; i++)
+        threads.push_back(thread([&timer, i]() {
+            for (uint64_t ns = 1; ns <= 10000; ns++)
+                timer.Add(ns + i);
+        }));
+    for (vector<thread>::iterator it = threads.begin(); it != threads.end(); it++)
+        it->join();
+
+    CHECK_EQUAL(40000, timer.GetNumberOfCalls());
+    CHECK_EQUAL(1, timer.GetMinimumNanoseconds());
+    CHECK_EQUAL(10003, timer.GetMaximumNanoseconds());
+}
+
+TEST(TestScopedTimer) {
+    StageTimer timer("group", "scoped");
+    {
+        ScopedStageTimer scoped(&timer);
+    }
+    try {
+        ScopedStageTimer scoped(&timer);
+        throw runtime_error("leave the scope");
+    } catch (runtime_error &) {}
+    CHECK_EQUAL(2, timer.GetNumberOfCalls());
+
+    ScopedStageTimer nothing(NULL);
+}
+
+TEST(TestRegistry) {
+    StageTimer *timer = StageTimers::get()->Get("unittest", "registry");
+    CHECK(timer == StageTimers::get()->Get("unittest", "registry"));
+    CHECK(timer != StageTimers::get()->Get("unittest", "other"));
+    CHECK_EQUAL("unittest", timer->GetGroup());
+    CHECK_EQUAL("registry", timer->GetName());
+
+    timer->Add(2500);
+    timer->Add(1500);
+    StageTimers::get()->Get("unittest", "other")->Add(10);
+
+    stringstream table;
+    StageTimers::get()->Print(table);
+    CHECK(table.str().find("registry") != string::npos);
+    CHECK(table.str().find("registry") < table.str().find("other"));
+
+    const string fileName = "unittest-StageTimer.json";
+    StageTimers::get()->Write(fileName);
+    ifstream in(fileName.c_str());
+    string line, json;
+    while (getline(in, line))
+        json += line + "\n";
+    in.close();
+    remove(fileName.c_str());
+    CHECK(json.find("\"group\": \"unittest\", \"name\": \"registry\", \"calls\": 2, \"total_ns\": 4000") !=
+          string::npos);
+    CHECK(json.find("\"histogram\": [[1280, 1], [2048, 1]]") != string::npos);
+
+    StageTimers::get()->Reset();
+    CHECK_EQUAL(0, timer->GetNumberOfCalls());
+    CHECK_THROW(StageTimers::get()->Write("/this/directory/does/not/exist.json"), invalid_argument);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,54 @@
+///@file unittest-ThreadPool.cpp
+///@brief Unit tests for the ThreadPool class
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <stdexcept>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+TEST(TestEveryTaskRunsOnce) {
+    ThreadPool pool(3);
+    CHECK_EQUAL(3, pool.GetNumberOfThreads());
+
+    //Run a few batches to make sure that the workers pick up each new batch.
+    for (unsigned int batch = 0; batch < 50; batch++) {
+        vector<unsigned int> counts(13, 0);
+        pool.ParallelFor(counts.size(), [&counts](const size_t &i) { counts[i]++; });
+        for (unsigned int i = 0; i < counts.size(); i++)
+            CHECK_EQUAL(1, counts[i]);
+    }
+}
+
+TEST(TestNoWorkers) {
+    ThreadPool pool(0);
+    vector<unsigned int> counts(5, 0);
+    pool.ParallelFor(counts.size(), [&counts](const size_t &i) { counts[i] += i; });
+    for (unsigned int i = 0; i < counts.size(); i++)
+        CHECK_EQUAL(i, counts[i]);
+    pool.ParallelFor(0, [&counts](const size_t &i) { counts[i] = 0; });
+}
+
+TEST(TestException) {
+    ThreadPool pool(2);
+    vector<unsigned int> counts(8, 0);
+    CHECK_THROW(pool.ParallelFor(counts.size(), [&counts](const size_t &i) {
+        counts[i]++;
+        if (i == 3)
+            throw invalid_argument("Task three failed");
+    }), invalid_argument);
+
+    //The rest of the tasks still run, and the pool is still usable.
+    for (unsigned int i = 0; i < counts.size(); i++)
+        CHECK_EQUAL(1, counts[i]);
+    pool.ParallelFor(counts.size(), [&counts](const size_t &i) { counts[i]++; });
+    CHECK_EQUAL(2, counts[7]);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
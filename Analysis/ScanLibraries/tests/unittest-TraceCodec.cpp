@@ -0,0 +1,148 @@
+///@file unittest-TraceCodec.cpp
+///@brief Unit tests for the compression of the traces in poll2 spills
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <cmath>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "SpillIndex.h"
+#include "TraceCodec.h"
+#include "XiaData.hpp"
+#include "XiaListModeDataDecoder.hpp"
+#include "XiaListModeDataEncoder.hpp"
+
+using namespace std;
+
+///@return A trace that looks like an ADC pulse sitting on a noisy baseline.
+static vector<unsigned short> MakePulse(const unsigned int &length, const unsigned int &amplitude) {
+    vector<unsigned short> trace(length);
+    unsigned int seed = 12345;
+    for (unsigned int i = 0; i < length; i++) {
+        seed = seed * 1103515245 + 12345;
+        double value = 400 + (seed >> 16) % 7;
+        if (i >= length / 4)
+            value += amplitude * (exp(-(i - length / 4.) / 40.) - exp(-(i - length / 4.) / 4.));
+        trace[i] = (unsigned short) value;
+    }
+    return trace;
+}
+
+///Compresses a trace and checks that we get exactly the same samples back.
+static unsigned int CheckRoundTrip(const vector<unsigned short> &trace) {
+    vector<unsigned int> compressed(TraceCodec::GetMaxCompressedWords(trace.size()));
+    unsigned int nWords = TraceCodec::Compress(&trace[0], trace.size(), &compressed[0]);
+    CHECK(nWords != 0 && nWords <= compressed.size());
+
+    vector<unsigned short> samples(trace.size());
+    CHECK(TraceCodec::Decompress(&compressed[0], nWords, &samples[0], samples.size()));
+    CHECK_ARRAY_EQUAL(trace, samples, trace.size());
+    return nWords;
+}
+
+TEST(TestTraceRoundTrip) {
+    //Smooth traces shrink by a good deal, including the partial block at the end.
+    vector<unsigned short> pulse = MakePulse(1000, 3000);
+    CHECK(CheckRoundTrip(pulse) < pulse.size() / 4);
+
+    for (unsigned int length = 1; length < 300; length += 63)
+        CheckRoundTrip(MakePulse(length, 500));
+    CheckRoundTrip(vector<unsigned short>(256, 0));
+    CheckRoundTrip(vector<unsigned short>(128, 65535));
+
+    //The largest steps, in both directions, need the full sixteen bits.
+    vector<unsigned short> steps(300);
+    for (unsigned int i = 0; i < steps.size(); i++)
+        steps[i] = (unsigned short) (i % 2 == 0 ? 0 : 65535 - i);
+    CheckRoundTrip(steps);
+}
+
+TEST(TestCorruptTraces) {
+    vector<unsigned short> pulse = MakePulse(200, 1000);
+    vector<unsigned int> compressed(TraceCodec::GetMaxCompressedWords(pulse.size()));
+    unsigned int nWords = TraceCodec::Compress(&pulse[0], pulse.size(), &compressed[0]);
+    vector<unsigned short> samples(pulse.size());
+
+    CHECK(!TraceCodec::Decompress(&compressed[0], nWords - 1, &samples[0], samples.size()));
+    CHECK(!TraceCodec::Decompress(&compressed[0], nWords, &samples[0], samples.size() - 1));
+    compressed[1] |= 0x11;
+    CHECK(!TraceCodec::Decompress(&compressed[0], nWords, &samples[0], samples.size()));
+    CHECK_EQUAL(0u, TraceCodec::Compress(&pulse[0], 0, &compressed[0]));
+}
+
+///Encodes a hit with XiaListModeDataEncoder, compresses the spill that holds it and makes sure that the decoder
+/// gives back the same trace.
+TEST(TestSpillRoundTrip) {
+    XiaListModeDataEncoder encoder("30474", 250);
+    vector<unsigned short> pulse = MakePulse(500, 2000);
+
+    XiaData withTrace;
+    withTrace.SetSlotNumber(2);
+    withTrace.SetChannelNumber(3);
+    withTrace.SetEnergy(1500);
+    withTrace.SetEventTimeLow(1000);
+    withTrace.SetTrace(&pulse[0], &pulse[0] + pulse.size());
+
+    XiaData withoutTrace;
+    withoutTrace.SetSlotNumber(2);
+    withoutTrace.SetChannelNumber(4);
+    withoutTrace.SetEnergy(700);
+    withoutTrace.SetEventTimeLow(1010);
+
+    vector<unsigned int> spill(2);
+    spill[1] = 0;
+    vector<unsigned int> encoded = encoder.EncodeXiaData(withTrace);
+    spill.insert(spill.end(), encoded.begin(), encoded.end());
+    encoded = encoder.EncodeXiaData(withoutTrace);
+    spill.insert(spill.end(), encoded.begin(), encoded.end());
+    spill[0] = (unsigned int) spill.size();
+    spill.push_back(2);
+    spill.push_back(9999);
+
+    vector<unsigned int> compressed;
+    unsigned int nWords = TraceCodec::CompressSpill(&spill[0], spill.size(), compressed);
+    CHECK_EQUAL((unsigned int) compressed.size(), nWords);
+    CHECK(compressed.size() < spill.size() - pulse.size() / 4);
+    CHECK_EQUAL((unsigned int) compressed.size() - 2, compressed[0]);
+
+    //The index doesn't care whether or not the traces are compressed.
+    SpillIndexEntry entry = SpillIndex::Summarize(&compressed[0], compressed.size(), 0);
+    CHECK_EQUAL(2ul, entry.GetNumberOfHits());
+    CHECK_EQUAL(1000ull, entry.firstTime);
+    CHECK_EQUAL(1010ull, entry.lastTime);
+
+    XiaListModeDataMask mask(DataProcessing::R30474, 250);
+    XiaListModeDataDecoder plain;
+    CHECK_EQUAL((size_t) 0, plain.DecodeBuffer(&compressed[0], mask).size());
+    CHECK_EQUAL(1u, plain.GetNumberOfSkippedBuffers());
+
+    XiaListModeDataDecoder decoder;
+    decoder.SetCompressedTraces(true);
+    vector<XiaData *> events = decoder.DecodeBuffer(&compressed[0], mask);
+    CHECK_EQUAL((size_t) 2, events.size());
+    if (events.size() == 2) {
+        CHECK_EQUAL(withTrace.GetChannelNumber(), events[0]->GetChannelNumber());
+        CHECK_EQUAL(withTrace.GetEnergy(), events[0]->GetEnergy());
+        CHECK_EQUAL(pulse.size(), events[0]->GetTraceLength());
+        CHECK_ARRAY_EQUAL(pulse, events[0]->GetRawTrace(), pulse.size());
+        CHECK_EQUAL(withoutTrace.GetChannelNumber(), events[1]->GetChannelNumber());
+        CHECK_EQUAL(withoutTrace.GetEventTimeLow(), events[1]->GetEventTimeLow());
+        CHECK_EQUAL((size_t) 0, events[1]->GetTraceLength());
+    }
+    CHECK_EQUAL(0u, decoder.GetNumberOfSkippedBuffers());
+    for (vector<XiaData *>::iterator it = events.begin(); it != events.end(); it++)
+        delete *it;
+
+    //Spills without traces come through untouched.
+    spill.assign(2, 0);
+    encoded = encoder.EncodeXiaData(withoutTrace);
+    spill.insert(spill.end(), encoded.begin(), encoded.end());
+    spill[0] = (unsigned int) spill.size();
+    TraceCodec::CompressSpill(&spill[0], spill.size(), compressed);
+    CHECK_ARRAY_EQUAL(spill, compressed, spill.size());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
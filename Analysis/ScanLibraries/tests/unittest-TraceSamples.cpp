@@ -0,0 +1,75 @@
+///@file unittest-TraceSamples.cpp
+///@brief A program that will execute unit tests on the TraceSamples conversions and on how ProcessedXiaData takes
+/// over the trace from XiaData.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <utility>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "ProcessedXiaData.hpp"
+#include "TraceSamples.hpp"
+#include "UnitTestSampleData.hpp"
+
+using namespace std;
+using namespace unittest_trace_variables;
+
+///Every length up to a few vector widths so that we exercise the vectorized loop and the scalar tail.
+TEST(TestWidenAllLengths) {
+    for (unsigned int length = 0; length < 70; length++) {
+        vector<unsigned short> samples(length);
+        for (unsigned int i = 0; i < length; i++)
+            samples[i] = (unsigned short) (65535 - i * 997);
+
+        vector<unsigned int> widened = TraceSamples::Widen(samples);
+        CHECK_EQUAL(length, widened.size());
+        for (unsigned int i = 0; i < length; i++)
+            CHECK_EQUAL((unsigned int) samples[i], widened[i]);
+    }
+}
+
+TEST(TestNarrow) {
+    vector<unsigned int> samples;
+    samples.push_back(0);
+    samples.push_back(437);
+    samples.push_back(65535);
+    samples.push_back(70000);
+
+    vector<unsigned short> narrowed = TraceSamples::Narrow(samples);
+    CHECK_EQUAL(samples.size(), narrowed.size());
+    CHECK_EQUAL(0, narrowed[0]);
+    CHECK_EQUAL(437, narrowed[1]);
+    CHECK_EQUAL(65535, narrowed[2]);
+    CHECK_EQUAL(65535, narrowed[3]);
+
+    CHECK_ARRAY_EQUAL(trace, TraceSamples::Widen(TraceSamples::Narrow(trace)), trace.size());
+}
+
+TEST(TestProcessedXiaDataTakesTheTrace) {
+    XiaData data;
+    data.SetEnergy(1000);
+    data.SetSaturation(true);
+    data.SetTrace(trace);
+    const unsigned short *samples = data.GetRawTrace().data();
+
+    //A copy leaves the hit alone.
+    ProcessedXiaData copied(data);
+    CHECK_EQUAL(samples, data.GetRawTrace().data());
+    CHECK_ARRAY_EQUAL(trace, copied.GetTrace(), trace.size());
+
+    ProcessedXiaData processed(std::move(data));
+
+    //The samples were handed over without being copied.
+    CHECK(data.GetRawTrace().empty());
+    CHECK_EQUAL(samples, processed.GetRawTrace().data());
+    CHECK_EQUAL(1000, data.GetEnergy());
+
+    CHECK(processed.GetTrace().IsSaturated());
+    CHECK_ARRAY_EQUAL(trace, processed.GetTrace(), trace.size());
+    CHECK_EQUAL(trace.size(), processed.GetTrace().size());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
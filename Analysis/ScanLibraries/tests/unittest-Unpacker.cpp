@@ -0,0 +1,154 @@
+///@file unittest-Unpacker.cpp
+///@brief Unit tests for how the Unpacker builds raw events from consecutive spills
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "Unpacker.hpp"
+#include "XiaData.hpp"
+#include "XiaListModeDataEncoder.hpp"
+
+using namespace std;
+
+///Keeps a copy of every raw event that it processes.
+class RecordingUnpacker : public Unpacker {
+public:
+    RecordingUnpacker() : Unpacker() { InitializeDataMask("30474", 250); }
+
+    vector<vector<XiaData> > events;
+
+private:
+    void ProcessRawEvent() {
+        events.push_back(vector<XiaData>());
+        for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+            events.back().push_back(**it);
+        rawEvent.clear();
+    }
+};
+
+///Builds a spill with one buffer per module. Each hit is given as a module number and a time in clock ticks.
+static vector<unsigned int> MakeSpill(const vector<pair<unsigned int, unsigned long long> > &hits,
+                                      const unsigned int &numberOfModules, const vector<unsigned int> &trace) {
+    XiaListModeDataEncoder encoder("30474", 250);
+    vector<unsigned int> spill;
+    XiaData data;
+
+    for (unsigned int mod = 0; mod < numberOfModules; mod++) {
+        size_t offset = spill.size();
+        spill.push_back(0);
+        spill.push_back(mod);
+        for (vector<pair<unsigned int, unsigned long long> >::const_iterator it = hits.begin(); it != hits.end(); it++) {
+            if (it->first != mod)
+                continue;
+            data.Initialize();
+            data.SetSlotNumber(mod + 2);
+            data.SetEnergy(1000);
+            data.SetEventTimeLow((unsigned int) (it->second & 0xFFFFFFFF));
+            data.SetEventTimeHigh((unsigned int) (it->second >> 32));
+            data.SetTrace(trace);
+            vector<unsigned int> encoded = encoder.EncodeXiaData(data);
+            spill.insert(spill.end(), encoded.begin(), encoded.end());
+        }
+        spill[offset] = (unsigned int) (spill.size() - offset);
+    }
+
+    spill.push_back(2);
+    spill.push_back(9999);
+    return spill;
+}
+
+///Reads two spills where the hit at 5000 in module 0 and the hit at 5010 in module 1 end up in different spills. Every
+/// buffer has at least two hits, since ReadSpill takes a six word buffer to be an empty module.
+static void ReadSpills(RecordingUnpacker &unpacker, const vector<unsigned int> &trace) {
+    vector<pair<unsigned int, unsigned long long> > hits;
+    hits.push_back(make_pair(0, 1000));
+    hits.push_back(make_pair(0, 5000));
+    hits.push_back(make_pair(1, 1010));
+    hits.push_back(make_pair(1, 4000));
+    vector<unsigned int> first = MakeSpill(hits, 2, trace);
+
+    hits.clear();
+    hits.push_back(make_pair(0, 8000));
+    hits.push_back(make_pair(0, 8500));
+    hits.push_back(make_pair(1, 5010));
+    hits.push_back(make_pair(1, 9000));
+    vector<unsigned int> second = MakeSpill(hits, 2, trace);
+
+    unpacker.ReadSpill(&first[0], first.size(), false);
+    unpacker.WaitForPipeline();
+    //Whatever was held back has to survive the spill being overwritten.
+    first.assign(first.size(), 0);
+    unpacker.ReadSpill(&second[0], second.size(), false);
+    unpacker.FlushEvents();
+    unpacker.WaitForPipeline();
+}
+
+TEST(TestEventsWithinSpills) {
+    RecordingUnpacker unpacker;
+    ReadSpills(unpacker, vector<unsigned int>());
+
+    CHECK_EQUAL((size_t) 7, unpacker.events.size());
+    CHECK_EQUAL((size_t) 2, unpacker.events[0].size());
+    CHECK_EQUAL(7u, unpacker.GetNumRawEvents());
+}
+
+TEST(TestStreamingEvents) {
+    vector<unsigned int> trace(50, 400);
+    trace[20] = 3000;
+
+    RecordingUnpacker unpacker;
+    unpacker.SetStreamingEvents(true);
+    CHECK(unpacker.IsStreamingEvents());
+    ReadSpills(unpacker, trace);
+
+    //The events after the watermark of the second spill are only built by the flush.
+    CHECK_EQUAL((size_t) 6, unpacker.events.size());
+    CHECK_EQUAL((size_t) 2, unpacker.events[0].size());
+    CHECK_EQUAL((size_t) 1, unpacker.events[1].size());
+
+    //The hits at 5000 and 5010 were read in different spills, but they're in the same event.
+    CHECK_EQUAL((size_t) 2, unpacker.events[2].size());
+    CHECK_EQUAL(0u, unpacker.events[2][0].GetModuleNumber());
+    CHECK_EQUAL(1u, unpacker.events[2][1].GetModuleNumber());
+    CHECK_ARRAY_EQUAL(trace, unpacker.events[2][0].GetTrace(), trace.size());
+
+    for (unsigned int i = 1; i < unpacker.events.size(); i++)
+        CHECK(unpacker.events[i - 1].front().GetFilterTime() < unpacker.events[i].front().GetFilterTime());
+
+    //There's nothing left to flush.
+    unpacker.FlushEvents();
+    CHECK_EQUAL((size_t) 6, unpacker.events.size());
+}
+
+TEST(TestStreamingEventsInPipeline) {
+    RecordingUnpacker unpacker;
+    unpacker.SetStreamingEvents(true);
+    unpacker.StartPipeline(2);
+    CHECK_THROW(unpacker.SetStreamingEvents(false), runtime_error);
+    ReadSpills(unpacker, vector<unsigned int>());
+    unpacker.StopPipeline();
+
+    CHECK_EQUAL((size_t) 6, unpacker.events.size());
+    CHECK_EQUAL((size_t) 2, unpacker.events[2].size());
+}
+
+TEST(TestTurningOffStreamingFlushes) {
+    RecordingUnpacker unpacker;
+    unpacker.SetStreamingEvents(true);
+
+    vector<pair<unsigned int, unsigned long long> > hits;
+    hits.push_back(make_pair(0, 1000));
+    hits.push_back(make_pair(0, 5000));
+    vector<unsigned int> spill = MakeSpill(hits, 1, vector<unsigned int>());
+    unpacker.ReadSpill(&spill[0], spill.size(), false);
+    CHECK_EQUAL((size_t) 1, unpacker.events.size());
+
+    unpacker.SetStreamingEvents(false);
+    CHECK_EQUAL((size_t) 2, unpacker.events.size());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
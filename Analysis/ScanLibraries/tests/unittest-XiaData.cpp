@@ -115,6 +115,12 @@ TEST_FIXTURE (XiaData, Test_GetSetTrace) {
     CHECK_ARRAY_EQUAL(trace, GetTrace(), trace.size());
 }
 
+TEST_FIXTURE (XiaData, Test_GetRawTrace) {
+    SetTrace(trace);
+    CHECK_EQUAL(trace.size(), GetRawTrace().size());
+    CHECK_ARRAY_EQUAL(trace, GetRawTrace(), trace.size());
+}
+
 TEST_FIXTURE (XiaData, Test_GetSetVirtualChannel) {
     SetVirtualChannel(virtual_channel);
     CHECK (IsVirtualChannel());
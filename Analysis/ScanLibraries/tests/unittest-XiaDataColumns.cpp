@@ -0,0 +1,225 @@
+///@file unittest-XiaDataColumns.cpp
+///@brief Unit tests for the column files that hold the decoded hits of each spill
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "Unpacker.hpp"
+#include "XiaData.hpp"
+#include "XiaDataColumns.hpp"
+#include "XiaListModeDataEncoder.hpp"
+
+using namespace std;
+
+///Keeps a copy of every raw event that it processes.
+class RecordingUnpacker : public Unpacker {
+public:
+    RecordingUnpacker() : Unpacker() { InitializeDataMask("30474", 250); }
+
+    vector<vector<XiaData> > events;
+
+private:
+    void ProcessRawEvent() {
+        events.push_back(vector<XiaData>());
+        for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+            events.back().push_back(**it);
+        rawEvent.clear();
+    }
+};
+
+///@return A hit with every field that the column file stores set to something other than its default.
+static XiaData MakeHit(const unsigned int &mod, const unsigned int &channel, const double &time) {
+    XiaData data;
+    data.SetSlotNumber(mod + 2);
+    data.SetCrateNumber(1);
+    data.SetChannelNumber(channel);
+    data.SetEnergy(1000 + channel);
+    data.SetTime(time + 0.25);
+    data.SetFilterTime(time);
+    data.SetFilterBaseline(12.5);
+    data.SetExternalTimestamp(2 * time);
+    data.SetEventTimeLow((unsigned int) time);
+    data.SetEventTimeHigh(3);
+    data.SetExternalTimeLow(7);
+    data.SetExternalTimeHigh(8);
+    data.SetCfdFractionalTime(1234);
+    data.SetPileup(channel % 2 == 1);
+    data.SetSaturation(true);
+    data.SetCfdTriggerSourceBit(true);
+    data.SetQdc(vector<unsigned int>(8, 10 * channel));
+    data.SetEnergySums(vector<unsigned int>(4, channel));
+    data.SetTrace(vector<unsigned int>(20 + channel, 400 + channel));
+    return data;
+}
+
+///@return The contents of a file, in storage that is aligned well enough to parse the chunks in place.
+static vector<double> ReadFile(const string &name, size_t &nBytes) {
+    ifstream file(name.c_str(), ios::binary);
+    vector<char> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    nBytes = bytes.size();
+    vector<double> aligned(nBytes / sizeof(double) + 1);
+    if (nBytes != 0)
+        memcpy(&aligned[0], &bytes[0], nBytes);
+    return aligned;
+}
+
+///Writes a chunk of three hits from two modules and checks that every field comes back from the file.
+static void CheckRoundTrip(const bool &withTraces) {
+    const string name = "unittest-XiaDataColumns.xcol";
+    vector<XiaData> hits;
+    hits.push_back(MakeHit(0, 1, 1000));
+    hits.push_back(MakeHit(0, 2, 1050));
+    hits.push_back(MakeHit(1, 3, 1020));
+
+    vector<deque<XiaData *> > eventList(2);
+    eventList[0].push_back(&hits[0]);
+    eventList[0].push_back(&hits[1]);
+    eventList[1].push_back(&hits[2]);
+
+    XiaDataColumnWriter writer;
+    CHECK(writer.Open(name, withTraces));
+    writer.Write(eventList);
+    writer.Write(vector<deque<XiaData *> >(2));
+    CHECK_EQUAL((size_t) 1, writer.GetNumberOfChunks());
+    CHECK_EQUAL(3ull, writer.GetNumberOfHits());
+    writer.Close();
+
+    size_t nBytes;
+    vector<double> file = ReadFile(name, nBytes);
+    const char *data = (const char *) &file[0];
+    unsigned int flags;
+    CHECK(XiaDataColumns::ReadFileHeader(data, nBytes, flags));
+    CHECK_EQUAL(withTraces, (flags & XiaDataColumns::HAS_TRACES) != 0);
+
+    XiaDataColumnChunk chunk;
+    CHECK_EQUAL(nBytes - XiaDataColumns::FILE_HEADER_SIZE,
+                chunk.Parse(data + XiaDataColumns::FILE_HEADER_SIZE, nBytes - XiaDataColumns::FILE_HEADER_SIZE));
+    CHECK_EQUAL((size_t) 3, chunk.GetNumberOfHits());
+    CHECK_EQUAL(withTraces, chunk.HasTraces());
+    CHECK_EQUAL(1050., chunk.GetFilterTimes()[1]);
+    CHECK_EQUAL(3, chunk.GetChannelNumbers()[2]);
+
+    for (size_t i = 0; i < hits.size(); i++) {
+        XiaData read;
+        chunk.Fill(i, &read);
+        CHECK(read == hits[i]);
+        CHECK_EQUAL(hits[i].GetTime(), read.GetTime());
+        CHECK_EQUAL(hits[i].GetFilterBaseline(), read.GetFilterBaseline());
+        CHECK_EQUAL(hits[i].GetExternalTimestamp(), read.GetExternalTimestamp());
+        CHECK_EQUAL(hits[i].GetEventTimeHigh(), read.GetEventTimeHigh());
+        CHECK_EQUAL(hits[i].GetExternalTimeLow(), read.GetExternalTimeLow());
+        CHECK_EQUAL(hits[i].GetExternalTimeHigh(), read.GetExternalTimeHigh());
+        CHECK_EQUAL(hits[i].GetCfdFractionalTime(), read.GetCfdFractionalTime());
+        CHECK_EQUAL(hits[i].IsPileup(), read.IsPileup());
+        CHECK_EQUAL(hits[i].IsSaturated(), read.IsSaturated());
+        CHECK_EQUAL(hits[i].IsVirtualChannel(), read.IsVirtualChannel());
+        CHECK_EQUAL(hits[i].GetCfdTriggerSourceBit(), read.GetCfdTriggerSourceBit());
+        CHECK_ARRAY_EQUAL(hits[i].GetQdc(), read.GetQdc(), hits[i].GetQdc().size());
+        CHECK_ARRAY_EQUAL(hits[i].GetEnergySums(), read.GetEnergySums(), hits[i].GetEnergySums().size());
+        if (withTraces) {
+            CHECK_EQUAL(hits[i].GetTraceLength(), read.GetTraceLength());
+            CHECK_ARRAY_EQUAL(hits[i].GetRawTrace(), read.GetRawTrace(), hits[i].GetTraceLength());
+        } else
+            CHECK_EQUAL((size_t) 0, read.GetTraceLength());
+    }
+
+    //A truncated chunk, or one with the wrong magic number, is rejected.
+    CHECK_EQUAL((size_t) 0, chunk.Parse(data + XiaDataColumns::FILE_HEADER_SIZE,
+                                        nBytes - XiaDataColumns::FILE_HEADER_SIZE - 8));
+    CHECK_EQUAL((size_t) 0, chunk.GetNumberOfHits());
+    CHECK_EQUAL((size_t) 0, chunk.Parse(data, nBytes));
+
+    remove(name.c_str());
+}
+
+TEST(TestRoundTripWithTraces) {
+    CheckRoundTrip(true);
+}
+
+TEST(TestRoundTripWithoutTraces) {
+    CheckRoundTrip(false);
+}
+
+///Builds a spill with one buffer per module. Each hit is given as a module number and a time in clock ticks.
+static vector<unsigned int> MakeSpill(const vector<pair<unsigned int, unsigned long long> > &hits) {
+    XiaListModeDataEncoder encoder("30474", 250);
+    vector<unsigned int> spill;
+    XiaData data;
+
+    for (unsigned int mod = 0; mod < 2; mod++) {
+        size_t offset = spill.size();
+        spill.push_back(0);
+        spill.push_back(mod);
+        for (vector<pair<unsigned int, unsigned long long> >::const_iterator it = hits.begin(); it != hits.end(); it++) {
+            if (it->first != mod)
+                continue;
+            data.Initialize();
+            data.SetSlotNumber(mod + 2);
+            data.SetEnergy(1000 + mod);
+            data.SetEventTimeLow((unsigned int) (it->second & 0xFFFFFFFF));
+            data.SetEventTimeHigh((unsigned int) (it->second >> 32));
+            data.SetTrace(vector<unsigned int>(30, 400 + mod));
+            vector<unsigned int> encoded = encoder.EncodeXiaData(data);
+            spill.insert(spill.end(), encoded.begin(), encoded.end());
+        }
+        spill[offset] = (unsigned int) (spill.size() - offset);
+    }
+
+    spill.push_back(2);
+    spill.push_back(9999);
+    return spill;
+}
+
+///Exports a spill while it's scanned, and then checks that scanning the column file gives the same events.
+TEST(TestUnpackerExport) {
+    const string name = "unittest-XiaDataColumns-export.xcol";
+    vector<pair<unsigned int, unsigned long long> > hits;
+    hits.push_back(make_pair(0, 1000));
+    hits.push_back(make_pair(0, 5000));
+    hits.push_back(make_pair(1, 1010));
+    hits.push_back(make_pair(1, 4000));
+    vector<unsigned int> spill = MakeSpill(hits);
+
+    XiaDataColumnWriter writer;
+    CHECK(writer.Open(name, true));
+    RecordingUnpacker raw;
+    raw.SetColumnWriter(&writer);
+    raw.ReadSpill(&spill[0], spill.size(), false);
+    raw.SetColumnWriter(NULL);
+    writer.Close();
+
+    size_t nBytes;
+    vector<double> file = ReadFile(name, nBytes);
+    XiaDataColumnChunk chunk;
+    CHECK(chunk.Parse((const char *) &file[0] + XiaDataColumns::FILE_HEADER_SIZE,
+                      nBytes - XiaDataColumns::FILE_HEADER_SIZE) != 0);
+
+    RecordingUnpacker columns;
+    columns.StartPipeline(2);
+    CHECK(columns.ReadColumns(chunk, false));
+    columns.WaitForPipeline();
+    columns.StopPipeline();
+
+    CHECK_EQUAL((size_t) 3, raw.events.size());
+    CHECK_EQUAL(raw.events.size(), columns.events.size());
+    for (size_t i = 0; i < raw.events.size() && i < columns.events.size(); i++) {
+        CHECK_EQUAL(raw.events[i].size(), columns.events[i].size());
+        for (size_t j = 0; j < raw.events[i].size() && j < columns.events[i].size(); j++) {
+            CHECK(raw.events[i][j] == columns.events[i][j]);
+            CHECK_ARRAY_EQUAL(raw.events[i][j].GetRawTrace(), columns.events[i][j].GetRawTrace(),
+                              raw.events[i][j].GetTraceLength());
+        }
+    }
+
+    remove(name.c_str());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,73 @@
+///@file unittest-XiaDataMerger.cpp
+///@brief Unit tests for the XiaDataMerger class
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <UnitTest++.h>
+
+#include "XiaDataMerger.hpp"
+
+using namespace std;
+
+///Builds a hit in the requested module with the requested time.
+static XiaData *MakeHit(vector<XiaData> &storage, const unsigned int &mod, const double &time) {
+    XiaData data;
+    data.SetSlotNumber(mod + 2);
+    data.SetFilterTime(time);
+    storage.push_back(data);
+    return &storage.back();
+}
+
+TEST(TestEmptyStreams) {
+    vector<deque<XiaData *> > streams(4);
+    XiaDataMerger merger;
+    merger.Initialize(streams);
+    CHECK(merger.IsEmpty());
+    CHECK(merger.Pop() == NULL);
+}
+
+TEST(TestMergeOrder) {
+    vector<XiaData> storage;
+    storage.reserve(10);
+    vector<deque<XiaData *> > streams(3);
+
+    //Module 0 is out of order so that we check the merger sorts the streams.
+    streams[0].push_back(MakeHit(storage, 0, 30));
+    streams[0].push_back(MakeHit(storage, 0, 10));
+    streams[0].push_back(MakeHit(storage, 0, 50));
+    streams[2].push_back(MakeHit(storage, 2, 20));
+    streams[2].push_back(MakeHit(storage, 2, 30));
+    streams[2].push_back(MakeHit(storage, 2, 60));
+
+    XiaDataMerger merger;
+    merger.Initialize(streams);
+    CHECK_EQUAL(10, merger.GetNextTime());
+
+    const double expectedTimes[] = {10, 20, 30, 30, 50, 60};
+    //The two hits at t = 30 are tied, so the one from the lower module comes first.
+    const unsigned int expectedModules[] = {0, 2, 0, 2, 0, 2};
+    for (unsigned int i = 0; i < 6; i++) {
+        CHECK(!merger.IsEmpty());
+        XiaData *data = merger.Pop();
+        CHECK_EQUAL(expectedTimes[i], data->GetFilterTime());
+        CHECK_EQUAL(expectedModules[i], data->GetModuleNumber());
+    }
+
+    CHECK(merger.IsEmpty());
+    CHECK(streams[0].empty() && streams[2].empty());
+}
+
+TEST(TestClear) {
+    vector<XiaData> storage;
+    vector<deque<XiaData *> > streams(1);
+    streams[0].push_back(MakeHit(storage, 0, 10));
+
+    XiaDataMerger merger;
+    merger.Initialize(streams);
+    merger.Clear();
+    CHECK(merger.IsEmpty());
+    CHECK_EQUAL((size_t) 1, streams[0].size());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,65 @@
+///@file unittest-XiaDataPool.cpp
+///@brief Unit tests for the XiaDataPool class
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <UnitTest++.h>
+
+#include "UnitTestSampleData.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
+
+using namespace std;
+using namespace DataProcessing;
+using namespace unittest_encoded_data;
+
+TEST(TestAcquireAndReset) {
+    XiaDataPool pool(2);
+    CHECK_EQUAL((size_t) 0, pool.GetCapacity());
+
+    XiaData *first = pool.Acquire();
+    XiaData *second = pool.Acquire();
+    XiaData *third = pool.Acquire();
+    CHECK(first != second && second != third);
+    CHECK_EQUAL((size_t) 3, pool.GetNumberInUse());
+    CHECK_EQUAL((size_t) 2, pool.GetNumberOfBlocks());
+
+    pool.Reset();
+    CHECK_EQUAL((size_t) 0, pool.GetNumberInUse());
+    CHECK_EQUAL((size_t) 4, pool.GetCapacity());
+
+    //Objects are recycled in the same order, and the pool does not grow if we stay under the capacity.
+    CHECK(first == pool.Acquire());
+    CHECK(second == pool.Acquire());
+    CHECK_EQUAL((size_t) 2, pool.GetNumberOfBlocks());
+}
+
+TEST(TestRecycledObjectsAreInitialized) {
+    XiaDataPool pool;
+    XiaData *data = pool.Acquire();
+    data->SetEnergy(unittest_decoded_data::energy);
+    data->SetTrace(unittest_trace_variables::trace);
+    data->SetQdc(unittest_decoded_data::qdc);
+    pool.Reset();
+
+    XiaData *recycled = pool.Acquire();
+    CHECK(data == recycled);
+    CHECK(*recycled == XiaData());
+    CHECK(recycled->GetTrace().empty());
+    CHECK(recycled->GetQdc().empty());
+}
+
+TEST(TestDecodingIntoPool) {
+    XiaDataPool pool;
+    XiaListModeDataDecoder decoder;
+    XiaListModeDataMask mask(R30474, 250);
+
+    vector<XiaData *> result = decoder.DecodeBuffer(&R30474_250::headerWithTrace[0], mask, &pool);
+    CHECK_EQUAL((size_t) 1, result.size());
+    CHECK_EQUAL((size_t) 1, pool.GetNumberInUse());
+    CHECK_ARRAY_EQUAL(unittest_trace_variables::trace, result.front()->GetTrace(),
+                      unittest_trace_variables::trace.size());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
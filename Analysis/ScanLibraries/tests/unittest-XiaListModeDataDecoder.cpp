@@ -99,6 +99,59 @@ TEST_FIXTURE(XiaListModeDataDecoder, TestCfdTimeCalculation) {
     CHECK_CLOSE(unittest_decoded_data::R30474_250::ts_w_cfd, result.GetTime(), 1e-5);
 }
 
+TEST(TestLayoutResolvesMasks) {
+    XiaListModeDataLayout layout(mask);
+    CHECK_EQUAL(R30474, layout.firmware);
+    CHECK_EQUAL((unsigned int)250, layout.frequency);
+    CHECK_EQUAL(mask.GetEventLengthMask().first, layout.eventLengthMask);
+    CHECK_EQUAL(mask.GetCfdFractionalTimeMask().first, layout.cfdFractionalTimeMask);
+    CHECK_EQUAL(mask.GetCfdSize(), layout.cfdSize);
+    CHECK_EQUAL((unsigned int)0, layout.wordZeroSaturationMask);
+    CHECK_EQUAL(mask.GetTraceOutOfRangeFlagMask().first, layout.wordThreeSaturationMask);
+
+    //The oldest firmwares keep the Trace-out-of-range flag in Word 0.
+    XiaListModeDataMask oldMask(R17562, 100);
+    XiaListModeDataLayout oldLayout(oldMask);
+    CHECK_EQUAL(oldMask.GetTraceOutOfRangeFlagMask().first, oldLayout.wordZeroSaturationMask);
+    CHECK_EQUAL((unsigned int)0, oldLayout.wordThreeSaturationMask);
+
+    XiaListModeDataMask emptyMask;
+    CHECK_THROW(XiaListModeDataLayout badLayout(emptyMask), invalid_argument);
+}
+
+TEST_FIXTURE(XiaListModeDataDecoder, TestLayoutDecoding) {
+    XiaListModeDataLayout layout(mask);
+    CHECK_THROW(DecodeBuffer(&empty_buffer[0], layout), length_error);
+    CHECK_EQUAL(empty_buffer[1], DecodeBuffer(&empty_module_buffer[0], layout).size());
+
+    XiaData expected = *(DecodeBuffer(&headerWithCfd[0], mask).front());
+    XiaData result = *(DecodeBuffer(&headerWithCfd[0], layout).front());
+    CHECK(expected == result);
+    CHECK_EQUAL(expected.GetCfdFractionalTime(), result.GetCfdFractionalTime());
+    CHECK_EQUAL(expected.GetTime(), result.GetTime());
+
+    result = *(DecodeBuffer(&headerWithTrace[0], layout).front());
+    CHECK_ARRAY_EQUAL(unittest_trace_variables::trace, result.GetTrace(), unittest_trace_variables::trace.size());
+}
+
+TEST_FIXTURE(XiaListModeDataDecoder, TestTraceChannelsAndReferences) {
+    SetTraceReferences(true);
+    XiaData *result = DecodeBuffer(&headerWithTrace[0], mask).front();
+    CHECK_EQUAL(unittest_trace_variables::trace.size(), result->GetTraceLength());
+    CHECK_ARRAY_EQUAL(unittest_trace_variables::trace, result->GetTrace(), unittest_trace_variables::trace.size());
+
+    //Channels that aren't flagged don't get a trace at all.
+    vector<bool> channels(result->GetId() + 1, true);
+    channels[result->GetId()] = false;
+    delete result;
+
+    SetTraceChannels(channels);
+    result = DecodeBuffer(&headerWithTrace[0], mask).front();
+    CHECK_EQUAL((size_t) 0, result->GetTraceLength());
+    CHECK(result->GetTrace().empty());
+    delete result;
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
\ No newline at end of file
@@ -93,7 +93,6 @@ bool EventReaderUnpacker::AddEvent(XiaData *event_){
     else{ numSkip_--; }
 
     eventsRead_++;
-    delete event_;
 
     return false;
 }
\ No newline at end of file
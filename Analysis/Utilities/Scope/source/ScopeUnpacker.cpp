@@ -20,6 +20,7 @@
 #include <TPaveStats.h>
 
 #include <fstream>
+#include <utility>
 
 using namespace std;
 using namespace TraceFunctions;
@@ -174,24 +175,22 @@ void ScopeUnpacker::ProcessRawEvent() {
         rawEvent.pop_front();
 
         // Safety catches for null event or empty ->GetTrace().
-        if (!current_event || current_event->GetTrace().empty())
+        if (!current_event || current_event->GetRawTrace().empty())
             continue;
 
         if (current_event->GetModuleNumber() != mod_ &&
             current_event->GetChannelNumber() != chan_)
             continue;
 
-        pair<double, double> baseline = CalculateBaseline(current_event->GetTrace(), make_pair(0, 10));
-        pair<double, double> maximum = FindMaximum(current_event->GetTrace(), current_event->GetTrace().size());
-        double qdc = CalculateQdc(current_event->GetTrace(), make_pair(5, 15));
+        pair<double, double> baseline = CalculateBaseline(current_event->GetRawTrace(), make_pair(0, 10));
+        pair<double, double> maximum = FindMaximum(current_event->GetRawTrace(), current_event->GetRawTrace().size());
+        double qdc = CalculateQdc(current_event->GetRawTrace(), make_pair(5, 15));
 
-        if (maximum.second < threshLow_ || (threshHigh_ > threshLow_ && maximum.second > threshHigh_)) {
-            delete current_event;
+        if (maximum.second < threshLow_ || (threshHigh_ > threshLow_ && maximum.second > threshHigh_))
             continue;
-        }
 
         //Convert the XiaData object into a ProcessedXiaData object
-        ProcessedXiaData *channel_event = new ProcessedXiaData(*current_event);
+        ProcessedXiaData *channel_event = new ProcessedXiaData(std::move(*current_event));
 
         channel_event->GetTrace().SetBaseline(baseline);
         channel_event->GetTrace().SetMax(maximum);
@@ -46,8 +46,7 @@ bool SkeletonUnpacker::AddEvent(XiaData *event) {
         return false;
 
     // Handle the individual XiaData. Maybe add it to a detector's event list or something.
-    // Do nothing with it for now.
-    delete event;
+    // Do nothing with it for now. The event is owned by the Unpacker's spill pool, so it must not be deleted here.
 
     return false;
 }
@@ -0,0 +1,61 @@
+///@file spillIndexer.cpp
+///@brief Builds the spill index of .ldf and .pld files that were written without one
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <iostream>
+#include <string.h>
+
+#include "SpillIndex.h"
+
+void help(char *name_) {
+    std::cout << "  SYNTAX: " << name_ << " [options] <files ...>\n";
+    std::cout << "   Available options:\n";
+    std::cout << "    --force | Rebuild the index even if the file already has one.\n";
+    std::cout << "    --print | Print a summary of the index of each file.\n";
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cout << " Error: Invalid number of arguments to " << argv[0]
+                  << ". Expected 1, received " << argc - 1 << ".\n";
+        help(argv[0]);
+        return 1;
+    }
+
+    bool force = false;
+    bool print = false;
+    int file_count = 1;
+    int failures = 0;
+    for (int i = 1; i < argc; i++) {
+        // Check for command line options.
+        if (strcmp(argv[i], "--force") == 0) {
+            force = true;
+            continue;
+        } else if (strcmp(argv[i], "--print") == 0) {
+            print = true;
+            continue;
+        }
+
+        std::cout << "File no. " << file_count++ << ": " << argv[i] << std::endl;
+
+        const std::string index_fname = SpillIndex::GetIndexFilename(argv[i]);
+        SpillIndex index;
+        if (!force && index.Read(index_fname)) {
+            std::cout << " Using the existing index " << index_fname << ".\n";
+        } else if (!index.Build(argv[i])) {
+            std::cout << " ERROR! Failed to read the input file! Check that the path is correct and that it is a "
+                    "ldf or pld file.\n\n";
+            failures++;
+            continue;
+        } else if (!index.Write(index_fname)) {
+            std::cout << " ERROR! Failed to write the index " << index_fname << "!\n\n";
+            failures++;
+            continue;
+        } else { std::cout << " Wrote the index " << index_fname << ".\n"; }
+
+        if (print) { index.Print(); }
+        std::cout << std::endl;
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
@@ -6,6 +6,8 @@
 #ifndef __CFDANALYZER_HPP_
 #define __CFDANALYZER_HPP_
 
+#include <string>
+
 #include "TimingDriver.hpp"
 #include "Trace.hpp"
 #include "TraceAnalyzer.hpp"
@@ -17,7 +19,7 @@ public:
     CfdAnalyzer(const std::string &s);
 
     /** Default Destructor */
-    ~CfdAnalyzer() {};
+    ~CfdAnalyzer() { delete driver_; };
 
     /** Declare the plots */
     void DeclarePlots(void) const {};
@@ -29,8 +31,18 @@ public:
     * \param [in] tagMap : the map of tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return A new analyzer with its own CFD, since the CFDs keep their
+     * results between calls */
+    TraceAnalyzer *Clone(void) const { return new CfdAnalyzer(driverName_); }
+
 private:
     TimingDriver *driver_;
+    std::string driverName_; //!< The name of the CFD that we were asked for
+
+    /** A copy would delete the CFD of the original, use Clone instead. */
+    CfdAnalyzer(const CfdAnalyzer &);
+
+    CfdAnalyzer &operator=(const CfdAnalyzer &);
 };
 
 #endif
@@ -32,8 +32,18 @@ public:
      * \param [in] tagMap : the map of tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return A new analyzer with its own fitter, or NULL for the ROOT
+     * fitter, since ROOT's fitting can't be run on several threads at once */
+    TraceAnalyzer *Clone(void) const;
+
 private:
     TimingDriver *driver_;
+    std::string driverName_; //!< The name of the fitter that we were asked for
+
+    /** A copy would delete the fitter of the original, use Clone instead. */
+    FittingAnalyzer(const FittingAnalyzer &);
+
+    FittingAnalyzer &operator=(const FittingAnalyzer &);
 };
 
 #endif // __FITTINGANALYZER_HPP_
@@ -6,6 +6,7 @@
 #ifndef __TRACEANALYZER_HPP_
 #define __TRACEANALYZER_HPP_
 
+#include <atomic>
 #include <string>
 #include <sys/times.h>
 
@@ -40,6 +41,16 @@ public:
     ///@param [in] cfg : Configuration for the channel to analyze.
     virtual void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    ///@return A new analyzer that does the same analysis as this one, for one of the workers of the DetectorDriver,
+    /// or NULL if the analyzer can't be run on more than one thread at a time. That's the default, since most
+    /// analyzers keep something from one trace to the next.
+    virtual TraceAnalyzer *Clone(void) const { return NULL; }
+
+    ///@param [in] cfg : Configuration for the channel
+    ///@return True if this analyzer looks at the traces of the channel. The
+    /// unpacker doesn't decode traces that no analyzer or processor wants.
+    virtual bool IsAnalyzed(const ChannelConfiguration &cfg) const { return true; }
+
     /** End the analysis and record the analyzer level in the trace
      * \param [in] trace : the trace */
     void EndAnalyze(Trace &trace);
@@ -54,9 +65,12 @@ public:
     /** \return the level of the trace analysis */
     int GetLevel() { return level; }
 
+    /** \return the name of the analyzer */
+    std::string GetName(void) const { return (name); }
+
 protected:
     int level;                ///< the level of analysis to proceed with
-    static int numTracesAnalyzed;    ///< rownumber for DAMM spectrum 850
+    static std::atomic<int> numTracesAnalyzed;    ///< rownumber for DAMM spectrum 850
     std::string name;         ///< name of the analyzer
 
     /** Plots class for given Processor, takes care of declaration
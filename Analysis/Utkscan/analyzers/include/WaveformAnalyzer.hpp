@@ -30,6 +30,15 @@ public:
     * \param [in] tags : the map of the tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return A copy of the analyzer, it keeps nothing from one trace to the next */
+    TraceAnalyzer *Clone(void) const { return new WaveformAnalyzer(*this); }
+
+    ///@param [in] cfg : Configuration for the channel
+    ///@return False if the channel's type is one of the ignored types.
+    bool IsAnalyzed(const ChannelConfiguration &cfg) const {
+        return ignoredTypes_.find(cfg.GetType()) == ignoredTypes_.end();
+    }
+
 private:
     std::set<std::string> ignoredTypes_;
 };
@@ -16,7 +16,7 @@
 
 using namespace std;
 
-CfdAnalyzer::CfdAnalyzer(const std::string &s) : TraceAnalyzer() {
+CfdAnalyzer::CfdAnalyzer(const std::string &s) : TraceAnalyzer(), driverName_(s) {
     name = "CfdAnalyzer";
     if (s == "polynomial" || s == "poly")
         driver_ = new PolynomialCfd();
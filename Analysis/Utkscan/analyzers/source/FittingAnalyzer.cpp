@@ -25,7 +25,7 @@
 
 using namespace std;
 
-FittingAnalyzer::FittingAnalyzer(const std::string &s) {
+FittingAnalyzer::FittingAnalyzer(const std::string &s) : driverName_(s) {
     name = "FittingAnalyzer";
     if (s == "GSL" || s == "gsl")
         driver_ = new GslFitter();
@@ -43,6 +43,12 @@ FittingAnalyzer::~FittingAnalyzer() {
     delete driver_;
 }
 
+TraceAnalyzer *FittingAnalyzer::Clone() const {
+    if (dynamic_cast<RootFitter *>(driver_))
+        return NULL;
+    return new FittingAnalyzer(driverName_);
+}
+
 void FittingAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
     TraceAnalyzer::Analyze(trace, cfg);
 
@@ -22,14 +22,14 @@
 
 using namespace std;
 
-int TraceAnalyzer::numTracesAnalyzed = -1; //!< number of analyzed traces
+atomic<int> TraceAnalyzer::numTracesAnalyzed(-1); //!< number of analyzed traces
 
 TraceAnalyzer::TraceAnalyzer() : histo(0, 0, "generic"), userTime(0.), systemTime(0.) {
     clocksPerSecond = sysconf(_SC_CLK_TCK);
 }
 
 TraceAnalyzer::TraceAnalyzer(const unsigned int &offset, const unsigned int &range, const std::string &name) :
-        histo(offset, range, name), userTime(0.), systemTime(0.) {
+        name(name), histo(offset, range, name), userTime(0.), systemTime(0.) {
     clocksPerSecond = sysconf(_SC_CLK_TCK);
 }
 
@@ -0,0 +1,166 @@
+///@file benchmark-DetectorDriver.cpp
+///@brief Measures the hits/s of each of the TraceAnalyzers and of DetectorDriver::ProcessEvent, using the analyzers
+/// and processors of a utkscan configuration file.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <iostream>
+#include <set>
+
+#include "BenchmarkReport.hpp"
+#include "DetectorDriver.hpp"
+#include "DetectorLibrary.hpp"
+#include "Display.h"
+#include "Globals.hpp"
+#include "Places.hpp"
+#include "RawEvent.hpp"
+#include "RootHandler.hpp"
+#include "SyntheticSpill.hpp"
+#include "TraceAnalyzer.hpp"
+#include "TreeCorrelator.hpp"
+#include "Unpacker.hpp"
+#include "XmlInterface.hpp"
+
+using namespace std;
+
+///An Unpacker that keeps a copy of every event that it builds, so that the analysis can be timed on its own.
+class CollectingUnpacker : public Unpacker {
+public:
+    vector<vector<XiaData> > events; ///< The hits of each event
+
+private:
+    void ProcessRawEvent() {
+        events.push_back(vector<XiaData>());
+        for (deque<XiaData *>::const_iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+            events.back().push_back(**it);
+        rawEvent.clear();
+    }
+};
+
+///@return The number of bytes that the hit took up in the spill.
+static unsigned long long GetRawBytes(const XiaData &hit) {
+    return 4 * (4 + hit.GetTraceLength() / 2);
+}
+
+///Times each of the analyzers in the order that DetectorDriver calls them. Most of them use what the ones before
+/// them found, so each analyzer is timed on traces that the ones before it have already been through.
+static void TimeAnalyzers(BenchmarkReport &report, const string &workload,
+                          const vector<vector<XiaData> > &events) {
+    DetectorLibrary *detectorLibrary = DetectorLibrary::get();
+    vector<Trace> prepared;
+    vector<const ChannelConfiguration *> configurations;
+    unsigned long long bytes = 0;
+
+    for (vector<vector<XiaData> >::const_iterator event = events.begin(); event != events.end(); event++) {
+        for (vector<XiaData>::const_iterator hit = event->begin(); hit != event->end(); hit++) {
+            const ChannelConfiguration &cfg = detectorLibrary->at(hit->GetId());
+            if (hit->GetTraceLength() == 0 || cfg.GetType() == "ignore")
+                continue;
+            ChanEvent chan(*hit);
+            prepared.push_back(chan.GetTrace());
+            configurations.push_back(&cfg);
+            bytes += GetRawBytes(*hit);
+        }
+    }
+
+    const vector<TraceAnalyzer *> &analyzers = DetectorDriver::get()->GetTraceAnalyzers();
+    for (vector<TraceAnalyzer *>::const_iterator analyzer = analyzers.begin(); analyzer != analyzers.end();
+         analyzer++) {
+        vector<Trace> traces;
+        double fastest = 0;
+        for (unsigned int repeat = 0; repeat < report.GetRepeats(); repeat++) {
+            traces = prepared;
+            const double elapsed = TimeFastest(1, [&]() {
+                for (size_t i = 0; i < traces.size(); i++)
+                    (*analyzer)->Analyze(traces[i], *configurations[i]);
+            });
+            if (repeat == 0 || elapsed < fastest)
+                fastest = elapsed;
+        }
+        report.Add("analyze", (*analyzer)->GetName(), workload, fastest, bytes, traces.size());
+        prepared.swap(traces);
+    }
+}
+
+///Processes every event the same way that UtkUnpacker::ProcessRawEvent does, without the raw plots.
+static void ProcessEvents(const vector<vector<XiaData> > &events) {
+    static DetectorDriver *driver = DetectorDriver::get();
+    static DetectorLibrary *detectorLibrary = DetectorLibrary::get();
+    set<string> usedDetectors;
+
+    for (vector<vector<XiaData> >::const_iterator event = events.begin(); event != events.end(); event++) {
+        RawEvent &rawev = driver->GetNextEvent();
+        for (vector<XiaData>::const_iterator hit = event->begin(); hit != event->end(); hit++) {
+            const string &type = detectorLibrary->at(hit->GetId()).GetType();
+            if (type == "ignore")
+                continue;
+            usedDetectors.insert(type);
+            rawev.AddChan(new ChanEvent(*hit));
+        }
+
+        driver->ProcessNextEvent(usedDetectors);
+        usedDetectors.clear();
+
+        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
+             it != TreeCorrelator::get()->places_.end(); ++it)
+            if ((*it).second->resetable())
+                (*it).second->reset();
+    }
+    driver->FinishEvents();
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        BenchmarkReport report("DetectorDriver", argc, argv);
+        const string config = report.GetOption("config", BENCHMARK_CONFIG);
+        const unsigned int numberOfSpills = (unsigned int) stoul(report.GetOption("spills", "20"));
+        const unsigned int traceLength = (unsigned int) stoul(report.GetOption("trace-length", "250"));
+
+        //This is the same setup that UtkScanInterface::Initialize and UtkUnpacker::InitializeDriver go through.
+        XmlInterface::get(config);
+        Globals::get(config);
+        DetectorLibrary::get();
+        TreeCorrelator::get()->buildTree();
+        const string outputPath = report.GetOption("path", "/tmp/");
+        Globals::get()->SetOutputFilename("benchmark-DetectorDriver");
+        Globals::get()->SetOutputPath(outputPath);
+        RootHandler::get(outputPath + "benchmark-DetectorDriver");
+
+        DetectorDriver *driver = DetectorDriver::get();
+        driver->SetNumberOfThreads((unsigned int) stoul(report.GetOption("threads",
+                                                                         to_string(driver->GetNumberOfThreads()))));
+        driver->DeclarePlots();
+        RawEvent rawev;
+        driver->Init(rawev);
+
+        //The modules in the spills are the ones that are in the configuration.
+        const unsigned int numberOfModules = DetectorLibrary::get()->GetModules();
+        SyntheticSpillGenerator generator(numberOfModules, 200, traceLength);
+        CollectingUnpacker unpacker;
+        unpacker.InitializeDataMask("30474", 250);
+        unpacker.SetEventWidth(Globals::get()->GetEventLengthInTicks());
+        unsigned long long bytes = 0, hits = 0;
+        for (unsigned int i = 0; i < numberOfSpills; i++) {
+            SyntheticSpill spill = generator.Next();
+            bytes += 4 * (spill.words.size() - 2);
+            hits += spill.numberOfHits;
+            unpacker.ReadSpill(&spill.words[0], spill.words.size(), false);
+        }
+        unpacker.FlushEvents();
+
+        const string workload = to_string(numberOfModules) + "x200 " + to_string(traceLength) + " samples";
+        cout << "benchmark-DetectorDriver - " << unpacker.events.size() << " events from " << config << endl;
+
+        TimeAnalyzers(report, workload, unpacker.events);
+
+        //The analyzers run again inside of ProcessEvent, so this includes their time as well.
+        report.Add("process", "DetectorDriver::ProcessEvent", workload + " " + to_string(driver->GetNumberOfThreads()) +
+                " threads", TimeFastest(report.GetRepeats(), [&]() { ProcessEvents(unpacker.events); }), bytes, hits);
+
+        const int retval = report.Finish();
+        delete driver;
+        return retval;
+    } catch (exception &ex) {
+        cerr << Display::ErrorStr(ex.what()) << endl;
+        return 1;
+    }
+}
@@ -5,6 +5,7 @@
 #ifndef __CHANEVENT_HPP__
 #define __CHANEVENT_HPP__
 
+#include <utility>
 #include <vector>
 
 #include "ChannelConfiguration.hpp"
@@ -28,9 +29,15 @@ public:
     ChanEvent() {}
 
     ///Constructor taking the base class as an argument so that we can set
-    /// the trace information properly
+    /// the trace information properly. The trace is copied from evt.
     ///@param[in] evt : The event that we are going to assign here.
-    ChanEvent(XiaData &evt) : ProcessedXiaData(evt) {}
+    ChanEvent(const XiaData &evt) : ProcessedXiaData(evt) {}
+
+    ///Constructor taking the base class as an argument so that we can set
+    /// the trace information properly. The trace is moved out of evt, see
+    /// ProcessedXiaData.
+    ///@param[in] evt : The event that we are going to assign here.
+    ChanEvent(XiaData &&evt) : ProcessedXiaData(std::move(evt)) {}
 
     ///Default Destructor
     ~ChanEvent() {}
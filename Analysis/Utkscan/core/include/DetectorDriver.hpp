@@ -43,10 +43,13 @@
 #include "Globals.hpp"
 #include "Messenger.hpp"
 #include "Plots.hpp"
+#include "StageTimer.hpp"
 #include "WalkCorrector.hpp"
 
 class Calibration;
 
+class ThreadPool;
+
 class RawEvent;
 
 class EventProcessor;
@@ -82,6 +85,42 @@ public:
     * \param [in] rawev : the raw event to process */
     void ProcessEvent(RawEvent &rawev);
 
+    /*! \return The raw event that the next event should be built into. This
+     * is the raw event given to Init when we process the events one at a
+     * time, and the next free event of the batch otherwise. */
+    RawEvent &GetNextEvent(void);
+
+    /*! Processes the event that was built into GetNextEvent. When we process
+     * the events one at a time this is ProcessEvent followed by zeroing the
+     * event. Otherwise the event is added to the batch, and a full batch is
+     * processed at once.
+     *
+     * The events of a batch are calibrated and handed to the copies of the
+     * processors that can be cloned in parallel, one worker per event. Then
+     * the places of the TreeCorrelator are activated and the rest of the
+     * processors are run on each event in turn, in the order that the events
+     * were built. While an event is in that ordered stage GetProcessor
+     * returns the copies that processed it.
+     * \param [in] usedDetectors : the detector types in the event */
+    void ProcessNextEvent(const std::set<std::string> &usedDetectors);
+
+    /*! Processes the events that are left in a batch that isn't full. This
+     * has to be called after the last event, and before the histograms are
+     * written if they should include every event. */
+    void FinishEvents(void);
+
+    /*! Sets the number of threads that process the events. This has to be
+     * called before Init.
+     * \param [in] numberOfThreads : the number of threads, including the
+     * one that builds the events. Zero or one processes the events one at a
+     * time with ProcessEvent. */
+    void SetNumberOfThreads(const unsigned int &numberOfThreads) {
+        numberOfThreads_ = numberOfThreads;
+    }
+
+    /*! \return The number of threads that process the events */
+    unsigned int GetNumberOfThreads(void) const { return numberOfThreads_; }
+
     /*! \brief Check threshold and calibrate each channel.
      * Check the thresholds and calibrate the energy for each channel using the
      * calibrations contained in the calibration vector filled during ReadCal()
@@ -137,6 +176,12 @@ public:
         return vecProcess;
     }
 
+    /** \return the list of the Trace Analyzers, in the order that they're
+     * called on each trace */
+    const std::vector<TraceAnalyzer *> &GetTraceAnalyzers(void) const {
+        return vecAnalyzer;
+    }
+
     /** \return The requested event processor
      * \param [in] name : the name of the processor to return */
     EventProcessor *GetProcessor(const std::string &name) const;
@@ -144,17 +189,18 @@ public:
     /** \return the set of detectors used in the analysis */
     const std::set<std::string> &GetUsedDetectors(void) const;
 
-    ///Sets the processor list
+    /** \return The channels whose traces are looked at by one of the
+     * analyzers or processors, indexed by the DetectorLibrary index. Channels
+     * of type "ignore" never need their traces. */
+    std::vector<bool> GetTraceChannels(void) const;
+
+    ///Sets the processor list, and looks up the timers for their PreProcess and Process
     ///@param[in] a : The vector containing the pointer to the event processors
-    void SetEventProcessors(const std::vector<EventProcessor *> &a) {
-        vecProcess = a;
-    }
+    void SetEventProcessors(const std::vector<EventProcessor *> &a);
 
-    ///Sets the analyzer list
+    ///Sets the analyzer list, and looks up the timers for their Analyze
     ///@param[in] a : The vector containing the pointer to the Trace Analyzers
-    void SetTraceAnalyzers(const std::vector<TraceAnalyzer *> &a) {
-        vecAnalyzer = a;
-    }
+    void SetTraceAnalyzers(const std::vector<TraceAnalyzer *> &a);
 
     /** Default Destructor */
     virtual ~DetectorDriver();
@@ -167,6 +213,58 @@ private:
     DetectorDriver &operator=(DetectorDriver const &);//!< Equality constructor
     static DetectorDriver *instance;//!< The only instance of DetectorDriver
 
+    /** Everything that one event of a batch needs while it is processed in
+     * parallel with the others. */
+    struct Worker {
+        RawEvent *event; //!< The event, which owns its channels
+        std::set<std::string> usedDetectors; //!< The detector types in the event
+        std::vector<TraceAnalyzer *> analyzers; //!< Copies of vecAnalyzer, empty if they can't all be cloned
+        std::vector<EventProcessor *> processors; //!< Copies of vecProcess, NULL for the ones run in order
+    };
+
+    /** Calibrates the channels of an event and fills its summaries
+     * \param [in] rawev : the event to calibrate
+     * \param [in] analyzers : the trace analyzers to use */
+    void CalibrateEvent(RawEvent &rawev, const std::vector<TraceAnalyzer *> &analyzers);
+
+    /** Runs the PreProcess and then the Process of the processors that have
+     * an event.
+     * \param [in] rawev : the event to process
+     * \param [in] processors : the processors, NULL entries are skipped */
+    void RunProcessors(RawEvent &rawev, const std::vector<EventProcessor *> &processors);
+
+    /** Activates the places of the TreeCorrelator for the channels of an
+     * event. The event has to be calibrated.
+     * \param [in] rawev : the event that activates the places */
+    void ActivatePlaces(const RawEvent &rawev);
+
+    /** Resets the places of the TreeCorrelator that are resetable */
+    void ResetPlaces(void);
+
+    /** Check threshold and calibrate a channel with the given analyzers
+     * \param [in] chan : the channel to do the calibration on
+     * \param [in] rawev : the raw event to write the information into
+     * \param [in] analyzers : the trace analyzers to use
+     * \return an unused integer */
+    int ThreshAndCal(ChanEvent *chan, RawEvent &rawev, const std::vector<TraceAnalyzer *> &analyzers);
+
+    /** Makes the copies of the processors and analyzers for each worker */
+    void InitWorkers(void);
+
+    /** Processes the first numberOfEvents_ events of workers_ */
+    void ProcessBatch(void);
+
+    /** Deletes the workers and their copies */
+    void DeleteWorkers(void);
+
+    unsigned int numberOfThreads_; //!< The number of threads that process the events
+    ThreadPool *pool_; //!< The threads that process a batch, NULL when we process one event at a time
+    RawEvent *rawev_; //!< The raw event that was given to Init
+    std::vector<Worker> workers_; //!< One worker for each event in a batch
+    std::vector<EventProcessor *> orderedProcessors_; //!< vecProcess without the processors that were cloned
+    size_t numberOfEvents_; //!< The number of events in the current batch
+    StageTimer *orderedTimer_; //!< Times the ordered stage of each event in a batch
+
     std::vector<EventProcessor *> vecProcess; /**< vector of processors to handle each event */
 
     std::vector<TraceAnalyzer *> vecAnalyzer; /**< object which analyzes traces of channels to extract
@@ -174,6 +272,10 @@ private:
     std::set<std::string> knownDetectors; /**< list of valid detectors that can
                    be used as detector types */
     std::string cfg_; //!< The configuration file to read
+    StageTimer *eventTimer_; //!< Times each call to ProcessEvent
+    std::vector<StageTimer *> analyzerTimers_; //!< Times the Analyze of each of vecAnalyzer
+    std::vector<StageTimer *> preProcessTimers_; //!< Times the PreProcess of each of vecProcess
+    std::vector<StageTimer *> processTimers_; //!< Times the Process of each of vecProcess
     std::pair<double, time_t> pixieToWallClock; /**< rough estimate of pixie to wall clock */
 };
 
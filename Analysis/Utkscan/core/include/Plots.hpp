@@ -9,8 +9,8 @@
 #include <fstream>
 #include <string>
 #include <map>
-#include <set>
 #include <string>
+#include <vector>
 
 #include "PlotsRegister.hpp"
 #include "RootHandler.hpp"
@@ -52,8 +52,8 @@ public:
     * \param [in] xLow : the Low range of the histogram
     * \param [in] xHigh : the High range of the histogram
     * \param [in] mne : the mnemonic for the histogram
-    * \return true if things go all right */
-    bool DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int xHistLength, int xLow,
+    * \return the handle of the histogram */
+    HistogramHandle DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int xHistLength, int xLow,
                             int xHigh, const std::string &mne = "");
 
     /*! \brief Declares a 1D histogram calls the C++ wrapper for DAMM
@@ -62,8 +62,8 @@ public:
     * \param [in] title : The title for the histogram
     * \param [in] halfWordsPerChan : the half words per channel in the his
     * \param [in] mne : the mnemonic for the histogram
-    * \return true if things go all right */
-    bool DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan = 2,
+    * \return the handle of the histogram */
+    HistogramHandle DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan = 2,
                             const std::string &mne = "");
 
     /*! \brief Declares a 1D histogram calls the C++ wrapper for DAMM
@@ -73,8 +73,8 @@ public:
     * \param [in] halfWordsPerChan : the half words per channel in the his
     * \param [in] contraction : the histogram contraction number
     * \param [in] mne : the mnemonic for the histogram
-    * \return true if things go all right */
-    bool DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int contraction,
+    * \return the handle of the histogram */
+    HistogramHandle DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int contraction,
                             const std::string &mne = "");
 
     /*! \brief Declares a 2D histogram calls the C++ wrapper for DAMM
@@ -90,8 +90,8 @@ public:
     * \param [in] yLow : the Low for the y-range of the histogram
     * \param [in] yHigh : the High for the y-range of the histogram
     * \param [in] mne : the mnemonic for the histogram
-    * \return true if things go all right */
-    bool DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan, int xHistLength,
+    * \return the handle of the histogram */
+    HistogramHandle DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan, int xHistLength,
                             int xLow, int xHigh, int yHistLength, int yLow, int yHigh, const std::string &mne = "");
 
     /*! \brief Declares a 2D histogram calls the C++ wrapper for DAMM
@@ -101,8 +101,8 @@ public:
     * \param [in] title : The title of the histogram
     * \param [in] halfWordPerChan : the half words per channel in the his
     * \param [in] mne : the mnemonic for the histogram
-    * \return true if things go all right */
-    bool DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordPerChan = 1,
+    * \return the handle of the histogram */
+    HistogramHandle DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordPerChan = 1,
                             const std::string &mne = "");
 
     /*! \brief Declares a 2D histogram calls the C++ wrapper for DAMM
@@ -114,8 +114,8 @@ public:
     * \param [in] xContraction : the histogram x contraction number
     * \param [in] yContraction : the histogram y contraction number
     * \param [in] mne : the mnemonic for the histogram
-    * \return true if things go all right */
-    bool DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan, int xContraction,
+    * \return the handle of the histogram */
+    HistogramHandle DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan, int xContraction,
                             int yContraction, const std::string &mne = "");
 
     /*! \brief Plots into histogram defined by dammId
@@ -136,6 +136,26 @@ public:
     * \return true if successful */
     bool Plot(const std::string &mne, double val1, double val2 = -1, double val3 = -1, const char *name = "h");
 
+    /*! \brief Plots into the histogram of a handle from DeclareHistogram or GetHandle. This skips the lookups
+    * that the other Plot methods do, so processors can keep the handles of the histograms they fill most.
+    * \param [in] handle : the handle of the histogram
+    * \param [in] val1 : the x value
+    * \param [in] val2 : the y value, -1 for a 1D histogram
+    * \param [in] val3 : the z value, -1 for a 1D or 2D histogram. A 2D histogram takes it as the y value when val2
+    * is -1. The ROOT histograms don't take weights, nothing is plotted if the number of values that aren't -1
+    * doesn't match the dimension of the histogram.
+    * \param [in] name : the name of the histogram in ROOT (not implemented now)
+    * \return true if successful */
+    bool Plot(const HistogramHandle &handle, double val1, double val2 = -1, double val3 = -1, const char *name = "h");
+
+    /** \return the handle of histogram number id, which is false if it hasn't been declared
+    * \param [in] id : the id of the histogram without the offset */
+    HistogramHandle GetHandle(int id) const;
+
+    /** \return the handle of the histogram with mnemonic mne, which is false if it hasn't been declared
+    * \param [in] mne : the mnemonic of the histogram */
+    HistogramHandle GetHandle(const std::string &mne) const;
+
     /** Method to test if a parameter is inside of a loaded banana
     *
     * Will not help you defend against a man wielding a pointed stick.
@@ -154,8 +174,8 @@ private:
     int range_;
     /** Name of the owner of plots, mainly for debugging */
     std::string name_;
-    /** set of int (relative dammId without offsets */
-    std::set<int> idList_;
+    /** Handles of the declared histograms, indexed by relative dammId without offsets */
+    std::vector<HistogramHandle> handles_;
     /** Map of mnemonic -> int */
     std::map<std::string, int> mneList;
     /** Map of dammid -> title, helps debugging duplicated dammids*/
@@ -64,6 +64,14 @@ public:
     * \param [in] usedev : the detector summary to zero */
     void Zero(const std::set<std::string> &usedev);
 
+    /** Makes this event a copy of another one, so that the processors that
+    * were initialized with this event can process the other. The summaries
+    * that were handed out by this event stay where they are. The channels
+    * still belong to the other event, so this one should only be cleared
+    * afterwards, not zeroed.
+    * \param [in] rhs : the event to copy */
+    void CopyFrom(const RawEvent &rhs);
+
     /** \brief Get a pointer to a specific detector summary
     *
     * Retrieve from the detector summary map a pointer to the specific detector
@@ -11,10 +11,57 @@
 #include <TH2.h>
 #include <TH3.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-//! A Class to handle outputting things into ROOT, registering histograms, filling trees, all that jazzy stuff.
+#include <cstdint>
+
+#include "DenseHistogram.hpp"
+
+///A histogram that has been looked up once, so that it can be filled without looking it up again. The handles are
+/// handed out by RootHandler::GetHandle, and the default constructed one refers to no histogram at all.
+class HistogramHandle {
+public:
+    ///Default constructor that refers to no histogram.
+    HistogramHandle() : index_(0), id_(0), dimension_(0) {}
+
+    ///@return True if the handle refers to a histogram
+    explicit operator bool() const { return dimension_ != 0; }
+
+    ///@return The number of dimensions of the histogram, or 0 if the handle doesn't refer to one.
+    unsigned int GetDimension() const { return dimension_; }
+
+    ///@return The id of the histogram including the offset of the Plots block that declared it.
+    unsigned int GetId() const { return id_; }
+
+private:
+    friend class RootHandler;
+
+    ///Constructor used by RootHandler when it registers a histogram.
+    ///@param[in] index : The index of the histogram in the table of the RootHandler
+    ///@param[in] id : The id of the histogram
+    ///@param[in] dimension : The number of dimensions of the histogram
+    HistogramHandle(const unsigned int &index, const unsigned int &id, const unsigned int &dimension) :
+            index_(index), id_(id), dimension_(dimension) {}
+
+    unsigned int index_; ///< The index of the histogram in the table of the RootHandler
+    unsigned int id_; ///< The id of the histogram
+    unsigned int dimension_; ///< The number of dimensions of the histogram
+};
+
+//! A Class to handle outputting things into ROOT, registering histograms, filling trees, all that jazzy stuff. The
+//! histograms are counted in DenseHistograms as they're plotted, which hold everything that has been plotted. Any
+//! number of threads may plot at once, each into its own shard of the counts. A ROOT histogram is only built from the
+//! shards to be written, which happens on a thread of its own, and freed once it has been. The exception is a
+//! histogram that somebody asked for with one of the Get methods, which is kept in the file for them and has the
+//! shards added into it from then on. The sums that ROOT uses for the mean and RMS are kept along with the counts, so
+//! they're what TH1::Fill would have given. Flush, the Get methods and the destructor read the shards, so nothing may
+//! be plotting while those are called.
 class RootHandler {
 public:
     ///Get method that initializes the RootHandler with a default name for the ROOT File: histograms.root.
@@ -31,12 +78,17 @@ public:
     /// the destructor is called. Ex. delete RootHandler::get();
     ~RootHandler();
 
-    /// Method to access a specific histogram
+    /// Method to access a specific histogram, which brings it up to date with everything that has been plotted.
     /// @param [in] id : The id of the histogram that we're after, this should include the OFFSET that the
     /// Analyzer/Processor defines in its namespace.
     /// @returns a TH1D pointer to the correct histogram
     TH1D *Get1DHistogram(const unsigned int &id);
 
+    ///Looks up a histogram once so that it can be filled with Plot(handle, ...) from then on.
+    ///@param[in] id : The id of the histogram including the OFFSET of the Analyzer/Processor
+    ///@return The handle of the histogram, which is false if the histogram hasn't been registered.
+    HistogramHandle GetHandle(const unsigned int &id) const;
+
     /// Method to access a specific histogram
     /// @param [in] id : The id of the histogram that we're after, this should include the OFFSET that the
     /// Analyzer/Processor defines in its namespace.
@@ -64,15 +116,32 @@ public:
     /// @return true if successful
     bool Plot(const unsigned int &id, const double &xval, const double &yval = -1, const double &zval = -1);
 
+    ///Plots into a histogram that was looked up with GetHandle, without any further lookups or casts. The values
+    /// have the same meaning as they do for the other Plot.
+    ///@param[in] handle : The handle of the histogram
+    ///@param[in] xval : the x value
+    ///@param[in] yval : the y value
+    ///@param[in] zval : the z value, or the y value of a histogram registered with only x and z bins
+    ///@return False if the handle doesn't refer to a histogram, or if the number of values doesn't match the number
+    /// of dimensions of the histogram.
+    bool Plot(const HistogramHandle &handle, const double &xval, const double &yval = -1, const double &zval = -1);
+
+    ///Plots many values into a 1D histogram at once.
+    ///@param[in] handle : The handle of the histogram
+    ///@param[in] xvals : The x values
+    ///@param[in] n : The number of values
+    ///@return False if the handle doesn't refer to a 1D histogram.
+    bool Plot(const HistogramHandle &handle, const double *xvals, const size_t &n);
+
     /// Wrapper function for the ROOT TH* constructors. We've simplified things to make it look more like DAMM for now.
     ///@param[in] id : The numerical ID of the histogram to register. The method prepends it with an "h", ex. h1
     ///@param[in] title : The Title of the histogram
     ///@param[in] xbins : The numbers of bins in the X Direction
     ///@param[in] yBins : The Number of bins in the Y Direction
     ///@param[in] zBins : The Number of bins in teh Z direction.
-    ///@return a pointer to the newly registered histogram, or a pointer to the histogram of the same id
-    TH1 *RegisterHistogram(const unsigned int &id, const std::string &title, const unsigned int &xbins,
-                           const unsigned int &yBins = 0, const unsigned int &zBins = 0);
+    ///@return the handle of the newly registered histogram, or the handle of the histogram of the same id
+    HistogramHandle RegisterHistogram(const unsigned int &id, const std::string &title, const unsigned int &xbins,
+                                      const unsigned int &yBins = 0, const unsigned int &zBins = 0);
 
     ///Registers a TTree with the provided name and description.
     ///@param[in] name : The name of the tree to register
@@ -81,13 +150,57 @@ public:
     /// TTree if one was inserted.
     TTree *RegisterTree(const std::string &name, const std::string &description = "");
 
-    ///Method that will update all the trees and histograms in the system. It spawns a new thread that writes histograms
-    ///  to disk. It locks the histogramFile_ for writing. Trees write to disk serially due to the complex memory
-    ///  management necessary to write them in parallel. BEWARE: This could become a time sink if you have a lot of
-    ///  big trees defined in the system.
+    ///Method that will update all the trees and histograms in the system. It builds snapshots of the histograms that
+    ///  changed since the last flush and then spawns a new thread that writes the snapshots to disk and frees them.
+    ///  Nothing is written, trees included, if the last flush is still being written. Trees write to disk serially
+    ///  due to the complex memory management necessary to write them in parallel. BEWARE: This could become a time
+    ///  sink if you have a lot of big trees defined in the system.
     void Flush();
 
+    ///@return The number of bytes that have been written to the histogram file by the flushes and the destructor.
+    static uint64_t GetFlushedBytes() { return flushedBytes_; }
+
+    ///@return The number of histograms that have been written by the flushes and the destructor.
+    static uint64_t GetFlushedHistograms() { return flushedHistograms_; }
+
+    ///Merges the output of several scans into the files that a single scan would have written. The histograms are
+    /// added together and the trees are chained in the order that the scans are given.
+    ///@param[in] parts : The file names that were given to the scans that we are merging
+    ///@param[in] fileName : The file name to give the merged output
+    ///@return True if both the histogram and the tree files were merged
+    static bool MergeOutputs(const std::vector<std::string> &parts, const std::string &fileName);
+
 private:
+    ///A registered histogram. The counts are kept in the shards, unless they've been added into the ROOT histogram.
+    struct HistogramEntry {
+        TH1 *histogram; ///< The ROOT histogram, nullptr unless somebody asked for it with one of the Get methods
+        bool isChanged; ///< True if histogram may have changed since it was last flushed
+        uint64_t flushedEntries; ///< The number of entries in the shards when the histogram was last flushed
+        unsigned int id; ///< The id of the histogram
+        std::string title; ///< The title of the histogram
+        unsigned int xBins; ///< The number of bins in x
+        unsigned int yBins; ///< The number of bins in y, which are the z bins for a histogram of x and z
+        unsigned int zBins; ///< The number of bins in z for a 3D histogram
+
+        ///Constructor
+        ///@param[in] id_ : The id of the histogram
+        ///@param[in] title_ : The title of the histogram
+        ///@param[in] xBins_ : The number of bins in x
+        ///@param[in] yBins_ : The number of bins in y
+        ///@param[in] zBins_ : The number of bins in z
+        HistogramEntry(const unsigned int &id_, const std::string &title_, const unsigned int &xBins_,
+                       const unsigned int &yBins_, const unsigned int &zBins_) :
+                histogram(nullptr), isChanged(false), flushedEntries(0), id(id_), title(title_), xBins(xBins_),
+                yBins(yBins_), zBins(zBins_) {}
+    };
+
+    ///The counts that one thread has plotted, less any that were added into the ROOT histograms. Every thread that
+    /// plots gets a shard of its own, so that Plot doesn't need a lock.
+    struct Shard {
+        ///The counts of each histogram, indexed by the handles. They're nullptr until the thread plots into them.
+        std::vector<std::unique_ptr<DenseHistogram> > counts;
+    };
+
     ///The static instance of the RootHandler that everybody can access.
     static RootHandler *instance_;
 
@@ -106,14 +219,58 @@ private:
     ///@returns a pointer to the histogram in the list if we found it.
     TH1 *GetHistogramFromList(const unsigned int &id, const std::string &callingFunctionName);
 
-    ///Method that loops through histogramList_ and calls Write() on everything that has a non-zero number of entries.
-    static void AsyncFlush();
+    ///Method that writes each of the snapshots that Flush took into histogramFile_ and then deletes them. It runs on
+    /// writer_, and never changes the current directory, since that's shared with the scan thread.
+    ///@param[in] snapshots : The snapshots of the histograms that changed
+    static void AsyncFlush(const std::vector<TH1 *> &snapshots);
+
+    ///Waits for the writer to finish the last flush. Anything else that touches histogramFile_ has to call this first.
+    static void JoinWriter();
+
+    ///Adds the counts of a histogram from every shard into its ROOT histogram, which is created in histogramFile_ the
+    /// first time, and empties them. It waits for the writer first, since the histogram goes into its file.
+    ///@param[in] index : The index of the histogram in histograms_
+    ///@return The ROOT histogram
+    static TH1 *Materialize(const size_t &index);
+
+    ///Adds the counts of a histogram from every shard into a new ROOT histogram that isn't in any directory. The
+    /// shards are left as they are.
+    ///@param[in] index : The index of the histogram in histograms_
+    ///@return The new histogram, which the caller has to delete
+    static TH1 *CreateSnapshot(const size_t &index);
+
+    ///@param[in] entry : The histogram to create
+    ///@return A new, empty ROOT histogram of the same bins as the entry
+    static TH1 *CreateHistogram(const HistogramEntry &entry);
+
+    ///Adds the counts of a histogram from every shard into a ROOT histogram, along with their entries and the sums
+    /// that the statistics are worked out from.
+    ///@param[in] histogram : The histogram to add the counts to, which has to have the same bins as the entry
+    ///@param[in] index : The index of the histogram in histograms_
+    ///@param[in] reset : True if the shards are emptied once they've been added
+    ///@return True if any of the shards had counts to add
+    static bool AddShards(TH1 *histogram, const size_t &index, const bool &reset);
+
+    ///@param[in] index : The index of the histogram in histograms_
+    ///@return The number of entries of the histogram in all of the shards.
+    static uint64_t GetShardEntries(const size_t &index);
+
+    ///@param[in] handle : The handle of a histogram
+    ///@return The counts of the histogram in the shard of the calling thread, which are created if need be.
+    static DenseHistogram &GetShardCounts(const HistogramHandle &handle);
 
     static TFile *histogramFile_; //!< ROOT file storing user registered histograms
-    static std::map<unsigned int, TH1 *> histogramList_; //!< List of user registered histograms
+    static std::map<unsigned int, HistogramHandle> histogramList_; //!< The handles of the user registered histograms
+    static std::vector<HistogramEntry> histograms_; //!< The user registered histograms, indexed by their handles
     static TFile *treeFile_; //!< ROOT File storing user registered trees.
     static std::map<std::string, TTree *> treeList_; //!< The list of user registered trees
-    static std::mutex flushMutex_; //!< Ensures only one thread writes to histogramFile_
+    static std::thread writer_; //!< The thread that writes the snapshots of the histograms to histogramFile_
+    static std::atomic<bool> isWriting_; //!< True while the writer is writing the snapshots
+    static std::atomic<uint64_t> flushedBytes_; //!< The number of bytes that the histogram writes have taken
+    static std::atomic<uint64_t> flushedHistograms_; //!< The number of histograms that have been written
+    static std::vector<std::unique_ptr<Shard> > shards_; //!< The shards of every thread that has plotted
+    static std::mutex registryMutex_; //!< Guards histogramList_, histograms_ and shards_ when they're added to
+    static std::atomic<unsigned int> generation_; //!< Counts the handlers, so a thread can tell its shard is gone
 };
 
 #endif // __ROOTHANDLER_HPP_
\ No newline at end of file
@@ -0,0 +1,88 @@
+///@file ScanCoordinator.hpp
+///@brief Splits a run, or a list of runs, into spill ranges that are scanned by separate utkscan processes and merges
+/// their output.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#ifndef __SCANCOORDINATOR_HPP__
+#define __SCANCOORDINATOR_HPP__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "SpillIndex.h"
+
+///Runs utkscan in coordinator mode. The spill index of each run is used to split it into contiguous ranges of spills
+/// with about the same number of hits. Each range is scanned by a utkscan worker, which is the same program started
+/// in batch mode with a --spill-range and its own output file. All of the workers measure run times from the first
+/// event of the first run. When they've all finished, the partial histograms are added together and the partial
+/// trees are chained, in the order of the runs and spills, into the output files that a serial scan would write.
+class ScanCoordinator {
+public:
+    ///Constructor that picks the coordinator options out of the command line. Every other option is handed to the
+    /// workers.
+    ///@param[in] argc : The number of arguments in argv
+    ///@param[in] argv : The command line that utkscan was started with
+    ///@throws invalid_argument if the coordinator options can't be understood or there are no input files
+    ScanCoordinator(int argc, char *argv[]);
+
+    ///@param[in] argc : The number of arguments in argv
+    ///@param[in] argv : The command line that utkscan was started with
+    ///@return True if the command line asks for a coordinated scan.
+    static bool IsRequested(int argc, char *argv[]);
+
+    ///Splits the spills [first, end) into contiguous ranges with about the same number of hits in each.
+    ///@param[in] index : The spill index of the run
+    ///@param[in] first : The first spill to scan
+    ///@param[in] end : One past the last spill to scan
+    ///@param[in] parts : The number of ranges to make. Fewer are made if there aren't enough spills.
+    ///@return The first and last spill in each range.
+    static std::vector<std::pair<size_t, size_t> > SplitSpills(const SpillIndex &index, const size_t &first,
+                                                               const size_t &end, const unsigned int &parts);
+
+    ///Scans all of the runs with the workers and merges their output.
+    ///@return Zero if every worker finished and their output was merged, one otherwise.
+    int Execute();
+
+private:
+    ///A range of spills in a run that a single worker scans.
+    struct Task {
+        std::string inputFile; ///< The run to scan
+        size_t firstSpill; ///< The first spill in the range
+        size_t lastSpill; ///< The last spill in the range
+        std::string output; ///< The output name given to the worker
+    };
+
+    ///Reads the spill index of each run and fills the task list.
+    ///@return True if every run has an index and at least one spill to scan.
+    bool BuildTasks();
+
+    ///Starts a worker for a task. Its terminal output goes to a log file next to its output.
+    ///@param[in] task : The task to start the worker for
+    ///@return The process ID of the worker, or -1 if it couldn't be started.
+    pid_t LaunchWorker(const Task &task);
+
+    ///Runs every task with at most numWorkers_ workers at a time.
+    ///@return True if every worker exited cleanly.
+    bool RunTasks();
+
+    ///Deletes the output and log files of the workers.
+    void RemovePartialOutputs();
+
+    std::string program_; ///< The program that the workers run
+    std::vector<std::string> workerArgs_; ///< The arguments shared by every worker
+    std::vector<std::string> inputFiles_; ///< The runs to scan, in order
+    std::string output_; ///< The output name that the merged files are given
+    unsigned int numWorkers_; ///< The number of workers that run at once
+    unsigned long long startTime_; ///< Only scan spills with hits at or after this time
+    unsigned long long stopTime_; ///< Only scan spills with hits at or before this time
+    size_t firstSpill_; ///< The first spill of each run to scan
+    size_t lastSpill_; ///< The last spill of each run to scan
+    bool hasFirstTime_; ///< True if the user gave the time of the first event of the run
+    unsigned long long firstTime_; ///< The time of the first event in the first run
+    std::vector<Task> tasks_; ///< The ranges that the workers scan, in the order that their output is merged
+};
+
+#endif //__SCANCOORDINATOR_HPP__
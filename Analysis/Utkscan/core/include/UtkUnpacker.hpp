@@ -27,6 +27,10 @@ public:
     /// Default destructor that deconstructs the DetectorDriver singleton
     ~UtkUnpacker();
 
+    ///@brief Processes the events that the DetectorDriver is still holding in a batch, so that they're in the
+    /// histograms at the end of each scan rather than only when the driver is deleted.
+    void FinishEvents();
+
 private:
     DetectorDriver *driver_;
     DetectorLibrary *detectorLibrary_;
@@ -14,6 +14,7 @@
 #include "HighResTimingData.hpp"
 #include "RandomInterface.hpp"
 #include "RawEvent.hpp"
+#include "ThreadPool.hpp"
 #include "TraceAnalyzer.hpp"
 #include "TreeCorrelator.hpp"
 
@@ -31,13 +32,24 @@ using namespace dammIds::raw;
 
 DetectorDriver *DetectorDriver::instance = NULL;
 
+///The processors of the worker whose event is being processed on this thread, so that GetProcessor can hand out the
+/// copies that processed it. NULL when the processors in vecProcess are being used.
+static thread_local const vector<EventProcessor *> *currentProcessors = NULL;
+
+///The number of events in a batch for each thread. A few events for each thread keeps them busy while the events take
+/// different amounts of time.
+static const unsigned int eventsPerThread = 16;
+
 DetectorDriver *DetectorDriver::get() {
     if (!instance)
         instance = new DetectorDriver();
     return instance;
 }
 
-DetectorDriver::DetectorDriver() : histo_(OFFSET, RANGE, "DetectorDriver") {
+DetectorDriver::DetectorDriver() : histo_(OFFSET, RANGE, "DetectorDriver"), numberOfThreads_(1), pool_(NULL),
+                                   rawev_(NULL), numberOfEvents_(0) {
+    eventTimer_ = StageTimers::get()->Get("driver", "ProcessEvent");
+    orderedTimer_ = StageTimers::get()->Get("driver", "ProcessEventInOrder");
     try {
         DetectorDriverXmlParser parser;
         parser.ParseNode(this);
@@ -55,6 +67,14 @@ DetectorDriver::DetectorDriver() : histo_(OFFSET, RANGE, "DetectorDriver") {
 }
 
 DetectorDriver::~DetectorDriver() {
+    try {
+        FinishEvents();
+    } catch (exception &e) {
+        cout << Display::ErrorStr("Exception caught at DetectorDriver::~DetectorDriver") << endl;
+        cout << "\t" << Display::ErrorStr(e.what()) << endl;
+    }
+    DeleteWorkers();
+
     for (vector<EventProcessor *>::iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
         delete (*it);
     vecProcess.clear();
@@ -70,6 +90,23 @@ DetectorDriver::~DetectorDriver() {
     instance = NULL;
 }
 
+void DetectorDriver::SetEventProcessors(const std::vector<EventProcessor *> &a) {
+    vecProcess = a;
+    preProcessTimers_.clear();
+    processTimers_.clear();
+    for (vector<EventProcessor *>::const_iterator it = vecProcess.begin(); it != vecProcess.end(); it++) {
+        preProcessTimers_.push_back(StageTimers::get()->Get("preprocess", (*it)->GetName()));
+        processTimers_.push_back(StageTimers::get()->Get("process", (*it)->GetName()));
+    }
+}
+
+void DetectorDriver::SetTraceAnalyzers(const std::vector<TraceAnalyzer *> &a) {
+    vecAnalyzer = a;
+    analyzerTimers_.clear();
+    for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
+        analyzerTimers_.push_back(StageTimers::get()->Get("analyzer", (*it)->GetName()));
+}
+
 void DetectorDriver::Init(RawEvent &rawev) {
     for (vector<TraceAnalyzer *>::iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++) {
         (*it)->Init();
@@ -81,46 +118,162 @@ void DetectorDriver::Init(RawEvent &rawev) {
 
     walk_ = DetectorLibrary::get()->GetWalkCorrections();
     cali_ = DetectorLibrary::get()->GetCalibrations();
+
+    rawev_ = &rawev;
+    DeleteWorkers();
+    if (numberOfThreads_ > 1)
+        InitWorkers();
 }
 
-void DetectorDriver::ProcessEvent(RawEvent &rawev) {
-    histo_.Plot(dammIds::raw::D_NUMBER_OF_EVENTS, dammIds::GENERIC_CHANNEL);
-    try {
-        for (vector<ChanEvent *>::const_iterator it = rawev.GetEventList().begin(); it != rawev.GetEventList().end(); ++it) {
-            PlotRaw((*it));
-            ThreshAndCal((*it), rawev);
-            PlotCal((*it));
+/// The processors that can be cloned get a copy for each worker, which is initialized on the worker's own event so
+/// that it finds its summaries there. The worker's event also gets all of the summaries of rawev_, so that the
+/// processors that run in order find theirs once the worker's event has been copied into rawev_. If any of the
+/// analyzers can't be cloned the events are calibrated on the calling thread instead.
+void DetectorDriver::InitWorkers() {
+    // The randoms are created on first use, which should not happen on the workers.
+    RandomInterface::get();
+
+    bool analyzersCloneable = true;
+    for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++) {
+        TraceAnalyzer *clone = (*it)->Clone();
+        analyzersCloneable = analyzersCloneable && clone;
+        delete clone;
+    }
+
+    orderedProcessors_ = vecProcess;
+    for (size_t i = 0; i < vecProcess.size(); i++) {
+        EventProcessor *clone = vecProcess[i]->Clone();
+        if (clone)
+            orderedProcessors_[i] = NULL;
+        delete clone;
+    }
+
+    workers_.resize(numberOfThreads_ * eventsPerThread);
+    for (vector<Worker>::iterator worker = workers_.begin(); worker != workers_.end(); worker++) {
+        worker->event = new RawEvent();
+        worker->event->CopyFrom(*rawev_);
+
+        if (analyzersCloneable) {
+            for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++) {
+                worker->analyzers.push_back((*it)->Clone());
+                worker->analyzers.back()->Init();
+                worker->analyzers.back()->SetLevel(20);
+            }
+        }
+
+        for (size_t i = 0; i < vecProcess.size(); i++) {
+            worker->processors.push_back(orderedProcessors_[i] ? NULL : vecProcess[i]->Clone());
+            if (worker->processors.back())
+                worker->processors.back()->Init(*worker->event);
+        }
+    }
+
+    pool_ = new ThreadPool(numberOfThreads_ - 1);
+}
+
+void DetectorDriver::DeleteWorkers() {
+    delete pool_;
+    pool_ = NULL;
+
+    for (vector<Worker>::iterator worker = workers_.begin(); worker != workers_.end(); worker++) {
+        worker->event->Zero(worker->usedDetectors);
+        delete worker->event;
+        for (vector<TraceAnalyzer *>::iterator it = worker->analyzers.begin(); it != worker->analyzers.end(); it++)
+            delete *it;
+        for (vector<EventProcessor *>::iterator it = worker->processors.begin(); it != worker->processors.end(); it++)
+            delete *it;
+    }
+    workers_.clear();
+    orderedProcessors_.clear();
+    numberOfEvents_ = 0;
+}
+
+RawEvent &DetectorDriver::GetNextEvent() {
+    if (!pool_)
+        return *rawev_;
+    return *workers_[numberOfEvents_].event;
+}
+
+void DetectorDriver::ProcessNextEvent(const std::set<std::string> &usedDetectors) {
+    if (!pool_) {
+        ProcessEvent(*rawev_);
+        rawev_->Zero(usedDetectors);
+        return;
+    }
 
-            string place = (*it)->GetChanID().GetPlaceName();
-            if (place == "__9999")
-                continue;
+    workers_[numberOfEvents_++].usedDetectors = usedDetectors;
+    if (numberOfEvents_ == workers_.size())
+        ProcessBatch();
+}
 
-            if ((*it)->IsSaturated() || (*it)->IsPileup())
-                continue;
+void DetectorDriver::FinishEvents() {
+    if (pool_ && numberOfEvents_ != 0)
+        ProcessBatch();
+}
 
-            double time = (*it)->GetTime();
-            double energy = (*it)->GetCalibratedEnergy();
-            int location = (*it)->GetChanID().GetLocation();
+/// The events that were calibrated in parallel still have to activate the places of the TreeCorrelator in order,
+/// since the places remember what activated them.
+void DetectorDriver::ProcessBatch() {
+    const size_t numberOfEvents = numberOfEvents_;
+    numberOfEvents_ = 0;
 
-            EventData data(time, energy, location);
-            TreeCorrelator::get()->place(place)->activate(data);
+    //The events are zeroed as the ordered stage gets through them, so this is the first one that still holds channels.
+    size_t filled = 0;
+    try {
+        const bool calibrateInParallel = vecAnalyzer.empty() || !workers_.front().analyzers.empty();
+        if (!calibrateInParallel)
+            for (size_t i = 0; i < numberOfEvents; i++)
+                CalibrateEvent(*workers_[i].event, vecAnalyzer);
+
+        pool_->ParallelFor(numberOfEvents, [this, calibrateInParallel](const size_t &i) {
+            Worker &worker = workers_[i];
+            ScopedStageTimer eventTimer(eventTimer_);
+            histo_.Plot(dammIds::raw::D_NUMBER_OF_EVENTS, dammIds::GENERIC_CHANNEL);
+            try {
+                if (calibrateInParallel)
+                    CalibrateEvent(*worker.event, worker.analyzers);
+                RunProcessors(*worker.event, worker.processors);
+            } catch (PaassWarning &w) {
+                cout << Display::WarningStr("Warning caught at DetectorDriver::ProcessBatch") << endl;
+                cout << "\t" << Display::WarningStr(w.what()) << endl;
+            }
+        });
+
+        for (; filled < numberOfEvents; filled++) {
+            Worker &worker = workers_[filled];
+            ScopedStageTimer orderedTimer(orderedTimer_);
+            currentProcessors = &worker.processors;
+            try {
+                rawev_->CopyFrom(*worker.event);
+                ActivatePlaces(*rawev_);
+                RunProcessors(*rawev_, orderedProcessors_);
+            } catch (PaassWarning &w) {
+                cout << Display::WarningStr("Warning caught at DetectorDriver::ProcessBatch") << endl;
+                cout << "\t" << Display::WarningStr(w.what()) << endl;
+            }
+            ResetPlaces();
+            currentProcessors = NULL;
+            rawev_->Clear();
+            worker.event->Zero(worker.usedDetectors);
         }
+    } catch (...) {
+        //The batch has already been handed back, so nothing else would free the channels of the events left in it.
+        cout << endl << Display::ErrorStr("Exception caught at DetectorDriver::ProcessBatch") << endl;
+        currentProcessors = NULL;
+        rawev_->Clear();
+        for (; filled < numberOfEvents; filled++)
+            workers_[filled].event->Zero(workers_[filled].usedDetectors);
+        throw;
+    }
+}
 
-        //!First round is preprocessing, where process result must be guaranteed
-        //!to not to be dependent on results of other Processors.
-        for (vector<EventProcessor *>::iterator iProc = vecProcess.begin(); iProc != vecProcess.end(); iProc++)
-            if ((*iProc)->HasEvent())
-                (*iProc)->PreProcess(rawev);
-        ///In the second round the Process is called, which may depend on other
-        ///Processors.
-        for (vector<EventProcessor *>::iterator iProc = vecProcess.begin(); iProc != vecProcess.end(); iProc++)
-            if ((*iProc)->HasEvent())
-                (*iProc)->Process(rawev);
-        // Clear all places in correlator (if of resetable type)
-        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
-             it != TreeCorrelator::get()->places_.end(); ++it)
-            if ((*it).second->resetable())
-                (*it).second->reset();
+void DetectorDriver::ProcessEvent(RawEvent &rawev) {
+    ScopedStageTimer eventTimer(eventTimer_);
+    histo_.Plot(dammIds::raw::D_NUMBER_OF_EVENTS, dammIds::GENERIC_CHANNEL);
+    try {
+        CalibrateEvent(rawev, vecAnalyzer);
+        ActivatePlaces(rawev);
+        RunProcessors(rawev, vecProcess);
     } catch (PaassWarning &w) {
         cout << Display::WarningStr("Warning caught at DetectorDriver::ProcessEvent") << endl;
         cout << "\t" << Display::WarningStr(w.what()) << endl;
@@ -130,6 +283,60 @@ void DetectorDriver::ProcessEvent(RawEvent &rawev) {
         cout << endl << Display::ErrorStr("Exception caught at DetectorDriver::ProcessEvent") << endl;
         throw;
     }
+    ResetPlaces();
+}
+
+void DetectorDriver::CalibrateEvent(RawEvent &rawev, const std::vector<TraceAnalyzer *> &analyzers) {
+    for (vector<ChanEvent *>::const_iterator it = rawev.GetEventList().begin(); it != rawev.GetEventList().end(); ++it) {
+        PlotRaw((*it));
+        ThreshAndCal((*it), rawev, analyzers);
+        PlotCal((*it));
+    }
+}
+
+void DetectorDriver::ActivatePlaces(const RawEvent &rawev) {
+    for (vector<ChanEvent *>::const_iterator it = rawev.GetEventList().begin(); it != rawev.GetEventList().end(); ++it) {
+        string place = (*it)->GetChanID().GetPlaceName();
+        if (place == "__9999")
+            continue;
+
+        if ((*it)->IsSaturated() || (*it)->IsPileup())
+            continue;
+
+        double time = (*it)->GetTime();
+        double energy = (*it)->GetCalibratedEnergy();
+        int location = (*it)->GetChanID().GetLocation();
+
+        EventData data(time, energy, location);
+        TreeCorrelator::get()->place(place)->activate(data);
+    }
+}
+
+void DetectorDriver::RunProcessors(RawEvent &rawev, const std::vector<EventProcessor *> &processors) {
+    //!First round is preprocessing, where process result must be guaranteed
+    //!to not to be dependent on results of other Processors.
+    for (size_t i = 0; i < processors.size(); i++) {
+        if (processors[i] && processors[i]->HasEvent()) {
+            ScopedStageTimer timer(preProcessTimers_[i]);
+            processors[i]->PreProcess(rawev);
+        }
+    }
+    ///In the second round the Process is called, which may depend on other
+    ///Processors.
+    for (size_t i = 0; i < processors.size(); i++) {
+        if (processors[i] && processors[i]->HasEvent()) {
+            ScopedStageTimer timer(processTimers_[i]);
+            processors[i]->Process(rawev);
+        }
+    }
+}
+
+// Clear all places in correlator (if of resetable type)
+void DetectorDriver::ResetPlaces() {
+    for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
+         it != TreeCorrelator::get()->places_.end(); ++it)
+        if ((*it).second->resetable())
+            (*it).second->reset();
 }
 
 /// Declare some of the raw and basic plots that are going to be used in the
@@ -185,6 +392,10 @@ void DetectorDriver::DeclarePlots() {
 }
 
 int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
+    return ThreshAndCal(chan, rawev, vecAnalyzer);
+}
+
+int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev, const std::vector<TraceAnalyzer *> &analyzers) {
     ChannelConfiguration chanCfg = chan->GetChanID();
     int id = chan->GetID();
     string type = chanCfg.GetType();
@@ -203,8 +414,10 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
     if (!trace.empty()) {
         histo_.Plot(D_HAS_TRACE, id);
 
-        for (vector<TraceAnalyzer *>::iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
-            (*it)->Analyze(trace, chanCfg);
+        for (size_t i = 0; i < analyzers.size(); i++) {
+            ScopedStageTimer timer(analyzerTimers_[i]);
+            analyzers[i]->Analyze(trace, chanCfg);
+        }
 
         //We are going to handle the filtered energies here.
         vector<double> filteredEnergies = trace.GetFilteredEnergies();
@@ -253,6 +466,29 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
     return (1);
 }
 
+/// A channel needs its trace if one of the processors handles its type, since
+/// we can't know what the processor does with it, or if one of the analyzers
+/// wants to look at it.
+vector<bool> DetectorDriver::GetTraceChannels() const {
+    DetectorLibrary *modChan = DetectorLibrary::get();
+    vector<bool> channels(modChan->size(), false);
+
+    for (DetectorLibrary::size_type i = 0; i < modChan->size(); i++) {
+        const ChannelConfiguration &cfg = modChan->at(i);
+        if (cfg.GetType() == "ignore" || cfg.GetType() == "")
+            continue;
+
+        for (vector<EventProcessor *>::const_iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
+            if ((*it)->GetTypes().find(cfg.GetType()) != (*it)->GetTypes().end())
+                channels[i] = true;
+
+        for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
+            if ((*it)->IsAnalyzed(cfg))
+                channels[i] = true;
+    }
+    return channels;
+}
+
 int DetectorDriver::PlotRaw(const ChanEvent *chan) {
     histo_.Plot(D_RAW_ENERGY + chan->GetID(), chan->GetEnergy());
     return (0);
@@ -264,8 +500,8 @@ int DetectorDriver::PlotCal(const ChanEvent *chan) {
 }
 
 EventProcessor *DetectorDriver::GetProcessor(const std::string &name) const {
-    for (vector<EventProcessor *>::const_iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
-        if ((*it)->GetName() == name)
-            return (*it);
+    for (size_t i = 0; i < vecProcess.size(); i++)
+        if (vecProcess[i]->GetName() == name)
+            return currentProcessors && (*currentProcessors)[i] ? (*currentProcessors)[i] : vecProcess[i];
     return (NULL);
 }
@@ -69,6 +69,10 @@ void DetectorDriverXmlParser::ParseNode(DetectorDriver *driver) {
     messenger_.start("Loading Processors");
     driver->SetEventProcessors(ParseProcessors(node.child("Processor")));
     messenger_.done();
+
+    driver->SetNumberOfThreads(node.attribute("threads").as_uint(1));
+    if (driver->GetNumberOfThreads() > 1)
+        messenger_.detail("Processing the events with " + to_string(driver->GetNumberOfThreads()) + " threads");
 }
 
 vector<EventProcessor *> DetectorDriverXmlParser::ParseProcessors(const pugi::xml_node &node) {
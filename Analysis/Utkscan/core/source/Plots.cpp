@@ -21,8 +21,8 @@ Plots::Plots(int offset, int range, std::string name) {
     range_ = range;
     name_ = name;
     PlotsRegister::get()->Add(offset_, range_, name_);
-    if(!rootHandler_)
-        rootHandler_ = RootHandler::get();
+    rootHandler_ = RootHandler::get();
+    handles_.resize(range_ > 0 ? range_ : 0);
 }
 
 bool Plots::BananaTest(const int &id, const double &x, const double &y) {
@@ -40,7 +40,7 @@ bool Plots::CheckRange(int id) const {
 
 /** Checks if id is taken */
 bool Plots::Exists(int id) const {
-    return (idList_.count(id) != 0);
+    return (CheckRange(id) && handles_[id]);
 }
 
 bool Plots::Exists(const std::string &mne) const {
@@ -51,7 +51,7 @@ bool Plots::Exists(const std::string &mne) const {
 }
 
 /** Constructors based on DeclareHistogram functions. */
-bool Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int xHistLength,
+HistogramHandle Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int xHistLength,
                                int xLow, int xHigh, const std::string &mne) {
     if (!CheckRange(dammId)) {
         stringstream ss;
@@ -66,31 +66,28 @@ bool Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int hal
         throw HistogramException(ss.str());
     }
 
-    pair<set<int>::iterator, bool> result = idList_.insert(dammId);
-    if (!result.second)
-        return false;
     // Mnemonic is optional and added only if longer then 0
     if (mne.size() > 0)
         mneList.insert(pair<string, int>(mne, dammId));
 #ifdef USE_HRIBF
     hd1d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength, xLow, xHigh, title, strlen(title));
 #endif
-    rootHandler_->RegisterHistogram(dammId + offset_, title, xHistLength);
+    handles_[dammId] = rootHandler_->RegisterHistogram(dammId + offset_, title, xHistLength);
     titleList.insert(pair<int, string>(dammId, string(title)));
-    return true;
+    return handles_[dammId];
 }
 
-bool Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan /* = 2*/,
+HistogramHandle Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan /* = 2*/,
                                const std::string &mne /*=empty*/ ) {
     return DeclareHistogram1D(dammId, xSize, title, halfWordsPerChan, xSize, 0, xSize - 1, mne);
 }
 
-bool Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int contraction,
+HistogramHandle Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int halfWordsPerChan, int contraction,
                                const std::string &mne) {
     return DeclareHistogram1D(dammId, xSize, title, halfWordsPerChan, xSize / contraction, 0, xSize / contraction - 1, mne);
 }
 
-bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan,
+HistogramHandle Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan,
                                int xHistLength, int xLow, int xHigh, int yHistLength, int yLow, int yHigh,
                                const std::string &mne) {
     if (!CheckRange(dammId)) {
@@ -106,9 +103,6 @@ bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *tit
         throw HistogramException(ss.str());
     }
 
-    pair<set<int>::iterator, bool> result = idList_.insert(dammId);
-    if (!result.second)
-        return (false);
     // Mnemonic is optional and added only if longer then 0
     if (mne.size() > 0)
         mneList.insert(pair<string, int>(mne, dammId));
@@ -116,17 +110,17 @@ bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *tit
 #ifdef USE_HRIBF
     hd2d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength, xLow, xHigh, ySize, yHistLength, yLow, yHigh, title, strlen(title));
 #endif
-    rootHandler_->RegisterHistogram(dammId + offset_, title, xSize, ySize);
+    handles_[dammId] = rootHandler_->RegisterHistogram(dammId + offset_, title, xSize, ySize);
     titleList.insert(pair<int, string>(dammId, string(title)));
-    return true;
+    return handles_[dammId];
 }
 
-bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan /* = 1*/,
+HistogramHandle Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan /* = 1*/,
                                const std::string &mne /* = empty*/) {
     return DeclareHistogram2D(dammId, xSize, ySize, title, halfWordsPerChan, xSize, 0, xSize - 1, ySize, 0, ySize - 1, mne);
 }
 
-bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan, int xContraction,
+HistogramHandle Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *title, int halfWordsPerChan, int xContraction,
                                int yContraction, const std::string &mne) {
     return DeclareHistogram2D(dammId, xSize, ySize, title, halfWordsPerChan, xSize / xContraction, 0,
                               xSize / xContraction - 1, ySize / yContraction, 0, ySize / yContraction - 1, mne);
@@ -141,20 +135,34 @@ bool Plots::Plot(int dammId, double val1, double val2, double val3, const char *
         return false;
     }
 
-    rootHandler_->Plot(dammId + offset_, val1, val2, val3);
+    return Plot(handles_[dammId], val1, val2, val3, name);
+}
+
+bool Plots::Plot(const HistogramHandle &handle, double val1, double val2, double val3, const char *name) {
+    if (!handle)
+        return false;
+
+    const bool isPlotted = rootHandler_->Plot(handle, val1, val2, val3);
 #ifdef USE_HRIBF
     if (val2 == -1 && val3 == -1)
-        count1cc_(dammId + offset_, int(val1), 1);
+        count1cc_(handle.GetId(), int(val1), 1);
     else if (val3 == -1 || val3 == 0)
-        count1cc_(dammId + offset_, int(val1), int(val2));
+        count1cc_(handle.GetId(), int(val1), int(val2));
     else
-        set2cc_(dammId + offset_, int(val1), int(val2), int(val3));
+        set2cc_(handle.GetId(), int(val1), int(val2), int(val3));
 #endif
-    return true;
+    return isPlotted;
 }
 
 bool Plots::Plot(const std::string &mne, double val1, double val2, double val3, const char *name) {
-    if (!Exists(mne))
-        return false;
-    return Plot(mneList.find(mne)->second, val1, val2, val3, name);
+    return Plot(GetHandle(mne), val1, val2, val3, name);
+}
+
+HistogramHandle Plots::GetHandle(int id) const {
+    return Exists(id) ? handles_[id] : HistogramHandle();
+}
+
+HistogramHandle Plots::GetHandle(const std::string &mne) const {
+    map<string, int>::const_iterator it = mneList.find(mne);
+    return it == mneList.end() ? HistogramHandle() : GetHandle(it->second);
 }
\ No newline at end of file
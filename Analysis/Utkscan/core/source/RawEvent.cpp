@@ -34,9 +34,18 @@ void RawEvent::Zero(const std::set<std::string> &usedev) {
     eventList.clear();
 }
 
+void RawEvent::CopyFrom(const RawEvent &rhs) {
+    for (map<string, DetectorSummary>::iterator it = sumMap.begin(); it != sumMap.end(); it++)
+        (*it).second.Zero();
+
+    for (map<string, DetectorSummary>::const_iterator it = rhs.sumMap.begin(); it != rhs.sumMap.end(); it++)
+        sumMap[(*it).first] = (*it).second;
+
+    eventList = rhs.eventList;
+}
+
 DetectorSummary *RawEvent::GetSummary(const std::string &s, bool construct) {
     map<string, DetectorSummary>::iterator it = sumMap.find(s);
-    static set <string> nullSummaries;
 
     Messenger m;
     stringstream ss;
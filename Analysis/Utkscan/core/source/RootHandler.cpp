@@ -4,17 +4,30 @@
 ///@date January 2010
 #include "RootHandler.hpp"
 
+#include <TFileMerger.h>
+#include <TROOT.h>
+
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
+#include "StageTimer.hpp"
+
 using namespace std;
 
 RootHandler *RootHandler::instance_ = nullptr; //!< The ONLY instance of this class.
 TFile *RootHandler::histogramFile_ = nullptr; //!< ROOT file storing user registered histograms
 TFile *RootHandler::treeFile_ = nullptr; //!< ROOT File storing user registered trees.
 map<std::string, TTree *> RootHandler::treeList_; //!< The list of user registered trees
-map<unsigned int, TH1 *> RootHandler::histogramList_; //!< List of user registered histograms
-mutex RootHandler::flushMutex_; //!< Ensures only one thread writes to histogramFile_
+map<unsigned int, HistogramHandle> RootHandler::histogramList_; //!< The handles of the user registered histograms
+vector<RootHandler::HistogramEntry> RootHandler::histograms_; //!< The user registered histograms, indexed by their handles
+thread RootHandler::writer_; //!< The thread that writes the snapshots of the histograms to histogramFile_
+atomic<bool> RootHandler::isWriting_(false); //!< True while the writer is writing the snapshots
+atomic<uint64_t> RootHandler::flushedBytes_(0); //!< The number of bytes that the histogram writes have taken
+atomic<uint64_t> RootHandler::flushedHistograms_(0); //!< The number of histograms that have been written
+vector<unique_ptr<RootHandler::Shard> > RootHandler::shards_; //!< The shards of every thread that has plotted
+mutex RootHandler::registryMutex_; //!< Guards histogramList_, histograms_ and shards_ when they're added to
+atomic<unsigned int> RootHandler::generation_(0); //!< Counts the handlers, so a thread can tell its shard is gone
 
 RootHandler *RootHandler::get() {
     if (!instance_)
@@ -28,24 +41,40 @@ RootHandler *RootHandler::get(const std::string &fileName) {
     return (instance_);
 }
 
+///The histograms are written on a thread of their own, so ROOT has to guard its global state before we make anything.
 RootHandler::RootHandler(const std::string &fileName) {
+    static once_flag threadSafety;
+    call_once(threadSafety, ROOT::EnableThreadSafety);
     histogramFile_ = new TFile((fileName+"-hist.root").c_str(), "recreate");
     treeFile_ = new TFile((fileName+"-tree.root").c_str(), "recreate");
+    generation_++;
 }
 
 RootHandler::~RootHandler() {
-    if(histogramFile_) {
-        while(!flushMutex_.try_lock())
-            usleep(1000000);
+    JoinWriter();
 
-        histogramFile_->cd();
-        for(const auto &hist : histogramList_)
-            if(hist.second->GetEntries() > 0)
-                hist.second->Write(nullptr, TObject::kWriteDelete);
+    //The histograms that nobody asked for are built one at a time, so that only one of them is ever held as a ROOT
+    // histogram.
+    if(histogramFile_) {
+        for(size_t index = 0; index < histograms_.size(); index++) {
+            if(histograms_[index].histogram) {
+                TH1 *histogram = Materialize(index);
+                if(histogram->GetEntries() > 0) {
+                    flushedBytes_ += histogramFile_->WriteTObject(histogram, nullptr, "WriteDelete");
+                    flushedHistograms_++;
+                }
+            } else if(GetShardEntries(index) > 0) {
+                TH1 *snapshot = CreateSnapshot(index);
+                flushedBytes_ += histogramFile_->WriteTObject(snapshot, nullptr, "WriteDelete");
+                flushedHistograms_++;
+                delete snapshot;
+            }
+        }
 
         histogramFile_->Write(nullptr, TObject::kWriteDelete);
         histogramFile_->Close();
         delete histogramFile_;
+        histogramFile_ = nullptr;
     }
 
     if(treeFile_) {
@@ -53,8 +82,14 @@ RootHandler::~RootHandler() {
         treeFile_->Write(nullptr, TObject::kWriteDelete);
         treeFile_->Close();
         delete treeFile_;
+        treeFile_ = nullptr;
     }
 
+    //The files owned the histograms and trees, so the handles that we gave out don't refer to anything anymore.
+    histogramList_.clear();
+    histograms_.clear();
+    shards_.clear();
+    treeList_.clear();
     instance_ = nullptr;
 }
 
@@ -88,75 +123,235 @@ TTree *RootHandler::RegisterTree(const std::string &name, const std::string &des
     return pTempTree;
 }
 
+HistogramHandle RootHandler::GetHandle(const unsigned int &id) const {
+    auto handle = histogramList_.find(id);
+    return handle == histogramList_.end() ? HistogramHandle() : handle->second;
+}
+
+///@TODO Really we want to throw for an unknown id, but for now we're just going to emulate what happened with DAMM.
+/// We just silently ignored any Plot request to an unknown histogram id.
 bool RootHandler::Plot(const unsigned int &id, const double &xval, const double &yval/*=-1*/, const double &zval/*=-1*/) {
-    TH1 *histogram = nullptr;
-    try {
-        histogram = GetHistogramFromList(id, "Plot");
-    } catch(invalid_argument &invalidArgument) {
-        ///@TODO Really we want to rethrow here, but for now we're just going to emulate what happened with DAMM. We
-        /// just silently ignored any Plot request to an unknown histogram id.
-        return false;
-    }
+    return Plot(GetHandle(id), xval, yval, zval);
+}
 
+///A histogram with only x and z bins is a 2D histogram that is filled with the z value as its y.
+bool RootHandler::Plot(const HistogramHandle &handle, const double &xval, const double &yval/*=-1*/,
+                       const double &zval/*=-1*/) {
     bool hasYval = yval != -1;
     bool hasZval = zval != -1;
-    if(!hasYval && !hasZval)
-        histogram->Fill(xval);
-    if(hasYval && !hasZval)
-        dynamic_cast<TH2D*>(histogram)->Fill(xval, yval);
-    if(!hasYval && hasZval)
-        dynamic_cast<TH2D*>(histogram)->Fill(xval, zval);
-    if(hasYval && hasZval)
-        dynamic_cast<TH3D*>(histogram)->Fill(xval, yval, zval);
+    unsigned int dimension = 1 + (hasYval || hasZval) + (hasYval && hasZval);
+    if(!handle || dimension != handle.dimension_)
+        return false;
+
+    DenseHistogram &counts = GetShardCounts(handle);
+    if(dimension == 1)
+        counts.Fill(xval);
+    else if(dimension == 2)
+        counts.Fill(xval, hasYval ? yval : zval);
+    else
+        counts.Fill(xval, yval, zval);
+    return true;
+}
+
+bool RootHandler::Plot(const HistogramHandle &handle, const double *xvals, const size_t &n) {
+    if(handle.dimension_ != 1)
+        return false;
+    GetShardCounts(handle).Fill(xvals, n);
     return true;
 }
 
 ///@TODO Update this so that we're being a little more flexible with our histogramming. At the moment, I'm wanting to
 /// mimic the function calls to DAMM as closely as possible. This will reduce the amount of rewrites for now.
-TH1 *RootHandler::RegisterHistogram(const unsigned int &id, const std::string &title, const unsigned int &xBins,
-                                    const unsigned int &yBins/* = 0*/, const unsigned int &zBins/* = 0*/) {
+HistogramHandle RootHandler::RegisterHistogram(const unsigned int &id, const std::string &title,
+                                               const unsigned int &xBins, const unsigned int &yBins/* = 0*/,
+                                               const unsigned int &zBins/* = 0*/) {
+    lock_guard<mutex> lock(registryMutex_);
     auto histogram = histogramList_.find(id);
     if (histogram != histogramList_.end())
         return histogram->second;
 
-    TH1 *pTempHistogram = nullptr;
+    //Checks the bins before we hand out a handle for them.
+    DenseHistogram counts(xBins, yBins ? yBins : zBins, yBins ? zBins : 0);
+    HistogramHandle handle(histograms_.size(), id, counts.GetDimension());
+    histograms_.emplace_back(id, title, counts.GetXBins(), counts.GetYBins(), counts.GetZBins());
+    histogramList_.emplace(make_pair(id, handle));
+    return handle;
+}
 
-    if (!yBins && !zBins)
-        pTempHistogram = histogramList_.emplace(make_pair(id, new TH1D(("h"+to_string(id)).c_str(), title.c_str(), xBins, 0, xBins))).first->second;
-    else if(yBins && !zBins)
-        pTempHistogram = histogramList_.emplace(make_pair(id, new TH2D(("h"+to_string(id)).c_str(), title.c_str(), xBins, 0, xBins, yBins, 0, yBins))).first->second;
-    else if(!yBins)
-        pTempHistogram = histogramList_.emplace(make_pair(id, new TH2D(("h"+to_string(id)).c_str(), title.c_str(), xBins, 0, xBins, zBins, 0, zBins))).first->second;
-    else
-        pTempHistogram = histogramList_.emplace(make_pair(id, new TH3D(("h"+to_string(id)).c_str(), title.c_str(), xBins, 0, xBins, yBins, 0, yBins, zBins, 0, zBins))).first->second;
+///The shard belongs to the thread, so the only time that we need the lock is the first time that the thread plots
+/// into a histogram. The generation tells us that a thread's shard went with a handler that has since been deleted.
+DenseHistogram &RootHandler::GetShardCounts(const HistogramHandle &handle) {
+    thread_local Shard *shard = nullptr;
+    thread_local unsigned int generation = 0;
+    if (!shard || generation != generation_) {
+        lock_guard<mutex> lock(registryMutex_);
+        shards_.emplace_back(new Shard());
+        shard = shards_.back().get();
+        generation = generation_;
+    }
+
+    if (handle.index_ >= shard->counts.size())
+        shard->counts.resize(handle.index_ + 1);
+    unique_ptr<DenseHistogram> &counts = shard->counts[handle.index_];
+    if (!counts) {
+        lock_guard<mutex> lock(registryMutex_);
+        const HistogramEntry &entry = histograms_[handle.index_];
+        counts.reset(new DenseHistogram(entry.xBins, entry.yBins, entry.zBins));
+    }
+    return *counts;
+}
 
-    pTempHistogram->SetDirectory(histogramFile_);
-    return pTempHistogram;
+TH1 *RootHandler::CreateHistogram(const HistogramEntry &entry) {
+    string name = "h" + to_string(entry.id);
+    if (entry.zBins)
+        return new TH3D(name.c_str(), entry.title.c_str(), entry.xBins, 0, entry.xBins, entry.yBins, 0, entry.yBins,
+                        entry.zBins, 0, entry.zBins);
+    if (entry.yBins)
+        return new TH2D(name.c_str(), entry.title.c_str(), entry.xBins, 0, entry.xBins, entry.yBins, 0, entry.yBins);
+    return new TH1D(name.c_str(), entry.title.c_str(), entry.xBins, 0, entry.xBins);
 }
 
-void RootHandler::AsyncFlush() {
-    for(const auto &hist : histogramList_) {
-        histogramFile_->cd();
-        if(hist.second->GetEntries() > 0)
-            hist.second->Write(nullptr, TObject::kWriteDelete);
+///The counts are added in cell by cell with the global bin numbers, which DenseHistogram shares with ROOT. Adding to
+/// the bins directly doesn't touch the statistics, so the sums that the shards kept are added to them by hand. The
+/// sums of the shards are added together exactly before they're handed to ROOT, so neither the bins nor the
+/// statistics depend on how the fills were shared out between the threads.
+bool RootHandler::AddShards(TH1 *histogram, const size_t &index, const bool &reset) {
+    const HistogramEntry &entry = histograms_[index];
+    DenseHistogram::Sums sums(max(entry.xBins, max(entry.yBins, entry.zBins)));
+    double entries = histogram->GetEntries();
+    bool added = false;
+    for(const auto &shard : shards_) {
+        if(index >= shard->counts.size() || !shard->counts[index] || shard->counts[index]->IsEmpty())
+            continue;
+        DenseHistogram &counts = *shard->counts[index];
+        counts.ForEachFilledCell([histogram](size_t cell, uint64_t count) {
+            histogram->AddBinContent(cell, count);
+        });
+        sums.Add(counts.GetSums());
+        entries += counts.GetEntries();
+        if(reset)
+            counts.Reset();
+        added = true;
     }
-    flushMutex_.unlock();
+
+    if(added) {
+        double stats[TH1::kNstat] = {0}, shardStats[DenseHistogram::Sums::numberOfStats];
+        histogram->GetStats(stats);
+        sums.Get(shardStats);
+        for(size_t i = 0; i < DenseHistogram::Sums::numberOfStats; i++)
+            stats[i] += shardStats[i];
+        histogram->PutStats(stats);
+        histogram->SetEntries(entries);
+    }
+    return added;
+}
+
+uint64_t RootHandler::GetShardEntries(const size_t &index) {
+    uint64_t entries = 0;
+    for(const auto &shard : shards_)
+        if(index < shard->counts.size() && shard->counts[index])
+            entries += shard->counts[index]->GetEntries();
+    return entries;
 }
 
+TH1 *RootHandler::Materialize(const size_t &index) {
+    JoinWriter();
+    HistogramEntry &entry = histograms_[index];
+    if(!entry.histogram) {
+        entry.histogram = CreateHistogram(entry);
+        entry.histogram->SetDirectory(histogramFile_);
+    }
+
+    if(AddShards(entry.histogram, index, true))
+        entry.isChanged = true;
+    return entry.histogram;
+}
+
+TH1 *RootHandler::CreateSnapshot(const size_t &index) {
+    TH1 *snapshot = CreateHistogram(histograms_[index]);
+    snapshot->SetDirectory(nullptr);
+    AddShards(snapshot, index, false);
+    return snapshot;
+}
+
+void RootHandler::AsyncFlush(const std::vector<TH1 *> &snapshots) {
+    static StageTimer *timer = StageTimers::get()->Get("RootHandler", "AsyncFlush");
+    ScopedStageTimer scopedTimer(timer);
+    for(const auto &snapshot : snapshots) {
+        flushedBytes_ += histogramFile_->WriteTObject(snapshot, nullptr, "WriteDelete");
+        delete snapshot;
+    }
+    flushedHistograms_ += snapshots.size();
+    isWriting_ = false;
+}
+
+void RootHandler::JoinWriter() {
+    if(writer_.joinable())
+        writer_.join();
+}
+
+///The writer only ever sees the snapshots, which are built here on the scan thread while nothing is plotting, so it
+/// writes a consistent picture of the histograms without Plot having to wait for it. The snapshots belong to the
+/// writer, which frees them as it goes, so only the histograms that changed are held as ROOT histograms, and only
+/// while they're written. The shards only ever grow, so a histogram has changed if it has more entries than it did
+/// at the last flush. If the writer is still busy with the last flush we skip this one, the changes will go out with
+/// the next. The trees are saved here as well, once the writer is done, so that only one thread is writing at a time.
 void RootHandler::Flush() {
+    static StageTimer *timer = StageTimers::get()->Get("RootHandler", "Flush");
+    ScopedStageTimer scopedTimer(timer);
+    if(isWriting_)
+        return;
+    JoinWriter();
+
     for(const auto &tree : treeList_)
         tree.second->AutoSave("overwrite");
 
-    if(flushMutex_.try_lock()) {
-        thread worker0(AsyncFlush);
-        worker0.detach();
+    vector<TH1 *> snapshots;
+    for(size_t index = 0; index < histograms_.size(); index++) {
+        HistogramEntry &entry = histograms_[index];
+        if(entry.histogram) {
+            TH1 *histogram = Materialize(index);
+            if(!entry.isChanged || histogram->GetEntries() == 0)
+                continue;
+            TH1 *snapshot = static_cast<TH1 *>(histogram->Clone());
+            snapshot->SetDirectory(nullptr);
+            snapshots.push_back(snapshot);
+            entry.isChanged = false;
+        } else {
+            uint64_t entries = GetShardEntries(index);
+            if(entries == entry.flushedEntries)
+                continue;
+            snapshots.push_back(CreateSnapshot(index));
+            entry.flushedEntries = entries;
+        }
     }
+
+    if(snapshots.empty())
+        return;
+    isWriting_ = true;
+    writer_ = thread(AsyncFlush, snapshots);
+}
+
+bool RootHandler::MergeOutputs(const std::vector<std::string> &parts, const std::string &fileName) {
+    for(const auto &suffix : {"-hist.root", "-tree.root"}) {
+        TFileMerger merger(false);
+        if(!merger.OutputFile((fileName + suffix).c_str(), "RECREATE"))
+            return false;
+        for(const auto &part : parts)
+            if(!merger.AddFile((part + suffix).c_str(), false))
+                return false;
+        if(!merger.Merge())
+            return false;
+    }
+    return true;
 }
 
 TH1 *RootHandler::GetHistogramFromList(const unsigned int &id, const std::string &callingFunctionName) {
-    auto histogramPair = histogramList_.find(id);
-    if(histogramPair == histogramList_.end())
+    HistogramHandle handle = GetHandle(id);
+    if(!handle)
         throw invalid_argument("RootHandler::" + callingFunctionName + " - Somebody requested histogram "
                                + to_string(id) + ", which I know nothing about!!");
-    return histogramPair->second;
+    //Whoever asked for it might fill it themselves, so we have to assume that it'll change.
+    histograms_[handle.index_].isChanged = true;
+    return Materialize(handle.index_);
 }
\ No newline at end of file
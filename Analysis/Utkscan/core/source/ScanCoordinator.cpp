@@ -0,0 +1,345 @@
+///@file ScanCoordinator.cpp
+///@brief Splits a run, or a list of runs, into spill ranges that are scanned by separate utkscan processes and merges
+/// their output.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "RootHandler.hpp"
+#include "ScanCoordinator.hpp"
+
+using namespace std;
+
+namespace {
+    ///Checks if argv[i] is the given option and gets its value, which is either attached to it ("--opt=value" or
+    /// "-ovalue") or the next argument.
+    ///@param[in] argc : The number of arguments
+    ///@param[in] argv : The arguments
+    ///@param[in,out] i : The argument to check. Moved to the value if it's the next argument.
+    ///@param[in] longName : The long name of the option, including the dashes
+    ///@param[in] shortName : The short name of the option, including the dash. Empty if there isn't one.
+    ///@param[out] value : The value of the option
+    ///@return True if argv[i] is the option.
+    bool GetOptionValue(int argc, char *argv[], int &i, const string &longName, const string &shortName,
+                        string &value) {
+        const string arg = argv[i];
+        if (arg == longName || (!shortName.empty() && arg == shortName)) {
+            if (i + 1 >= argc)
+                throw invalid_argument("ScanCoordinator::ScanCoordinator - The " + longName + " option needs a value.");
+            value = argv[++i];
+            return true;
+        }
+        if (arg.compare(0, longName.size() + 1, longName + "=") == 0) {
+            value = arg.substr(longName.size() + 1);
+            return true;
+        }
+        if (!shortName.empty() && arg.size() > shortName.size() && arg.compare(0, shortName.size(), shortName) == 0
+            && arg[1] != '-') {
+            value = arg.substr(shortName.size());
+            return true;
+        }
+        return false;
+    }
+}
+
+bool ScanCoordinator::IsRequested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "--workers" || arg.compare(0, 10, "--workers=") == 0 || arg == "--run-list"
+            || arg.compare(0, 11, "--run-list=") == 0)
+            return true;
+    }
+    return false;
+}
+
+ScanCoordinator::ScanCoordinator(int argc, char *argv[]) : program_(argv[0]), numWorkers_(1), startTime_(0),
+                                                            stopTime_(numeric_limits<unsigned long long>::max()),
+                                                            firstSpill_(0), lastSpill_(numeric_limits<size_t>::max()),
+                                                            hasFirstTime_(false), firstTime_(0) {
+    string value;
+    for (int i = 1; i < argc; i++) {
+        if (GetOptionValue(argc, argv, i, "--workers", "", value)) {
+            numWorkers_ = (unsigned int) strtoul(value.c_str(), NULL, 0);
+            if (numWorkers_ == 0)
+                throw invalid_argument("ScanCoordinator::ScanCoordinator - We need at least one worker.");
+        } else if (GetOptionValue(argc, argv, i, "--run-list", "", value)) {
+            ifstream list(value.c_str());
+            if (!list.good())
+                throw invalid_argument("ScanCoordinator::ScanCoordinator - Could not open the run list " + value);
+            string line;
+            while (getline(list, line)) {
+                line.erase(0, line.find_first_not_of(" \t"));
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if (!line.empty() && line[0] != '#')
+                    inputFiles_.push_back(line);
+            }
+        } else if (GetOptionValue(argc, argv, i, "--input", "-i", value)) {
+            inputFiles_.push_back(value);
+        } else if (GetOptionValue(argc, argv, i, "--output", "-o", value)) {
+            output_ = value;
+        } else if (GetOptionValue(argc, argv, i, "--start-time", "", value)) {
+            startTime_ = strtoull(value.c_str(), NULL, 0);
+        } else if (GetOptionValue(argc, argv, i, "--stop-time", "", value)) {
+            stopTime_ = strtoull(value.c_str(), NULL, 0);
+        } else if (GetOptionValue(argc, argv, i, "--spill-range", "", value)) {
+            const size_t colon = value.find(':');
+            if (colon == string::npos)
+                throw invalid_argument("ScanCoordinator::ScanCoordinator - The spill range needs to be given as "
+                                               "<first>:<last>.");
+            firstSpill_ = strtoul(value.substr(0, colon).c_str(), NULL, 0);
+            if (colon + 1 < value.size())
+                lastSpill_ = strtoul(value.substr(colon + 1).c_str(), NULL, 0);
+        } else if (GetOptionValue(argc, argv, i, "--first-time", "", value)) {
+            // The workers get this as is, since it's what we would have given them anyway.
+            firstTime_ = strtoull(value.c_str(), NULL, 0);
+            hasFirstTime_ = true;
+            workerArgs_.push_back("--first-time");
+            workerArgs_.push_back(value);
+        } else if (strcmp(argv[i], "-b") != 0 && strcmp(argv[i], "--batch") != 0) {
+            workerArgs_.push_back(argv[i]);
+        }
+    }
+
+    if (inputFiles_.empty())
+        throw invalid_argument("ScanCoordinator::ScanCoordinator - No input files were given to split between the "
+                                       "workers.");
+    if (output_.empty())
+        throw invalid_argument("ScanCoordinator::ScanCoordinator - The output file name was not provided.");
+}
+
+vector<pair<size_t, size_t> > ScanCoordinator::SplitSpills(const SpillIndex &index, const size_t &first,
+                                                           const size_t &end, const unsigned int &parts) {
+    vector<pair<size_t, size_t> > ranges;
+    if (first >= end || parts == 0)
+        return ranges;
+
+    unsigned long long totalHits = 0;
+    for (size_t spill = first; spill < end; spill++)
+        totalHits += index.GetSpill(spill).GetNumberOfHits();
+
+    // A range is closed once it holds its share of the hits. The last range takes whatever is left.
+    unsigned long long hits = 0;
+    size_t start = first;
+    for (size_t spill = first; spill + 1 < end && ranges.size() + 1 < parts; spill++) {
+        hits += index.GetSpill(spill).GetNumberOfHits();
+        if (hits * parts >= totalHits * (ranges.size() + 1)) {
+            ranges.push_back(make_pair(start, spill));
+            start = spill + 1;
+        }
+    }
+    ranges.push_back(make_pair(start, end - 1));
+
+    return ranges;
+}
+
+bool ScanCoordinator::BuildTasks() {
+    vector<unique_ptr<SpillIndex> > indices;
+    vector<pair<size_t, size_t> > bounds;
+    unsigned long long totalHits = 0;
+    vector<unsigned long long> runHits;
+
+    for (vector<string>::const_iterator file = inputFiles_.begin(); file != inputFiles_.end(); file++) {
+        indices.push_back(unique_ptr<SpillIndex>(new SpillIndex()));
+        SpillIndex &index = *indices.back();
+
+        const string indexName = SpillIndex::GetIndexFilename(*file);
+        if (!index.Read(indexName)) {
+            cout << "ScanCoordinator::BuildTasks : Building the spill index of " << *file << endl;
+            if (!index.Build(*file)) {
+                cout << "ScanCoordinator::BuildTasks : Could not read " << *file << ". Only ldf and pld files can be "
+                        "split between workers." << endl;
+                return false;
+            }
+            // The workers would each build it again if we didn't write it.
+            if (!index.Write(indexName)) {
+                cout << "ScanCoordinator::BuildTasks : Could not write the spill index " << indexName << endl;
+                return false;
+            }
+        }
+
+        size_t first = max(firstSpill_, index.FindFirstSpill(startTime_));
+        size_t end = index.FindEndSpill(stopTime_);
+        if (lastSpill_ < end)
+            end = lastSpill_ + 1;
+        bounds.push_back(make_pair(first, max(first, end)));
+
+        // Everything is measured from the first event of the first run, which is what a serial scan of the runs does.
+        if (!hasFirstTime_ && file == inputFiles_.begin() && index.GetNumberOfSpills() != 0)
+            firstTime_ = index.GetSpill(0).firstTime;
+
+        unsigned long long hits = 0;
+        for (size_t spill = bounds.back().first; spill < bounds.back().second; spill++)
+            hits += index.GetSpill(spill).GetNumberOfHits();
+        runHits.push_back(hits);
+        totalHits += hits;
+    }
+
+    tasks_.clear();
+    for (size_t run = 0; run < inputFiles_.size(); run++) {
+        // Each run gets workers in proportion to its share of the hits.
+        unsigned int parts = numWorkers_;
+        if (inputFiles_.size() > 1)
+            parts = totalHits == 0 ? 1 : max(1u, (unsigned int) ((numWorkers_ * runHits[run] + totalHits / 2) /
+                                                                 totalHits));
+
+        vector<pair<size_t, size_t> > ranges = SplitSpills(*indices[run], bounds[run].first, bounds[run].second,
+                                                           parts);
+        for (vector<pair<size_t, size_t> >::const_iterator range = ranges.begin(); range != ranges.end(); range++) {
+            Task task;
+            task.inputFile = inputFiles_[run];
+            task.firstSpill = range->first;
+            task.lastSpill = range->second;
+            stringstream output;
+            output << output_ << "-part" << tasks_.size();
+            task.output = output.str();
+            tasks_.push_back(task);
+        }
+    }
+
+    if (tasks_.empty())
+        cout << "ScanCoordinator::BuildTasks : None of the spills are in the requested range." << endl;
+    return !tasks_.empty();
+}
+
+pid_t ScanCoordinator::LaunchWorker(const Task &task) {
+    stringstream range, firstTime;
+    range << task.firstSpill << ":" << task.lastSpill;
+    firstTime << firstTime_;
+
+    vector<string> args;
+    args.push_back(program_);
+    args.insert(args.end(), workerArgs_.begin(), workerArgs_.end());
+    args.push_back("--batch");
+    args.push_back("--input");
+    args.push_back(task.inputFile);
+    args.push_back("--output");
+    args.push_back(task.output);
+    args.push_back("--spill-range");
+    args.push_back(range.str());
+    if (!hasFirstTime_) {
+        args.push_back("--first-time");
+        args.push_back(firstTime.str());
+    }
+
+    vector<char *> argv;
+    for (vector<string>::iterator arg = args.begin(); arg != args.end(); arg++)
+        argv.push_back(&(*arg)[0]);
+    argv.push_back(NULL);
+
+    const string log = task.output + ".log";
+    cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    if (pid < 0)
+        cout << "ScanCoordinator::LaunchWorker : Could not start a worker : " << strerror(errno) << endl;
+    else
+        cout << "ScanCoordinator::LaunchWorker : Scanning spills " << range.str() << " of " << task.inputFile
+             << " in process " << pid << " (log in " << log << ")" << endl;
+    return pid;
+}
+
+bool ScanCoordinator::RunTasks() {
+    map<pid_t, size_t> running;
+    size_t next = 0;
+    bool success = true;
+
+    while (true) {
+        // Once a worker has failed we only wait for the ones that are still running.
+        while (success && next < tasks_.size() && running.size() < numWorkers_) {
+            pid_t pid = LaunchWorker(tasks_[next]);
+            if (pid < 0) {
+                success = false;
+                break;
+            }
+            running[pid] = next++;
+        }
+
+        if (running.empty())
+            break;
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR)
+                continue;
+            cout << "ScanCoordinator::RunTasks : Lost track of the workers : " << strerror(errno) << endl;
+            return false;
+        }
+
+        map<pid_t, size_t>::iterator worker = running.find(pid);
+        if (worker == running.end())
+            continue;
+
+        const Task &task = tasks_[worker->second];
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            cout << "ScanCoordinator::RunTasks : Finished spills " << task.firstSpill << " to " << task.lastSpill
+                 << " of " << task.inputFile << endl;
+        } else {
+            cout << "ScanCoordinator::RunTasks : The worker scanning spills " << task.firstSpill << " to "
+                 << task.lastSpill << " of " << task.inputFile << " failed. See " << task.output << ".log" << endl;
+            success = false;
+        }
+        running.erase(worker);
+    }
+
+    return success && next == tasks_.size();
+}
+
+void ScanCoordinator::RemovePartialOutputs() {
+    for (vector<Task>::const_iterator task = tasks_.begin(); task != tasks_.end(); task++) {
+        remove((task->output + "-hist.root").c_str());
+        remove((task->output + "-tree.root").c_str());
+        remove((task->output + ".log").c_str());
+    }
+}
+
+int ScanCoordinator::Execute() {
+    if (!BuildTasks())
+        return 1;
+
+    cout << "ScanCoordinator::Execute : Scanning " << tasks_.size() << " ranges of spills with up to " << numWorkers_
+         << " workers. Run times are measured from " << firstTime_ << " clock ticks." << endl;
+
+    // The partial outputs are left behind when something goes wrong so that the logs can be looked at.
+    if (!RunTasks())
+        return 1;
+
+    vector<string> parts;
+    for (vector<Task>::const_iterator task = tasks_.begin(); task != tasks_.end(); task++)
+        parts.push_back(task->output);
+
+    cout << "ScanCoordinator::Execute : Merging the output of the workers into " << output_ << endl;
+    if (!RootHandler::MergeOutputs(parts, output_)) {
+        cout << "ScanCoordinator::Execute : Could not merge the output of the workers." << endl;
+        return 1;
+    }
+
+    RemovePartialOutputs();
+    return 0;
+}
@@ -15,8 +15,15 @@
 
 using namespace std;
 
-/// Default constructor.
-UtkScanInterface::UtkScanInterface() : ScanInterface() {}
+/// Default constructor. The coordinator options are handled by ScanCoordinator before the scan is set up, they're only
+/// added here so that they show up in the help.
+UtkScanInterface::UtkScanInterface() : ScanInterface() {
+    AddOption(optionExt("workers", required_argument, NULL, 0, "<number>",
+                        "Split the input into spill ranges that are scanned by <number> utkscan processes at once and "
+                                "merge their output"));
+    AddOption(optionExt("run-list", required_argument, NULL, 0, "<filename>",
+                        "Scan each of the runs listed in <filename> with the workers and merge their output"));
+}
 
 /// Destructor.
 UtkScanInterface::~UtkScanInterface() {
@@ -63,6 +70,9 @@ bool UtkScanInterface::Initialize(string prefix_) {
          *  calibration and walk correction factors.
          */
         DetectorDriver::get()->DeclarePlots();
+
+        // Now that we know the analyzers and processors, the unpacker can skip the traces that none of them use.
+        unpacker_->SetTraceChannels(DetectorDriver::get()->GetTraceChannels());
     } catch (exception &e) {
         cout << Display::ErrorStr(
                 prefix_ + "Exception caught at UtkScanInterface::Initialize")
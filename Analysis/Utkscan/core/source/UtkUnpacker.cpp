@@ -6,14 +6,12 @@
 #include "UtkUnpacker.hpp"
 
 #include "DammPlotIds.hpp"
-#include "Places.hpp"
-#include "TreeCorrelator.hpp"
 #include "UtkScanInterface.hpp"
 
 using namespace std;
 using namespace dammIds::raw;
 
-UtkUnpacker::UtkUnpacker()  : Unpacker() {
+UtkUnpacker::UtkUnpacker()  : Unpacker(), driver_(nullptr), detectorLibrary_(nullptr) {
     ///Does nothing at all
 }
 
@@ -27,6 +25,12 @@ UtkUnpacker::~UtkUnpacker() {
         delete DetectorDriver::get();
 }
 
+///The driver only exists once the first event has been processed, so there's nothing to finish before that.
+void UtkUnpacker::FinishEvents() {
+    if(driver_)
+        driver_->FinishEvents();
+}
+
 /// This method initializes the DetectorLibrary and DetectorDriver classes so
 /// that we can begin processing the events. We take special action on the
 /// first event so that we can handle somethings poperly. Then we processes
@@ -91,6 +95,8 @@ void UtkUnpacker::ProcessRawEvent() {
     driver_->histo_.Plot(D_EVENT_MULTIPLICITY, rawEvent.size());
     lastTimeOfPreviousEvent = GetRealStopTime();
 
+    RawEvent &nextEvent = driver_->GetNextEvent();
+
     //loop over the list of channels that fired in this event
     for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++) {
 
@@ -113,25 +119,18 @@ void UtkUnpacker::ProcessRawEvent() {
         ///@TODO we need to ensure that all of the memory is getting freed
         /// appropriately at the end of processing an event. I'm not sure
         /// that it is right now.
-        ChanEvent *event = new ChanEvent(*(*it));
+        ChanEvent *event = new ChanEvent(std::move(*(*it)));
 
         ///@TODO This will also fail if the user doesn't define enough modules in the map. Related to pixie16/paass:#103
         usedDetectors.insert((*detectorLibrary_)[(*it)->GetId()].GetType());
-        rawev.AddChan(event);
+        nextEvent.AddChan(event);
 
         ///@TODO Add back in the processing for the dtime.
     }//for(deque<PixieData*>::iterator
 
     try {
-        driver_->ProcessEvent(rawev);
-        rawev.Zero(usedDetectors);
+        driver_->ProcessNextEvent(usedDetectors);
         usedDetectors.clear();
-
-        ///@TODO I think that this is done twice, it needs to be investigated.
-        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
-             it != TreeCorrelator::get()->places_.end(); ++it)
-            if ((*it).second->resetable())
-                (*it).second->reset();
     } catch (exception &ex) {
         throw;
     }
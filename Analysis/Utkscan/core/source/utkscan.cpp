@@ -5,12 +5,25 @@
 
 // Local files
 #include "Display.h"
+#include "ScanCoordinator.hpp"
 #include "UtkScanInterface.hpp"
 #include "UtkUnpacker.hpp"
 
 using namespace std;
 
 int main(int argc, char *argv[]) {
+    // In coordinator mode this process only hands out the work and merges the results.
+    if (ScanCoordinator::IsRequested(argc, argv)) {
+        try {
+            cout << "utkscan.cpp : Splitting the scan between workers" << endl;
+            ScanCoordinator coordinator(argc, argv);
+            return coordinator.Execute();
+        } catch (std::exception &ex) {
+            cerr << Display::ErrorStr(ex.what()) << endl;
+            return 1;
+        }
+    }
+
     // Define the unpacker and scan objects.
     cout << "utkscan.cpp : Instancing the UtkScanInterface" << endl;
     UtkScanInterface scanner;
@@ -21,6 +34,8 @@ int main(int argc, char *argv[]) {
     cout << "utkscan.cpp : Setting the Program Name" << endl;
     scanner.SetProgramName("utkscan");
 
+    // A worker started by the coordinator reports failures through its exit status.
+    int status = 0;
     try {
         // Initialize the scanner.
         cout << "utkscan.cpp : Performing the setup routine" << endl;
@@ -32,10 +47,11 @@ int main(int argc, char *argv[]) {
         scanner.Execute();
     } catch (std::exception &ex) {
         cerr << Display::ErrorStr(ex.what()) << endl;
+        status = 1;
     }
 
     cout << "utkscan.cpp : Closing things out" << endl;
     scanner.Close();
 
-    return 0;
+    return status;
 }
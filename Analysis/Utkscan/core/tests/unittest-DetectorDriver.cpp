@@ -0,0 +1,228 @@
+///@file unittest-DetectorDriver.cpp
+///@brief Unittests for the DetectorDriver class, which check that the events come out the same whether they're
+/// processed one at a time or in batches on several threads.
+///@author S. V. Paulauskas
+///@date October 17, 2026
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "DammPlotIds.hpp"
+#include "DetectorDriver.hpp"
+#include "DetectorLibrary.hpp"
+#include "EventProcessor.hpp"
+#include "Globals.hpp"
+#include "PaassExceptions.hpp"
+#include "Places.hpp"
+#include "RawEvent.hpp"
+#include "RootHandler.hpp"
+#include "TreeCorrelator.hpp"
+#include "XmlInterface.hpp"
+
+using namespace std;
+
+///Records the places of the TreeCorrelator that were active in each event. It can't be cloned, so it runs in the
+/// ordered stage, which is where the places are activated.
+class ActivationRecorder : public EventProcessor {
+public:
+    ///Constructor
+    ///@param[in] activations : Where to record the places of each event
+    ActivationRecorder(vector<string> *activations) : EventProcessor(0, 0, "ActivationRecorder"),
+                                                      activations_(activations) {
+        associatedTypes.insert("ge");
+    }
+
+    ///Records the places that are active, along with the time of their last activation.
+    ///@param[in] event : The event to process
+    ///@return True if the processor was initialized
+    bool Process(RawEvent &event) {
+        if (!EventProcessor::Process(event))
+            return false;
+        stringstream places;
+        for (map<string, Place *>::const_iterator it = TreeCorrelator::get()->places_.begin();
+             it != TreeCorrelator::get()->places_.end(); it++)
+            if ((*it).second->status())
+                places << (*it).first << "@" << (*it).second->last().time << " ";
+        activations_->push_back(places.str());
+        return true;
+    }
+
+private:
+    vector<string> *activations_; ///< The places of each event
+};
+
+///Stands in for a processor that fails in the middle of a batch. It can be cloned, so it throws on a worker.
+class FailingProcessor : public EventProcessor {
+public:
+    ///Constructor
+    FailingProcessor() : EventProcessor(0, 0, "FailingProcessor") {
+        associatedTypes.insert("ge");
+    }
+
+    ///@return A copy of the processor
+    EventProcessor *Clone(void) const { return new FailingProcessor(); }
+
+    ///@param[in] event : The event to process
+    ///@return True if the processor was initialized
+    ///@throws PaassException if any of the channels has a raw energy of 13
+    bool PreProcess(RawEvent &event) {
+        if (!EventProcessor::PreProcess(event))
+            return false;
+        const vector<ChanEvent *> &channels = event.GetSummary("ge")->GetList();
+        for (vector<ChanEvent *>::const_iterator it = channels.begin(); it != channels.end(); it++)
+            if ((*it)->GetEnergy() == 13)
+                throw PaassException("FailingProcessor::PreProcess - Found the energy that we fail on.");
+        return true;
+    }
+};
+
+///Adds a hit to an event the way that UtkUnpacker::ProcessRawEvent does.
+///@param[in] event : The event to add the hit to
+///@param[in] channel : The channel of the hit in module 0
+///@param[in] energy : The raw energy of the hit
+///@param[in] time : The time of the hit
+///@param[out] usedDetectors : The detector types in the event, which the type of the hit is added to
+static void AddHit(RawEvent &event, const unsigned int &channel, const double &energy, const double &time,
+                   set<string> &usedDetectors) {
+    XiaData hit;
+    hit.SetCrateNumber(0);
+    hit.SetSlotNumber(2);
+    hit.SetChannelNumber(channel);
+    hit.SetEnergy(energy);
+    hit.SetTime(time);
+    event.AddChan(new ChanEvent(hit));
+    usedDetectors.insert(DetectorLibrary::get()->at(hit.GetId()).GetType());
+}
+
+///The places that were active in each event, which the ActivationRecorder records.
+static vector<string> activations;
+
+///Loads the configuration and the DetectorDriver the first time that it's called. The DetectorDriver gets the
+/// processors of the configuration followed by an ActivationRecorder and a FailingProcessor. PlotsRegister only lets
+/// the plots be declared once, so every test shares the one DetectorDriver.
+///@return The DetectorDriver
+static DetectorDriver *GetDriver() {
+    static DetectorDriver *driver = NULL;
+    if (driver)
+        return driver;
+
+    XmlInterface::get(UNITTEST_CONFIG);
+    Globals::get(UNITTEST_CONFIG);
+    DetectorLibrary::get();
+    TreeCorrelator::get()->buildTree();
+    RootHandler::get("/tmp/unittest-DetectorDriver");
+
+    driver = DetectorDriver::get();
+    vector<EventProcessor *> processors = driver->GetProcessors();
+    processors.push_back(new ActivationRecorder(&activations));
+    processors.push_back(new FailingProcessor());
+    driver->SetEventProcessors(processors);
+    driver->DeclarePlots();
+    return driver;
+}
+
+///The histograms of DetectorDriver and GeProcessor that the events fill.
+static vector<unsigned int> GetHistogramIds() {
+    vector<unsigned int> ids;
+    ids.push_back(dammIds::raw::OFFSET + dammIds::raw::D_NUMBER_OF_EVENTS);
+    for (unsigned int channel = 0; channel < 4; channel++) {
+        ids.push_back(dammIds::raw::OFFSET + dammIds::raw::D_RAW_ENERGY + channel);
+        ids.push_back(dammIds::raw::OFFSET + dammIds::raw::D_CAL_ENERGY + channel);
+    }
+    ids.push_back(dammIds::ge::OFFSET);
+    return ids;
+}
+
+///@return The bins of each of the histograms, including the underflows and overflows.
+static vector<vector<double> > GetHistogramContents() {
+    vector<vector<double> > contents;
+    vector<unsigned int> ids = GetHistogramIds();
+    for (vector<unsigned int>::const_iterator id = ids.begin(); id != ids.end(); id++) {
+        TH1 *histogram = RootHandler::get()->Get1DHistogram(*id);
+        if (!histogram)
+            histogram = RootHandler::get()->Get2DHistogram(*id);
+        contents.push_back(vector<double>());
+        for (int bin = 0; bin < histogram->GetNcells(); bin++)
+            contents.back().push_back(histogram->GetBinContent(bin));
+    }
+    return contents;
+}
+
+///Processes the same events with the given number of threads, the way that UtkUnpacker::ProcessRawEvent does. The
+/// number of events doesn't fill the last batch, so FinishEvents has to process what's left.
+///@param[in] numberOfThreads : The number of threads to process the events with
+///@param[in] rawev : The raw event to initialize the driver with
+static void ProcessEvents(const unsigned int &numberOfThreads, RawEvent &rawev) {
+    DetectorDriver *driver = GetDriver();
+    driver->SetNumberOfThreads(numberOfThreads);
+    driver->Init(rawev);
+
+    set<string> usedDetectors;
+    for (unsigned int event = 0; event < 1000; event++) {
+        RawEvent &next = driver->GetNextEvent();
+        for (unsigned int channel = 0; channel < 4; channel++) {
+            //The energies are whole numbers, so the random number added to them never moves them into another bin.
+            if ((event + channel) % 3 != 0)
+                AddHit(next, channel, (event * 37 + channel * 101) % 4000 + 20, event * 1000. + channel, usedDetectors);
+        }
+        driver->ProcessNextEvent(usedDetectors);
+        usedDetectors.clear();
+    }
+    driver->FinishEvents();
+}
+
+TEST(TestThreadedEventsMatchSerialEvents) {
+    GetDriver();
+    RawEvent rawev;
+    vector<vector<double> > before = GetHistogramContents();
+    activations.clear();
+    ProcessEvents(1, rawev);
+    vector<vector<double> > serial = GetHistogramContents();
+    vector<string> serialActivations;
+    serialActivations.swap(activations);
+
+    //The histograms that were asked for keep what was filled before, so we compare what each run added to them.
+    ProcessEvents(4, rawev);
+    vector<vector<double> > threaded = GetHistogramContents();
+
+    CHECK_EQUAL(1000, serialActivations.size());
+    CHECK(serialActivations == activations);
+    for (size_t histogram = 0; histogram < before.size(); histogram++)
+        for (size_t bin = 0; bin < before[histogram].size(); bin++)
+            CHECK_EQUAL(serial[histogram][bin] - before[histogram][bin],
+                        threaded[histogram][bin] - serial[histogram][bin]);
+    CHECK_EQUAL(1000, serial[0][dammIds::GENERIC_CHANNEL + 1] - before[0][dammIds::GENERIC_CHANNEL + 1]);
+}
+
+///A batch is handed back before it's processed, so the events that are left in it when a processor throws have to
+/// be emptied then. Otherwise their channels would end up in the next batch.
+TEST(TestExceptionEmptiesTheBatch) {
+    DetectorDriver *driver = GetDriver();
+    RawEvent rawev;
+    driver->SetNumberOfThreads(4);
+    driver->Init(rawev);
+
+    set<string> usedDetectors;
+    for (unsigned int event = 0; event < 63; event++) {
+        AddHit(driver->GetNextEvent(), 0, event == 5 ? 13 : 100, event * 1000., usedDetectors);
+        driver->ProcessNextEvent(usedDetectors);
+        usedDetectors.clear();
+    }
+    AddHit(driver->GetNextEvent(), 0, 100, 63000., usedDetectors);
+    CHECK_THROW(driver->ProcessNextEvent(usedDetectors), PaassException);
+    usedDetectors.clear();
+
+    for (unsigned int event = 0; event < 64; event++) {
+        CHECK_EQUAL(0, driver->GetNextEvent().Size());
+        driver->ProcessNextEvent(usedDetectors);
+    }
+}
+
+int main(int argv, char *argc[]) {
+    const int failures = UnitTest::RunAllTests();
+    delete GetDriver();
+    return failures;
+}
@@ -10,15 +10,21 @@
 
 #include <chrono>
 #include <random>
+#include <thread>
+#include <vector>
 
 TEST(TestRootHandler) {
     RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
     CHECK(handler);
 
-    CHECK_EQUAL("TH1D", handler->RegisterHistogram(0, "test1d", 10)->ClassName());
-    CHECK_EQUAL("TH2D", handler->RegisterHistogram(1, "test2d-xy", 10, 10)->ClassName());
-    CHECK_EQUAL("TH2D", handler->RegisterHistogram(2, "test2d-xz", 10, 0, 10)->ClassName());
-    CHECK_EQUAL("TH3D", handler->RegisterHistogram(3, "test3d", 10, 10, 10)->ClassName());
+    CHECK_EQUAL(1, handler->RegisterHistogram(0, "test1d", 10).GetDimension());
+    CHECK_EQUAL(2, handler->RegisterHistogram(1, "test2d-xy", 10, 10).GetDimension());
+    CHECK_EQUAL(2, handler->RegisterHistogram(2, "test2d-xz", 10, 0, 10).GetDimension());
+    CHECK_EQUAL(3, handler->RegisterHistogram(3, "test3d", 10, 10, 10).GetDimension());
+    CHECK_EQUAL("TH1D", handler->Get1DHistogram(0)->ClassName());
+    CHECK_EQUAL("TH2D", handler->Get2DHistogram(1)->ClassName());
+    CHECK_EQUAL("TH2D", handler->Get2DHistogram(2)->ClassName());
+    CHECK_EQUAL("TH3D", handler->Get3DHistogram(3)->ClassName());
 
     CHECK(!handler->Plot(123,123));
     CHECK_THROW(handler->Get1DHistogram(123), std::invalid_argument);
@@ -31,6 +37,177 @@ TEST(TestRootHandler) {
     delete RootHandler::get();
 }
 
+TEST(TestHistogramHandles) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
+
+    CHECK(!handler->GetHandle(123));
+    CHECK(!handler->Plot(HistogramHandle(), 1));
+
+    handler->RegisterHistogram(10, "handle1d", 10);
+    handler->RegisterHistogram(11, "handle2d-xz", 10, 0, 10);
+    handler->RegisterHistogram(12, "handle3d", 10, 10, 10);
+
+    HistogramHandle handle1d = handler->GetHandle(10);
+    CHECK(handle1d);
+    CHECK_EQUAL(10, handle1d.GetId());
+    CHECK_EQUAL(1, handle1d.GetDimension());
+    CHECK_EQUAL(2, handler->GetHandle(11).GetDimension());
+    CHECK_EQUAL(3, handler->GetHandle(12).GetDimension());
+
+    CHECK(handler->Plot(handle1d, 3));
+    CHECK(handler->Plot(10, 3));
+    CHECK_EQUAL(2, handler->Get1DHistogram(10)->GetBinContent(4));
+
+    //The values have to match the dimensions of the histogram.
+    CHECK(!handler->Plot(handle1d, 3, 4));
+    CHECK(!handler->Plot(handler->GetHandle(11), 3));
+    CHECK(handler->Plot(handler->GetHandle(11), 3, -1, 5));
+    CHECK_EQUAL(1, handler->Get2DHistogram(11)->GetBinContent(4, 6));
+    CHECK(handler->Plot(handler->GetHandle(12), 1, 2, 3));
+    CHECK_EQUAL(1, handler->Get3DHistogram(12)->GetBinContent(2, 3, 4));
+
+    delete RootHandler::get();
+}
+
+TEST(TestPlotsReachTheRootHistograms) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
+    HistogramHandle handle = handler->RegisterHistogram(20, "dense1d", 10);
+
+    //Anything that was filled into the ROOT histogram directly has to survive the plots being added in.
+    handler->Get1DHistogram(20)->Fill(5);
+    const double values[] = {5, 5.5, 6, -1, 10};
+    CHECK(handler->Plot(handle, values, 5));
+    CHECK(!handler->Plot(handler->RegisterHistogram(21, "dense2d", 10, 10), values, 5));
+
+    TH1D *histogram = handler->Get1DHistogram(20);
+    CHECK_EQUAL(3, histogram->GetBinContent(6));
+    CHECK_EQUAL(1, histogram->GetBinContent(7));
+    CHECK_EQUAL(1, histogram->GetBinContent(0));
+    CHECK_EQUAL(1, histogram->GetBinContent(11));
+    CHECK_EQUAL(6, histogram->GetEntries());
+
+    CHECK(handler->Plot(handle, 6));
+    handler->Flush();
+    CHECK_EQUAL(2, histogram->GetBinContent(7));
+    CHECK_EQUAL(7, histogram->GetEntries());
+
+    delete RootHandler::get();
+}
+
+TEST(TestPlotsKeepTheStatistics) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
+    HistogramHandle handle = handler->RegisterHistogram(25, "stats1d", 10);
+
+    //The mean comes from the values that were plotted, not the centres of the bins that they landed in.
+    CHECK(handler->Plot(handle, 3));
+    CHECK(handler->Plot(handle, 5));
+    CHECK(handler->Plot(handle, 12));
+    TH1D *histogram = handler->Get1DHistogram(25);
+    CHECK_EQUAL(4, histogram->GetMean());
+    CHECK_EQUAL(3, histogram->GetEntries());
+
+    histogram->Fill(7);
+    CHECK(handler->Plot(handle, 9));
+    CHECK_EQUAL(6, handler->Get1DHistogram(25)->GetMean());
+
+    delete RootHandler::get();
+}
+
+///The threads plot the same values as the serial loop, just shared out between them, so the histograms have to match
+/// bin for bin, and so do the sums that the mean and RMS come from.
+TEST(TestThreadedPlotsMatchSerialPlots) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
+    HistogramHandle serial = handler->RegisterHistogram(30, "serial", 100, 50);
+    HistogramHandle threaded = handler->RegisterHistogram(31, "threaded", 100, 50);
+    const unsigned int numberOfPlots = 100000;
+    const unsigned int numberOfThreads = 4;
+
+    for (unsigned int i = 0; i < numberOfPlots; i++)
+        handler->Plot(serial, i % 113 - 5.5, i % 61 * 0.9);
+
+    std::vector<std::thread> workers;
+    for (unsigned int worker = 0; worker < numberOfThreads; worker++)
+        workers.emplace_back([handler, threaded, worker, numberOfPlots, numberOfThreads]() {
+            for (unsigned int i = worker; i < numberOfPlots; i += numberOfThreads)
+                handler->Plot(threaded, i % 113 - 5.5, i % 61 * 0.9);
+        });
+    for (auto &worker : workers)
+        worker.join();
+
+    TH2D *serialHistogram = handler->Get2DHistogram(30);
+    TH2D *threadedHistogram = handler->Get2DHistogram(31);
+    CHECK_EQUAL(serialHistogram->GetEntries(), threadedHistogram->GetEntries());
+    for (int x = 0; x <= 101; x++)
+        for (int y = 0; y <= 51; y++)
+            CHECK_EQUAL(serialHistogram->GetBinContent(x, y), threadedHistogram->GetBinContent(x, y));
+
+    double serialStats[TH1::kNstat] = {0}, threadedStats[TH1::kNstat] = {0};
+    serialHistogram->GetStats(serialStats);
+    threadedHistogram->GetStats(threadedStats);
+    for (int i = 0; i < TH1::kNstat; i++)
+        CHECK_EQUAL(serialStats[i], threadedStats[i]);
+
+    delete RootHandler::get();
+}
+
+///Waits for the writer to get through a flush, since it has no way of telling us that it's done.
+static bool WaitForFlushedHistograms(const uint64_t &expected) {
+    for (unsigned int i = 0; i < 1000 && RootHandler::GetFlushedHistograms() < expected; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return RootHandler::GetFlushedHistograms() == expected;
+}
+
+TEST(TestFlushOnlyWritesChangedHistograms) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
+    HistogramHandle changing = handler->RegisterHistogram(40, "changing", 10);
+    HistogramHandle constant = handler->RegisterHistogram(41, "constant", 10);
+    handler->RegisterHistogram(42, "empty", 10);
+    const uint64_t histograms = RootHandler::GetFlushedHistograms();
+    const uint64_t bytes = RootHandler::GetFlushedBytes();
+
+    handler->Plot(changing, 1);
+    handler->Plot(constant, 1);
+    handler->Flush();
+    CHECK(WaitForFlushedHistograms(histograms + 2));
+    CHECK(RootHandler::GetFlushedBytes() > bytes);
+
+    handler->Flush();
+    CHECK_EQUAL(histograms + 2, RootHandler::GetFlushedHistograms());
+
+    handler->Plot(changing, 2);
+    handler->Flush();
+    CHECK(WaitForFlushedHistograms(histograms + 3));
+
+    delete RootHandler::get();
+}
+
+///The Get methods put the histogram into the file that the writer is writing to, so they have to wait for the flush
+/// to be written first. Nothing else tells us when the writer is done, so the count of written histograms has to be
+/// up to date as soon as Get returns.
+TEST(TestGetHistogramWhileFlushing) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
+    const unsigned int numberOfHistograms = 200;
+    for (unsigned int id = 50; id < 50 + numberOfHistograms; id++)
+        for (unsigned int bin = 0; bin < 1000; bin++)
+            handler->Plot(handler->RegisterHistogram(id, "flushing", 1000), bin);
+    const uint64_t histograms = RootHandler::GetFlushedHistograms();
+
+    handler->Flush();
+    TH1D *histogram = handler->Get1DHistogram(50);
+    CHECK_EQUAL(histograms + numberOfHistograms, RootHandler::GetFlushedHistograms());
+    CHECK_EQUAL(1000, histogram->GetEntries());
+    CHECK_EQUAL(1, histogram->GetBinContent(500));
+
+    //The histogram that was handed out is written along with the rest on the next flush, while it's filled some more.
+    handler->Plot(handler->GetHandle(51), 1);
+    handler->Flush();
+    histogram->Fill(2);
+    CHECK_EQUAL(2, handler->Get1DHistogram(51)->GetBinContent(2));
+    CHECK_EQUAL(histograms + numberOfHistograms + 2, RootHandler::GetFlushedHistograms());
+
+    delete RootHandler::get();
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
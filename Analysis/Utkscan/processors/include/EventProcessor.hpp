@@ -39,6 +39,14 @@ public:
     /** Declares the plots for the class */
     virtual void DeclarePlots(void) {};
 
+    /** \return A new processor that does the same processing as this one,
+     * for one of the workers of the DetectorDriver, or NULL if the processor
+     * has to see every event in order. That's the default, a processor should
+     * only provide a copy if it keeps nothing from one event to the next and
+     * doesn't look at the TreeCorrelator. The copy is initialized with the
+     * worker's event, and shares the histograms of this one. */
+    virtual EventProcessor *Clone(void) const { return NULL; }
+
     /** Sets the associated types for the derived classes
     * \return The types associated with a Processor */
     virtual const std::set<std::string> &GetTypes(void) const {
@@ -55,7 +63,8 @@ public:
     virtual bool HasEvent(void) const;
 
     /** Initialize the processor if the detectors that require it are used in
-     * the analysis
+     * the analysis. The summaries of any event that it was initialized with
+     * before are forgotten
      * \param [in] event : the event to initialize with
      * \return True on success */
     virtual bool Init(RawEvent &event);
@@ -23,6 +23,9 @@ public:
     ///@return true if successful
     virtual bool PreProcess(RawEvent &event);
 
+    ///@return A copy of the processor, it keeps nothing between events
+    virtual EventProcessor *Clone(void) const { return new GeProcessor(*this); }
+
     ///Declare the plots for the processor
     virtual void DeclarePlots(void);
 };
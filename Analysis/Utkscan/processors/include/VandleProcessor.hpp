@@ -51,6 +51,9 @@ public:
    ///@return Returns true if the processing was successful */
     virtual bool Process(RawEvent &event);
 
+    ///@return A copy of the processor, the bars and starts are rebuilt for every event
+    virtual EventProcessor *Clone(void) const { return new VandleProcessor(*this); }
+
     ///@brief Correct the time of flight based on the geometry of the setup
     ///@param [in] TOF : The time of flight to correct
     ///@param [in] corRadius : the corrected radius for the flight path
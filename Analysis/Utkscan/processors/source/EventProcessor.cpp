@@ -63,6 +63,7 @@ bool EventProcessor::Init(RawEvent &rawev) {
     if (intersect.empty())
         return (false);
 
+    sumMap.clear();
     for (vector<string>::const_iterator it = intersect.begin();
          it != intersect.end(); it++) {
         sumMap.insert(make_pair(*it, rawev.GetSummary(*it)));
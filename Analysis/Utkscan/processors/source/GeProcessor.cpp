@@ -39,7 +39,7 @@ bool GeProcessor::PreProcess(RawEvent &event) {
     if (!EventProcessor::PreProcess(event))
         return false;
 
-    static const vector<ChanEvent *> &geEvents =
+    const vector<ChanEvent *> &geEvents =
             event.GetSummary("ge", true)->GetList();
 
     for (vector<ChanEvent *>::const_iterator ge = geEvents.begin();
@@ -75,11 +75,11 @@ bool LiquidScintProcessor::Process(RawEvent &event) {
     if (!EventProcessor::Process(event))
         return false;
 
-    static const vector<ChanEvent *> &liquidEvents =
+    const vector<ChanEvent *> &liquidEvents =
             event.GetSummary("liquid_scint:liquid")->GetList();
-    static const vector<ChanEvent *> &betaStartEvents =
+    const vector<ChanEvent *> &betaStartEvents =
             event.GetSummary("liquid_scint:beta:start")->GetList();
-    static const vector<ChanEvent *> &liquidStartEvents =
+    const vector<ChanEvent *> &liquidStartEvents =
             event.GetSummary("liquid_scint:liquid:start")->GetList();
 
     vector<ChanEvent *> startEvents;
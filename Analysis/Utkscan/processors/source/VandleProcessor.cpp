@@ -85,7 +85,7 @@ bool VandleProcessor::PreProcess(RawEvent &event) {
     bars_.clear();
     starts_.clear();
 
-    static const vector<ChanEvent *> &events = event.GetSummary("vandle")->GetList();
+    const vector<ChanEvent *> &events = event.GetSummary("vandle")->GetList();
 
     if (events.empty() || events.size() < 2) {
         if (events.empty())
@@ -116,8 +116,8 @@ bool VandleProcessor::Process(RawEvent &event) {
 
     geSummary_ = event.GetSummary("clover");
 
-    static const vector<ChanEvent *> &betaStarts = event.GetSummary("beta_scint:beta")->GetList();
-    static const vector<ChanEvent *> &liquidStarts = event.GetSummary("liquid:scint:start")->GetList();
+    const vector<ChanEvent *> &betaStarts = event.GetSummary("beta_scint:beta")->GetList();
+    const vector<ChanEvent *> &liquidStarts = event.GetSummary("liquid:scint:start")->GetList();
 
     vector<ChanEvent *> startEvents;
     startEvents.insert(startEvents.end(), betaStarts.begin(), betaStarts.end());
@@ -126,7 +126,7 @@ bool VandleProcessor::Process(RawEvent &event) {
     TimingMapBuilder bldStarts(startEvents);
     starts_ = bldStarts.GetMap();
 
-    static const vector<ChanEvent *> &doubleBetaStarts = event.GetSummary("beta:double:start")->GetList();
+    const vector<ChanEvent *> &doubleBetaStarts = event.GetSummary("beta:double:start")->GetList();
     BarBuilder startBars(doubleBetaStarts);
     startBars.BuildBars();
     barStarts_ = startBars.GetBarMap();
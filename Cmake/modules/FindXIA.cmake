@@ -74,6 +74,9 @@ function(XIA_CONFIG)
             "#associated with the type specified prior to the tag. If no type is specified the \n"
             "#type 'default' is used.                                                          \n"
             "#\n"
+            "#The optional global tag EmulatorFile replaces the crate with modules emulated in \n"
+            "#software, see PixieEmulator.h for the format of the file that it names.          \n"
+            "#\n"
             "#The tag values are prepended with a base directory unless the first character in \n"
             "#the value is forward slash, '/',  or a period '.', permiting the use of absolute \n"
             "#and relative paths. The global tags are prepended with the PixieBaseDir. Module  \n"
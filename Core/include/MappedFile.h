@@ -0,0 +1,71 @@
+/** \file MappedFile.h
+  *
+  * \brief Read-only memory mapped access to poll2 output data files
+  *
+  * The file is mapped privately so that the scan code may
+  * temporarily write into the mapping (e.g. to terminate a spill
+  * in place) without touching the file on disk. Only the pages
+  * which are actually written are copied by the kernel.
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+#include <cstddef>
+
+class MappedFile {
+public:
+    MappedFile();
+
+    ~MappedFile();
+
+    /// Map an entire file into memory. Return false if the file could not be opened or mapped.
+    bool Open(const std::string &fname_);
+
+    /// Unmap the file, if one is mapped.
+    void Close();
+
+    /// Return true if a file is currently mapped.
+    bool IsOpen() { return (data != NULL); }
+
+    /// Return true if the read position is at or beyond the end of the file.
+    bool Eof() { return (position >= length); }
+
+    /// Return the length of the mapped file in bytes.
+    size_t GetLength() { return length; }
+
+    /// Return the current read position in bytes.
+    size_t GetPosition() { return position; }
+
+    /// Return the number of bytes between the read position and the end of the file.
+    size_t GetBytesRemaining() { return (position < length ? length - position : 0); }
+
+    /// Move the read position to a specified byte. Return false if the position is beyond the end of the file.
+    bool Seek(const size_t &position_);
+
+    /// Return a pointer to the current read position without moving it, or NULL if no file is mapped.
+    char *Peek() { return (data ? &data[position] : NULL); }
+
+    /** Return a pointer to the current read position and advance the read position by the requested number of bytes.
+      * Returns NULL, without moving the read position, if there are fewer than nBytes_ left in the file. */
+    char *Read(const size_t &nBytes_);
+
+private:
+    char *data; /// Pointer to the start of the mapping.
+    size_t length; /// Length of the mapped file in bytes.
+    size_t position; /// Current read position in bytes.
+
+    /// Copying would unmap the file twice.
+    MappedFile(const MappedFile &);
+
+    MappedFile &operator=(const MappedFile &);
+};
+
+#endif
@@ -0,0 +1,113 @@
+/** \file SpillIndex.h
+  *
+  * \brief Sidecar index of the spills in poll2 output data files
+  *
+  * The index stores one small entry for each spill in a .ldf or .pld
+  * file: where the spill starts in the file, how many words it has,
+  * the first and last time stamps in it and the number of hits from
+  * each module. poll2 writes the index next to the data file while it
+  * records, and SpillIndex::Build creates one for an existing file in
+  * a single pass that never decodes the channel data. With the index
+  * a scan can jump straight to any spill or time in the run.
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#ifndef SPILLINDEX_H
+#define SPILLINDEX_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// The summary of a single spill in a data file.
+struct SpillIndexEntry {
+    unsigned long long offset; /// The byte in the data file at which the spill starts.
+    unsigned int nWords; /// The number of data words in the spill.
+    unsigned long long firstTime; /// The earliest time stamp in the spill (in clock ticks).
+    unsigned long long lastTime; /// The latest time stamp in the spill (in clock ticks).
+    std::vector<unsigned int> moduleHits; /// The number of hits from each module, indexed by module number.
+
+    SpillIndexEntry() : offset(0), nWords(0), firstTime(0), lastTime(0) {}
+
+    /// Return the total number of hits in the spill.
+    unsigned long GetNumberOfHits() const;
+};
+
+class SpillIndex {
+public:
+    SpillIndex();
+
+    ~SpillIndex();
+
+    /// Return the name of the index file that belongs to a data file.
+    static std::string GetIndexFilename(const std::string &fname_) { return fname_ + ".idx"; }
+
+    /** Summarize a spill made of the module buffers that poll2 reads out (buffer length, module number and
+      * the list mode data). Only the first four words of each hit are looked at. */
+    static SpillIndexEntry Summarize(const unsigned int *data_, const unsigned int &nWords_,
+                                     const unsigned long long &offset_);
+
+    /// Build the index of an existing .ldf or .pld file by reading through it once. Return false on failure.
+    bool Build(const std::string &fname_);
+
+    /// Read an index file. Return false if the file could not be opened or is not an index.
+    bool Read(const std::string &fname_);
+
+    /// Write the whole index to a file. Return false if the file could not be written.
+    bool Write(const std::string &fname_);
+
+    /** Open an index file for writing. Every entry added afterwards is appended to it right away, so the
+      * index is usable even if the program writing it dies. Return false if the file could not be opened. */
+    bool OpenOutput(const std::string &fname_);
+
+    /// Close the index file opened with OpenOutput, if there is one.
+    void CloseOutput();
+
+    /// Return true if an index file is open for writing.
+    bool IsOutputOpen() { return output_file.is_open(); }
+
+    /// Add an entry to the end of the index, and to the output file if one is open.
+    void Add(const SpillIndexEntry &entry_);
+
+    /// Remove all entries from the index.
+    void Clear() { entries.clear(); }
+
+    /// Return the number of spills in the index.
+    size_t GetNumberOfSpills() const { return entries.size(); }
+
+    /// Return the entry for a spill. The spill must be less than GetNumberOfSpills.
+    const SpillIndexEntry &GetSpill(const size_t &spill_) const { return entries[spill_]; }
+
+    /** Return the first spill that could contain a hit at or after time_. The time stamps only ever
+      * increase from one spill to the next, so this is a binary search. Returns GetNumberOfSpills if
+      * every spill ends before time_. */
+    size_t FindFirstSpill(const unsigned long long &time_) const;
+
+    /** Return one past the last spill that could contain a hit at or before time_, i.e. the number of
+      * spills that start at or before time_. */
+    size_t FindEndSpill(const unsigned long long &time_) const;
+
+    /// Print a summary of the run: the number of spills, words and hits, the time range and the hits per module.
+    void Print() const;
+
+private:
+    std::vector<SpillIndexEntry> entries; /// The spills in the order in which they appear in the data file.
+    std::ofstream output_file; /// The index file that entries are appended to.
+
+    /// Write the file header.
+    static void write_header(std::ofstream &file_);
+
+    /// Write a single entry.
+    static void write_entry(std::ofstream &file_, const SpillIndexEntry &entry_);
+
+    /// Copying would write the output file twice.
+    SpillIndex(const SpillIndex &);
+
+    SpillIndex &operator=(const SpillIndex &);
+};
+
+#endif
@@ -0,0 +1,226 @@
+/** \file SpillRing.h
+  *
+  * \brief A POSIX shared-memory ring buffer that poll2 writes spills into and that the scanners read them from
+  *
+  * The ring lives in a named shared-memory object (shm_open) made of a
+  * header page followed by the data region. The data region is mapped
+  * twice, back to back, so that a record which wraps around the end of
+  * the ring is still contiguous in memory. Spills are therefore handed to
+  * the scanners without any copies, and may be as large as the ring.
+  *
+  * There is a single writer. Any number of readers map the data region
+  * read-only and register themselves as a consumer in the header, each
+  * with its own policy for what happens when it can't keep up (see
+  * SpillRingPolicy). The writer only ever waits on the lossless consumers.
+  * A reader that falls more than a ring behind skips to the newest record
+  * and counts the records that it missed, instead of reading data that has
+  * been written over. Readers sleep on a futex in the header until the
+  * writer commits a record.
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#ifndef SPILLRING_H
+#define SPILLRING_H
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/// The default name of the ring that poll2 writes to.
+#define SPILL_RING_DEFAULT_NAME "/paass-spills"
+
+/// The default size of the data region of the ring, enough for a few dozen full crate spills.
+#define SPILL_RING_DEFAULT_SIZE (128ul * 1024ul * 1024ul)
+
+/// The types of record in the ring.
+enum SpillRingRecordType {
+    SPILL_RING_SPILL = 0, /// A spill, ending with the end of spill flag
+    SPILL_RING_OPEN_FILE = 1, /// poll2 opened a new output file
+    SPILL_RING_CLOSE_FILE = 2, /// poll2 closed its output file
+    SPILL_RING_CLOSE = 3 /// The writer is closing the ring
+};
+
+/// The maximum number of consumers that can be registered with a ring at once.
+#define SPILL_RING_MAX_CONSUMERS 16
+
+/// What a consumer wants to happen to the records that it can't keep up with.
+enum SpillRingPolicy {
+    SPILL_RING_BEST_EFFORT = 0, /// Read every record, unless the writer laps us, then skip to the newest one
+    SPILL_RING_LOSSLESS = 1, /// The writer waits for us before it writes over a record that we haven't read
+    SPILL_RING_SPOOL = 2, /// Lossless, but the consumer copies each record to disk as soon as it is written
+    SPILL_RING_LATEST = 3, /// Only read the newest record, whatever was written before it is skipped
+    SPILL_RING_SAMPLED = 4 /// Read every Nth spill, and all of the other types of record
+};
+
+/// The header at the start of the shared memory object, shared by the writer and the readers.
+struct SpillRingHeader;
+
+/// The entry for a consumer in the header of the ring.
+struct SpillRingConsumer;
+
+/// What the writer knows about one of the consumers of its ring, see SpillRingWriter::GetConsumers.
+struct SpillRingConsumerInfo {
+    std::string name; /// The name that the consumer registered with, e.g. utkscan.
+    int pid; /// The process ID of the consumer.
+    unsigned int policy; /// One of the SpillRingPolicy.
+    unsigned int sampling; /// The N of SPILL_RING_SAMPLED.
+    uint64_t delivered; /// The number of records that the consumer has read.
+    uint64_t dropped; /// The number of records that were written over before the consumer could read them.
+    uint64_t skipped; /// The number of records that the consumer skipped because of its policy.
+    uint64_t behind; /// The number of bytes that the consumer has left to read.
+};
+
+/// A record that has been read from the ring. The data points into the ring itself.
+struct SpillRingRecord {
+    uint64_t sequence; /// The number of records that the writer had committed before this one.
+    uint64_t position; /// The position of the record in the ring, in bytes since the ring was created.
+    unsigned int type; /// One of the SpillRingRecordType.
+    unsigned int nWords; /// The number of words in data.
+    const unsigned int *data; /// The words of the record, only valid while SpillRingReader::IsValid is true.
+};
+
+class SpillRingWriter {
+public:
+    SpillRingWriter();
+
+    /// Writes a SPILL_RING_CLOSE record and removes the ring, if one is open.
+    ~SpillRingWriter();
+
+    /** Create the ring, replacing any ring of the same name that a previous writer left behind. Return false if the
+      * shared memory object could not be created or mapped. The size is rounded up to a whole number of pages. */
+    bool Open(const std::string &name_ = SPILL_RING_DEFAULT_NAME, const size_t &size_ = SPILL_RING_DEFAULT_SIZE);
+
+    /// Write a SPILL_RING_CLOSE record, unmap the ring and remove its name, if a ring is open.
+    void Close();
+
+    /// Return true if a ring is currently open.
+    bool IsOpen() { return (header != NULL); }
+
+    /// Return the size of the data region in bytes.
+    size_t GetSize() { return size; }
+
+    /** Return a pointer to room for a record of nWords_ words in the ring, which the caller fills in and then passes
+      * to Commit. The readers don't see the record until it's committed. Returns NULL if no ring is open or if the
+      * record wouldn't fit in the ring. */
+    unsigned int *Reserve(const unsigned int &nWords_);
+
+    /** Make the record at the last Reserve visible to the readers and wake them up. nWords_ may be smaller than the
+      * number of words that were reserved. Return false if nothing was reserved. */
+    bool Commit(const unsigned int &type_, const unsigned int &nWords_);
+
+    /// Copy nWords_ words into a new record and commit it. Return false if the record could not be reserved.
+    bool Write(const unsigned int &type_, const unsigned int *data_ = NULL, const unsigned int &nWords_ = 0);
+
+    /// Return the number of records committed since the ring was opened.
+    uint64_t GetNumberOfRecords();
+
+    /** Set the longest time, in milliseconds, that Reserve waits for the lossless consumers before it writes over
+      * records that they haven't read. A negative time waits for as long as it takes, which is the default. */
+    void SetMaximumWait(const int &timeout_) { maximumWait = timeout_; }
+
+    /// Return the number of times that Reserve had to wait for a lossless consumer.
+    uint64_t GetNumberOfWaits() { return waits; }
+
+    /// Fill consumers_ with the consumers that are registered with the ring. Return the number of consumers.
+    size_t GetConsumers(std::vector<SpillRingConsumerInfo> &consumers_);
+
+private:
+    SpillRingHeader *header; /// The header of the ring, NULL if no ring is open.
+    char *ring; /// The start of the first of the two mappings of the data region.
+    size_t size; /// The size of the data region in bytes.
+    std::string name; /// The name of the shared memory object.
+    unsigned int *reserved; /// The record returned by the last Reserve, NULL if there isn't one.
+    unsigned int reservedWords; /// The number of words that were reserved.
+    int maximumWait; /// The longest time that Reserve waits for the lossless consumers in ms, negative for forever.
+    uint64_t waits; /// The number of times that Reserve had to wait for a lossless consumer.
+
+    /// Wait until none of the lossless consumers need the records before end_, or until maximumWait runs out.
+    void WaitForConsumers(const uint64_t &end_);
+
+    /// Return true if a lossless consumer still needs a record before end_.
+    bool IsWaitingForConsumers(const uint64_t &end_);
+
+    /// Free the entries of the consumers whose process has exited without closing the ring.
+    void RemoveDeadConsumers();
+
+    /// Copying would unmap the ring twice.
+    SpillRingWriter(const SpillRingWriter &);
+
+    SpillRingWriter &operator=(const SpillRingWriter &);
+};
+
+class SpillRingReader {
+public:
+    SpillRingReader();
+
+    ~SpillRingReader();
+
+    /** Map an existing ring and register with it as a consumer, see SpillRingPolicy. Reading starts with the next
+      * record that the writer commits. Return false if there is no ring of that name, it could not be mapped, or
+      * there is no room for another consumer. A best effort consumer that may not write to the header of the ring,
+      * e.g. because it belongs to another user, reads the ring without registering. */
+    bool Open(const std::string &name_ = SPILL_RING_DEFAULT_NAME, const unsigned int &policy_ = SPILL_RING_BEST_EFFORT,
+              const unsigned int &sampling_ = 1, const std::string &consumer_ = "");
+
+    /// Unmap the ring, if one is mapped.
+    void Close();
+
+    /// Return true if a ring is currently mapped.
+    bool IsOpen() { return (header != NULL); }
+
+    /** Get the next record from the ring, waiting up to timeout_ milliseconds for the writer to commit one. A
+      * negative timeout waits forever. Return false if there was no new record in time. The record that was
+      * returned by the last call is given back to the writer, a lossless consumer has to be done with it. */
+    bool Next(SpillRingRecord &record_, const int &timeout_);
+
+    /** Return true if the writer hasn't started writing over the record yet. Check this after the record's data has
+      * been used, if it's false the data may have changed underneath us and should be thrown away. */
+    bool IsValid(const SpillRingRecord &record_);
+
+    /// Return the number of records that were written over before we could read them, or while we were using them.
+    uint64_t GetNumberOfLostRecords() { return lostRecords; }
+
+    /// Count a record that was written over while it was being used, see IsValid.
+    void AddLostRecord();
+
+    /// Return the number of records that were skipped because of the policy.
+    uint64_t GetNumberOfSkippedRecords() { return skippedRecords; }
+
+    /// Return the policy that we registered with.
+    unsigned int GetPolicy() { return policy; }
+
+    /** Return true if the name of the ring now belongs to a different ring, e.g. because poll2 was restarted after a
+      * crash without closing the ring. The ring should be opened again. */
+    bool IsStale();
+
+private:
+    SpillRingHeader *header; /// The header of the ring, NULL if no ring is mapped.
+    SpillRingConsumer *consumer; /// Our entry in the header, NULL if we aren't registered.
+    const char *ring; /// The start of the first of the two mappings of the data region.
+    size_t size; /// The size of the data region in bytes.
+    uint64_t position; /// The position of the next record to read, in bytes since the ring was created.
+    uint64_t sequence; /// The sequence number of the next record to read.
+    uint64_t lostRecords; /// The number of records that we missed.
+    uint64_t skippedRecords; /// The number of records that we skipped because of the policy.
+    uint64_t spills; /// The number of spills that we've come across, for SPILL_RING_SAMPLED.
+    unsigned int policy; /// One of the SpillRingPolicy.
+    unsigned int sampling; /// Read every Nth spill for SPILL_RING_SAMPLED.
+    std::string name; /// The name of the shared memory object.
+    unsigned long inode; /// Identifies the shared memory object that we have mapped.
+
+    /// Let the writer know that we're done with everything before position, and wake it up if it's waiting on us.
+    void Release();
+
+    /// Copying would unmap the ring twice.
+    SpillRingReader(const SpillRingReader &);
+
+    SpillRingReader &operator=(const SpillRingReader &);
+};
+
+#endif
@@ -0,0 +1,51 @@
+/** \file TraceCodec.h
+  *
+  * \brief Lossless compression of the ADC traces in poll2 spills
+  *
+  * ADC traces change slowly from one sample to the next, so we store
+  * the difference between neighbouring samples instead of the samples
+  * themselves. The differences are zigzag encoded, so that small
+  * negative numbers become small positive ones, and bit packed in
+  * blocks of 128 samples using the fewest bits that hold the largest
+  * difference in the block. Inside of a block the values are dealt out
+  * to four interleaved lanes, which lets the decoder unpack, undo the
+  * zigzag and sum four samples at a time with SSE2.
+  *
+  * A compressed trace is laid out as follows:
+  *  - 1 word: the first sample (lower 16 bits) and the number of samples (upper 16 bits)
+  *  - ceil(nBlocks/4) words: the bit width of each block, one byte per block
+  *  - 4*width words for each block, the last block is padded with zeros
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#ifndef TRACECODEC_H
+#define TRACECODEC_H
+
+#include <vector>
+
+namespace TraceCodec {
+    /// Return the largest number of words that a trace with nSamples_ samples can compress to.
+    unsigned int GetMaxCompressedWords(const unsigned int &nSamples_);
+
+    /** Compress a trace. The output array must hold at least GetMaxCompressedWords(nSamples_) words.
+      * Return the number of words written, or zero if the trace is empty or too long to compress. */
+    unsigned int Compress(const unsigned short *samples_, const unsigned int &nSamples_, unsigned int *out_);
+
+    /** Decompress a trace. The samples array must hold at least nSamples_ samples. Return false if the
+      * compressed trace is corrupt, does not have nSamples_ samples or does not use exactly nWords_ words. */
+    bool Decompress(const unsigned int *in_, const unsigned int &nWords_, unsigned short *samples_,
+                    const unsigned int &nSamples_);
+
+    /** Copy a spill of module buffers, as poll2 reads them out, and compress every trace along the way.
+      * The event length of each hit and the length of each buffer are updated to match. A trace is only
+      * compressed if that makes it shorter, and anything that we don't recognize is copied as it is.
+      * Return the number of words in the compressed spill. */
+    unsigned int CompressSpill(const unsigned int *data_, const unsigned int &nWords_,
+                               std::vector<unsigned int> &out_);
+}
+
+#endif
@@ -24,13 +24,19 @@
 #include <fstream>
 #include <vector>
 
+#include "SpillIndex.h"
+
 #define HRIBF_BUFFERS_VERSION "1.3.00"
 #define HRIBF_BUFFERS_DATE "Sept. 19th, 2016"
 
 #define ACTUAL_BUFF_SIZE 8194 /// HRIBF .ldf file format
 
+#define POLL_OUTPUT_BUFFER_SIZE 4194304 /// The size of the stream buffer of PollOutputFile, in bytes
+
 class Client;
 
+class MappedFile;
+
 class BufferType {
 protected:
     unsigned int bufftype;
@@ -105,6 +111,9 @@ public:
 
     float GetRunTime() { return run_time; }
 
+    /// Return true if the traces in the DATA buffers are compressed with TraceCodec.
+    bool HasCompressedTraces();
+
     void SetStartDateTime();
 
     void SetEndDateTime();
@@ -120,6 +129,9 @@ public:
 
     void SetRunTime(float time_) { run_time = time_; }
 
+    /// Mark the traces in the DATA buffers as compressed with TraceCodec, this changes the format string.
+    void SetCompressedTraces(bool compressed_);
+
     /** HEAD buffer (1 word buffer type, 1 word run number, 1 word maximum spill size, 4 word format,
       * 2 word facility, 6 word date, 1 word title length (x in bytes), x/4 word title, 1 word end of buffer*/
     virtual bool Write(std::ofstream *file_);
@@ -151,6 +163,11 @@ public:
     virtual bool Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
                       unsigned int max_bytes_, bool dry_run_mode = false);
 
+    /** Read a data spill from a memory mapped file without copying it. On success data_ points
+      * to the first word of the spill inside of the mapping. */
+    bool Read(MappedFile *file_, unsigned int *&data_, unsigned int &nBytes,
+              unsigned int max_bytes_);
+
     /// Set initial values.
     virtual void Reset() {}
 };
@@ -258,12 +275,29 @@ private:
     unsigned int missing_chunks; /// Count of the number of missing spill chunks which were dropped.
 
     unsigned int buff_pos; /// The actual position in the current ldf buffer.
+    unsigned int start_word; /// The word in the first ldf buffer after a reset at which to start reading.
+
+    unsigned long long curr_offset; /// The position of the current ldf buffer in the file (in bytes).
+    unsigned long long next_offset; /// The position of the next ldf buffer in the file (in bytes).
+    unsigned long long spill_offset; /// The position of the first chunk of the last spill read or written (in bytes).
 
     /// DATA buffer (1 word buffer type, 1 word buffer size)
     bool open_(std::ofstream *file_);
 
     bool read_next_buffer(std::ifstream *f_, bool force_ = false);
 
+    /// Point the current and next buffers directly into a memory mapped file instead of copying them.
+    bool read_next_buffer(MappedFile *f_, bool force_ = false);
+
+    /// Move past the words before start_word in the first buffer read after a reset.
+    void skip_to_start_word();
+
+    /// Stitch the next spill together from the buffers provided by read_next_buffer.
+    template<typename T>
+    bool read_spill(T *file_, char *data_, unsigned int &nBytes_,
+                    unsigned int max_bytes_, bool &full_spill,
+                    bool &bad_spill, bool dry_run_mode);
+
 public:
     DATA_buffer(); /// 0x41544144 "DATA"
 
@@ -292,6 +326,14 @@ public:
     /// Return the number of missing or dropped spill chunks.
     unsigned int GetNumMissing() { return missing_chunks; }
 
+    /// Return the position in the file of the first chunk of the last spill read or written (in bytes).
+    unsigned long long GetSpillOffset() { return spill_offset; }
+
+    /** Start reading the first ldf buffer after a reset at the given word instead of right after its header.
+      * This lets a spill be read starting from a position recorded with GetSpillOffset. The file must
+      * be positioned at the start of the ldf buffer that holds the word. Call this after Reset. */
+    void SetStartWord(unsigned int word_) { start_word = word_; }
+
     /// Write a data spill to file
     virtual bool Write(std::ofstream *file_, char *data_, unsigned int nWords_,
                        int &buffs_written);
@@ -301,6 +343,12 @@ public:
                       unsigned int max_bytes_, bool &full_spill,
                       bool &bad_spill, bool dry_run_mode = false);
 
+    /** Read a data spill from a memory mapped file. The ldf buffers are read in place, so
+      * each spill chunk is copied exactly once, from the mapping into data_. */
+    bool Read(MappedFile *file_, char *data_, unsigned int &nBytes_,
+              unsigned int max_bytes_, bool &full_spill,
+              bool &bad_spill, bool dry_run_mode = false);
+
     /// Set initial values.
     virtual void Reset();
 };
@@ -332,12 +380,16 @@ private:
     HEAD_buffer headBuff;
     DATA_buffer dataBuff;
     EOF_buffer eofBuff;
+    SpillIndex spillIndex; /// The index of the spills written to the current file.
     unsigned int max_spill_size;
     unsigned int current_file_num;
     unsigned int output_format;
     unsigned int number_spills;
     unsigned int run_num;
     bool debug_mode;
+    bool compress_traces; /// True if the traces in .pld files are compressed.
+    std::vector<unsigned int> compressed_spill; /// The last spill that we compressed, kept to reuse the storage.
+    std::vector<char> stream_buffer; /// The buffer of output_file, so that the file is written in large blocks.
 
     unsigned int current_depth;
     std::string current_directory;
@@ -400,6 +452,13 @@ public:
     /// Set the output filename prefix
     void SetFilenamePrefix(std::string filename_);
 
+    /** Compress the traces of every spill written to a .pld file with TraceCodec. The HEAD buffer marks
+      * the file so that the scan knows to decompress them. Only takes effect when the next file is opened. */
+    void SetCompressTraces(bool compress_ = true) { compress_traces = compress_; }
+
+    /// Return true if the traces written to .pld files are compressed.
+    bool GetCompressTraces() { return compress_traces; }
+
     /// Return true if an output file is open and writable and false otherwise
     bool IsOpen() { return (output_file.is_open() && output_file.good()); }
 
@@ -0,0 +1,77 @@
+/** \file MappedFile.cpp
+  *
+  * \brief Read-only memory mapped access to poll2 output data files
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+MappedFile::MappedFile() : data(NULL), length(0), position(0) {
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+/// Map an entire file into memory.
+bool MappedFile::Open(const std::string &fname_) {
+    Close();
+
+    int fd = open(fname_.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping is private, so writes into it are never written back to the file.
+    void *addr = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    // The mapping holds its own reference to the file.
+    close(fd);
+
+    if (addr == MAP_FAILED) { return false; }
+
+    // We read the file front to back, so ask the kernel for aggressive read-ahead.
+    madvise(addr, info.st_size, MADV_SEQUENTIAL);
+
+    data = (char *) addr;
+    length = info.st_size;
+    position = 0;
+
+    return true;
+}
+
+/// Unmap the file.
+void MappedFile::Close() {
+    if (data) { munmap(data, length); }
+    data = NULL;
+    length = 0;
+    position = 0;
+}
+
+/// Move the read position to a specified byte.
+bool MappedFile::Seek(const size_t &position_) {
+    if (!data || position_ > length) { return false; }
+    position = position_;
+    return true;
+}
+
+/// Return a pointer to the current read position and advance the read position.
+char *MappedFile::Read(const size_t &nBytes_) {
+    if (!data || nBytes_ > GetBytesRemaining()) { return NULL; }
+    char *output = &data[position];
+    position += nBytes_;
+    return output;
+}
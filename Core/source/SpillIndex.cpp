@@ -0,0 +1,275 @@
+/** \file SpillIndex.cpp
+  *
+  * \brief Sidecar index of the spills in poll2 output data files
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#include <iomanip>
+#include <iostream>
+
+#include "hribf_buffers.h"
+#include "SpillIndex.h"
+
+#define SPILL_INDEX_MAGIC 0x58444953 /// "SIDX"
+#define SPILL_INDEX_VERSION 1
+
+#define MAX_SPILL_WORDS 1000000 /// The largest spill that we will read while building an index.
+
+/// Return the total number of hits in the spill.
+unsigned long SpillIndexEntry::GetNumberOfHits() const {
+    unsigned long total = 0;
+    for (std::vector<unsigned int>::const_iterator iter = moduleHits.begin(); iter != moduleHits.end(); iter++)
+        total += *iter;
+    return total;
+}
+
+SpillIndex::SpillIndex() {
+}
+
+SpillIndex::~SpillIndex() {
+    CloseOutput();
+}
+
+/// The module buffers have the same layout as the ones that Unpacker::ReadSpill walks through, and they're skipped
+/// in the same situations. The header length, the time stamp and the lower bits of the event length sit in the same
+/// place for every firmware. The oldest firmwares use bit 30 as the out of range flag rather than as part of the
+/// event length, which we can tell from the hit running past the end of its buffer.
+SpillIndexEntry SpillIndex::Summarize(const unsigned int *data_, const unsigned int &nWords_,
+                                      const unsigned long long &offset_) {
+    SpillIndexEntry entry;
+    entry.offset = offset_;
+    entry.nWords = nWords_;
+
+    bool first_hit = true;
+    unsigned int position = 0;
+    while (position + 1 < nWords_) {
+        if (data_[position] == 0xFFFFFFFF) { // Skip the delimiters between buffers.
+            position++;
+            continue;
+        }
+
+        unsigned int length = data_[position];
+        unsigned int vsn = data_[position + 1];
+        if (vsn == 9999 || length < 2 || position + length > nWords_) { break; } // End of spill or lost our place.
+
+        // The buffer with VSN 1000 holds the wall clock time and a six word buffer is an empty module.
+        if (vsn == 1000 || length == 6 || vsn > 13) {
+            position += length;
+            continue;
+        }
+
+        if (entry.moduleHits.size() <= vsn) { entry.moduleHits.resize(vsn + 1, 0); }
+
+        const unsigned int end = position + length;
+        unsigned int hit = position + 2;
+        while (hit + 4 <= end) {
+            unsigned int header_length = (data_[hit] & 0x0001F000) >> 12;
+            unsigned int event_length = (data_[hit] & 0x7FFE0000) >> 17;
+            if (hit + event_length > end) { event_length &= 0x1FFF; }
+            if (header_length < 4 || event_length < header_length || hit + event_length > end) { break; }
+
+            unsigned long long time = data_[hit + 1] | ((unsigned long long) (data_[hit + 2] & 0x0000FFFF) << 32);
+            if (first_hit || time < entry.firstTime) { entry.firstTime = time; }
+            if (first_hit || time > entry.lastTime) { entry.lastTime = time; }
+            first_hit = false;
+
+            entry.moduleHits[vsn]++;
+            hit += event_length;
+        }
+
+        position = end;
+    }
+
+    return entry;
+}
+
+/// Build the index of an existing .ldf or .pld file.
+bool SpillIndex::Build(const std::string &fname_) {
+    const size_t dot = fname_.find_last_of('.');
+    const std::string extension = (dot == std::string::npos ? "" : fname_.substr(dot + 1));
+    if (extension != "ldf" && extension != "pld") { return false; }
+
+    std::ifstream file(fname_.c_str(), std::ios::binary);
+    if (!file.is_open() || !file.good()) { return false; }
+
+    entries.clear();
+    std::vector<unsigned int> data(MAX_SPILL_WORDS + 2);
+    unsigned int nBytes;
+
+    if (extension == "pld") {
+        PLD_header head;
+        PLD_data spill;
+        head.Read(&file);
+
+        while (true) {
+            unsigned long long offset = file.tellg();
+            if (!spill.Read(&file, (char *) &data[0], nBytes, 4 * MAX_SPILL_WORDS)) { break; }
+            Add(Summarize(&data[0], nBytes / 4, offset));
+        }
+    } else {
+        DIR_buffer dir;
+        HEAD_buffer head;
+        DATA_buffer spill;
+        dir.Read(&file);
+        head.Read(&file);
+
+        bool full_spill, bad_spill;
+        while (true) {
+            if (!spill.Read(&file, (char *) &data[0], nBytes, 4 * MAX_SPILL_WORDS, full_spill, bad_spill)) {
+                if (spill.GetRetval() == 2 || spill.GetRetval() == 6) { break; }
+                continue;
+            }
+
+            // Fragments are never handed to the unpacker, so they don't get an entry either. The last two words
+            // are the end of spill flag, which isn't part of the spill.
+            if (full_spill && !bad_spill && nBytes >= 8)
+                Add(Summarize(&data[0], nBytes / 4 - 2, spill.GetSpillOffset()));
+        }
+    }
+
+    return true;
+}
+
+/// Read an index file.
+bool SpillIndex::Read(const std::string &fname_) {
+    std::ifstream file(fname_.c_str(), std::ios::binary);
+    if (!file.is_open() || !file.good()) { return false; }
+
+    unsigned int magic = 0, version = 0;
+    file.read((char *) &magic, 4);
+    file.read((char *) &version, 4);
+    if (!file.good() || magic != SPILL_INDEX_MAGIC || version != SPILL_INDEX_VERSION) { return false; }
+
+    entries.clear();
+    SpillIndexEntry entry;
+    unsigned int nModules;
+    while (true) {
+        file.read((char *) &entry.offset, 8);
+        file.read((char *) &entry.nWords, 4);
+        file.read((char *) &entry.firstTime, 8);
+        file.read((char *) &entry.lastTime, 8);
+        file.read((char *) &nModules, 4);
+        if (!file.good() || nModules > 256) { break; }
+
+        entry.moduleHits.resize(nModules);
+        if (nModules != 0) { file.read((char *) &entry.moduleHits[0], 4 * nModules); }
+
+        // A partially written entry at the end of the file was cut off when the writer stopped.
+        if (!file.good()) { break; }
+        entries.push_back(entry);
+    }
+
+    return true;
+}
+
+/// Write the whole index to a file.
+bool SpillIndex::Write(const std::string &fname_) {
+    std::ofstream file(fname_.c_str(), std::ios::binary);
+    if (!file.is_open() || !file.good()) { return false; }
+
+    write_header(file);
+    for (std::vector<SpillIndexEntry>::const_iterator iter = entries.begin(); iter != entries.end(); iter++)
+        write_entry(file, *iter);
+
+    return file.good();
+}
+
+/// Open an index file that entries are appended to as they're added.
+bool SpillIndex::OpenOutput(const std::string &fname_) {
+    CloseOutput();
+    entries.clear();
+
+    output_file.open(fname_.c_str(), std::ios::binary);
+    if (!output_file.is_open() || !output_file.good()) {
+        output_file.close();
+        return false;
+    }
+
+    write_header(output_file);
+    output_file.flush();
+    return true;
+}
+
+/// Close the index file opened with OpenOutput.
+void SpillIndex::CloseOutput() {
+    if (output_file.is_open()) { output_file.close(); }
+}
+
+/// Add an entry to the end of the index.
+void SpillIndex::Add(const SpillIndexEntry &entry_) {
+    entries.push_back(entry_);
+    if (output_file.is_open()) {
+        write_entry(output_file, entry_);
+        output_file.flush();
+    }
+}
+
+/// Return the first spill that could contain a hit at or after time_.
+size_t SpillIndex::FindFirstSpill(const unsigned long long &time_) const {
+    size_t low = 0, high = entries.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (entries[middle].lastTime < time_) { low = middle + 1; }
+        else { high = middle; }
+    }
+    return low;
+}
+
+/// Return the number of spills that start at or before time_.
+size_t SpillIndex::FindEndSpill(const unsigned long long &time_) const {
+    size_t low = 0, high = entries.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (entries[middle].firstTime <= time_) { low = middle + 1; }
+        else { high = middle; }
+    }
+    return low;
+}
+
+/// Print a summary of the run.
+void SpillIndex::Print() const {
+    unsigned long long words = 0;
+    unsigned long hits = 0;
+    std::vector<unsigned long> module_hits;
+    for (std::vector<SpillIndexEntry>::const_iterator iter = entries.begin(); iter != entries.end(); iter++) {
+        words += iter->nWords;
+        if (module_hits.size() < iter->moduleHits.size()) { module_hits.resize(iter->moduleHits.size(), 0); }
+        for (size_t i = 0; i < iter->moduleHits.size(); i++) {
+            module_hits[i] += iter->moduleHits[i];
+            hits += iter->moduleHits[i];
+        }
+    }
+
+    std::cout << " Spills         - " << entries.size() << std::endl;
+    std::cout << " Words          - " << words << std::endl;
+    std::cout << " Hits           - " << hits << std::endl;
+    if (!entries.empty()) {
+        std::cout << " First time     - " << entries.front().firstTime << " clock ticks\n";
+        std::cout << " Last time      - " << entries.back().lastTime << " clock ticks\n";
+    }
+    for (size_t i = 0; i < module_hits.size(); i++)
+        std::cout << " Module " << std::setw(2) << i << "      - " << module_hits[i] << " hits\n";
+}
+
+/// Write the file header (4 byte magic number and 4 byte version).
+void SpillIndex::write_header(std::ofstream &file_) {
+    unsigned int magic = SPILL_INDEX_MAGIC, version = SPILL_INDEX_VERSION;
+    file_.write((char *) &magic, 4);
+    file_.write((char *) &version, 4);
+}
+
+/** Write a single entry (8 byte offset, 4 byte word count, 8 byte first time, 8 byte last time,
+  * 4 byte number of modules and 4 bytes of hits for each module). */
+void SpillIndex::write_entry(std::ofstream &file_, const SpillIndexEntry &entry_) {
+    unsigned int nModules = entry_.moduleHits.size();
+    file_.write((char *) &entry_.offset, 8);
+    file_.write((char *) &entry_.nWords, 4);
+    file_.write((char *) &entry_.firstTime, 8);
+    file_.write((char *) &entry_.lastTime, 8);
+    file_.write((char *) &nModules, 4);
+    if (nModules != 0) { file_.write((char *) &entry_.moduleHits[0], 4 * nModules); }
+}
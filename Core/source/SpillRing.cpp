@@ -0,0 +1,554 @@
+/** \file SpillRing.cpp
+  *
+  * \brief A POSIX shared-memory ring buffer that poll2 writes spills into and that the scanners read them from
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "SpillRing.h"
+
+/// Identifies a spill ring, "PSRB" in ASCII.
+#define SPILL_RING_MAGIC 0x50535242
+
+/// Bumped whenever the layout of the header or of the records changes.
+#define SPILL_RING_VERSION 2
+
+/// The states of an entry in the table of consumers.
+enum SpillRingConsumerState {
+    SPILL_RING_CONSUMER_FREE = 0, /// Nobody is using the entry
+    SPILL_RING_CONSUMER_CLAIMED = 1, /// A reader is filling in the entry, the writer ignores it
+    SPILL_RING_CONSUMER_ACTIVE = 2 /// The entry belongs to a reader
+};
+
+/// A consumer's entry in the header. The reader fills it in and keeps it up to date, the writer only looks at it.
+struct SpillRingConsumer {
+    std::atomic<uint32_t> state; /// One of the SpillRingConsumerState
+    uint32_t policy; /// One of the SpillRingPolicy
+    uint32_t sampling; /// The N of SPILL_RING_SAMPLED
+    int32_t pid; /// The process ID of the reader, so that the writer can tell if it has died
+    char name[32]; /// The name of the consumer, not always null terminated
+    std::atomic<uint64_t> position; /// The start of the oldest record that the reader may still be using
+    std::atomic<uint64_t> delivered; /// The number of records that the reader has read
+    std::atomic<uint64_t> dropped; /// The number of records that were written over before the reader got them
+    std::atomic<uint64_t> skipped; /// The number of records that the reader skipped because of its policy
+};
+
+/// The header is followed by the data region. Positions count the bytes written since the ring was created, so they
+/// never wrap around, and the offset of a position in the data region is the position modulo the size.
+struct SpillRingHeader {
+    uint32_t magic; /// SPILL_RING_MAGIC once the ring is ready
+    uint32_t version; /// SPILL_RING_VERSION
+    uint64_t size; /// The size of the data region in bytes
+    std::atomic<uint64_t> writePosition; /// The end of the last committed record
+    std::atomic<uint64_t> lastPosition; /// The start of the last committed record
+    std::atomic<uint64_t> reservePosition; /// The end of everything that the writer has started writing to
+    std::atomic<uint64_t> records; /// The number of committed records
+    std::atomic<uint32_t> futex; /// Incremented on every commit, the readers sleep on it
+    std::atomic<uint32_t> writerWaiting; /// Set while the writer waits for a lossless consumer
+    std::atomic<uint32_t> releaseFutex; /// Incremented when a reader gives records back, the writer sleeps on it
+    SpillRingConsumer consumers[SPILL_RING_MAX_CONSUMERS]; /// The readers that have registered with the ring
+};
+
+static_assert(sizeof(SpillRingHeader) <= 4096, "The header of the spill ring has to fit in a page");
+
+/// Every record starts with this, the words of the record follow it.
+struct SpillRingRecordHeader {
+    uint64_t sequence; /// The number of records committed before this one
+    uint32_t type; /// One of the SpillRingRecordType
+    uint32_t nWords; /// The number of words in the record
+};
+
+/// Return the number of bytes that a record of nWords_ takes up in the ring. Records are kept 8 byte aligned.
+static size_t GetRecordSize(const unsigned int &nWords_) {
+    return (sizeof(SpillRingRecordHeader) + 4 * (size_t) nWords_ + 7) & ~(size_t) 7;
+}
+
+/// Return the size of the header, which takes up a whole page so that the data region is page aligned.
+static size_t GetHeaderSize() {
+    return (size_t) sysconf(_SC_PAGESIZE);
+}
+
+/** Map the data region of the ring twice, one copy right after the other, so that a record which wraps around the
+  * end of the ring can be read and written as if it didn't. Return NULL if the mapping failed. */
+static char *MapRing(const int &fd_, const size_t &size_, const int &prot_) {
+    // Reserve the address space for both copies, and then map the shared memory over each half of it.
+    void *addr = mmap(NULL, 2 * size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) { return NULL; }
+
+    char *ring = (char *) addr;
+    if (mmap(ring, size_, prot_, MAP_SHARED | MAP_FIXED, fd_, GetHeaderSize()) == MAP_FAILED ||
+        mmap(ring + size_, size_, prot_, MAP_SHARED | MAP_FIXED, fd_, GetHeaderSize()) == MAP_FAILED) {
+        munmap(addr, 2 * size_);
+        return NULL;
+    }
+    return ring;
+}
+
+SpillRingWriter::SpillRingWriter() : header(NULL), ring(NULL), size(0), reserved(NULL), reservedWords(0),
+                                     maximumWait(-1), waits(0) {
+}
+
+SpillRingWriter::~SpillRingWriter() {
+    Close();
+}
+
+/// Create the ring, replacing any ring of the same name.
+bool SpillRingWriter::Open(const std::string &name_/*=SPILL_RING_DEFAULT_NAME*/,
+                           const size_t &size_/*=SPILL_RING_DEFAULT_SIZE*/) {
+    Close();
+
+    const size_t pageSize = GetHeaderSize();
+    const size_t ringSize = (size_ + pageSize - 1) / pageSize * pageSize;
+    if (ringSize == 0) { return false; }
+
+    // A ring left behind by a writer that crashed is replaced. Readers that still have it mapped notice that the
+    // name now belongs to a different ring, see SpillRingReader::Next.
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) { return false; }
+
+    if (ftruncate(fd, pageSize + ringSize) != 0) {
+        close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    void *addr = mmap(NULL, pageSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    char *data = MapRing(fd, ringSize, PROT_READ | PROT_WRITE);
+    close(fd);
+
+    if (addr == MAP_FAILED || !data) {
+        if (addr != MAP_FAILED) { munmap(addr, pageSize); }
+        if (data) { munmap(data, 2 * ringSize); }
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    // The shared memory starts out zeroed, so the atomics are already zero. The magic goes in last, so that a reader
+    // never sees a ring that's only half set up.
+    header = (SpillRingHeader *) addr;
+    header->version = SPILL_RING_VERSION;
+    header->size = ringSize;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SPILL_RING_MAGIC;
+
+    ring = data;
+    size = ringSize;
+    name = name_;
+    reserved = NULL;
+    reservedWords = 0;
+    waits = 0;
+
+    return true;
+}
+
+/// Write a SPILL_RING_CLOSE record, unmap the ring and remove its name.
+void SpillRingWriter::Close() {
+    if (!header) { return; }
+
+    // Don't hang on a lossless consumer that has stopped reading, it has a second to make room for the last record.
+    const int wait = maximumWait;
+    if (maximumWait < 0 || maximumWait > 1000) { maximumWait = 1000; }
+    Write(SPILL_RING_CLOSE);
+    maximumWait = wait;
+
+    munmap(ring, 2 * size);
+    munmap(header, GetHeaderSize());
+    shm_unlink(name.c_str());
+
+    header = NULL;
+    ring = NULL;
+    size = 0;
+    reserved = NULL;
+    reservedWords = 0;
+}
+
+/// Return a pointer to room for a record in the ring.
+unsigned int *SpillRingWriter::Reserve(const unsigned int &nWords_) {
+    if (!header || GetRecordSize(nWords_) > size) { return NULL; }
+
+    // Tell the readers which part of the ring we're about to write over before we touch it, the same way as the
+    // sequence counter of a seqlock.
+    const uint64_t start = header->writePosition.load(std::memory_order_relaxed);
+    const uint64_t end = start + GetRecordSize(nWords_);
+    WaitForConsumers(end);
+    if (end > header->reservePosition.load(std::memory_order_relaxed))
+        header->reservePosition.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    reserved = (unsigned int *) (ring + start % size + sizeof(SpillRingRecordHeader));
+    reservedWords = nWords_;
+    return reserved;
+}
+
+/// Make the reserved record visible to the readers and wake them up.
+bool SpillRingWriter::Commit(const unsigned int &type_, const unsigned int &nWords_) {
+    if (!header || !reserved || nWords_ > reservedWords) { return false; }
+
+    const uint64_t start = header->writePosition.load(std::memory_order_relaxed);
+    SpillRingRecordHeader *record = (SpillRingRecordHeader *) (ring + start % size);
+    record->sequence = header->records.load(std::memory_order_relaxed);
+    record->type = type_;
+    record->nWords = nWords_;
+
+    // The record has to be in place before the readers can see the new write position.
+    header->lastPosition.store(start, std::memory_order_release);
+    header->records.fetch_add(1, std::memory_order_relaxed);
+    header->writePosition.store(start + GetRecordSize(nWords_), std::memory_order_release);
+
+    header->futex.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, &header->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+    reserved = NULL;
+    reservedWords = 0;
+    return true;
+}
+
+/// Copy the words into a new record and commit it.
+bool SpillRingWriter::Write(const unsigned int &type_, const unsigned int *data_/*=NULL*/,
+                            const unsigned int &nWords_/*=0*/) {
+    unsigned int *output = Reserve(nWords_);
+    if (!output) { return false; }
+    if (nWords_ > 0) { memcpy(output, data_, 4 * (size_t) nWords_); }
+    return Commit(type_, nWords_);
+}
+
+/// Return the number of records committed since the ring was opened.
+uint64_t SpillRingWriter::GetNumberOfRecords() {
+    return (header ? header->records.load(std::memory_order_relaxed) : 0);
+}
+
+/// Return the number of consumers that are registered with the ring.
+size_t SpillRingWriter::GetConsumers(std::vector<SpillRingConsumerInfo> &consumers_) {
+    consumers_.clear();
+    if (!header) { return 0; }
+
+    RemoveDeadConsumers();
+
+    const uint64_t end = header->writePosition.load(std::memory_order_relaxed);
+    for (unsigned int i = 0; i < SPILL_RING_MAX_CONSUMERS; i++) {
+        const SpillRingConsumer &consumer = header->consumers[i];
+        if (consumer.state.load(std::memory_order_acquire) != SPILL_RING_CONSUMER_ACTIVE) { continue; }
+
+        SpillRingConsumerInfo info;
+        info.name = std::string(consumer.name, strnlen(consumer.name, sizeof(consumer.name)));
+        info.pid = consumer.pid;
+        info.policy = consumer.policy;
+        info.sampling = consumer.sampling;
+        info.delivered = consumer.delivered.load(std::memory_order_relaxed);
+        info.dropped = consumer.dropped.load(std::memory_order_relaxed);
+        info.skipped = consumer.skipped.load(std::memory_order_relaxed);
+        const uint64_t position = consumer.position.load(std::memory_order_relaxed);
+        info.behind = (end > position ? end - position : 0);
+        consumers_.push_back(info);
+    }
+    return consumers_.size();
+}
+
+/// Wait until the lossless consumers are done with the records before end_.
+void SpillRingWriter::WaitForConsumers(const uint64_t &end_) {
+    if (!IsWaitingForConsumers(end_)) { return; }
+
+    waits++;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // The readers only wake us up while this is set. It has to be set before we look at their positions for the
+    // last time, or a reader could give records back in between and never wake us up.
+    header->writerWaiting.store(1, std::memory_order_seq_cst);
+    while (true) {
+        const uint32_t futex = header->releaseFutex.load(std::memory_order_seq_cst);
+        if (!IsWaitingForConsumers(end_)) { break; }
+
+        const long elapsed = (long) std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        if (maximumWait >= 0 && elapsed >= maximumWait) { break; }
+
+        // Wake up every so often to check for consumers that have died while we were waiting on them.
+        long wait = 100;
+        if (maximumWait >= 0 && maximumWait - elapsed < wait) { wait = maximumWait - elapsed; }
+        timespec timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = wait * 1000000l;
+        syscall(SYS_futex, &header->releaseFutex, FUTEX_WAIT, futex, &timeout, NULL, 0);
+
+        RemoveDeadConsumers();
+    }
+    header->writerWaiting.store(0, std::memory_order_relaxed);
+}
+
+/// Return true if a lossless consumer still needs a record before end_.
+bool SpillRingWriter::IsWaitingForConsumers(const uint64_t &end_) {
+    for (unsigned int i = 0; i < SPILL_RING_MAX_CONSUMERS; i++) {
+        const SpillRingConsumer &consumer = header->consumers[i];
+        if (consumer.state.load(std::memory_order_acquire) != SPILL_RING_CONSUMER_ACTIVE ||
+            (consumer.policy != SPILL_RING_LOSSLESS && consumer.policy != SPILL_RING_SPOOL)) { continue; }
+
+        // The reader is done with the records before its position once it has stored it, so we can write over them.
+        if (end_ - consumer.position.load(std::memory_order_seq_cst) > size) { return true; }
+    }
+    return false;
+}
+
+/// Free the entries of the consumers that have exited without closing the ring.
+void SpillRingWriter::RemoveDeadConsumers() {
+    for (unsigned int i = 0; i < SPILL_RING_MAX_CONSUMERS; i++) {
+        SpillRingConsumer &consumer = header->consumers[i];
+        if (consumer.state.load(std::memory_order_acquire) != SPILL_RING_CONSUMER_ACTIVE) { continue; }
+        if (kill(consumer.pid, 0) != 0 && errno == ESRCH) {
+            uint32_t expected = SPILL_RING_CONSUMER_ACTIVE;
+            consumer.state.compare_exchange_strong(expected, SPILL_RING_CONSUMER_FREE);
+        }
+    }
+}
+
+SpillRingReader::SpillRingReader() : header(NULL), consumer(NULL), ring(NULL), size(0), position(0), sequence(0),
+                                     lostRecords(0), skippedRecords(0), spills(0), policy(SPILL_RING_BEST_EFFORT),
+                                     sampling(1), inode(0) {
+}
+
+SpillRingReader::~SpillRingReader() {
+    Close();
+}
+
+/// Map an existing ring and register with it as a consumer.
+bool SpillRingReader::Open(const std::string &name_/*=SPILL_RING_DEFAULT_NAME*/,
+                           const unsigned int &policy_/*=SPILL_RING_BEST_EFFORT*/,
+                           const unsigned int &sampling_/*=1*/, const std::string &consumer_/*=""*/) {
+    Close();
+    if (policy_ > SPILL_RING_SAMPLED) { return false; }
+
+    // Registering means writing to the header. A best effort consumer gets along without it, so it can still read a
+    // ring that belongs to another user.
+    bool isRegistered = true;
+    int fd = shm_open(name_.c_str(), O_RDWR, 0);
+    if (fd < 0 && policy_ == SPILL_RING_BEST_EFFORT) {
+        isRegistered = false;
+        fd = shm_open(name_.c_str(), O_RDONLY, 0);
+    }
+    if (fd < 0) { return false; }
+
+    struct stat info;
+    const size_t pageSize = GetHeaderSize();
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size <= pageSize) {
+        close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, pageSize, isRegistered ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    SpillRingHeader *ringHeader = (SpillRingHeader *) addr;
+    const uint32_t magic = ringHeader->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (magic != SPILL_RING_MAGIC || ringHeader->version != SPILL_RING_VERSION ||
+        ringHeader->size != (uint64_t) info.st_size - pageSize) {
+        munmap(addr, pageSize);
+        close(fd);
+        return false;
+    }
+
+    const char *data = MapRing(fd, ringHeader->size, PROT_READ);
+    close(fd);
+    if (!data) {
+        munmap(addr, pageSize);
+        return false;
+    }
+
+    header = ringHeader;
+    ring = data;
+    size = header->size;
+    name = name_;
+    inode = info.st_ino;
+    lostRecords = 0;
+    skippedRecords = 0;
+    spills = 0;
+    policy = policy_;
+    sampling = (sampling_ > 0 ? sampling_ : 1);
+
+    if (isRegistered) {
+        for (unsigned int i = 0; i < SPILL_RING_MAX_CONSUMERS && !consumer; i++) {
+            uint32_t expected = SPILL_RING_CONSUMER_FREE;
+            if (header->consumers[i].state.compare_exchange_strong(expected, SPILL_RING_CONSUMER_CLAIMED))
+                consumer = &header->consumers[i];
+        }
+        if (!consumer) {
+            Close();
+            return false;
+        }
+
+        consumer->policy = policy;
+        consumer->sampling = sampling;
+        consumer->pid = (int32_t) getpid();
+        memset(consumer->name, 0, sizeof(consumer->name));
+        consumer_.copy(consumer->name, sizeof(consumer->name));
+        consumer->position.store(header->writePosition.load(std::memory_order_acquire), std::memory_order_relaxed);
+        consumer->delivered.store(0, std::memory_order_relaxed);
+        consumer->dropped.store(0, std::memory_order_relaxed);
+        consumer->skipped.store(0, std::memory_order_relaxed);
+        consumer->state.store(SPILL_RING_CONSUMER_ACTIVE, std::memory_order_seq_cst);
+    }
+
+    // Start with the next record that the writer commits. The record count goes up before the write position, so
+    // if the writer commits in between the two we only skip the count ahead, which Next doesn't count as lost. The
+    // writer may have gone on since we registered, which only made it wait on us for longer than it had to.
+    position = header->writePosition.load(std::memory_order_acquire);
+    sequence = header->records.load(std::memory_order_acquire);
+    Release();
+
+    return true;
+}
+
+/// Unregister from the ring and unmap it.
+void SpillRingReader::Close() {
+    if (!header) { return; }
+
+    if (consumer) {
+        consumer->state.store(SPILL_RING_CONSUMER_FREE, std::memory_order_seq_cst);
+        if (header->writerWaiting.load(std::memory_order_seq_cst)) {
+            header->releaseFutex.fetch_add(1, std::memory_order_release);
+            syscall(SYS_futex, &header->releaseFutex, FUTEX_WAKE, 1, NULL, NULL, 0);
+        }
+    }
+
+    if (ring) { munmap((void *) ring, 2 * size); }
+    munmap((void *) header, GetHeaderSize());
+
+    header = NULL;
+    consumer = NULL;
+    ring = NULL;
+    size = 0;
+}
+
+/// Get the next record from the ring, waiting for the writer if there isn't one.
+bool SpillRingReader::Next(SpillRingRecord &record_, const int &timeout_) {
+    if (!header) { return false; }
+
+    // We're done with the record from the last call.
+    Release();
+
+    bool hasWaited = false;
+    while (true) {
+        const uint32_t futex = header->futex.load(std::memory_order_acquire);
+        const uint64_t end = header->writePosition.load(std::memory_order_acquire);
+
+        if (position == end) {
+            if (hasWaited) { return false; }
+
+            // Sleep until the writer bumps the futex. If it has done so since we looked, this returns right away.
+            timespec timeout;
+            timeout.tv_sec = timeout_ / 1000;
+            timeout.tv_nsec = (timeout_ % 1000) * 1000000l;
+            syscall(SYS_futex, &header->futex, FUTEX_WAIT, futex, timeout_ < 0 ? NULL : &timeout, NULL, 0);
+            hasWaited = true;
+            continue;
+        }
+
+        // If we've fallen more than a ring behind, our next record is gone. Skip to the newest record, which a
+        // consumer that only wants the newest record does anyway.
+        bool isSkipping = false;
+        if (end - position > size) {
+            position = header->lastPosition.load(std::memory_order_acquire);
+        } else if (policy == SPILL_RING_LATEST) {
+            const uint64_t last = header->lastPosition.load(std::memory_order_acquire);
+            isSkipping = (last > position);
+            if (isSkipping) { position = last; }
+        }
+
+        SpillRingRecordHeader recordHeader;
+        memcpy(&recordHeader, ring + position % size, sizeof(recordHeader));
+
+        // The header may have been written over while we were copying it, in which case we try again.
+        record_.position = position;
+        record_.nWords = 0;
+        if (!IsValid(record_)) { continue; }
+
+        if (recordHeader.sequence > sequence) {
+            if (isSkipping) { skippedRecords += recordHeader.sequence - sequence; }
+            else { lostRecords += recordHeader.sequence - sequence; }
+        }
+
+        record_.sequence = recordHeader.sequence;
+        record_.type = recordHeader.type;
+        record_.nWords = recordHeader.nWords;
+        record_.data = (const unsigned int *) (ring + position % size + sizeof(SpillRingRecordHeader));
+
+        position += GetRecordSize(record_.nWords);
+        sequence = recordHeader.sequence + 1;
+
+        // A sampled consumer only reads every Nth spill. The other types of record are small and always get through.
+        if (policy == SPILL_RING_SAMPLED && record_.type == SPILL_RING_SPILL && spills++ % sampling != 0) {
+            skippedRecords++;
+            continue;
+        }
+
+        if (consumer) {
+            consumer->position.store(record_.position, std::memory_order_relaxed);
+            consumer->delivered.fetch_add(1, std::memory_order_relaxed);
+            consumer->dropped.store(lostRecords, std::memory_order_relaxed);
+            consumer->skipped.store(skippedRecords, std::memory_order_relaxed);
+        }
+        return true;
+    }
+}
+
+/// Return true if the writer hasn't started writing over the record.
+bool SpillRingReader::IsValid(const SpillRingRecord &record_) {
+    if (!header) { return false; }
+
+    // Everything that we read from the record has to have been read before we look at the reserve position.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header->reservePosition.load(std::memory_order_relaxed) - record_.position <= size;
+}
+
+/// Count a record that was written over while it was being used.
+void SpillRingReader::AddLostRecord() {
+    lostRecords++;
+    if (consumer) { consumer->dropped.store(lostRecords, std::memory_order_relaxed); }
+}
+
+/// Let the writer know that we're done with everything before position.
+void SpillRingReader::Release() {
+    if (!consumer) { return; }
+
+    // The writer sets the flag before it looks at our position for the last time before it sleeps, so either it sees
+    // the new position or we see the flag.
+    consumer->position.store(position, std::memory_order_seq_cst);
+    if (header->writerWaiting.load(std::memory_order_seq_cst)) {
+        header->releaseFutex.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, &header->releaseFutex, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+/// Return true if the name of the ring now belongs to a different ring.
+bool SpillRingReader::IsStale() {
+    if (!header) { return false; }
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) { return true; }
+
+    struct stat info;
+    const bool isStale = fstat(fd, &info) != 0 || info.st_ino != inode;
+    close(fd);
+    return isStale;
+}
@@ -0,0 +1,273 @@
+/** \file TraceCodec.cpp
+  *
+  * \brief Lossless compression of the ADC traces in poll2 spills
+  *
+  * \author S. V. Paulauskas
+  *
+  * \date October 17, 2026
+  *
+*/
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "TraceCodec.h"
+
+#define BLOCK_SIZE 128 /// The number of samples in a block, all of them are packed with the same width.
+#define NUMBER_OF_LANES 4 /// The number of interleaved lanes in a block.
+#define MAX_WIDTH 16 /// The largest width that a block can have, the samples are 16 bits.
+#define MAX_SAMPLES 0xFFFF /// The largest number of samples that fits in the first word.
+
+/// Map a 16-bit difference onto the non-negative numbers, so that small differences of either sign stay small.
+static inline unsigned int zigzag(const unsigned short &delta_) {
+    const int delta = (short) delta_;
+    return (((unsigned int) delta << 1) ^ (unsigned int) (delta >> 15)) & 0xFFFF;
+}
+
+/// Undo zigzag, the result is the difference modulo 2^16.
+static inline unsigned short unzigzag(const unsigned int &value_) {
+    return (unsigned short) ((value_ >> 1) ^ (0 - (value_ & 1)));
+}
+
+/// Return the bit width of the given block.
+static inline unsigned int get_width(const unsigned int *widths_, const unsigned int &block_) {
+    return (widths_[block_ / 4] >> (8 * (block_ % 4))) & 0xFF;
+}
+
+/** Pack a block of values with the given width. Value i goes to lane i % 4, and the j-th word of a lane
+  * is stored at 4*j + lane, so that word j of all four lanes can be loaded at once. */
+static void pack_block(const unsigned int *values_, const unsigned int &width_, unsigned int *out_) {
+    memset(out_, 0, NUMBER_OF_LANES * width_ * sizeof(unsigned int));
+    if (width_ == 0) { return; }
+
+    for (unsigned int i = 0; i < BLOCK_SIZE; i++) {
+        const unsigned int lane = i % NUMBER_OF_LANES;
+        const unsigned int bit = (i / NUMBER_OF_LANES) * width_;
+        const unsigned int word = bit / 32;
+        const unsigned int shift = bit % 32;
+        out_[NUMBER_OF_LANES * word + lane] |= values_[i] << shift;
+        if (shift + width_ > 32)
+            out_[NUMBER_OF_LANES * (word + 1) + lane] |= values_[i] >> (32 - shift);
+    }
+}
+
+/** Decode a packed block into BLOCK_SIZE samples, starting from the sample before the block.
+  * Return the last sample of the block. */
+static unsigned short decode_block(const unsigned int *in_, const unsigned int &width_, unsigned short previous_,
+                                   unsigned short *out_) {
+    if (width_ == 0) {
+        for (unsigned int i = 0; i < BLOCK_SIZE; i++) { out_[i] = previous_; }
+        return previous_;
+    }
+
+#if defined(__SSE2__)
+    // Each register holds one word of all four lanes, so a shift unpacks four consecutive samples. The differences
+    // are summed inside the register and the last sum is carried into the next four samples.
+    const __m128i *in = (const __m128i *) in_;
+    const __m128i mask = _mm_set1_epi32((1 << width_) - 1);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = _mm_set1_epi32(previous_);
+    __m128i current = _mm_loadu_si128(in++);
+    unsigned int loaded = 1;
+    unsigned int bit = 0;
+
+    for (unsigned int i = 0; i < BLOCK_SIZE / NUMBER_OF_LANES; i++) {
+        __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(bit));
+        bit += width_;
+        if (bit >= 32) {
+            bit -= 32;
+            if (loaded < width_) {
+                current = _mm_loadu_si128(in++);
+                loaded++;
+                if (bit > 0)
+                    value = _mm_or_si128(value, _mm_sll_epi32(current, _mm_cvtsi32_si128(width_ - bit)));
+            }
+        }
+        value = _mm_and_si128(value, mask);
+
+        __m128i delta = _mm_xor_si128(_mm_srli_epi32(value, 1), _mm_sub_epi32(zero, _mm_and_si128(value, one)));
+        delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+        carry = _mm_add_epi32(delta, carry);
+
+        // Only the lower 16 bits of the sums matter. Sign extending them keeps the saturating pack from clipping.
+        const __m128i samples = _mm_srai_epi32(_mm_slli_epi32(carry, 16), 16);
+        _mm_storel_epi64((__m128i *) (out_ + NUMBER_OF_LANES * i), _mm_packs_epi32(samples, samples));
+        carry = _mm_shuffle_epi32(carry, 0xFF);
+    }
+
+    return (unsigned short) _mm_cvtsi128_si32(carry);
+#else
+    const unsigned int mask = (1u << width_) - 1;
+    for (unsigned int i = 0; i < BLOCK_SIZE; i++) {
+        const unsigned int lane = i % NUMBER_OF_LANES;
+        const unsigned int bit = (i / NUMBER_OF_LANES) * width_;
+        const unsigned int word = bit / 32;
+        const unsigned int shift = bit % 32;
+        unsigned int value = in_[NUMBER_OF_LANES * word + lane] >> shift;
+        if (shift + width_ > 32)
+            value |= in_[NUMBER_OF_LANES * (word + 1) + lane] << (32 - shift);
+        previous_ = (unsigned short) (previous_ + unzigzag(value & mask));
+        out_[i] = previous_;
+    }
+    return previous_;
+#endif
+}
+
+unsigned int TraceCodec::GetMaxCompressedWords(const unsigned int &nSamples_) {
+    const unsigned int nBlocks = (nSamples_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return 1 + (nBlocks + 3) / 4 + nBlocks * NUMBER_OF_LANES * MAX_WIDTH;
+}
+
+unsigned int TraceCodec::Compress(const unsigned short *samples_, const unsigned int &nSamples_, unsigned int *out_) {
+    if (!samples_ || !out_ || nSamples_ == 0 || nSamples_ > MAX_SAMPLES) { return 0; }
+
+    const unsigned int nBlocks = (nSamples_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const unsigned int nWidthWords = (nBlocks + 3) / 4;
+    unsigned int *widths = out_ + 1;
+
+    out_[0] = samples_[0] | (nSamples_ << 16);
+    memset(widths, 0, nWidthWords * sizeof(unsigned int));
+
+    unsigned int position = 1 + nWidthWords;
+    unsigned short previous = samples_[0];
+    unsigned int values[BLOCK_SIZE];
+
+    for (unsigned int block = 0; block < nBlocks; block++) {
+        const unsigned int start = block * BLOCK_SIZE;
+        const unsigned int count = (nSamples_ - start < BLOCK_SIZE ? nSamples_ - start : BLOCK_SIZE);
+
+        unsigned int all = 0;
+        for (unsigned int i = 0; i < BLOCK_SIZE; i++) {
+            if (i < count) {
+                values[i] = zigzag((unsigned short) (samples_[start + i] - previous));
+                previous = samples_[start + i];
+                all |= values[i];
+            } else { values[i] = 0; }
+        }
+
+        unsigned int width = 0;
+        while (all >> width) { width++; }
+
+        widths[block / 4] |= width << (8 * (block % 4));
+        pack_block(values, width, out_ + position);
+        position += NUMBER_OF_LANES * width;
+    }
+
+    return position;
+}
+
+bool TraceCodec::Decompress(const unsigned int *in_, const unsigned int &nWords_, unsigned short *samples_,
+                            const unsigned int &nSamples_) {
+    if (!in_ || !samples_ || nWords_ == 0 || nSamples_ == 0 || (in_[0] >> 16) != nSamples_) { return false; }
+
+    const unsigned int nBlocks = (nSamples_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const unsigned int nWidthWords = (nBlocks + 3) / 4;
+    if (nWords_ < 1 + nWidthWords) { return false; }
+
+    // Check every width, and that the blocks fill the trace exactly, before we read any of them.
+    const unsigned int *widths = in_ + 1;
+    unsigned int total = 1 + nWidthWords;
+    for (unsigned int block = 0; block < nBlocks; block++) {
+        const unsigned int width = get_width(widths, block);
+        if (width > MAX_WIDTH) { return false; }
+        total += NUMBER_OF_LANES * width;
+    }
+    if (total != nWords_) { return false; }
+
+    unsigned int position = 1 + nWidthWords;
+    unsigned short previous = (unsigned short) (in_[0] & 0xFFFF);
+    unsigned short last_block[BLOCK_SIZE];
+
+    for (unsigned int block = 0; block < nBlocks; block++) {
+        const unsigned int start = block * BLOCK_SIZE;
+        const unsigned int width = get_width(widths, block);
+        if (nSamples_ - start >= BLOCK_SIZE) {
+            previous = decode_block(in_ + position, width, previous, samples_ + start);
+        } else { // The padding of the last block must not land past the end of the samples.
+            decode_block(in_ + position, width, previous, last_block);
+            memcpy(samples_ + start, last_block, (nSamples_ - start) * sizeof(unsigned short));
+        }
+        position += NUMBER_OF_LANES * width;
+    }
+
+    return true;
+}
+
+/// The buffers are walked through the same way as in SpillIndex::Summarize. A hit is only rewritten when its event
+/// length agrees with its header and trace lengths. The oldest firmwares use bit 30 as the out of range flag rather
+/// than as part of the event length, so we fall back to their mask when the full one doesn't agree.
+unsigned int TraceCodec::CompressSpill(const unsigned int *data_, const unsigned int &nWords_,
+                                       std::vector<unsigned int> &out_) {
+    out_.clear();
+    out_.reserve(nWords_);
+    std::vector<unsigned int> trace;
+
+    unsigned int position = 0;
+    while (position < nWords_) {
+        if (data_[position] == 0xFFFFFFFF || position + 1 == nWords_) { // Delimiters and stray words are kept.
+            out_.push_back(data_[position++]);
+            continue;
+        }
+
+        const unsigned int length = data_[position];
+        const unsigned int vsn = data_[position + 1];
+        if (vsn == 9999 || length < 2 || position + length > nWords_) { // End of spill or lost our place.
+            out_.insert(out_.end(), data_ + position, data_ + nWords_);
+            break;
+        }
+
+        // The wall clock, empty modules and anything else that isn't list mode data are copied as they are.
+        if (vsn == 1000 || length == 6 || vsn > 13) {
+            out_.insert(out_.end(), data_ + position, data_ + position + length);
+            position += length;
+            continue;
+        }
+
+        const size_t start = out_.size();
+        const unsigned int end = position + length;
+        out_.push_back(length);
+        out_.push_back(vsn);
+
+        unsigned int hit = position + 2;
+        while (hit + 4 <= end) {
+            const unsigned int header_length = (data_[hit] & 0x0001F000) >> 12;
+            const unsigned int trace_length = (data_[hit + 3] >> 16) & 0x7FFF;
+            const unsigned int expected_length = header_length + trace_length / 2;
+
+            unsigned int mask = 0x7FFE0000;
+            unsigned int event_length = (data_[hit] & mask) >> 17;
+            if (hit + event_length > end || (event_length != expected_length
+                                             && (data_[hit] & 0x3FFE0000) >> 17 == expected_length)) {
+                mask = 0x3FFE0000;
+                event_length = (data_[hit] & mask) >> 17;
+            }
+            if (header_length < 4 || event_length < header_length || hit + event_length > end) { break; }
+
+            unsigned int words = 0;
+            if (trace_length > 0 && trace_length % 2 == 0 && event_length == expected_length) {
+                trace.resize(GetMaxCompressedWords(trace_length));
+                words = Compress((const unsigned short *) &data_[hit + header_length], trace_length, &trace[0]);
+            }
+
+            if (words != 0 && words < trace_length / 2) {
+                out_.push_back((data_[hit] & ~mask) | ((header_length + words) << 17));
+                out_.insert(out_.end(), data_ + hit + 1, data_ + hit + header_length);
+                out_.insert(out_.end(), trace.begin(), trace.begin() + words);
+            } else { out_.insert(out_.end(), data_ + hit, data_ + hit + event_length); }
+
+            hit += event_length;
+        }
+
+        // Whatever we couldn't make sense of stays the way it was.
+        out_.insert(out_.end(), data_ + hit, data_ + end);
+        out_[start] = (unsigned int) (out_.size() - start);
+        position = end;
+    }
+
+    return (unsigned int) out_.size();
+}
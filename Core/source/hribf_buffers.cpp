@@ -26,7 +26,9 @@
 #include <vector>
 
 #include "hribf_buffers.h"
+#include "MappedFile.h"
 #include "poll2_socket.h"
+#include "TraceCodec.h"
 
 #define SMALLEST_CHUNK_SIZE 20 /// Smallest possible size of a chunk in words
 #define NO_HEADER_SIZE 8192 /// Size of .ldf buffer with no header
@@ -43,6 +45,9 @@
 
 #define LDF_DATA_LENGTH 8193 // Maximum length of an ldf style DATA buffer.
 
+#define PLD_FORMAT "PIXIE LIST DATA " /// Format string of a .pld file.
+#define PLD_COMPRESSED_FORMAT "PIXIE LIST DATAZ" /// Format string of a .pld file with compressed traces.
+
 const unsigned int end_spill_size = 20; /// The size of the end of spill "event" (5 words).
 const unsigned int pacman_word1 = 2; /// Words to signify the end of a spill. The scan code searches for these words.
 const unsigned int pacman_word2 = 9999; /// End of spill vsn. The scan code searches for these words.
@@ -114,6 +119,11 @@ unsigned int PLD_header::GetBufferLength() {
     return buffer_len;
 }
 
+/// The format string tells us whether or not the traces are compressed. Older readers just print it.
+bool PLD_header::HasCompressedTraces() {
+    return strncmp(format, PLD_COMPRESSED_FORMAT, 16) == 0;
+}
+
 /// Set the date and tiem of when the file is opened.
 void PLD_header::SetStartDateTime() {
     time(&runStartTime);
@@ -140,6 +150,11 @@ void PLD_header::SetFacility(std::string input_) {
     set_char_array(input_, facility, 16);
 }
 
+/// Set the format string to say whether or not the traces are compressed.
+void PLD_header::SetCompressedTraces(bool compressed_) {
+    set_char_array(compressed_ ? PLD_COMPRESSED_FORMAT : PLD_FORMAT, format, 16);
+}
+
 /// Set the title of the output pld file (unlimited length).
 void PLD_header::SetTitle(std::string input_) {
     if (run_title) { delete[] run_title; }
@@ -234,7 +249,7 @@ bool PLD_header::Read(std::ifstream *file_) {
 /// Set initial values.
 void PLD_header::Reset() {
     set_char_array("U OF TENNESSEE  ", facility, 16);
-    set_char_array("PIXIE LIST DATA ", format, 16);
+    set_char_array(PLD_FORMAT, format, 16);
     set_char_array("Mon Jan 01 00:00:00 2000", start_date, 24);
     set_char_array("Mon Jan 01 00:00:00 2000", end_date, 24);
     max_spill_size = 0;
@@ -348,6 +363,65 @@ bool PLD_data::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
     return true;
 }
 
+/// Read a pld style data buffer from a memory mapped file.
+bool PLD_data::Read(MappedFile *file_, unsigned int *&data_, unsigned int &nBytes,
+                    unsigned int max_bytes_) {
+    if (!file_ || !file_->IsOpen()) { return false; }
+
+    unsigned int *word = (unsigned int *) file_->Read(4);
+    if (!word) { return false; }
+    if (*word != bufftype) { // Not a valid DATA buffer
+        if (debug_mode) { std::cout << "debug: not a valid DATA buffer\n"; }
+
+        unsigned int countw = 0;
+        while (*word != bufftype) {
+            word = (unsigned int *) file_->Read(4);
+            if (!word) {
+                if (debug_mode) {
+                    std::cout
+                            << "debug: encountered physical end-of-file before start of spill!\n";
+                }
+                return false;
+            }
+            countw++;
+        }
+
+        if (debug_mode) {
+            std::cout << "debug: read an extra " << countw
+                      << " words to get to first DATA buffer!\n";
+        }
+    }
+
+    word = (unsigned int *) file_->Read(4);
+    if (!word) { return false; }
+    nBytes = (*word) * 4;
+
+    if (debug_mode) {
+        std::cout << "debug: reading spill of " << nBytes << " bytes\n";
+    }
+
+    if (nBytes > max_bytes_) {
+        if (debug_mode) {
+            std::cout
+                    << "debug: spill size is greater than size of data array!\n";
+        }
+        return false;
+    }
+
+    data_ = (unsigned int *) file_->Read(nBytes);
+    word = (unsigned int *) file_->Read(4);
+    if (!data_ || !word) { return false; }
+
+    if (*word != buffend) { // Buffer was not terminated properly
+        if (debug_mode) {
+            std::cout << "debug: buffer not terminated properly\n";
+        }
+        return false;
+    }
+
+    return true;
+}
+
 /// Default constructor.
 DIR_buffer::DIR_buffer() : BufferType(DIR,
                                       NO_HEADER_SIZE) { // 0x20524944 "DIR "
@@ -589,6 +663,7 @@ bool DATA_buffer::read_next_buffer(std::ifstream *f_, bool force_/*=false*/) {
     if (!f_ || !f_->good() || f_->eof()) { return false; }
 
     if (bcount == 0) {
+        next_offset = f_->tellg();
         f_->read((char *) buffer1, ACTUAL_BUFF_SIZE * 4);
     } else if (buff_pos + 3 <= ACTUAL_BUFF_SIZE - 1 && !force_) {
         // Don't need to scan a new buffer yet. There are still
@@ -607,6 +682,8 @@ bool DATA_buffer::read_next_buffer(std::ifstream *f_, bool force_/*=false*/) {
     }
 
     // Read the buffer into memory.
+    curr_offset = next_offset;
+    next_offset = f_->tellg();
     if (bcount % 2 == 0) {
         f_->read((char *) buffer2, ACTUAL_BUFF_SIZE * 4);
         curr_buffer = buffer1;
@@ -626,6 +703,7 @@ bool DATA_buffer::read_next_buffer(std::ifstream *f_, bool force_/*=false*/) {
     // Read the buffer header and length.
     buff_head = curr_buffer[buff_pos++];
     buff_size = curr_buffer[buff_pos++];
+    skip_to_start_word();
 
     if (!f_->good()) { return false; }
     else if (f_->eof()) { retval = 2; }
@@ -633,6 +711,60 @@ bool DATA_buffer::read_next_buffer(std::ifstream *f_, bool force_/*=false*/) {
     return true;
 }
 
+/// The mapped version keeps the same one buffer look-ahead as the stream version, but the
+/// buffers are never copied. curr_buffer and next_buffer point directly into the mapping.
+bool DATA_buffer::read_next_buffer(MappedFile *f_, bool force_/*=false*/) {
+    if (!f_ || !f_->IsOpen() || f_->Eof()) { return false; }
+
+    if (bcount == 0) {
+        next_offset = f_->GetPosition();
+        next_buffer = (unsigned int *) f_->Read(ACTUAL_BUFF_SIZE * 4);
+        if (!next_buffer) { return false; }
+    } else if (buff_pos + 3 <= ACTUAL_BUFF_SIZE - 1 && !force_) {
+        // Don't need to scan a new buffer yet. There are still
+        // words remaining in the one currently in memory.
+
+        // Skip end of event delimiters.
+        while (curr_buffer[buff_pos] == ENDBUFF &&
+               buff_pos < ACTUAL_BUFF_SIZE - 1) {
+            buff_pos++;
+        }
+
+        // If we have more good words in this buffer, keep reading it.
+        if (buff_pos + 3 < ACTUAL_BUFF_SIZE - 1) {
+            return true;
+        }
+    }
+
+    // The look-ahead buffer becomes the current buffer.
+    unsigned long long offset = f_->GetPosition();
+    unsigned int *buffer = (unsigned int *) f_->Read(ACTUAL_BUFF_SIZE * 4);
+    if (!buffer) { return false; }
+    curr_offset = next_offset;
+    next_offset = offset;
+    curr_buffer = next_buffer;
+    next_buffer = buffer;
+
+    // Reset the buffer index.
+    buff_pos = 0;
+
+    // Increment the number of buffers read.
+    bcount++;
+
+    // Read the buffer header and length.
+    buff_head = curr_buffer[buff_pos++];
+    buff_size = curr_buffer[buff_pos++];
+    skip_to_start_word();
+
+    return true;
+}
+
+/// Move past the words before start_word in the first buffer read after a reset.
+void DATA_buffer::skip_to_start_word() {
+    if (bcount == 1 && start_word > buff_pos && start_word < ACTUAL_BUFF_SIZE) { buff_pos = start_word; }
+    start_word = 0;
+}
+
 /// Default constructor.
 DATA_buffer::DATA_buffer() : BufferType(DATA,
                                         NO_HEADER_SIZE) { // 0x41544144 "DATA"
@@ -730,6 +862,8 @@ bool DATA_buffer::Write(std::ofstream *file_, char *data_, unsigned int nWords_,
         spillpos += chunkPayload;
         chunkSizeB = 4 * (chunkPayload + 3);
 
+        if (currentNumChunk == 0) { spill_offset = file_->tellp(); }
+
         if (debug_mode)
             std::cout << "debug: writing " << 1 + chunkSizeB / 4
                       << " word spill chunk " << currentNumChunk << " of "
@@ -795,6 +929,26 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
         return false;
     }
 
+    return read_spill(file_, data_, nBytes, max_bytes_, full_spill, bad_spill, dry_run_mode);
+}
+
+/// Read a ldf data spill from a memory mapped file.
+bool DATA_buffer::Read(MappedFile *file_, char *data_, unsigned int &nBytes,
+                       unsigned int max_bytes_, bool &full_spill,
+                       bool &bad_spill, bool dry_run_mode/*=false*/) {
+    if (!file_ || !file_->IsOpen()) {
+        retval = 6;
+        return false;
+    }
+
+    return read_spill(file_, data_, nBytes, max_bytes_, full_spill, bad_spill, dry_run_mode);
+}
+
+/// Stitch a ldf data spill together. T is either a std::ifstream or a MappedFile.
+template<typename T>
+bool DATA_buffer::read_spill(T *file_, char *data_, unsigned int &nBytes,
+                             unsigned int max_bytes_, bool &full_spill,
+                             bool &bad_spill, bool dry_run_mode) {
     bad_spill = false;
 
     bool first_chunk = true;
@@ -818,6 +972,8 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
             prev_chunk_num = current_chunk_num;
             prev_num_chunks = total_num_chunks;
 
+            if (first_chunk) { spill_offset = curr_offset + 4 * buff_pos; }
+
             this_chunk_sizeB = curr_buffer[buff_pos++];
             total_num_chunks = curr_buffer[buff_pos++];
             current_chunk_num = curr_buffer[buff_pos++];
@@ -999,6 +1155,10 @@ void DATA_buffer::Reset() {
     curr_buffer = buffer1;
     next_buffer = buffer2;
     buff_pos = 0;
+    start_word = 0;
+    curr_offset = 0;
+    next_offset = 0;
+    spill_offset = 0;
     bcount = 0;
     retval = 0;
     good_chunks = 0;
@@ -1159,6 +1319,7 @@ void PollOutputFile::initialize() {
     current_filename = "unknown";
     current_full_filename = "unknown";
     debug_mode = false;
+    compress_traces = false;
 
     // Get the current working directory
     // current_directory DOES NOT include a trailing '/'
@@ -1228,10 +1389,18 @@ int PollOutputFile::Write(char *data_, unsigned int nWords_) {
 
     // Write data to disk
     int buffs_written;
+    unsigned long long offset = 0;
     if (output_format == 0) {
         if (!dataBuff.Write(&output_file, data_, nWords_,
                             buffs_written)) { return -1; }
+        offset = dataBuff.GetSpillOffset();
     } else if (output_format == 1) {
+        // The header of the open file decides, so that a file never mixes compressed and plain traces.
+        if (pldHead.HasCompressedTraces()) {
+            nWords_ = TraceCodec::CompressSpill((unsigned int *) data_, nWords_, compressed_spill);
+            data_ = (char *) &compressed_spill[0];
+        }
+        offset = output_file.tellp();
         if (!pldData.Write(&output_file, data_, nWords_)) { return -1; }
         buffs_written = 1;
     } else {
@@ -1243,6 +1412,9 @@ int PollOutputFile::Write(char *data_, unsigned int nWords_) {
     }
     number_spills++;
 
+    if (spillIndex.IsOutputOpen())
+        spillIndex.Add(SpillIndex::Summarize((unsigned int *) data_, nWords_, offset));
+
     return buffs_written;
 }
 
@@ -1336,6 +1508,10 @@ bool PollOutputFile::OpenNewFile(std::string title_, unsigned int &run_num_, std
 
     std::string filename = GetNextFileName(run_num_, prefix, output_directory, continueRun);
 
+    // The .ldf buffers are only 32 kB, with a larger stream buffer they reach the disk a few MB at a time.
+    // It has to be set before the file is opened.
+    stream_buffer.resize(POLL_OUTPUT_BUFFER_SIZE);
+    output_file.rdbuf()->pubsetbuf(&stream_buffer[0], stream_buffer.size());
     output_file.open(filename.c_str(), std::ios::binary);
 
     if (!output_file.is_open() || !output_file.good()) {
@@ -1346,6 +1522,10 @@ bool PollOutputFile::OpenNewFile(std::string title_, unsigned int &run_num_, std
     current_filename = filename;
     get_full_filename(current_full_filename);
 
+    // The index is only a convenience, so the run goes on without one if it can't be written.
+    if (!spillIndex.OpenOutput(SpillIndex::GetIndexFilename(filename)))
+        std::cout << "WARNING: Failed to open the spill index " << SpillIndex::GetIndexFilename(filename) << "!\n";
+
     if (output_format == 0) {
         dirBuff.SetRunNumber(run_num_);
         dirBuff.Write(&output_file); // Every .ldf file gets a DIR header
@@ -1357,6 +1537,7 @@ bool PollOutputFile::OpenNewFile(std::string title_, unsigned int &run_num_, std
     } else if (output_format == 1) {
         pldHead.SetTitle(title_);
         pldHead.SetRunNumber(run_num_);
+        pldHead.SetCompressedTraces(compress_traces);
         pldHead.SetStartDateTime();
 
         // Write a blank header for now and overwrite it later
@@ -1423,6 +1604,8 @@ unsigned int PollOutputFile::GetRunNumber() {
 
 /// Write the footer and close the file.
 void PollOutputFile::CloseFile(float total_run_time_/*=0.0*/) {
+    spillIndex.CloseOutput();
+
     if (!output_file.is_open() || !output_file.good()) { return; }
 
     if (output_format == 0) {
@@ -6,15 +6,20 @@
 #ifndef __RANDOMINTERFACE_HPP_
 #define __RANDOMINTERFACE_HPP_
 
+#include <atomic>
 #include <random>
 
+#include <cstdint>
+
 /// An  of numbers using Mersenne twister - Singleton Class
 class RandomInterface {
 public:
     /** \return The only instance to the random pool */
     static RandomInterface *get();
 
-    /** \return a random number in the specified range [0, range]
+    /** \return a random number in the specified range [0, range]. It may be
+    * called from several threads at once, each thread draws from an engine
+    * of its own.
     * \param [in] range : the upper bound for the range to get */
     double Generate(const double &range = 1);
 private:
@@ -23,9 +28,12 @@ private:
     RandomInterface &operator=(RandomInterface const &);//!< the copy constructor
     static RandomInterface *instance;//!< static instance of the class
 
-    std::mt19937_64 engine_;
-    std::uniform_real_distribution<double> distribution_;
-    unsigned seed_;
+    /** \return A new engine for the calling thread, seeded from seed_ and
+     * the number of engines that came before it. */
+    std::mt19937_64 CreateEngine();
+
+    uint64_t seed_; //!< The seed that every thread's engine is seeded from
+    std::atomic<unsigned int> numberOfEngines_; //!< The number of threads that have an engine
 };
 
 #endif // __RANDOMINTERFACE_HPP_
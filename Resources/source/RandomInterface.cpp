@@ -15,11 +15,19 @@ RandomInterface *RandomInterface::get() {
     return instance;
 }
 
-RandomInterface::RandomInterface() {
-    engine_ = std::mt19937_64(std::chrono::system_clock::now().time_since_epoch().count());
-    distribution_ = std::uniform_real_distribution<double>(0.0, 1.0);
+RandomInterface::RandomInterface() : numberOfEngines_(0) {
+    seed_ = std::chrono::system_clock::now().time_since_epoch().count();
+}
+
+///The number of the engine goes into the seed sequence alongside the seed, so that the threads don't draw the same
+/// numbers.
+std::mt19937_64 RandomInterface::CreateEngine() {
+    std::seed_seq sequence{(uint32_t) seed_, (uint32_t) (seed_ >> 32), (uint32_t) numberOfEngines_++};
+    return std::mt19937_64(sequence);
 }
 
 double RandomInterface::Generate(const double &range/*=1*/) {
-    return distribution_(engine_) * range;
+    thread_local std::mt19937_64 engine = CreateEngine();
+    thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    return distribution(engine) * range;
 }